@@ -0,0 +1,93 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/file/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "absl/status/status.h"
+#include "xls/common/file/file_descriptor.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/error_code_to_status.h"
+#include "xls/common/strerror.h"
+
+namespace xls {
+namespace {
+
+// Returns a Status error based on the current errno value, for the given
+// failed operation on the given file.
+absl::Status ErrNoToStatusWithFilename(absl::string_view operation,
+                                       const std::filesystem::path& path) {
+  xabsl::StatusBuilder builder = ErrnoToStatus(errno);
+  builder << "Failed to " << operation << " " << path.string();
+  return std::move(builder);
+}
+
+}  // namespace
+
+MappedFile::~MappedFile() { Unmap(); }
+
+/* static */ absl::StatusOr<MappedFile> MappedFile::Open(
+    const std::filesystem::path& path) {
+  FileDescriptor fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd.get() == -1) {
+    return ErrNoToStatusWithFilename("open", path);
+  }
+  struct stat stat_buf;
+  if (fstat(fd.get(), &stat_buf) != 0) {
+    return ErrNoToStatusWithFilename("stat", path);
+  }
+  size_t size = stat_buf.st_size;
+  if (size == 0) {
+    return MappedFile(nullptr, 0);
+  }
+  // The mapping holds its own reference to the file, so the descriptor can be
+  // closed straight away.
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (data == MAP_FAILED) {
+    return ErrNoToStatusWithFilename("map", path);
+  }
+  // Files like these are generally scanned front to back.
+  (void)madvise(data, size, MADV_SEQUENTIAL);
+  return MappedFile(data, size);
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+    : data_(other.data_), size_(other.size_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+  Unmap();
+  data_ = other.data_;
+  size_ = other.size_;
+  other.data_ = nullptr;
+  other.size_ = 0;
+  return *this;
+}
+
+void MappedFile::Unmap() {
+  if (data_ != nullptr) {
+    if (munmap(data_, size_) != 0) {
+      XLS_LOG(ERROR) << "Failed to unmap file: " << Strerror(errno);
+    }
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+}  // namespace xls
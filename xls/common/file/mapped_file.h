@@ -0,0 +1,62 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_FILE_MAPPED_FILE_H_
+#define XLS_COMMON_FILE_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <filesystem>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace xls {
+
+// A read-only memory mapping of a file's contents, unmapped when the object
+// goes out of scope.
+//
+// Unlike GetFileContents(), this doesn't copy the file onto the heap: pages
+// are read in on demand and, being backed by the file, can be dropped again
+// by the kernel under memory pressure. Prefer this for very large inputs
+// which are scanned once.
+class MappedFile {
+ public:
+  ~MappedFile();
+
+  // Maps the contents of the given file. Returns an error status if the file
+  // can't be opened or mapped.
+  static absl::StatusOr<MappedFile> Open(const std::filesystem::path& path);
+
+  absl::string_view contents() const {
+    return absl::string_view(static_cast<const char*>(data_), size_);
+  }
+
+  // MappedFile is movable but not copyable.
+  MappedFile(MappedFile&& other);
+  MappedFile& operator=(MappedFile&& other);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+ private:
+  MappedFile(void* data, size_t size) : data_(data), size_(size) {}
+  void Unmap();
+
+  // Null for empty files, which can't be mapped.
+  void* data_;
+  size_t size_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_FILE_MAPPED_FILE_H_
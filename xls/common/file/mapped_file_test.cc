@@ -0,0 +1,57 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/file/mapped_file.h"
+
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+
+TEST(MappedFile, ContentsMatchFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                           TempFile::CreateWithContent("module main();"));
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile file, MappedFile::Open(temp_file.path()));
+  EXPECT_EQ(file.contents(), "module main();");
+}
+
+TEST(MappedFile, EmptyFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file, TempFile::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile file, MappedFile::Open(temp_file.path()));
+  EXPECT_TRUE(file.contents().empty());
+}
+
+TEST(MappedFile, MoveTransfersMapping) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                           TempFile::CreateWithContent("abc"));
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile file, MappedFile::Open(temp_file.path()));
+  MappedFile other = std::move(file);
+  EXPECT_EQ(other.contents(), "abc");
+  EXPECT_TRUE(file.contents().empty());  // NOLINT(bugprone-use-after-move)
+}
+
+TEST(MappedFile, NonexistentFileFails) {
+  EXPECT_THAT(MappedFile::Open("nonexisting_path_name___"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace xls
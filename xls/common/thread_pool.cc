@@ -0,0 +1,93 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/thread_pool.h"
+
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+
+ThreadPool::ThreadPool(int64_t thread_count) {
+  XLS_CHECK_GE(thread_count, 1);
+  for (int64_t i = 1; i < thread_count; ++i) {
+    threads_.push_back(std::make_unique<Thread>([this]() { Work(); }));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    shutdown_ = true;
+  }
+  for (std::unique_ptr<Thread>& thread : threads_) {
+    thread->Join();
+  }
+}
+
+void ThreadPool::ParallelFor(int64_t count,
+                             const std::function<void(int64_t)>& fn) {
+  if (threads_.empty() || count <= 1 || !run_mutex_.TryLock()) {
+    for (int64_t i = 0; i < count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    fn_ = &fn;
+    count_ = count;
+    pending_ = threads_.size();
+    next_index_ = 0;
+    ++generation_;
+  }
+  RunItems(fn, count);
+  {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        +[](int64_t* pending) { return *pending == 0; }, &pending_));
+    fn_ = nullptr;
+  }
+  run_mutex_.Unlock();
+}
+
+void ThreadPool::RunItems(const std::function<void(int64_t)>& fn,
+                          int64_t count) {
+  for (int64_t i = next_index_++; i < count; i = next_index_++) {
+    fn(i);
+  }
+}
+
+void ThreadPool::Work() {
+  int64_t generation = 0;
+  while (true) {
+    const std::function<void(int64_t)>* fn;
+    int64_t count;
+    {
+      absl::MutexLock lock(&mutex_);
+      auto ready = [&]() { return shutdown_ || generation_ != generation; };
+      mutex_.Await(absl::Condition(&ready));
+      if (shutdown_) {
+        return;
+      }
+      generation = generation_;
+      fn = fn_;
+      count = count_;
+    }
+    RunItems(*fn, count);
+    absl::MutexLock lock(&mutex_);
+    --pending_;
+  }
+}
+
+}  // namespace xls
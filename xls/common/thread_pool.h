@@ -0,0 +1,75 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_THREAD_POOL_H_
+#define XLS_COMMON_THREAD_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread.h"
+
+namespace xls {
+
+// A fixed set of worker threads that repeatedly runs "parallel for" loops, so
+// that code which fans out many small batches of work doesn't pay for thread
+// creation on every batch.
+class ThreadPool {
+ public:
+  // Work is run on "thread_count" threads in total: the thread calling
+  // ParallelFor() takes part, so "thread_count - 1" threads are spawned.
+  explicit ThreadPool(int64_t thread_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int64_t thread_count() const { return threads_.size() + 1; }
+
+  // Calls fn(i) for every i in [0, count) and returns once all of the calls
+  // have completed. Calls are handed out to the threads in increasing order of
+  // "i", but may complete in any order.
+  //
+  // If the pool is already running a loop (e.g. ParallelFor() is called from
+  // within "fn"), the calls are instead made serially on the calling thread.
+  void ParallelFor(int64_t count, const std::function<void(int64_t)>& fn);
+
+ private:
+  void Work();
+  void RunItems(const std::function<void(int64_t)>& fn, int64_t count);
+
+  // Held for the duration of a ParallelFor() that uses the workers.
+  absl::Mutex run_mutex_;
+
+  absl::Mutex mutex_;
+  const std::function<void(int64_t)>* fn_ ABSL_GUARDED_BY(mutex_) = nullptr;
+  int64_t count_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t generation_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t pending_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+
+  // Index of the next call to hand out in the current loop.
+  std::atomic<int64_t> next_index_ = 0;
+
+  std::vector<std::unique_ptr<Thread>> threads_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_THREAD_POOL_H_
@@ -0,0 +1,76 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace xls {
+namespace {
+
+TEST(ThreadPoolTest, RunsEveryIndexOnce) {
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.thread_count(), 4);
+  // The pool is reused across loops of different sizes.
+  for (int64_t count : {0, 1, 3, 100}) {
+    std::vector<std::atomic<int64_t>> calls(count);
+    pool.ParallelFor(count, [&](int64_t i) { ++calls[i]; });
+    for (int64_t i = 0; i < count; ++i) {
+      EXPECT_EQ(calls[i], 1) << "count " << count << " index " << i;
+    }
+  }
+}
+
+TEST(ThreadPoolTest, CallsRunConcurrently) {
+  ThreadPool pool(3);
+  // Each call waits until all three are in flight, which can only happen if
+  // they run on different threads.
+  absl::Mutex mutex;
+  int64_t in_flight = 0;
+  int64_t max_in_flight = 0;
+  pool.ParallelFor(3, [&](int64_t i) {
+    absl::MutexLock lock(&mutex);
+    max_in_flight = std::max(max_in_flight, ++in_flight);
+    mutex.AwaitWithTimeout(
+        absl::Condition(+[](int64_t* n) { return *n == 3; }, &in_flight),
+        absl::Seconds(10));
+  });
+  EXPECT_EQ(max_in_flight, 3);
+}
+
+TEST(ThreadPoolTest, NestedLoopsRunOnCallingThread) {
+  ThreadPool pool(2);
+  std::atomic<int64_t> calls = 0;
+  pool.ParallelFor(4, [&](int64_t i) {
+    pool.ParallelFor(4, [&](int64_t j) { ++calls; });
+  });
+  EXPECT_EQ(calls, 16);
+}
+
+TEST(ThreadPoolTest, SingleThreadPoolRunsInline) {
+  ThreadPool pool(1);
+  std::vector<int64_t> order;
+  pool.ParallelFor(3, [&](int64_t i) { order.push_back(i); });
+  EXPECT_THAT(order, testing::ElementsAre(0, 1, 2));
+}
+
+}  // namespace
+}  // namespace xls
@@ -15,6 +15,8 @@
 #ifndef XLS_DSLX_AST_H_
 #define XLS_DSLX_AST_H_
 
+#include <filesystem>
+
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -23,6 +25,8 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "xls/common/casts.h"
@@ -532,6 +536,12 @@ class NameDef : public AstNode {
   void set_definer(AstNode* definer) { definer_ = definer; }
   AstNode* definer() const { return definer_; }
 
+  // Index of the interpreter frame slot this name is stored in, or -1 if it is
+  // not bound within a function body (e.g. module-level definitions); see
+  // FrameLayout.
+  int64_t frame_slot() const { return frame_slot_; }
+  void set_frame_slot(int64_t frame_slot) { frame_slot_ = frame_slot; }
+
  private:
   Span span_;
   std::string identifier_;
@@ -540,6 +550,7 @@ class NameDef : public AstNode {
   // defining nodes, and have to "circle back" and note what that resulting
   // "definer" node was.
   AstNode* definer_;
+  int64_t frame_slot_ = -1;
 };
 
 // Abstract base class for visitation of expression nodes in the AST.
@@ -1241,9 +1252,15 @@ class Function : public FunctionBase {
   const std::vector<Param*>& params() const { return params_; }
   TypeAnnotation* return_type() const { return return_type_; }
 
+  // Number of interpreter frame slots needed by an invocation of this
+  // function; see FrameLayout.
+  int64_t frame_size() const { return frame_size_; }
+  void set_frame_size(int64_t frame_size) { frame_size_ = frame_size; }
+
  private:
   std::vector<Param*> params_;
   TypeAnnotation* return_type_;  // May be null.
+  int64_t frame_size_ = 0;
 };
 
 // Represents a parsed 'process' specification in the DSL.
@@ -2353,6 +2370,7 @@ class Module : public AstNode {
     std::unique_ptr<T> node =
         absl::make_unique<T>(this, std::forward<Args>(args)...);
     T* ptr = node.get();
+    absl::MutexLock lock(&nodes_mutex_);
     nodes_.push_back(std::move(node));
     return ptr;
   }
@@ -2428,6 +2446,15 @@ class Module : public AstNode {
 
   const std::string& name() const { return name_; }
 
+  // Path of the file this module was parsed from, if it was located on disk
+  // (e.g. as an import).
+  const absl::optional<std::filesystem::path>& fs_path() const {
+    return fs_path_;
+  }
+  void set_fs_path(std::filesystem::path fs_path) {
+    fs_path_ = std::move(fs_path);
+  }
+
  private:
   // Returns all of the elements of top_ that have the given variant type T.
   template <typename T>
@@ -2457,7 +2484,12 @@ class Module : public AstNode {
 
   std::string name_;               // Name of this module.
   std::vector<ModuleMember> top_;  // Top-level members of this module.
-  std::vector<std::unique_ptr<AstNode>> nodes_;  // Lifetime-owned AST nodes.
+  // Nodes can be made while typechecking (e.g. for `map()` of a builtin), which
+  // for an imported module can happen concurrently in several importers.
+  absl::Mutex nodes_mutex_;
+  std::vector<std::unique_ptr<AstNode>> nodes_  // Lifetime-owned AST nodes.
+      ABSL_GUARDED_BY(nodes_mutex_);
+  absl::optional<std::filesystem::path> fs_path_;
 };
 
 // Helper for determining whether an AST node is constant (e.g. can be
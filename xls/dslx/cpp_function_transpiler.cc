@@ -0,0 +1,1038 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/cpp_function_transpiler.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/lsb_or_msb.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+
+namespace xls::dslx {
+namespace {
+
+constexpr int64_t kMaxBitCount = 128;
+
+// Helpers shared by all emitted functions. Instantiated once for values
+// computed in 64 bits and once for values computed in 128 bits.
+// $0: Helper name suffix.
+// $1: Unsigned computation type.
+// $2: Signed computation type.
+// $3: Bit count of the computation types.
+constexpr absl::string_view kHelperTemplate =
+    R"(inline $1 Mask$0($1 x, int64_t width) {
+  return width >= $3 ? x : x & ((static_cast<$1>(1) << width) - 1);
+}
+
+inline $2 Signed$0($1 x, int64_t width) {
+  if (width == 0) {
+    return 0;
+  }
+  return static_cast<$2>(x << ($3 - width)) >> ($3 - width);
+}
+
+inline $1 Shll$0($1 x, int64_t amount, int64_t width) {
+  return amount >= width ? 0 : Mask$0(x << amount, width);
+}
+
+inline $1 Shrl$0($1 x, int64_t amount, int64_t width) {
+  return amount >= width ? 0 : x >> amount;
+}
+
+inline $1 Shra$0($1 x, int64_t amount, int64_t width) {
+  if (width == 0) {
+    return 0;
+  }
+  if (amount >= width) {
+    amount = width - 1;
+  }
+  return Mask$0(static_cast<$1>(Signed$0(x, width) >> amount), width);
+}
+
+inline $1 UDiv$0($1 x, $1 y, int64_t width) {
+  return y == 0 ? Mask$0(~static_cast<$1>(0), width) : x / y;
+}
+
+inline $1 UMod$0($1 x, $1 y) { return y == 0 ? 0 : x % y; }
+
+inline $1 SDiv$0($1 x, $1 y, int64_t width) {
+  if (width == 0) {
+    return 0;
+  }
+  $2 signed_x = Signed$0(x, width);
+  $2 signed_y = Signed$0(y, width);
+  if (signed_y == 0) {
+    $1 min_value = static_cast<$1>(1) << (width - 1);
+    return signed_x < 0 ? min_value : min_value - 1;
+  }
+  if (signed_y == -1) {
+    return Mask$0(static_cast<$1>(0) - x, width);
+  }
+  return Mask$0(static_cast<$1>(signed_x / signed_y), width);
+}
+
+inline $1 SMod$0($1 x, $1 y, int64_t width) {
+  $2 signed_x = Signed$0(x, width);
+  $2 signed_y = Signed$0(y, width);
+  if (signed_y == 0 || signed_y == -1) {
+    return 0;
+  }
+  return Mask$0(static_cast<$1>(signed_x % signed_y), width);
+}
+
+inline $1 BitSliceUpdate$0($1 x, int64_t start, $1 update, int64_t width,
+                           int64_t update_width) {
+  if (start >= width) {
+    return x;
+  }
+  $1 mask = Mask$0(~static_cast<$1>(0), update_width) << start;
+  return Mask$0((x & ~mask) | (update << start), width);
+}
+
+inline $1 Reverse$0($1 x, int64_t width) {
+  $1 result = 0;
+  for (int64_t i = 0; i < width; ++i) {
+    result |= ((x >> i) & 1) << (width - 1 - i);
+  }
+  return result;
+}
+
+inline $1 Encode$0($1 x, int64_t width) {
+  $1 result = 0;
+  for (int64_t i = 0; i < width; ++i) {
+    if ((x >> i) & 1) {
+      result |= static_cast<$1>(i);
+    }
+  }
+  return result;
+}
+
+inline $1 OneHotLsb$0($1 x, int64_t width) {
+  return x == 0 ? static_cast<$1>(1) << width : x & (~x + 1);
+}
+
+inline $1 OneHotMsb$0($1 x, int64_t width) {
+  if (x == 0) {
+    return static_cast<$1>(1) << width;
+  }
+  $1 result = 1;
+  while (x >>= 1) {
+    result <<= 1;
+  }
+  return result;
+})";
+
+constexpr absl::string_view kCommonHelpers =
+    R"(inline xls_u128 MakeU128(uint64_t high, uint64_t low) {
+  return (static_cast<xls_u128>(high) << 64) | low;
+}
+
+// Returns "value" clamped to "limit".
+inline int64_t BoundedIndex(xls_u128 value, int64_t limit) {
+  return value > static_cast<xls_u128>(limit) ? limit
+                                               : static_cast<int64_t>(value);
+}
+
+inline bool Parity64(uint64_t x) { return __builtin_parityll(x); }
+
+inline bool Parity128(xls_u128 x) {
+  return __builtin_parityll(static_cast<uint64_t>(x) ^
+                            static_cast<uint64_t>(x >> 64));
+})";
+
+bool IsCppKeyword(absl::string_view name) {
+  static constexpr absl::string_view kKeywords[] = {
+      "and", "auto", "bool", "break", "case", "char", "class", "const",
+      "continue", "default", "delete", "do", "double", "else", "enum",
+      "explicit", "extern", "false", "float", "for", "friend", "goto", "if",
+      "inline", "int", "long", "namespace", "new", "not", "operator", "or",
+      "private", "protected", "public", "register", "return", "short", "signed",
+      "sizeof", "static", "struct", "switch", "template", "this", "throw",
+      "true", "try", "typedef", "typename", "union", "unsigned", "using",
+      "virtual", "void", "volatile", "while", "xor"};
+  return absl::c_linear_search(kKeywords, name);
+}
+
+// Turns an IR name (which may contain, e.g., periods) into a valid C++
+// identifier.
+std::string SanitizeName(absl::string_view name) {
+  std::string result(name);
+  for (char& c : result) {
+    if (!absl::ascii_isalnum(c) && c != '_') {
+      c = '_';
+    }
+  }
+  if (result.empty() || absl::ascii_isdigit(result[0])) {
+    result = absl::StrCat("_", result);
+  }
+  if (IsCppKeyword(result)) {
+    absl::StrAppend(&result, "_");
+  }
+  return result;
+}
+
+// Names used by the emitted code itself, which IR names must not shadow.
+constexpr absl::string_view kReservedNames[] = {
+    "BoundedIndex", "MakeU128", "Parity64", "Parity128", "int64_t",
+    "uint8_t", "uint16_t", "uint32_t", "uint64_t", "xls_u128", "xls_s128",
+    "xls_i", "xls_index", "xls_trip", "std"};
+
+// Families of helpers instantiated by kHelperTemplate, with a "64" or "128"
+// suffix.
+constexpr absl::string_view kHelperNames[] = {
+    "Mask", "Signed", "Shll", "Shrl", "Shra", "UDiv", "UMod", "SDiv", "SMod",
+    "BitSliceUpdate", "Reverse", "Encode", "OneHotLsb", "OneHotMsb"};
+
+// Assigns distinct C++ identifiers to IR names. Sanitizing alone does not
+// suffice, since distinct IR names can sanitize to the same identifier (e.g.
+// a parameter "add_5" and a node "add.5"); later names are given a numeric
+// suffix on collision.
+class NameTable {
+ public:
+  NameTable() {
+    for (absl::string_view name : kReservedNames) {
+      used_.insert(std::string(name));
+    }
+    for (absl::string_view name : kHelperNames) {
+      used_.insert(absl::StrCat(name, "64"));
+      used_.insert(absl::StrCat(name, "128"));
+    }
+  }
+
+  // Returns a new identifier based on "name", which is sanitized first unless
+  // it is already a valid identifier.
+  std::string Add(absl::string_view name) {
+    std::string base = SanitizeName(name);
+    std::string result = base;
+    for (int64_t i = 1; !used_.insert(result).second; ++i) {
+      result = absl::StrCat(base, "_", i);
+    }
+    return result;
+  }
+
+  // Claims "name" as is; returns false if it is already taken.
+  bool Reserve(absl::string_view name) {
+    return used_.insert(std::string(name)).second;
+  }
+
+ private:
+  absl::flat_hash_set<std::string> used_;
+};
+
+// Returns the preferred name of the local holding the value of "node". The
+// node ID is appended to assigned names, which usually avoids the need for a
+// suffix from the NameTable.
+std::string PreferredNodeName(Node* node) {
+  if (node->Is<xls::Param>() || !node->HasAssignedName()) {
+    return node->GetName();
+  }
+  return absl::StrCat(node->GetName(), "_", node->id());
+}
+
+absl::StatusOr<std::string> CppType(xls::Type* type) {
+  if (type->IsBits()) {
+    int64_t bit_count = type->AsBitsOrDie()->bit_count();
+    if (bit_count <= 8) {
+      return "uint8_t";
+    } else if (bit_count <= 16) {
+      return "uint16_t";
+    } else if (bit_count <= 32) {
+      return "uint32_t";
+    } else if (bit_count <= 64) {
+      return "uint64_t";
+    } else if (bit_count <= kMaxBitCount) {
+      return "xls_u128";
+    }
+    return absl::UnimplementedError(
+        absl::StrFormat("Only bits types up to %db wide are currently "
+                        "supported: %s",
+                        kMaxBitCount, type->ToString()));
+  }
+  if (type->IsTuple()) {
+    std::vector<std::string> elements;
+    for (xls::Type* element_type : type->AsTupleOrDie()->element_types()) {
+      XLS_ASSIGN_OR_RETURN(std::string element, CppType(element_type));
+      elements.push_back(element);
+    }
+    return absl::StrCat("std::tuple<", absl::StrJoin(elements, ", "), ">");
+  }
+  if (type->IsArray()) {
+    xls::ArrayType* array_type = type->AsArrayOrDie();
+    XLS_ASSIGN_OR_RETURN(std::string element,
+                         CppType(array_type->element_type()));
+    return absl::StrFormat("std::array<%s, %d>", element, array_type->size());
+  }
+  if (type->IsToken()) {
+    return "std::tuple<>";
+  }
+  return absl::UnimplementedError(
+      absl::StrCat("Unsupported type for transpilation: ", type->ToString()));
+}
+
+// Suffix of the helper family used to compute on values of the given width.
+std::string Suffix(int64_t bit_count) { return bit_count <= 64 ? "64" : "128"; }
+
+// Type in which values of the given width are computed. Arithmetic is never
+// performed in the (possibly narrower) storage type, which avoids both integer
+// promotion to signed int and the overflow that could follow.
+std::string ComputeType(int64_t bit_count) {
+  return bit_count <= 64 ? "uint64_t" : "xls_u128";
+}
+
+absl::StatusOr<std::string> ValueToCpp(const Value& value, xls::Type* type) {
+  XLS_ASSIGN_OR_RETURN(std::string type_str, CppType(type));
+  if (value.IsToken()) {
+    return absl::StrCat(type_str, "{}");
+  }
+  if (value.IsBits()) {
+    const Bits& bits = value.bits();
+    if (bits.bit_count() <= 64) {
+      return absl::StrFormat("%dULL", bits.ToUint64().value());
+    }
+    return absl::StrFormat(
+        "MakeU128(%dULL, %dULL)",
+        bits.Slice(64, bits.bit_count() - 64).ToUint64().value(),
+        bits.Slice(0, 64).ToUint64().value());
+  }
+
+  std::vector<std::string> elements;
+  for (int64_t i = 0; i < value.size(); ++i) {
+    xls::Type* element_type = type->IsTuple()
+                             ? type->AsTupleOrDie()->element_type(i)
+                             : type->AsArrayOrDie()->element_type();
+    XLS_ASSIGN_OR_RETURN(std::string element,
+                         ValueToCpp(value.element(i), element_type));
+    elements.push_back(element);
+  }
+  if (value.IsTuple()) {
+    return absl::StrCat(type_str, "{", absl::StrJoin(elements, ", "), "}");
+  }
+  return absl::StrCat(type_str, "{{", absl::StrJoin(elements, ", "), "}}");
+}
+
+// Emits the C++ bodies of IR functions, one node at a time.
+class FunctionEmitter {
+ public:
+  // "global_names" holds the names of all of the emitted functions, which
+  // locals must not shadow.
+  FunctionEmitter(
+      const absl::flat_hash_map<xls::Function*, std::string>* function_names,
+      const NameTable* global_names)
+      : function_names_(function_names), global_names_(global_names) {}
+
+  absl::StatusOr<std::string> Emit(xls::Function* f) {
+    XLS_ASSIGN_OR_RETURN(std::string return_type,
+                         CppType(f->return_value()->GetType()));
+    // Parameters are named first, so that they keep their names if possible.
+    NameTable local_names = *global_names_;
+    node_names_.clear();
+    for (xls::Param* param : f->params()) {
+      node_names_[param] = local_names.Add(PreferredNodeName(param));
+    }
+    for (Node* node : f->nodes()) {
+      if (!node->Is<xls::Param>()) {
+        node_names_[node] = local_names.Add(PreferredNodeName(node));
+      }
+    }
+
+    std::vector<std::string> params;
+    for (xls::Param* param : f->params()) {
+      XLS_ASSIGN_OR_RETURN(std::string type, CppType(param->GetType()));
+      // Aggregates are passed by reference; bits by value.
+      params.push_back(absl::StrFormat(
+          param->GetType()->IsBits() ? "%s %s" : "const %s& %s", type,
+          NodeName(param)));
+    }
+
+    lines_.clear();
+    lines_.push_back(absl::StrFormat("%s %s(%s) {", return_type,
+                                     function_names_->at(f),
+                                     absl::StrJoin(params, ", ")));
+    for (Node* node : TopoSort(f)) {
+      XLS_RETURN_IF_ERROR(EmitNode(node));
+    }
+    lines_.push_back(absl::StrCat("  return ", NodeName(f->return_value()),
+                                  ";"));
+    lines_.push_back("}");
+    return absl::StrJoin(lines_, "\n");
+  }
+
+ private:
+  const std::string& NodeName(Node* node) const { return node_names_.at(node); }
+
+  // Returns the value of "node" widened to the computation type for the given
+  // width.
+  std::string Widened(Node* node, int64_t bit_count) const {
+    return absl::StrCat("static_cast<", ComputeType(bit_count), ">(",
+                        NodeName(node), ")");
+  }
+
+  // Returns the value of the bits-typed "node" sign-extended into the
+  // computation type for the given width.
+  std::string SignedWidened(Node* node, int64_t bit_count) const {
+    int64_t operand_width = node->BitCountOrDie();
+    return absl::StrCat("static_cast<", ComputeType(bit_count), ">(Signed",
+                        Suffix(operand_width), "(",
+                        Widened(node, operand_width), ", ", operand_width,
+                        "))");
+  }
+
+  // Emits "const <type> <node name> = <expr>;", narrowing the expression back
+  // to the storage type for bits-typed nodes.
+  absl::Status Define(Node* node, absl::string_view expr) {
+    XLS_ASSIGN_OR_RETURN(std::string type, CppType(node->GetType()));
+    if (node->GetType()->IsBits()) {
+      lines_.push_back(absl::StrFormat("  const %s %s = static_cast<%s>(%s);",
+                                       type, NodeName(node), type, expr));
+    } else {
+      lines_.push_back(
+          absl::StrFormat("  const %s %s = %s;", type, NodeName(node), expr));
+    }
+    return absl::OkStatus();
+  }
+
+  // Emits a mutable declaration of "node", to be assigned by the statements
+  // that follow.
+  absl::Status Declare(Node* node, absl::string_view init = "") {
+    XLS_ASSIGN_OR_RETURN(std::string type, CppType(node->GetType()));
+    if (init.empty()) {
+      lines_.push_back(absl::StrFormat("  %s %s;", type, NodeName(node)));
+    } else {
+      lines_.push_back(
+          absl::StrFormat("  %s %s = %s;", type, NodeName(node), init));
+    }
+    return absl::OkStatus();
+  }
+
+  std::string Join(absl::Span<Node* const> nodes, absl::string_view separator,
+                   int64_t bit_count) {
+    return absl::StrJoin(nodes, separator, [&](std::string* out, Node* n) {
+      absl::StrAppend(out, Widened(n, bit_count));
+    });
+  }
+
+  std::string Args(absl::Span<Node* const> nodes) {
+    return absl::StrJoin(nodes, ", ", [&](std::string* out, Node* n) {
+      absl::StrAppend(out, NodeName(n));
+    });
+  }
+
+  absl::Status EmitNode(Node* node) {
+    const std::string name = NodeName(node);
+    const int64_t width =
+        node->GetType()->IsBits() ? node->BitCountOrDie() : 0;
+    const std::string suffix = Suffix(width);
+    switch (node->op()) {
+      case Op::kParam:
+        return absl::OkStatus();
+      case Op::kLiteral: {
+        XLS_ASSIGN_OR_RETURN(
+            std::string literal,
+            ValueToCpp(node->As<Literal>()->value(), node->GetType()));
+        return Define(node, literal);
+      }
+      case Op::kIdentity:
+        return Define(node, NodeName(node->operand(0)));
+      case Op::kAfterAll:
+        return Define(node, "{}");
+
+      case Op::kAdd:
+        return Define(node, absl::StrFormat("Mask%s(%s + %s, %d)", suffix,
+                                            Widened(node->operand(0), width),
+                                            Widened(node->operand(1), width),
+                                            width));
+      case Op::kSub:
+        return Define(node, absl::StrFormat("Mask%s(%s - %s, %d)", suffix,
+                                            Widened(node->operand(0), width),
+                                            Widened(node->operand(1), width),
+                                            width));
+      case Op::kUMul:
+        return Define(node, absl::StrFormat("Mask%s(%s * %s, %d)", suffix,
+                                            Widened(node->operand(0), width),
+                                            Widened(node->operand(1), width),
+                                            width));
+      case Op::kSMul:
+        return Define(node,
+                      absl::StrFormat("Mask%s(%s * %s, %d)", suffix,
+                                      SignedWidened(node->operand(0), width),
+                                      SignedWidened(node->operand(1), width),
+                                      width));
+      case Op::kUDiv:
+      case Op::kSDiv:
+      case Op::kSMod:
+        return Define(
+            node, absl::StrFormat("%s%s(%s, %s, %d)",
+                                  node->op() == Op::kUDiv   ? "UDiv"
+                                  : node->op() == Op::kSDiv ? "SDiv"
+                                                            : "SMod",
+                                  suffix, Widened(node->operand(0), width),
+                                  Widened(node->operand(1), width), width));
+      case Op::kUMod:
+        return Define(node, absl::StrFormat("UMod%s(%s, %s)", suffix,
+                                            Widened(node->operand(0), width),
+                                            Widened(node->operand(1), width)));
+      case Op::kNeg:
+        return Define(node,
+                      absl::StrFormat("Mask%s(static_cast<%s>(0) - %s, %d)",
+                                      suffix, ComputeType(width),
+                                      Widened(node->operand(0), width), width));
+      case Op::kNot:
+        return Define(node, absl::StrFormat("Mask%s(~%s, %d)", suffix,
+                                            Widened(node->operand(0), width),
+                                            width));
+
+      case Op::kAnd:
+        return Define(node, Join(node->operands(), " & ", width));
+      case Op::kOr:
+        return Define(node, Join(node->operands(), " | ", width));
+      case Op::kXor:
+        return Define(node, Join(node->operands(), " ^ ", width));
+      case Op::kNand:
+        return Define(node,
+                      absl::StrFormat("Mask%s(~(%s), %d)", suffix,
+                                      Join(node->operands(), " & ", width),
+                                      width));
+      case Op::kNor:
+        return Define(node,
+                      absl::StrFormat("Mask%s(~(%s), %d)", suffix,
+                                      Join(node->operands(), " | ", width),
+                                      width));
+
+      case Op::kAndReduce: {
+        int64_t operand_width = node->operand(0)->BitCountOrDie();
+        return Define(node,
+                      absl::StrFormat("%s == Mask%s(~static_cast<%s>(0), %d)",
+                                      Widened(node->operand(0), operand_width),
+                                      Suffix(operand_width),
+                                      ComputeType(operand_width),
+                                      operand_width));
+      }
+      case Op::kOrReduce:
+        return Define(node,
+                      absl::StrCat(NodeName(node->operand(0)), " != 0"));
+      case Op::kXorReduce: {
+        int64_t operand_width = node->operand(0)->BitCountOrDie();
+        return Define(node, absl::StrFormat(
+                                "Parity%s(%s)", Suffix(operand_width),
+                                Widened(node->operand(0), operand_width)));
+      }
+
+      case Op::kEq:
+        return Define(node, absl::StrFormat("%s == %s",
+                                            NodeName(node->operand(0)),
+                                            NodeName(node->operand(1))));
+      case Op::kNe:
+        return Define(node, absl::StrFormat("%s != %s",
+                                            NodeName(node->operand(0)),
+                                            NodeName(node->operand(1))));
+      case Op::kULt:
+      case Op::kULe:
+      case Op::kUGt:
+      case Op::kUGe: {
+        int64_t operand_width = node->operand(0)->BitCountOrDie();
+        return Define(
+            node, absl::StrFormat("%s %s %s",
+                                  Widened(node->operand(0), operand_width),
+                                  ComparisonOperator(node->op()),
+                                  Widened(node->operand(1), operand_width)));
+      }
+      case Op::kSLt:
+      case Op::kSLe:
+      case Op::kSGt:
+      case Op::kSGe: {
+        int64_t operand_width = node->operand(0)->BitCountOrDie();
+        std::string operand_suffix = Suffix(operand_width);
+        return Define(
+            node, absl::StrFormat("Signed%s(%s, %d) %s Signed%s(%s, %d)",
+                                  operand_suffix,
+                                  Widened(node->operand(0), operand_width),
+                                  operand_width, ComparisonOperator(node->op()),
+                                  operand_suffix,
+                                  Widened(node->operand(1), operand_width),
+                                  operand_width));
+      }
+
+      case Op::kShll:
+      case Op::kShrl:
+      case Op::kShra:
+        return Define(
+            node, absl::StrFormat("%s%s(%s, BoundedIndex(%s, %d), %d)",
+                                  node->op() == Op::kShll   ? "Shll"
+                                  : node->op() == Op::kShrl ? "Shrl"
+                                                            : "Shra",
+                                  suffix, Widened(node->operand(0), width),
+                                  NodeName(node->operand(1)), width, width));
+
+      case Op::kZeroExt:
+        return Define(node, NodeName(node->operand(0)));
+      case Op::kSignExt:
+        return Define(
+            node, absl::StrFormat("Mask%s(%s, %d)", suffix,
+                                  SignedWidened(node->operand(0), width),
+                                  width));
+      case Op::kConcat: {
+        std::vector<std::string> pieces;
+        int64_t offset = width;
+        for (Node* operand : node->operands()) {
+          offset -= operand->BitCountOrDie();
+          if (operand->BitCountOrDie() == 0) {
+            continue;
+          }
+          pieces.push_back(
+              offset == 0 ? Widened(operand, width)
+                          : absl::StrFormat("(%s << %d)",
+                                            Widened(operand, width), offset));
+        }
+        return Define(node,
+                      pieces.empty() ? "0" : absl::StrJoin(pieces, " | "));
+      }
+      case Op::kBitSlice: {
+        BitSlice* slice = node->As<BitSlice>();
+        if (slice->width() == 0) {
+          return Define(node, "0");
+        }
+        int64_t operand_width = node->operand(0)->BitCountOrDie();
+        return Define(node,
+                      absl::StrFormat("Mask%s(%s >> %d, %d)",
+                                      Suffix(operand_width),
+                                      Widened(node->operand(0), operand_width),
+                                      slice->start(), slice->width()));
+      }
+      case Op::kDynamicBitSlice: {
+        DynamicBitSlice* slice = node->As<DynamicBitSlice>();
+        int64_t operand_width = slice->to_slice()->BitCountOrDie();
+        std::string operand_suffix = Suffix(operand_width);
+        return Define(
+            node, absl::StrFormat(
+                      "Mask%s(Shrl%s(%s, BoundedIndex(%s, %d), %d), %d)",
+                      operand_suffix, operand_suffix,
+                      Widened(slice->to_slice(), operand_width),
+                      NodeName(slice->start()), operand_width, operand_width,
+                      slice->width()));
+      }
+      case Op::kBitSliceUpdate: {
+        BitSliceUpdate* update = node->As<BitSliceUpdate>();
+        int64_t update_width = update->update_value()->BitCountOrDie();
+        int64_t compute_width = std::max(width, update_width);
+        return Define(
+            node, absl::StrFormat(
+                      "BitSliceUpdate%s(%s, BoundedIndex(%s, %d), %s, %d, %d)",
+                      Suffix(compute_width),
+                      Widened(update->to_update(), compute_width),
+                      NodeName(update->start()), width,
+                      Widened(update->update_value(), compute_width), width,
+                      update_width));
+      }
+      case Op::kReverse:
+        return Define(node, absl::StrFormat("Reverse%s(%s, %d)", suffix,
+                                            Widened(node->operand(0), width),
+                                            width));
+      case Op::kEncode: {
+        int64_t operand_width = node->operand(0)->BitCountOrDie();
+        return Define(node, absl::StrFormat(
+                                "Encode%s(%s, %d)", Suffix(operand_width),
+                                Widened(node->operand(0), operand_width),
+                                operand_width));
+      }
+      case Op::kDecode:
+        return Define(node, absl::StrFormat(
+                                "Shll%s(1, BoundedIndex(%s, %d), %d)", suffix,
+                                NodeName(node->operand(0)), width, width));
+      case Op::kOneHot:
+        return Define(
+            node, absl::StrFormat(
+                      "OneHot%s%s(%s, %d)",
+                      node->As<OneHot>()->priority() == LsbOrMsb::kLsb ? "Lsb"
+                                                                       : "Msb",
+                      suffix, Widened(node->operand(0), width),
+                      node->operand(0)->BitCountOrDie()));
+
+      case Op::kSel:
+        return EmitSelect(node->As<Select>());
+      case Op::kOneHotSel: {
+        OneHotSelect* sel = node->As<OneHotSelect>();
+        if (!node->GetType()->IsBits()) {
+          return absl::UnimplementedError(absl::StrCat(
+              "Only bits-typed one-hot selects are currently supported: ",
+              node->ToString()));
+        }
+        int64_t selector_width = sel->selector()->BitCountOrDie();
+        std::vector<std::string> pieces;
+        for (int64_t i = 0; i < sel->cases().size(); ++i) {
+          pieces.push_back(absl::StrFormat(
+              "(((%s >> %d) & 1) ? %s : static_cast<%s>(0))",
+              Widened(sel->selector(), selector_width), i,
+              Widened(sel->get_case(i), width), ComputeType(width)));
+        }
+        return Define(node,
+                      pieces.empty() ? "0" : absl::StrJoin(pieces, " | "));
+      }
+      case Op::kGate: {
+        Gate* gate = node->As<Gate>();
+        XLS_ASSIGN_OR_RETURN(std::string type, CppType(node->GetType()));
+        // A set condition gates the data to zero.
+        return Define(node, absl::StrFormat("%s ? %s{} : %s",
+                                            NodeName(gate->condition()), type,
+                                            NodeName(gate->data())));
+      }
+
+      case Op::kTuple:
+        return Define(node, absl::StrCat("{", Args(node->operands()), "}"));
+      case Op::kTupleIndex:
+        return Define(node,
+                      absl::StrFormat("std::get<%d>(%s)",
+                                      node->As<TupleIndex>()->index(),
+                                      NodeName(node->operand(0))));
+      case Op::kArray:
+        return Define(node, absl::StrCat("{{", Args(node->operands()), "}}"));
+      case Op::kArrayIndex: {
+        ArrayIndex* index = node->As<ArrayIndex>();
+        std::string expr = NodeName(index->array());
+        xls::Type* type = index->array()->GetType();
+        // Out-of-bounds indices are clamped to the last element.
+        for (Node* index_operand : index->indices()) {
+          xls::ArrayType* array_type = type->AsArrayOrDie();
+          absl::StrAppendFormat(&expr, "[BoundedIndex(%s, %d)]",
+                                NodeName(index_operand),
+                                array_type->size() - 1);
+          type = array_type->element_type();
+        }
+        return Define(node, expr);
+      }
+      case Op::kArrayUpdate:
+        return EmitArrayUpdate(node->As<ArrayUpdate>());
+      case Op::kArraySlice: {
+        ArraySlice* slice = node->As<ArraySlice>();
+        int64_t last = slice->array()->GetType()->AsArrayOrDie()->size() - 1;
+        XLS_RETURN_IF_ERROR(Declare(node));
+        lines_.push_back(
+            absl::StrFormat("  for (int64_t xls_i = 0; xls_i < %d; ++xls_i) {",
+                            slice->width()));
+        lines_.push_back(absl::StrFormat(
+            "    %s[xls_i] = %s[std::min<int64_t>(BoundedIndex(%s, %d) + "
+            "xls_i, %d)];",
+            name, NodeName(slice->array()), NodeName(slice->start()), last,
+            last));
+        lines_.push_back("  }");
+        return absl::OkStatus();
+      }
+      case Op::kArrayConcat: {
+        XLS_RETURN_IF_ERROR(Declare(node));
+        int64_t offset = 0;
+        for (Node* operand : node->operands()) {
+          lines_.push_back(absl::StrFormat(
+              "  std::copy(%s.begin(), %s.end(), %s.begin() + %d);",
+              NodeName(operand), NodeName(operand), name, offset));
+          offset += operand->GetType()->AsArrayOrDie()->size();
+        }
+        return absl::OkStatus();
+      }
+
+      case Op::kInvoke:
+        return Define(
+            node, absl::StrFormat(
+                      "%s(%s)",
+                      function_names_->at(node->As<Invoke>()->to_apply()),
+                      Args(node->operands())));
+      case Op::kMap: {
+        Map* map = node->As<Map>();
+        XLS_RETURN_IF_ERROR(Declare(node));
+        lines_.push_back(absl::StrFormat(
+            "  for (int64_t xls_i = 0; xls_i < %d; ++xls_i) {",
+            node->GetType()->AsArrayOrDie()->size()));
+        lines_.push_back(absl::StrFormat(
+            "    %s[xls_i] = %s(%s[xls_i]);", name,
+            function_names_->at(map->to_apply()), NodeName(map->operand(0))));
+        lines_.push_back("  }");
+        return absl::OkStatus();
+      }
+      case Op::kCountedFor:
+        return EmitCountedFor(node->As<CountedFor>());
+
+      default:
+        return absl::UnimplementedError(
+            absl::StrCat("Unsupported operation for C++ transpilation: ",
+                         node->ToString()));
+    }
+  }
+
+  static absl::string_view ComparisonOperator(Op op) {
+    switch (op) {
+      case Op::kULt:
+      case Op::kSLt:
+        return "<";
+      case Op::kULe:
+      case Op::kSLe:
+        return "<=";
+      case Op::kUGt:
+      case Op::kSGt:
+        return ">";
+      default:
+        return ">=";
+    }
+  }
+
+  absl::Status EmitSelect(Select* sel) {
+    const std::string name = NodeName(sel);
+    if (sel->selector()->BitCountOrDie() == 1 && sel->cases().size() == 2) {
+      return Define(sel, absl::StrFormat("%s ? %s : %s",
+                                         NodeName(sel->selector()),
+                                         NodeName(sel->get_case(1)),
+                                         NodeName(sel->get_case(0))));
+    }
+
+    // Without a default value the cases cover every selector value, so the
+    // last case doubles as the default label.
+    int64_t case_count = sel->cases().size();
+    int64_t labeled_count =
+        sel->default_value().has_value() ? case_count : case_count - 1;
+    Node* default_value = sel->default_value().has_value()
+                              ? *sel->default_value()
+                              : sel->get_case(case_count - 1);
+    XLS_RETURN_IF_ERROR(Declare(sel));
+    lines_.push_back(absl::StrFormat("  switch (BoundedIndex(%s, %d)) {",
+                                     NodeName(sel->selector()), case_count));
+    for (int64_t i = 0; i < labeled_count; ++i) {
+      lines_.push_back(absl::StrFormat("    case %d:", i));
+      lines_.push_back(
+          absl::StrFormat("      %s = %s;", name, NodeName(sel->get_case(i))));
+      lines_.push_back("      break;");
+    }
+    lines_.push_back("    default:");
+    lines_.push_back(
+        absl::StrFormat("      %s = %s;", name, NodeName(default_value)));
+    lines_.push_back("      break;");
+    lines_.push_back("  }");
+    return absl::OkStatus();
+  }
+
+  absl::Status EmitArrayUpdate(ArrayUpdate* update) {
+    const std::string name = NodeName(update);
+    if (update->indices().empty()) {
+      return Define(update, NodeName(update->update_value()));
+    }
+
+    // Out-of-bounds updates leave the array unchanged.
+    std::vector<std::string> in_bounds;
+    std::string element = name;
+    xls::Type* type = update->GetType();
+    for (Node* index : update->indices()) {
+      xls::ArrayType* array_type = type->AsArrayOrDie();
+      in_bounds.push_back(absl::StrFormat("BoundedIndex(%s, %d) < %d",
+                                          NodeName(index), array_type->size(),
+                                          array_type->size()));
+      absl::StrAppend(&element, "[", NodeName(index), "]");
+      type = array_type->element_type();
+    }
+    XLS_RETURN_IF_ERROR(Declare(update, NodeName(update->array_to_update())));
+    lines_.push_back(
+        absl::StrFormat("  if (%s) {", absl::StrJoin(in_bounds, " && ")));
+    lines_.push_back(absl::StrFormat("    %s = %s;", element,
+                                     NodeName(update->update_value())));
+    lines_.push_back("  }");
+    return absl::OkStatus();
+  }
+
+  absl::Status EmitCountedFor(CountedFor* loop) {
+    const std::string name = NodeName(loop);
+    xls::Param* index_param = loop->body()->param(0);
+    int64_t index_width = index_param->BitCountOrDie();
+    XLS_ASSIGN_OR_RETURN(std::string index_type,
+                         CppType(index_param->GetType()));
+
+    std::vector<std::string> args = {
+        absl::StrFormat("static_cast<%s>(Mask%s(static_cast<%s>(xls_index), "
+                        "%d))",
+                        index_type, Suffix(index_width),
+                        ComputeType(index_width), index_width),
+        name};
+    for (Node* invariant : loop->invariant_args()) {
+      args.push_back(NodeName(invariant));
+    }
+
+    XLS_RETURN_IF_ERROR(Declare(loop, NodeName(loop->initial_value())));
+    lines_.push_back(absl::StrFormat(
+        "  for (int64_t xls_trip = 0, xls_index = 0; xls_trip < %d; "
+        "++xls_trip, xls_index += %d) {",
+        loop->trip_count(), loop->stride()));
+    lines_.push_back(absl::StrFormat("    %s = %s(%s);", name,
+                                     function_names_->at(loop->body()),
+                                     absl::StrJoin(args, ", ")));
+    lines_.push_back("  }");
+    return absl::OkStatus();
+  }
+
+  const absl::flat_hash_map<xls::Function*, std::string>* function_names_;
+  const NameTable* global_names_;
+  absl::flat_hash_map<Node*, std::string> node_names_;
+  std::vector<std::string> lines_;
+};
+
+// Appends "f" and every function it (transitively) calls to "functions",
+// callees first.
+void CollectFunctions(xls::Function* f,
+                      absl::flat_hash_set<xls::Function*>* seen,
+                      std::vector<xls::Function*>* functions) {
+  if (!seen->insert(f).second) {
+    return;
+  }
+  for (Node* node : f->nodes()) {
+    if (node->Is<Invoke>()) {
+      CollectFunctions(node->As<Invoke>()->to_apply(), seen, functions);
+    } else if (node->Is<Map>()) {
+      CollectFunctions(node->As<Map>()->to_apply(), seen, functions);
+    } else if (node->Is<CountedFor>()) {
+      CollectFunctions(node->As<CountedFor>()->body(), seen, functions);
+    }
+  }
+  functions->push_back(f);
+}
+
+std::string HeaderGuard(absl::string_view output_header_path) {
+  std::string header_guard;
+  std::filesystem::path current_path = output_header_path;
+  while (!current_path.empty()) {
+    std::string chunk =
+        absl::AsciiStrToUpper(std::string(current_path.filename()));
+    chunk = absl::StrReplaceAll(chunk, {{".", "_"}, {"-", "_"}});
+    header_guard = chunk + "_" + header_guard;
+    current_path = current_path.parent_path();
+  }
+  return header_guard;
+}
+
+}  // namespace
+
+absl::StatusOr<Sources> TranspileFunctionToCpp(
+    xls::Function* function, absl::string_view function_name,
+    absl::string_view output_header_path, std::string namespaces) {
+  // $0: Header guard.
+  // $1: Entry function declaration.
+  // $2: Namespace opening.
+  // $3: Namespace closing.
+  constexpr absl::string_view kHeaderTemplate =
+      R"(// AUTOMATICALLY GENERATED FILE. DO NOT EDIT!
+#ifndef $0
+#define $0
+#include <array>
+#include <cstdint>
+#include <tuple>
+
+__extension__ typedef unsigned __int128 xls_u128;
+__extension__ typedef __int128 xls_s128;
+
+$2$1$3
+
+#endif  // $0
+)";
+
+  // $0: Header path.
+  // $1: Helpers.
+  // $2: Internal (callee) functions.
+  // $3: Namespace opening.
+  // $4: Entry function.
+  // $5: Namespace closing.
+  constexpr absl::string_view kSourceTemplate =
+      R"(// AUTOMATICALLY GENERATED FILE. DO NOT EDIT!
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <tuple>
+
+#include "$0"
+
+namespace {
+
+$1$2
+
+}  // namespace
+
+$3$4$5
+)";
+
+  XLS_RET_CHECK(!function_name.empty());
+  absl::flat_hash_set<xls::Function*> seen;
+  std::vector<xls::Function*> functions;
+  CollectFunctions(function, &seen, &functions);
+
+  NameTable global_names;
+  XLS_RET_CHECK(global_names.Reserve(function_name))
+      << "Entry function name is reserved: " << function_name;
+  absl::flat_hash_map<xls::Function*, std::string> function_names;
+  function_names[function] = std::string(function_name);
+  for (xls::Function* f : functions) {
+    if (f != function) {
+      function_names[f] = global_names.Add(f->name());
+    }
+  }
+
+  FunctionEmitter emitter(&function_names, &global_names);
+  std::vector<std::string> callees;
+  for (xls::Function* f : functions) {
+    if (f == function) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(std::string text, emitter.Emit(f));
+    callees.push_back(text);
+  }
+  XLS_ASSIGN_OR_RETURN(std::string entry, emitter.Emit(function));
+  // The declaration is simply the signature line of the definition.
+  std::string declaration =
+      absl::StrCat(entry.substr(0, entry.find(" {\n")), ";");
+
+  std::string helpers = absl::StrCat(
+      kCommonHelpers, "\n\n",
+      absl::Substitute(kHelperTemplate, "64", "uint64_t", "int64_t", 64),
+      "\n\n",
+      absl::Substitute(kHelperTemplate, "128", "xls_u128", "xls_s128", 128));
+  std::string callee_block;
+  if (!callees.empty()) {
+    callee_block = absl::StrCat("\n\n", absl::StrJoin(callees, "\n\n"));
+  }
+
+  std::string namespace_begin;
+  std::string namespace_end;
+  if (!namespaces.empty()) {
+    namespace_begin = absl::StrCat("namespace ", namespaces, " {\n\n");
+    namespace_end = absl::StrCat("\n\n}  // namespace ", namespaces);
+  }
+
+  return Sources{
+      absl::Substitute(kHeaderTemplate, HeaderGuard(output_header_path),
+                       declaration, namespace_begin, namespace_end),
+      absl::Substitute(kSourceTemplate, output_header_path, helpers,
+                       callee_block, namespace_begin, entry, namespace_end)};
+}
+
+}  // namespace xls::dslx
@@ -0,0 +1,49 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef XLS_DSLX_CPP_FUNCTION_TRANSPILER_H_
+#define XLS_DSLX_CPP_FUNCTION_TRANSPILER_H_
+
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "xls/dslx/cpp_transpiler.h"
+#include "xls/ir/function.h"
+
+namespace xls::dslx {
+
+// Converts the body of the given (IR-converted) function, along with every
+// function it invokes, into standalone C++ suitable for compilation with the
+// host compiler as a bit-accurate software model. The emitted code has no
+// dependency on XLS or LLVM at runtime.
+//
+// Bits values are carried in the smallest containing native unsigned integer
+// type (uint8_t, ..., uint64_t, or an unsigned __int128 for widths up to 128)
+// and are kept zero-extended at all times; tuples map to std::tuple and arrays
+// to std::array. Signed operations sign-extend their operands explicitly, so
+// results match the IR interpreter bit-for-bit, including its out-of-bounds
+// and division-by-zero semantics.
+//
+// The entry point is declared in the header as "function_name"; callees are
+// emitted with internal linkage in the source.
+//
+// Returns an UnimplementedError for bits types wider than 128 bits and for
+// side-effecting operations (asserts, channel operations, etc.).
+absl::StatusOr<Sources> TranspileFunctionToCpp(
+    xls::Function* function, absl::string_view function_name,
+    absl::string_view output_header_path, std::string namespaces = "");
+
+}  // namespace xls::dslx
+
+#endif  // XLS_DSLX_CPP_FUNCTION_TRANSPILER_H_
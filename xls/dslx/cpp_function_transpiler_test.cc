@@ -0,0 +1,430 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "xls/dslx/cpp_function_transpiler.h"
+
+#include <cstdlib>
+#include <random>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/subprocess.h"
+#include "xls/interpreter/function_interpreter.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/value.h"
+
+namespace xls::dslx {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+TEST(CppFunctionTranspilerTest, SimpleFunction) {
+  const std::string kProgram = R"(
+package p
+
+fn add_one(x: bits[8]) -> bits[8] {
+  literal.1: bits[8] = literal(value=1)
+  ret add.2: bits[8] = add(x, literal.1)
+}
+)";
+
+  const std::string kExpectedHeader =
+      R"(// AUTOMATICALLY GENERATED FILE. DO NOT EDIT!
+#ifndef FAKE_PATH_H_
+#define FAKE_PATH_H_
+#include <array>
+#include <cstdint>
+#include <tuple>
+
+__extension__ typedef unsigned __int128 xls_u128;
+__extension__ typedef __int128 xls_s128;
+
+uint8_t add_one(uint8_t x);
+
+#endif  // FAKE_PATH_H_
+)";
+
+  const std::string kExpectedFunction = R"(uint8_t add_one(uint8_t x) {
+  const uint8_t literal_1 = static_cast<uint8_t>(1ULL);
+  const uint8_t add_2 = static_cast<uint8_t>(Mask64(static_cast<uint64_t>(x) + static_cast<uint64_t>(literal_1), 8));
+  return add_2;
+})";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kProgram));
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * f, package->GetFunction("add_one"));
+  XLS_ASSERT_OK_AND_ASSIGN(Sources result,
+                           TranspileFunctionToCpp(f, "add_one", "fake_path.h"));
+  EXPECT_EQ(result.header, kExpectedHeader);
+  EXPECT_THAT(result.body, HasSubstr(kExpectedFunction));
+}
+
+// Verifies that callees are emitted (with internal linkage) ahead of the entry
+// function, which is emitted under the requested name and namespace.
+TEST(CppFunctionTranspilerTest, InvokedFunctionsAreEmitted) {
+  const std::string kProgram = R"(
+package p
+
+fn __p__double(x: bits[16]) -> bits[16] {
+  ret add.1: bits[16] = add(x, x)
+}
+
+fn __p__main(y: bits[16]) -> bits[16] {
+  ret invoke.3: bits[16] = invoke(y, to_apply=__p__double)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kProgram));
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * f,
+                           package->GetFunction("__p__main"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Sources result,
+      TranspileFunctionToCpp(f, "main_fn", "fake_path.h", "my::ns"));
+  EXPECT_THAT(result.header, HasSubstr(R"(namespace my::ns {
+
+uint16_t main_fn(uint16_t y);
+
+}  // namespace my::ns)"));
+
+  size_t callee_pos = result.body.find("uint16_t __p__double(uint16_t x) {");
+  size_t entry_pos = result.body.find("uint16_t main_fn(uint16_t y) {");
+  ASSERT_NE(callee_pos, std::string::npos);
+  ASSERT_NE(entry_pos, std::string::npos);
+  EXPECT_LT(callee_pos, result.body.find("}  // namespace\n"));
+  EXPECT_LT(result.body.find("}  // namespace\n"), entry_pos);
+  EXPECT_THAT(result.body,
+              HasSubstr("const uint16_t invoke_3 = "
+                        "static_cast<uint16_t>(__p__double(y));"));
+}
+
+TEST(CppFunctionTranspilerTest, SignedOperationsSignExtend) {
+  const std::string kProgram = R"(
+package p
+
+fn f(x: bits[7], y: bits[7]) -> (bits[1], bits[7]) {
+  slt.1: bits[1] = slt(x, y)
+  sdiv.2: bits[7] = sdiv(x, y)
+  ret tuple.3: (bits[1], bits[7]) = tuple(slt.1, sdiv.2)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kProgram));
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * f, package->GetFunction("f"));
+  XLS_ASSERT_OK_AND_ASSIGN(Sources result,
+                           TranspileFunctionToCpp(f, "f", "fake_path.h"));
+  EXPECT_THAT(result.header, HasSubstr("std::tuple<uint8_t, uint8_t> "
+                                       "f(uint8_t x, uint8_t y);"));
+  EXPECT_THAT(result.body, HasSubstr("static_cast<uint8_t>(Signed64("
+                                     "static_cast<uint64_t>(x), 7) < "
+                                     "Signed64(static_cast<uint64_t>(y), 7))"));
+  EXPECT_THAT(result.body, HasSubstr("static_cast<uint8_t>(SDiv64("
+                                     "static_cast<uint64_t>(x), "
+                                     "static_cast<uint64_t>(y), 7))"));
+  EXPECT_THAT(result.body,
+              HasSubstr("const std::tuple<uint8_t, uint8_t> tuple_3 = "
+                        "{slt_1, sdiv_2};"));
+}
+
+TEST(CppFunctionTranspilerTest, SelectWithDefault) {
+  const std::string kProgram = R"(
+package p
+
+fn f(s: bits[2], a: bits[32], b: bits[32], c: bits[32]) -> bits[32] {
+  ret sel.1: bits[32] = sel(s, cases=[a, b], default=c)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kProgram));
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * f, package->GetFunction("f"));
+  XLS_ASSERT_OK_AND_ASSIGN(Sources result,
+                           TranspileFunctionToCpp(f, "f", "fake_path.h"));
+  EXPECT_THAT(result.body, HasSubstr(R"(  uint32_t sel_1;
+  switch (BoundedIndex(s, 2)) {
+    case 0:
+      sel_1 = a;
+      break;
+    case 1:
+      sel_1 = b;
+      break;
+    default:
+      sel_1 = c;
+      break;
+  }
+  return sel_1;)"));
+}
+
+TEST(CppFunctionTranspilerTest, WideBits) {
+  const std::string kProgram = R"(
+package p
+
+fn narrow_enough(x: bits[100]) -> bits[100] {
+  ret neg.1: bits[100] = neg(x)
+}
+
+fn too_wide(x: bits[129]) -> bits[129] {
+  ret neg.2: bits[129] = neg(x)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kProgram));
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * narrow_enough,
+                           package->GetFunction("narrow_enough"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Sources result,
+      TranspileFunctionToCpp(narrow_enough, "narrow_enough", "fake_path.h"));
+  EXPECT_THAT(result.header,
+              HasSubstr("xls_u128 narrow_enough(xls_u128 x);"));
+  EXPECT_THAT(result.body,
+              HasSubstr("Mask128(static_cast<xls_u128>(0) - "
+                        "static_cast<xls_u128>(x), 100)"));
+
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * too_wide,
+                           package->GetFunction("too_wide"));
+  EXPECT_THAT(TranspileFunctionToCpp(too_wide, "too_wide", "fake_path.h"),
+              StatusIs(absl::StatusCode::kUnimplemented,
+                       HasSubstr("Only bits types up to 128b wide")));
+}
+
+TEST(CppFunctionTranspilerTest, SanitizedNamesAreUnique) {
+  // The parameter "add_5" and the node "add.5" sanitize to the same
+  // identifier, and the parameter "std" would shadow the std namespace.
+  const std::string kProgram = R"(
+package p
+
+fn f(add_5: bits[8], x: bits[8], std: bits[8]) -> bits[8] {
+  add.5: bits[8] = add(x, add_5)
+  ret add.6: bits[8] = add(add.5, std)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kProgram));
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * f, package->GetFunction("f"));
+  XLS_ASSERT_OK_AND_ASSIGN(Sources result,
+                           TranspileFunctionToCpp(f, "f", "fake_path.h"));
+  EXPECT_THAT(result.header,
+              HasSubstr("uint8_t f(uint8_t add_5, uint8_t x, uint8_t std_1);"));
+  EXPECT_THAT(result.body,
+              HasSubstr("const uint8_t add_5_1 = static_cast<uint8_t>(Mask64("
+                        "static_cast<uint64_t>(x) + "
+                        "static_cast<uint64_t>(add_5), 8));"));
+  EXPECT_THAT(result.body,
+              HasSubstr("static_cast<uint64_t>(add_5_1) + "
+                        "static_cast<uint64_t>(std_1), 8));"));
+}
+
+// Returns "value" in the format printed by the driver of the execution test:
+// bits as "<high 64 bits>:<low 64 bits>", tuples in parentheses and arrays in
+// brackets.
+std::string FormatValue(const Value& value) {
+  if (value.IsBits()) {
+    const Bits& bits = value.bits();
+    int64_t low_width = std::min<int64_t>(bits.bit_count(), 64);
+    uint64_t low = bits.Slice(0, low_width).ToUint64().value();
+    uint64_t high =
+        bits.bit_count() > 64
+            ? bits.Slice(64, bits.bit_count() - 64).ToUint64().value()
+            : 0;
+    return absl::StrCat(high, ":", low);
+  }
+  std::vector<std::string> elements;
+  for (const Value& element : value.elements()) {
+    elements.push_back(FormatValue(element));
+  }
+  if (value.IsTuple()) {
+    return absl::StrCat("(", absl::StrJoin(elements, ", "), ")");
+  }
+  return absl::StrCat("[", absl::StrJoin(elements, ", "), "]");
+}
+
+// Returns "bits" as a C++ expression of type xls_u128.
+std::string BitsToCpp(const Bits& bits) {
+  Value value(bits);
+  std::vector<std::string> halves = absl::StrSplit(FormatValue(value), ':');
+  return absl::StrFormat("((static_cast<xls_u128>(%sULL) << 64) | %sULL)",
+                         halves[0], halves[1]);
+}
+
+// Compiles the transpiled function with the host compiler (or $CXX) and checks
+// that it computes the same results as the IR interpreter, including for the
+// corner cases of division by zero, overlong shifts and out-of-bounds indices.
+TEST(CppFunctionTranspilerTest, CompiledCodeMatchesInterpreter) {
+  const std::string kProgram = R"(
+package p
+
+fn body(i: bits[4], accum: bits[16], k: bits[16]) -> bits[16] {
+  zero_ext.1: bits[16] = zero_ext(i, new_bit_count=16)
+  umul.2: bits[16] = umul(accum, k)
+  ret add.3: bits[16] = add(umul.2, zero_ext.1)
+}
+
+fn clz(x: bits[8]) -> bits[8] {
+  reverse.44: bits[8] = reverse(x)
+  one_hot.45: bits[9] = one_hot(reverse.44, lsb_prio=true)
+  encode.46: bits[4] = encode(one_hot.45)
+  ret zero_ext.47: bits[8] = zero_ext(encode.46, new_bit_count=8)
+}
+
+fn main(x: bits[8], add_5: bits[8], std: bits[7], xls_index: bits[16], w: bits[100], s: bits[2]) -> (bits[8], bits[8], bits[8], bits[7], bits[8], bits[8], bits[7], bits[7], bits[8], bits[7], bits[16], bits[16], bits[23], bits[5], bits[16], bits[100], bits[1], bits[1], bits[1], bits[1], bits[100], bits[100], bits[100], bits[8], bits[8], bits[8], bits[8][3], bits[8][3], bits[16], bits[8], bits[16], bits[9]) {
+  add.5: bits[8] = add(x, add_5)
+  sub.8: bits[8] = sub(x, add_5)
+  umul.9: bits[8] = umul(x, add_5)
+  smul.10: bits[7] = smul(std, std)
+  udiv.11: bits[8] = udiv(x, add_5)
+  umod.12: bits[8] = umod(x, add_5)
+  bit_slice.13: bits[7] = bit_slice(x, start=1, width=7)
+  sdiv.14: bits[7] = sdiv(std, bit_slice.13)
+  smod.15: bits[7] = smod(std, bit_slice.13)
+  shll.16: bits[8] = shll(x, add_5)
+  shra.17: bits[7] = shra(std, add_5)
+  shrl.18: bits[16] = shrl(xls_index, x)
+  sign_ext.19: bits[16] = sign_ext(std, new_bit_count=16)
+  concat.20: bits[23] = concat(std, xls_index)
+  dynamic_bit_slice.21: bits[5] = dynamic_bit_slice(xls_index, x, width=5)
+  bit_slice_update.22: bits[16] = bit_slice_update(xls_index, add_5, x)
+  neg.23: bits[100] = neg(w)
+  slt.24: bits[1] = slt(std, bit_slice.13)
+  ult.25: bits[1] = ult(x, add_5)
+  xor_reduce.26: bits[1] = xor_reduce(w)
+  and_reduce.27: bits[1] = and_reduce(x)
+  literal.28: bits[100] = literal(value=0xabcdef0123456789abcdef012)
+  add.29: bits[100] = add(w, literal.28)
+  sign_ext.30: bits[100] = sign_ext(xls_index, new_bit_count=100)
+  umul.31: bits[100] = umul(w, sign_ext.30)
+  shrl.32: bits[100] = shrl(w, x)
+  sel.33: bits[8] = sel(s, cases=[x, add_5], default=add.5)
+  one_hot_sel.34: bits[8] = one_hot_sel(s, cases=[x, add_5])
+  array.35: bits[8][3] = array(x, add_5, add.5)
+  array_index.36: bits[8] = array_index(array.35, indices=[s])
+  array_update.37: bits[8][3] = array_update(array.35, sub.8, indices=[s])
+  map.38: bits[8][3] = map(array_update.37, to_apply=clz)
+  counted_for.39: bits[16] = counted_for(xls_index, trip_count=5, stride=3, body=body, invariant_args=[sign_ext.19])
+  invoke.40: bits[8] = invoke(add_5, to_apply=clz)
+  decode.41: bits[16] = decode(dynamic_bit_slice.21, width=16)
+  concat.42: bits[9] = concat(s, bit_slice.13)
+  ret tuple.43: (bits[8], bits[8], bits[8], bits[7], bits[8], bits[8], bits[7], bits[7], bits[8], bits[7], bits[16], bits[16], bits[23], bits[5], bits[16], bits[100], bits[1], bits[1], bits[1], bits[1], bits[100], bits[100], bits[100], bits[8], bits[8], bits[8], bits[8][3], bits[8][3], bits[16], bits[8], bits[16], bits[9]) = tuple(add.5, sub.8, umul.9, smul.10, udiv.11, umod.12, sdiv.14, smod.15, shll.16, shra.17, shrl.18, sign_ext.19, concat.20, dynamic_bit_slice.21, bit_slice_update.22, neg.23, slt.24, ult.25, xor_reduce.26, and_reduce.27, add.29, umul.31, shrl.32, sel.33, one_hot_sel.34, array_index.36, array_update.37, map.38, counted_for.39, invoke.40, decode.41, concat.42)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kProgram));
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * f, package->GetFunction("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(Sources sources,
+                           TranspileFunctionToCpp(f, "main_fn", "main_fn.h"));
+
+  // Arguments are all zeros, all ones, and then random.
+  std::mt19937_64 rng(42);
+  std::vector<std::vector<Value>> arg_sets;
+  for (int64_t i = 0; i < 64; ++i) {
+    std::vector<Value> args;
+    for (xls::Param* param : f->params()) {
+      int64_t bit_count = param->BitCountOrDie();
+      Bits bits;
+      if (i == 0) {
+        bits = Bits(bit_count);
+      } else if (i == 1) {
+        bits = Bits::AllOnes(bit_count);
+      } else if (bit_count > 64) {
+        bits = bits_ops::Concat(
+            {UBits(rng() >> (128 - bit_count), bit_count - 64),
+             UBits(rng(), 64)});
+      } else {
+        bits = UBits(rng() >> (64 - bit_count), bit_count);
+      }
+      args.push_back(Value(bits));
+    }
+    arg_sets.push_back(args);
+  }
+
+  std::string driver = R"cc(#include <iostream>
+#include <tuple>
+
+#include "main_fn.h"
+
+template <typename T, size_t N>
+void Print(const std::array<T, N>& array);
+template <typename... Ts>
+void Print(const std::tuple<Ts...>& tuple);
+
+void Print(xls_u128 x) {
+  std::cout << static_cast<uint64_t>(x >> 64) << ":"
+            << static_cast<uint64_t>(x);
+}
+
+template <typename T, size_t N>
+void Print(const std::array<T, N>& array) {
+  std::cout << "[";
+  for (size_t i = 0; i < N; ++i) {
+    std::cout << (i == 0 ? "" : ", ");
+    Print(array[i]);
+  }
+  std::cout << "]";
+}
+
+template <typename... Ts>
+void Print(const std::tuple<Ts...>& tuple) {
+  std::cout << "(";
+  std::apply([](const auto&... elements) {
+    int i = 0;
+    ((std::cout << (i++ == 0 ? "" : ", "), Print(elements)), ...);
+  }, tuple);
+  std::cout << ")";
+}
+
+int main() {
+)cc";
+  std::vector<std::string> expected;
+  for (const std::vector<Value>& args : arg_sets) {
+    XLS_ASSERT_OK_AND_ASSIGN(Value result, InterpretFunction(f, args));
+    expected.push_back(FormatValue(result));
+    std::vector<std::string> cpp_args;
+    for (const Value& arg : args) {
+      cpp_args.push_back(BitsToCpp(arg.bits()));
+    }
+    absl::StrAppend(&driver, "  Print(main_fn(", absl::StrJoin(cpp_args, ", "),
+                    "));\n  std::cout << \"\\n\";\n");
+  }
+  absl::StrAppend(&driver, "  return 0;\n}\n");
+
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK(SetFileContents(temp_dir.path() / "main_fn.h", sources.header));
+  XLS_ASSERT_OK(SetFileContents(temp_dir.path() / "main_fn.cc", sources.body));
+  XLS_ASSERT_OK(SetFileContents(temp_dir.path() / "driver.cc", driver));
+  const char* compiler = std::getenv("CXX");
+  XLS_ASSERT_OK(InvokeSubprocess({"/usr/bin/env",
+                                  compiler == nullptr ? "c++" : compiler,
+                                  "-std=c++17", "-Wall", "-Werror", "-o",
+                                  "driver", "main_fn.cc", "driver.cc"},
+                                 temp_dir.path())
+                    .status());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto output,
+      InvokeSubprocess({(temp_dir.path() / "driver").string()}));
+  EXPECT_EQ(output.first, absl::StrCat(absl::StrJoin(expected, "\n"), "\n"));
+}
+
+}  // namespace
+}  // namespace xls::dslx
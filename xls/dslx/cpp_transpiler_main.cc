@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include <filesystem>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "absl/flags/flag.h"
@@ -20,9 +22,14 @@
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dslx/cpp_function_transpiler.h"
 #include "xls/dslx/cpp_transpiler.h"
 #include "xls/dslx/import_data.h"
+#include "xls/dslx/ir_converter.h"
+#include "xls/dslx/mangle.h"
 #include "xls/dslx/parse_and_typecheck.h"
+#include "xls/ir/package.h"
 
 ABSL_FLAG(std::string, output_header_path, "",
           "Path at which to write the generated header.");
@@ -32,6 +39,10 @@ ABSL_FLAG(std::string, namespaces, "",
           "Double-colon-delimited namespaces with which to wrap the "
           "generated code, e.g., \"my::namespace\" or "
           "\"::my::explicitly::top::level::namespace\".");
+ABSL_FLAG(std::string, entry_function, "",
+          "If specified, emits a standalone C++ model of this (non-parametric) "
+          "function and everything it calls, instead of the module's type "
+          "declarations.");
 
 namespace xls {
 namespace dslx {
@@ -43,22 +54,52 @@ create a struct from a corresponding XLS Value and vice-versa.
 
 At present, only a single module file is supported (i.e., no colon refs to other
 modules).
+
+With --entry_function, the given function is instead converted to IR and emitted
+as plain C++ (see cpp_function_transpiler.h) that can be compiled with the host
+compiler as a bit-accurate software model.
 )";
 
+absl::StatusOr<Sources> TranspileEntryFunction(
+    Module* module, ImportData* import_data, absl::string_view entry_function,
+    absl::string_view output_header_path, absl::string_view namespaces) {
+  // The software model has no notion of assertion failure, so fail!() is
+  // converted with its value semantics only.
+  ConvertOptions options;
+  options.emit_fail_as_assert = false;
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       ConvertModuleToPackage(module, import_data, options));
+  XLS_ASSIGN_OR_RETURN(std::string mangled_name,
+                       MangleDslxName(module->name(), entry_function,
+                                      CallingConvention::kTypical));
+  XLS_ASSIGN_OR_RETURN(xls::Function * function,
+                       package->GetFunction(mangled_name));
+  return TranspileFunctionToCpp(function, entry_function, output_header_path,
+                                std::string(namespaces));
+}
+
 absl::Status RealMain(const std::filesystem::path& module_path,
                       absl::string_view output_header_path,
                       absl::string_view output_source_path,
-                      absl::string_view namespaces) {
+                      absl::string_view namespaces,
+                      absl::string_view entry_function) {
   XLS_ASSIGN_OR_RETURN(std::string module_text, GetFileContents(module_path));
 
   ImportData import_data;
   XLS_ASSIGN_OR_RETURN(TypecheckedModule module,
                        ParseAndTypecheck(module_text, std::string(module_path),
                                          "source", &import_data));
-  XLS_ASSIGN_OR_RETURN(
-      Sources sources,
-      TranspileToCpp(module.module, &import_data, output_header_path,
-                     std::string(namespaces)));
+  Sources sources;
+  if (entry_function.empty()) {
+    XLS_ASSIGN_OR_RETURN(
+        sources, TranspileToCpp(module.module, &import_data,
+                                output_header_path, std::string(namespaces)));
+  } else {
+    XLS_ASSIGN_OR_RETURN(
+        sources,
+        TranspileEntryFunction(module.module, &import_data, entry_function,
+                               output_header_path, namespaces));
+  }
 
   XLS_RETURN_IF_ERROR(SetFileContents(output_header_path, sources.header));
   XLS_RETURN_IF_ERROR(SetFileContents(output_source_path, sources.body));
@@ -80,9 +121,9 @@ int main(int argc, char* argv[]) {
   std::string output_source_path = absl::GetFlag(FLAGS_output_source_path);
   XLS_QCHECK(!output_source_path.empty())
       << "--output_source_path must be specified.";
-  XLS_QCHECK_OK(xls::dslx::RealMain(args[0], output_header_path,
-                                    output_source_path,
-                                    absl::GetFlag(FLAGS_namespaces)));
+  XLS_QCHECK_OK(xls::dslx::RealMain(
+      args[0], output_header_path, output_source_path,
+      absl::GetFlag(FLAGS_namespaces), absl::GetFlag(FLAGS_entry_function)));
 
   return 0;
 }
@@ -17,6 +17,7 @@
 #include "absl/container/btree_set.h"
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/concrete_type.h"
 #include "xls/dslx/interpreter.h"
@@ -161,6 +162,17 @@ static absl::Status ValidateParametricInvocation(
     absl::optional<const ImportedInfo*> imported =
         ctx->type_info()->GetImported(import_node);
     XLS_RET_CHECK(imported.has_value());
+    absl::MutexLock lock(&(*imported)->type_info->instantiation_mutex());
+
+    // If the function was already instantiated with these bindings (via some
+    // other invocation) we can reuse its type information.
+    if (absl::optional<TypeInfo*> instance =
+            (*imported)->type_info->GetParametricInstance(parametric_block,
+                                                          symbolic_bindings)) {
+      ctx->type_info()->SetInstantiationTypeInfo(
+          instantiation, /*caller=*/symbolic_bindings, /*type_info=*/*instance);
+      return absl::OkStatus();
+    }
 
     XLS_ASSIGN_OR_RETURN(
         TypeInfo * invocation_imported_type_info,
@@ -185,6 +197,8 @@ static absl::Status ValidateParametricInvocation(
     ctx->type_info()->SetInstantiationTypeInfo(
         instantiation, /*caller=*/symbolic_bindings,
         /*type_info=*/invocation_imported_type_info);
+    (*imported)->type_info->NoteParametricInstance(
+        parametric_block, symbolic_bindings, invocation_imported_type_info);
     return absl::OkStatus();
   }
 
@@ -196,6 +210,16 @@ static absl::Status ValidateParametricInvocation(
   }
 
   if (!ctx->type_info()->Contains(parametric_block->body())) {
+    // Likewise if it was typechecked with these symbolic bindings via some
+    // other invocation.
+    if (absl::optional<TypeInfo*> instance =
+            ctx->type_info()->GetParametricInstance(parametric_block,
+                                                    symbolic_bindings)) {
+      ctx->type_info()->SetInstantiationTypeInfo(
+          instantiation, symbolic_bindings, *instance);
+      return absl::OkStatus();
+    }
+
     // Typecheck this parametric function using the symbolic bindings we just
     // derived to make sure they check out ok.
     AstNode* type_missing_error_node = ToAstNode(name_ref->name_def());
@@ -220,6 +244,8 @@ static absl::Status ValidateParametricInvocation(
               << "; instantiated: " << ctx->type_info();
   ctx->type_info()->parent()->SetInstantiationTypeInfo(
       instantiation, symbolic_bindings, ctx->type_info());
+  ctx->type_info()->NoteParametricInstance(parametric_block, symbolic_bindings,
+                                           ctx->type_info());
   XLS_RETURN_IF_ERROR(ctx->PopDerivedTypeInfo());
   return absl::OkStatus();
 }
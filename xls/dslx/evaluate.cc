@@ -14,6 +14,8 @@
 
 #include "xls/dslx/evaluate.h"
 
+#include <mutex>  // NOLINT
+
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
 #include "xls/common/status/ret_check.h"
@@ -440,8 +442,10 @@ absl::StatusOr<InterpValue> EvaluateFunction(
                                                  symbolic_bindings.ToMap()));
 
   fn_bindings.set_fn_ctx(FnCtx{m->name(), f->identifier(), symbolic_bindings});
+  InterpFrame frame(f->frame_size());
+  fn_bindings.set_frame(&frame);
   for (int64_t i = 0; i < f->params().size(); ++i) {
-    fn_bindings.AddValue(f->params()[i]->identifier(), args[i]);
+    fn_bindings.AddNameDefValue(f->params()[i]->name_def(), args[i]);
   }
 
   return interp->Eval(f->body(), &fn_bindings);
@@ -1146,7 +1150,7 @@ static absl::StatusOr<bool> EvaluateMatcher(NameDefTree* pattern,
       return true;
     }
     if (absl::holds_alternative<NameDef*>(leaf)) {
-      bindings->AddValue(absl::get<NameDef*>(leaf)->identifier(), to_match);
+      bindings->AddNameDefValue(absl::get<NameDef*>(leaf), to_match);
       return true;
     }
     if (absl::holds_alternative<Number*>(leaf) ||
@@ -1208,6 +1212,11 @@ absl::StatusOr<const InterpBindings*> GetOrCreateTopLevelBindings(
   if (import_data->IsTopLevelBindingsDone(module)) {
     return &b;
   }
+  std::lock_guard<std::recursive_mutex> lock(
+      import_data->top_level_bindings_mutex());
+  if (import_data->IsTopLevelBindingsDone(module)) {
+    return &b;
+  }
 
   AbstractInterpreter::ScopedTypeInfoSwap stis(interp, module);
 
@@ -1428,9 +1437,7 @@ static absl::StatusOr<InterpBindings> BindingsWithStructParametrics(
       auto* name_ref = dynamic_cast<NameRef*>(d);
       XLS_CHECK(name_ref != nullptr)
           << d->GetNodeTypeName() << " " << d->ToString();
-      InterpValue value =
-          nested_bindings.ResolveValueFromIdentifier(name_ref->identifier())
-              .value();
+      InterpValue value = nested_bindings.ResolveValue(name_ref).value();
       nested_bindings.AddValue(p->name_def()->identifier(), value);
     }
   }
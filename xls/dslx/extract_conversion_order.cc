@@ -14,6 +14,9 @@
 
 #include "xls/dslx/extract_conversion_order.h"
 
+#include <tuple>
+
+#include "absl/container/flat_hash_set.h"
 #include "absl/types/variant.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/symbolized_stacktrace.h"
@@ -389,33 +392,54 @@ static absl::StatusOr<std::vector<Callee>> GetCallees(
   return std::move(visitor.callees());
 }
 
+namespace {
+
+// The conversion order being built up, indexed by (function, module,
+// symbolic bindings) so we can cheaply tell whether a given instantiation is
+// already present -- heavily parametric code can have a great many of them.
+class ReadyList {
+ public:
+  bool Contains(FunctionBase* fb, Module* m,
+                const SymbolicBindings& bindings) const {
+    return index_.contains(std::make_tuple(fb, m, bindings));
+  }
+
+  void Add(ConversionRecord record) {
+    index_.insert(std::make_tuple(record.fb(), record.module(),
+                                  record.symbolic_bindings()));
+    records_.push_back(std::move(record));
+  }
+
+  const std::vector<ConversionRecord>& records() const { return records_; }
+  std::vector<ConversionRecord> TakeRecords() { return std::move(records_); }
+
+ private:
+  std::vector<ConversionRecord> records_;
+  absl::flat_hash_set<std::tuple<FunctionBase*, Module*, SymbolicBindings>>
+      index_;
+};
+
+}  // namespace
+
 static bool IsReady(absl::variant<FunctionBase*, TestFunction*> f, Module* m,
-                    const SymbolicBindings& bindings,
-                    const std::vector<ConversionRecord>* ready) {
+                    const SymbolicBindings& bindings, const ReadyList* ready) {
   // Test functions are always the root and non-parametric, so they're always
   // ready.
   if (absl::holds_alternative<TestFunction*>(f)) {
     return true;
   }
 
-  for (const ConversionRecord& cr : *ready) {
-    FunctionBase* func = absl::get<FunctionBase*>(f);
-    if (cr.fb() == func && cr.module() == m &&
-        cr.symbolic_bindings() == bindings) {
-      return true;
-    }
-  }
-  return false;
+  return ready->Contains(absl::get<FunctionBase*>(f), m, bindings);
 }
 
 // Forward decl.
 static absl::Status AddToReady(absl::variant<FunctionBase*, TestFunction*> f,
                                Module* m, TypeInfo* type_info,
                                const SymbolicBindings& bindings,
-                               std::vector<ConversionRecord>* ready);
+                               ReadyList* ready);
 
 static absl::Status ProcessCallees(absl::Span<const Callee> orig_callees,
-                                   std::vector<ConversionRecord>* ready) {
+                                   ReadyList* ready) {
   // Knock out all callees that are already in the (ready) order.
   std::vector<Callee> non_ready;
   {
@@ -440,7 +464,7 @@ static absl::Status ProcessCallees(absl::Span<const Callee> orig_callees,
 static absl::Status AddToReady(absl::variant<FunctionBase*, TestFunction*> f,
                                Module* m, TypeInfo* type_info,
                                const SymbolicBindings& bindings,
-                               std::vector<ConversionRecord>* ready) {
+                               ReadyList* ready) {
   XLS_CHECK_EQ(type_info->module(), m);
   if (IsReady(f, m, bindings, ready)) {
     return absl::OkStatus();
@@ -462,7 +486,7 @@ static absl::Status AddToReady(absl::variant<FunctionBase*, TestFunction*> f,
     XLS_ASSIGN_OR_RETURN(
         ConversionRecord cr,
         ConversionRecord::Make(fb, m, type_info, bindings, orig_callees));
-    ready->push_back(std::move(cr));
+    ready->Add(std::move(cr));
   }
   return absl::OkStatus();
 }
@@ -471,7 +495,7 @@ absl::StatusOr<std::vector<ConversionRecord>> GetOrder(Module* module,
                                                        TypeInfo* type_info,
                                                        bool traverse_tests) {
   XLS_CHECK_EQ(type_info->module(), module);
-  std::vector<ConversionRecord> ready;
+  ReadyList ready;
 
   for (ModuleMember member : module->top()) {
     if (absl::holds_alternative<QuickCheck*>(member)) {
@@ -505,19 +529,19 @@ absl::StatusOr<std::vector<ConversionRecord>> GetOrder(Module* module,
     }
   }
 
-  XLS_VLOG(5) << "Ready list: " << ConversionRecordsToString(ready);
+  XLS_VLOG(5) << "Ready list: " << ConversionRecordsToString(ready.records());
 
-  return ready;
+  return ready.TakeRecords();
 }
 
 absl::StatusOr<std::vector<ConversionRecord>> GetOrderForEntry(
     Function* f, TypeInfo* type_info) {
-  std::vector<ConversionRecord> ready;
+  ReadyList ready;
   XLS_ASSIGN_OR_RETURN(Callee callee, Callee::Make(f, f->owner(), type_info,
                                                    SymbolicBindings()));
   XLS_RETURN_IF_ERROR(
       AddToReady(f, f->owner(), type_info, SymbolicBindings(), &ready));
-  return ready;
+  return ready.TakeRecords();
 }
 
 }  // namespace xls::dslx
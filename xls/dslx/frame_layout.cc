@@ -0,0 +1,59 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/frame_layout.h"
+
+namespace xls::dslx {
+
+/* static */ FrameLayout FrameLayout::ForFunction(Function* f) {
+  FrameLayout layout;
+  for (Param* param : f->params()) {
+    layout.AddNameDef(param->name_def());
+  }
+  layout.AddBoundNameDefs(f->body());
+  return layout;
+}
+
+/* static */ void FrameLayout::AssignFrameSlots(Function* f) {
+  FrameLayout layout = ForFunction(f);
+  for (int64_t slot = 0; slot < layout.size(); ++slot) {
+    layout.name_defs_[slot]->set_frame_slot(slot);
+  }
+  f->set_frame_size(layout.size());
+}
+
+void FrameLayout::AddBoundNameDefs(AstNode* node) {
+  // Name references point at the definition they refer to as their child; that
+  // definition is bound elsewhere (or is outside of this body entirely), so we
+  // don't traverse through it.
+  if (dynamic_cast<NameRef*>(node) != nullptr) {
+    return;
+  }
+  if (auto* name_def = dynamic_cast<NameDef*>(node)) {
+    AddNameDef(name_def);
+    return;
+  }
+  for (AstNode* child : node->GetChildren(/*want_types=*/false)) {
+    AddBoundNameDefs(child);
+  }
+}
+
+void FrameLayout::AddNameDef(NameDef* name_def) {
+  auto [it, inserted] = slots_.insert({name_def, name_defs_.size()});
+  if (inserted) {
+    name_defs_.push_back(name_def);
+  }
+}
+
+}  // namespace xls::dslx
@@ -0,0 +1,83 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DSLX_FRAME_LAYOUT_H_
+#define XLS_DSLX_FRAME_LAYOUT_H_
+
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
+#include "xls/dslx/ast.h"
+
+namespace xls::dslx {
+
+// Assigns dense "frame slot" indices to the names bound within a single
+// function body, so the interpreter can store local values in an array instead
+// of a chain of identifier-keyed maps.
+//
+// Every NameDef introduced by a parameter, `let`, `for` or `match` pattern gets
+// its own slot. Since each NameDef is a distinct AST node, shadowing (e.g.
+// `let x = ...; let x = x + 1; ...`) naturally lands in distinct slots, and a
+// loop body rebinding the same NameDef on every iteration simply overwrites
+// its slot.
+//
+// Names that are not bound within the body (module-level constants, imports,
+// parametric bindings, etc.) are not given slots and continue to be resolved
+// through InterpBindings' identifier mapping.
+//
+// The parser records each function's layout in the AST as it is built (see
+// AssignFrameSlots()), so the interpreter indexes frames directly by
+// NameDef::frame_slot() rather than looking slots up per name reference.
+class FrameLayout {
+ public:
+  // Computes the layout for "f" and records it in the AST: every NameDef bound
+  // within "f" has its frame_slot() set, and "f" has its frame_size() set.
+  static void AssignFrameSlots(Function* f);
+
+  // Creates a layout for the parameters and body of function "f".
+  static FrameLayout ForFunction(Function* f);
+
+  // Returns the slot assigned to "name_def", or nullopt if it is not bound
+  // within the function body this layout was created for.
+  absl::optional<int64_t> GetSlot(const NameDef* name_def) const {
+    auto it = slots_.find(name_def);
+    if (it == slots_.end()) {
+      return absl::nullopt;
+    }
+    return it->second;
+  }
+
+  // Returns the NameDef that was assigned to "slot".
+  const NameDef* GetNameDef(int64_t slot) const { return name_defs_.at(slot); }
+
+  // Returns the number of slots required by a frame with this layout.
+  int64_t size() const { return name_defs_.size(); }
+
+ private:
+  FrameLayout() = default;
+
+  // Walks the (non-type) AST nodes under "node" and assigns slots to the
+  // NameDefs that are bound within it.
+  void AddBoundNameDefs(AstNode* node);
+
+  void AddNameDef(NameDef* name_def);
+
+  std::vector<NameDef*> name_defs_;
+  absl::flat_hash_map<const NameDef*, int64_t> slots_;
+};
+
+}  // namespace xls::dslx
+
+#endif  // XLS_DSLX_FRAME_LAYOUT_H_
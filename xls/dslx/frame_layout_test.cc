@@ -0,0 +1,94 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/frame_layout.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/dslx/parse_and_typecheck.h"
+
+namespace xls::dslx {
+namespace {
+
+using testing::ElementsAre;
+
+std::vector<std::string> GetSlotIdentifiers(const FrameLayout& layout) {
+  std::vector<std::string> result;
+  for (int64_t i = 0; i < layout.size(); ++i) {
+    result.push_back(layout.GetNameDef(i)->identifier());
+  }
+  return result;
+}
+
+TEST(FrameLayoutTest, ParamsAndShadowedLets) {
+  const std::string kProgram = R"(
+const K = u32:42;
+
+fn f(x: u32, y: u32) -> u32 {
+  let x = x + y;
+  let (a, b) = (x, K);
+  let x = a + b;
+  x
+}
+)";
+  ImportData import_data;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(kProgram, "test.x", "test", &import_data));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, tm.module->GetFunctionOrError("f"));
+  FrameLayout layout = FrameLayout::ForFunction(f);
+  // Every definition of "x" gets its own slot, and the module-level constant
+  // is not given one.
+  EXPECT_THAT(GetSlotIdentifiers(layout),
+              ElementsAre("x", "y", "x", "a", "b", "x"));
+  for (int64_t i = 0; i < layout.size(); ++i) {
+    EXPECT_EQ(layout.GetSlot(layout.GetNameDef(i)), i);
+  }
+  EXPECT_EQ(layout.GetSlot(f->name_def()), absl::nullopt);
+
+  // The parser has already recorded the same layout in the AST.
+  EXPECT_EQ(f->frame_size(), layout.size());
+  for (int64_t i = 0; i < layout.size(); ++i) {
+    EXPECT_EQ(layout.GetNameDef(i)->frame_slot(), i);
+  }
+  EXPECT_EQ(f->name_def()->frame_slot(), -1);
+  XLS_ASSERT_OK_AND_ASSIGN(ConstantDef * k, tm.module->GetConstantDef("K"));
+  EXPECT_EQ(k->name_def()->frame_slot(), -1);
+}
+
+TEST(FrameLayoutTest, ForAndMatchBindings) {
+  const std::string kProgram = R"(
+fn f(x: u32) -> u32 {
+  let y = for (i, accum): (u32, u32) in range(u32:0, u32:4) {
+    accum + i
+  }(x);
+  match (x, y) {
+    (u32:0, z) => z,
+    (w, _) => w,
+  }
+}
+)";
+  ImportData import_data;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(kProgram, "test.x", "test", &import_data));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, tm.module->GetFunctionOrError("f"));
+  FrameLayout layout = FrameLayout::ForFunction(f);
+  EXPECT_THAT(GetSlotIdentifiers(layout),
+              ElementsAre("x", "y", "i", "accum", "z", "w"));
+}
+
+}  // namespace
+}  // namespace xls::dslx
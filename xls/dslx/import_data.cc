@@ -26,6 +26,7 @@ namespace xls::dslx {
 
 absl::StatusOr<const ModuleInfo*> ImportData::Get(
     const ImportTokens& subject) const {
+  absl::MutexLock lock(&mutex_);
   auto it = cache_.find(subject);
   if (it == cache_.end()) {
     return absl::NotFoundError("Module information was not found for import " +
@@ -36,6 +37,7 @@ absl::StatusOr<const ModuleInfo*> ImportData::Get(
 
 absl::StatusOr<const ModuleInfo*> ImportData::Put(const ImportTokens& subject,
                                                   ModuleInfo module_info) {
+  absl::MutexLock lock(&mutex_);
   auto it = cache_.insert({subject, std::move(module_info)});
   if (!it.second) {
     return absl::InvalidArgumentError(
@@ -44,6 +46,42 @@ absl::StatusOr<const ModuleInfo*> ImportData::Put(const ImportTokens& subject,
   return &it.first->second;
 }
 
+Module* ImportData::GetPrefetched(const ImportTokens& subject) const {
+  absl::MutexLock lock(&mutex_);
+  auto it = prefetched_.find(subject);
+  return it == prefetched_.end() ? nullptr : it->second.get();
+}
+
+std::unique_ptr<Module> ImportData::TakePrefetched(
+    const ImportTokens& subject) {
+  absl::MutexLock lock(&mutex_);
+  auto it = prefetched_.find(subject);
+  if (it == prefetched_.end()) {
+    return nullptr;
+  }
+  std::unique_ptr<Module> module = std::move(it->second);
+  prefetched_.erase(it);
+  return module;
+}
+
+absl::optional<absl::Status> ImportData::GetTypecheckError(
+    const ImportTokens& subject) const {
+  absl::MutexLock lock(&mutex_);
+  auto it = typecheck_errors_.find(subject);
+  if (it == typecheck_errors_.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+ThreadPool& ImportData::GetThreadPool() {
+  absl::MutexLock lock(&mutex_);
+  if (thread_pool_ == nullptr) {
+    thread_pool_ = std::make_unique<ThreadPool>(thread_count_);
+  }
+  return *thread_pool_;
+}
+
 absl::StatusOr<TypeInfo*> ImportData::GetRootTypeInfoForNode(AstNode* node) {
   XLS_RET_CHECK(node != nullptr);
   return type_info_owner().GetRootTypeInfo(node->owner());
@@ -54,6 +92,7 @@ absl::StatusOr<TypeInfo*> ImportData::GetRootTypeInfo(Module* module) {
 }
 
 InterpBindings& ImportData::GetOrCreateTopLevelBindings(Module* module) {
+  absl::MutexLock lock(&mutex_);
   auto it = top_level_bindings_.find(module);
   if (it == top_level_bindings_.end()) {
     it = top_level_bindings_
@@ -66,6 +105,7 @@ InterpBindings& ImportData::GetOrCreateTopLevelBindings(Module* module) {
 
 void ImportData::SetTopLevelBindings(Module* module,
                                      std::unique_ptr<InterpBindings> tlb) {
+  absl::MutexLock lock(&mutex_);
   auto it = top_level_bindings_.emplace(module, std::move(tlb));
   XLS_CHECK(it.second) << "Module already had top level bindings: "
                        << module->name();
@@ -15,9 +15,15 @@
 #ifndef XLS_DSLX_IMPORT_DATA_H_
 #define XLS_DSLX_IMPORT_DATA_H_
 
+#include <algorithm>
 #include <filesystem>
 #include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread_pool.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/interp_bindings.h"
 #include "xls/dslx/type_info.h"
@@ -75,6 +81,9 @@ class ImportTokens {
 
 // Wrapper around a {subject: module_info} mapping that modules can be imported
 // into.
+//
+// Modules in the import DAG that don't depend on each other are typechecked
+// concurrently (see PrefetchImports()), so the state kept here is synchronized.
 class ImportData {
  public:
   ImportData() {}
@@ -82,6 +91,7 @@ class ImportData {
       : additional_search_paths_(additional_search_paths) {}
 
   bool Contains(const ImportTokens& target) const {
+    absl::MutexLock lock(&mutex_);
     return cache_.find(target) != cache_.end();
   }
 
@@ -92,6 +102,46 @@ class ImportData {
   absl::StatusOr<const ModuleInfo*> Put(const ImportTokens& subject,
                                         ModuleInfo module_info);
 
+  // Helpers for modules that have been located and parsed ahead of their
+  // import being typechecked (see PrefetchImports()). GetPrefetched() and
+  // TakePrefetched() return nullptr if "subject" has not been prefetched.
+  bool IsPrefetched(const ImportTokens& subject) const {
+    absl::MutexLock lock(&mutex_);
+    return prefetched_.contains(subject);
+  }
+  void PutPrefetched(const ImportTokens& subject,
+                     std::unique_ptr<Module> module) {
+    absl::MutexLock lock(&mutex_);
+    prefetched_.emplace(subject, std::move(module));
+  }
+  Module* GetPrefetched(const ImportTokens& subject) const;
+  std::unique_ptr<Module> TakePrefetched(const ImportTokens& subject);
+
+  // Notes that typechecking the prefetched module for "subject" failed ahead of
+  // its import (see PrefetchImports()); DoImport() reports "status" when it
+  // gets to the import.
+  void SetTypecheckError(const ImportTokens& subject, absl::Status status) {
+    absl::MutexLock lock(&mutex_);
+    typecheck_errors_.emplace(subject, std::move(status));
+  }
+  absl::optional<absl::Status> GetTypecheckError(
+      const ImportTokens& subject) const;
+
+  // Number of threads used to parse and typecheck the import DAG (see
+  // PrefetchImports()), defaults to the hardware concurrency. With a single
+  // thread, imports are typechecked on demand, in import order.
+  int64_t thread_count() const { return thread_count_; }
+  void set_thread_count(int64_t thread_count) {
+    XLS_CHECK_GE(thread_count, 1);
+    absl::MutexLock lock(&mutex_);
+    XLS_CHECK(thread_pool_ == nullptr) << "Thread pool is already in use.";
+    thread_count_ = thread_count;
+  }
+
+  // Returns the (lazily created) pool of thread_count() threads, which is kept
+  // for the lifetime of this object.
+  ThreadPool& GetThreadPool();
+
   TypeInfoOwner& type_info_owner() { return type_info_owner_; }
 
   // Helper that gets the "root" type information for the module of the given
@@ -111,17 +161,29 @@ class ImportData {
   // this will check-fail.
   void SetTopLevelBindings(Module* module, std::unique_ptr<InterpBindings> tlb);
 
+  // Held while populating the top level bindings of a module (see
+  // GetOrCreateTopLevelBindings() in evaluate.h), so that concurrently
+  // typechecked modules don't both populate those of a common import. This is
+  // recursive, as doing so can evaluate code that needs other modules' top
+  // level bindings.
+  std::recursive_mutex& top_level_bindings_mutex() {
+    return top_level_bindings_mutex_;
+  }
+
   // Notes which node at the top level of the given module is currently
   // work-in-progress. "node" may be set as nullptr when done with the entire
   // module.
   void SetTypecheckWorkInProgress(Module* module, AstNode* node) {
+    absl::MutexLock lock(&mutex_);
     typecheck_wip_[module] = node;
   }
 
   // Retrieves which node was noted as currently work-in-progress, getter for
   // SetTypecheckWorkInProgress() above.
   AstNode* GetTypecheckWorkInProgress(Module* module) {
-    return typecheck_wip_[module];
+    absl::MutexLock lock(&mutex_);
+    auto it = typecheck_wip_.find(module);
+    return it == typecheck_wip_.end() ? nullptr : it->second;
   }
 
   // Helpers for marking/querying whether the top-level scope for a given module
@@ -130,9 +192,11 @@ class ImportData {
   // hitting a work-in-progress indicator) those completed bindings can be
   // re-used after that without any need for re-evaluation.
   bool IsTopLevelBindingsDone(Module* module) const {
+    absl::MutexLock lock(&mutex_);
     return top_level_bindings_done_.contains(module);
   }
   void MarkTopLevelBindingsDone(Module* module) {
+    absl::MutexLock lock(&mutex_);
     top_level_bindings_done_.insert(module);
   }
 
@@ -141,13 +205,24 @@ class ImportData {
   }
 
  private:
-  absl::flat_hash_map<ImportTokens, ModuleInfo> cache_;
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<ImportTokens, ModuleInfo> cache_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<ImportTokens, std::unique_ptr<Module>> prefetched_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<ImportTokens, absl::Status> typecheck_errors_
+      ABSL_GUARDED_BY(mutex_);
   absl::flat_hash_map<Module*, std::unique_ptr<InterpBindings>>
-      top_level_bindings_;
-  absl::flat_hash_set<Module*> top_level_bindings_done_;
-  absl::flat_hash_map<Module*, AstNode*> typecheck_wip_;
+      top_level_bindings_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_set<Module*> top_level_bindings_done_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<Module*, AstNode*> typecheck_wip_
+      ABSL_GUARDED_BY(mutex_);
+  std::recursive_mutex top_level_bindings_mutex_;
   TypeInfoOwner type_info_owner_;
   absl::Span<const std::filesystem::path> additional_search_paths_;
+  int64_t thread_count_ = std::max<int64_t>(
+      1, std::thread::hardware_concurrency());
+  std::unique_ptr<ThreadPool> thread_pool_ ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace xls::dslx
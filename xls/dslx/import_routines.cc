@@ -14,12 +14,16 @@
 
 #include "xls/dslx/import_routines.h"
 
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "xls/common/config/xls_config.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/status/ret_check.h"
+#include "xls/common/thread_pool.h"
 #include "xls/dslx/parser.h"
 #include "xls/dslx/scanner.h"
 
@@ -121,6 +125,26 @@ static absl::StatusOr<std::filesystem::path> FindExistingPath(
                       GetCurrentDirectory().value()));
 }
 
+// Locates the file for "subject" and parses it into a module.
+static absl::StatusOr<std::unique_ptr<Module>> LocateAndParse(
+    const ImportTokens& subject,
+    absl::Span<const std::filesystem::path> additional_search_paths,
+    const Span& import_span) {
+  XLS_ASSIGN_OR_RETURN(
+      std::filesystem::path found_path,
+      FindExistingPath(subject, additional_search_paths, import_span));
+  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(found_path));
+
+  std::string fully_qualified_name = subject.ToString();
+  XLS_VLOG(3) << "Parsing " << fully_qualified_name;
+
+  Scanner scanner(found_path, contents);
+  Parser parser(/*module_name=*/fully_qualified_name, &scanner);
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Module> module, parser.ParseModule());
+  module->set_fs_path(std::move(found_path));
+  return module;
+}
+
 absl::StatusOr<const ModuleInfo*> DoImport(
     const TypecheckFn& ftypecheck, const ImportTokens& subject,
     ImportData* import_data, const Span& import_span) {
@@ -130,23 +154,162 @@ absl::StatusOr<const ModuleInfo*> DoImport(
   }
 
   XLS_VLOG(3) << "DoImport (uncached) subject: " << subject.ToString();
+  if (absl::optional<absl::Status> error =
+          import_data->GetTypecheckError(subject)) {
+    return *error;
+  }
 
-  XLS_ASSIGN_OR_RETURN(
-      std::filesystem::path found_path,
-      FindExistingPath(subject, import_data->additional_search_paths(),
-                       import_span));
-  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(found_path));
-
-  absl::Span<std::string const> pieces = subject.pieces();
-  std::string fully_qualified_name = absl::StrJoin(pieces, ".");
-  XLS_VLOG(3) << "Parsing and typechecking " << fully_qualified_name
-              << ": start";
-
-  Scanner scanner(found_path, contents);
-  Parser parser(/*module_name=*/fully_qualified_name, &scanner);
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Module> module, parser.ParseModule());
+  std::unique_ptr<Module> module = import_data->TakePrefetched(subject);
+  if (module == nullptr) {
+    XLS_ASSIGN_OR_RETURN(
+        module, LocateAndParse(subject, import_data->additional_search_paths(),
+                               import_span));
+  }
+  XLS_VLOG(3) << "Typechecking " << subject.ToString() << ": start";
   XLS_ASSIGN_OR_RETURN(TypeInfo * type_info, ftypecheck(module.get()));
   return import_data->Put(subject, ModuleInfo{std::move(module), type_info});
 }
 
+// Parses the not-yet-known modules in the import DAG of "module", a level at a
+// time, and notes them as prefetched.
+static void ParseImports(Module* module, ImportData* import_data) {
+  // Subjects that are already imported or prefetched (or that we're about to
+  // prefetch) -- they don't need to be parsed again.
+  auto is_known = [import_data](const ImportTokens& subject) {
+    return import_data->Contains(subject) ||
+           import_data->IsPrefetched(subject);
+  };
+
+  // Each "wave" is the set of not-yet-parsed modules imported by the previous
+  // wave, which can be parsed independently of each other.
+  struct WaveItem {
+    ImportTokens subject;
+    Span import_span;
+    absl::StatusOr<std::unique_ptr<Module>> module;
+  };
+  absl::flat_hash_set<ImportTokens> seen;
+  std::vector<WaveItem> wave;
+  auto add_imports_of = [&](Module* m) {
+    for (const auto& [name, import] : m->GetImportByName()) {
+      ImportTokens subject(import->subject());
+      if (is_known(subject) || !seen.insert(subject).second) {
+        continue;
+      }
+      wave.push_back(WaveItem{std::move(subject), import->span(),
+                              absl::UnknownError("Not parsed.")});
+    }
+  };
+  add_imports_of(module);
+
+  while (!wave.empty()) {
+    XLS_VLOG(3) << "Prefetching " << wave.size() << " import(s) of "
+                << module->name();
+    import_data->GetThreadPool().ParallelFor(wave.size(), [&](int64_t i) {
+      wave[i].module =
+          LocateAndParse(wave[i].subject,
+                         import_data->additional_search_paths(),
+                         wave[i].import_span);
+    });
+
+    std::vector<WaveItem> done = std::move(wave);
+    wave.clear();
+    for (WaveItem& item : done) {
+      // Errors are not reported here: DoImport() will re-encounter (and report)
+      // them when it gets to the import in question.
+      if (!item.module.ok()) {
+        XLS_VLOG(3) << "Could not prefetch " << item.subject.ToString() << ": "
+                    << item.module.status();
+        continue;
+      }
+      std::unique_ptr<Module> parsed = std::move(item.module).value();
+      add_imports_of(parsed.get());
+      import_data->PutPrefetched(item.subject, std::move(parsed));
+    }
+  }
+}
+
+// Typechecks the prefetched modules in the import DAG of "module" a level at a
+// time: all of the modules whose imports have been typechecked are typechecked
+// concurrently, each into its own (root) TypeInfo.
+static void TypecheckImports(Module* module, ImportData* import_data,
+                             const TypecheckFn& ftypecheck) {
+  struct Pending {
+    ImportTokens subject;
+    Module* module;
+    std::vector<ImportTokens> imports;
+  };
+  std::vector<Pending> pending;
+  absl::flat_hash_set<ImportTokens> seen;
+  std::vector<Module*> worklist = {module};
+  while (!worklist.empty()) {
+    Module* m = worklist.back();
+    worklist.pop_back();
+    for (const auto& [name, import] : m->GetImportByName()) {
+      ImportTokens subject(import->subject());
+      if (!seen.insert(subject).second) {
+        continue;
+      }
+      if (Module* prefetched = import_data->GetPrefetched(subject);
+          prefetched != nullptr &&
+          !import_data->GetTypecheckError(subject).has_value()) {
+        pending.push_back(Pending{subject, prefetched, {}});
+        worklist.push_back(prefetched);
+      }
+    }
+  }
+  for (Pending& p : pending) {
+    for (const auto& [name, import] : p.module->GetImportByName()) {
+      p.imports.push_back(ImportTokens(import->subject()));
+    }
+  }
+
+  while (true) {
+    // Modules with an import that failed to parse or typecheck (or that are
+    // part of a cycle) never become ready; they are left for DoImport() to
+    // report on.
+    std::vector<Pending> ready;
+    std::vector<Pending> not_ready;
+    for (Pending& p : pending) {
+      bool is_ready = absl::c_all_of(
+          p.imports, [import_data](const ImportTokens& subject) {
+            return import_data->Contains(subject);
+          });
+      (is_ready ? ready : not_ready).push_back(std::move(p));
+    }
+    if (ready.empty()) {
+      return;
+    }
+    pending = std::move(not_ready);
+
+    XLS_VLOG(3) << "Typechecking " << ready.size() << " import(s) of "
+                << module->name();
+    std::vector<absl::StatusOr<TypeInfo*>> type_infos(
+        ready.size(), absl::UnknownError("Not typechecked."));
+    import_data->GetThreadPool().ParallelFor(ready.size(), [&](int64_t i) {
+      type_infos[i] = ftypecheck(ready[i].module);
+    });
+    for (int64_t i = 0; i < ready.size(); ++i) {
+      if (!type_infos[i].ok()) {
+        import_data->SetTypecheckError(ready[i].subject,
+                                       type_infos[i].status());
+        continue;
+      }
+      std::unique_ptr<Module> typechecked =
+          import_data->TakePrefetched(ready[i].subject);
+      XLS_CHECK_OK(import_data
+                       ->Put(ready[i].subject,
+                             ModuleInfo{std::move(typechecked), *type_infos[i]})
+                       .status());
+    }
+  }
+}
+
+void PrefetchImports(Module* module, ImportData* import_data,
+                     const TypecheckFn& ftypecheck) {
+  ParseImports(module, import_data);
+  if (import_data->thread_count() > 1) {
+    TypecheckImports(module, import_data, ftypecheck);
+  }
+}
+
 }  // namespace xls::dslx
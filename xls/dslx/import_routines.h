@@ -48,6 +48,22 @@ absl::StatusOr<const ModuleInfo*> DoImport(
     const TypecheckFn& ftypecheck, const ImportTokens& subject,
     ImportData* import_data, const Span& import_span);
 
+// Locates, parses and typechecks the modules in the (transitive) import DAG of
+// "module" that are not yet present in "import_data", so that typechecking
+// "module" finds its imports already done.
+//
+// The DAG is discovered one "level" at a time, and the modules within a level
+// are parsed concurrently. Then, again a level at a time, all of the modules
+// whose imports have been typechecked are typechecked concurrently (via
+// "ftypecheck", each into its own TypeInfo) and added to "import_data". All of
+// this runs on import_data->GetThreadPool(); with a thread_count() of one, the
+// parsed modules are instead typechecked on demand by DoImport().
+//
+// Modules that cannot be located, parsed or typechecked are skipped (as are
+// their importers): DoImport() reports the error when it gets to the import.
+void PrefetchImports(Module* module, ImportData* import_data,
+                     const TypecheckFn& ftypecheck);
+
 }  // namespace xls::dslx
 
 #endif  // XLS_DSLX_IMPORT_ROUTINES_H_
@@ -0,0 +1,197 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/import_routines.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/dslx/ir_converter.h"
+#include "xls/dslx/parse_and_typecheck.h"
+#include "xls/dslx/parser.h"
+#include "xls/dslx/scanner.h"
+#include "xls/dslx/typecheck.h"
+
+namespace xls::dslx {
+namespace {
+
+using status_testing::StatusIs;
+using testing::HasSubstr;
+
+constexpr absl::string_view kLeaves[] = {"a", "b", "c", "d"};
+
+// A "common" module imported by four independent "leaf" modules, which all
+// instantiate the same parametric functions and use the same constants from
+// it; "top" imports the leaves.
+class ImportRoutinesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    XLS_ASSERT_OK_AND_ASSIGN(temp_dir_, TempDirectory::Create());
+    search_paths_ = {temp_dir_->path()};
+    XLS_ASSERT_OK(WriteModule("common", R"(
+import std
+
+pub const WIDTH = u32:8;
+
+pub fn double<N: u32>(x: bits[N]) -> bits[N] { x + x }
+
+pub fn widen<N: u32, M: u32 = N + u32:1>(x: bits[N]) -> bits[M] {
+  double(x as bits[M])
+}
+
+pub fn clzs<N: u32>(x: bits[N][4]) -> bits[N][4] { map(x, clz) }
+
+pub fn log2(x: u32) -> u32 { std::clog2(x) }
+)"));
+    std::string top;
+    for (int64_t i = 0; i < std::size(kLeaves); ++i) {
+      absl::string_view leaf = kLeaves[i];
+      XLS_ASSERT_OK(WriteModule(leaf, absl::StrFormat(R"(
+import common
+
+const SIZE = common::log2(common::WIDTH) + u32:%d;
+
+pub fn %s(x: bits[SIZE], y: bits[common::WIDTH]) -> (bits[SIZE], u9) {
+  (common::double(x), common::widen(common::double(y)))
+}
+
+pub fn %s_clzs(x: u8[4]) -> u8[4] { common::clzs(x) }
+)",
+                                                       i, leaf, leaf)));
+      absl::StrAppend(&top, "import ", leaf, "\n");
+    }
+    absl::StrAppend(&top, R"(
+fn main(x: u3, y: u8) -> u9 {
+  let (_, ay) = a::a(x, y);
+  let (_, by) = b::b(x as u4, y);
+  let (_, cy) = c::c(x as u5, y);
+  let (_, dy) = d::d(x as u6, y);
+  ay + by + cy + dy
+}
+)");
+    top_ = top;
+  }
+
+  absl::Status WriteModule(absl::string_view name, absl::string_view text) {
+    return SetFileContents(temp_dir_->path() / absl::StrCat(name, ".x"), text);
+  }
+
+  // Typechecks and converts "top" with the given number of threads, returning
+  // the IR along with the types of all of the functions in the imported
+  // modules.
+  absl::StatusOr<std::string> TypecheckAndConvert(int64_t thread_count) {
+    ImportData import_data(search_paths_);
+    import_data.set_thread_count(thread_count);
+    XLS_ASSIGN_OR_RETURN(
+        TypecheckedModule tm,
+        ParseAndTypecheck(top_, "top.x", "top", &import_data));
+    XLS_ASSIGN_OR_RETURN(std::string result,
+                         ConvertModule(tm.module, &import_data, {}));
+    for (absl::string_view subject : {"common", "a", "b", "c", "d"}) {
+      XLS_ASSIGN_OR_RETURN(
+          const ModuleInfo* info,
+          import_data.Get(ImportTokens({std::string(subject)})));
+      for (FunctionBase* f : info->module->GetFunctionBases()) {
+        absl::optional<ConcreteType*> type = info->type_info->GetItem(f);
+        absl::StrAppend(&result, "\n", subject, "::", f->identifier(), ": ",
+                        type.has_value() ? (*type)->ToString() : "<none>");
+      }
+    }
+    return result;
+  }
+
+  absl::optional<TempDirectory> temp_dir_;
+  std::vector<std::filesystem::path> search_paths_;
+  std::string top_;
+};
+
+TEST_F(ImportRoutinesTest, ConcurrentTypecheckMatchesSerial) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::string serial, TypecheckAndConvert(1));
+  EXPECT_THAT(serial, HasSubstr("fn __d__d"));
+  EXPECT_THAT(serial, HasSubstr("a::a_clzs: (uN[8][4]) -> uN[8][4]"));
+  for (int64_t thread_count : {2, 4, 8}) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::string concurrent,
+                             TypecheckAndConvert(thread_count));
+    EXPECT_EQ(serial, concurrent) << "thread count: " << thread_count;
+  }
+}
+
+TEST_F(ImportRoutinesTest, IndependentImportsTypecheckConcurrently) {
+  ImportData import_data(search_paths_);
+  import_data.set_thread_count(std::size(kLeaves));
+  Scanner scanner("top.x", top_);
+  Parser parser("top", &scanner);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Module> top, parser.ParseModule());
+
+  // Each leaf waits until all of them are being typechecked, which only
+  // happens if they are typechecked concurrently.
+  absl::Mutex mutex;
+  int64_t in_flight = 0;
+  int64_t max_in_flight = 0;
+  std::vector<std::string> order;
+  auto ftypecheck = [&](Module* module) -> absl::StatusOr<TypeInfo*> {
+    {
+      absl::MutexLock lock(&mutex);
+      order.push_back(module->name());
+      if (absl::c_linear_search(kLeaves, module->name())) {
+        max_in_flight = std::max(max_in_flight, ++in_flight);
+        mutex.AwaitWithTimeout(absl::Condition(
+                                   +[](int64_t* n) {
+                                     return *n == std::size(kLeaves);
+                                   },
+                                   &in_flight),
+                               absl::Seconds(10));
+      }
+    }
+    return CheckModule(module, &import_data);
+  };
+  PrefetchImports(top.get(), &import_data, ftypecheck);
+
+  EXPECT_EQ(max_in_flight, std::size(kLeaves));
+  // The levels below the leaves are typechecked first: "common" imports "std".
+  ASSERT_EQ(order.size(), 6);
+  EXPECT_EQ(order[0], "std");
+  EXPECT_EQ(order[1], "common");
+  for (absl::string_view subject : {"std", "common", "a", "b", "c", "d"}) {
+    ImportTokens tokens({std::string(subject)});
+    EXPECT_TRUE(import_data.Contains(tokens)) << subject;
+    EXPECT_FALSE(import_data.IsPrefetched(tokens)) << subject;
+  }
+  XLS_EXPECT_OK(CheckModule(top.get(), &import_data).status());
+}
+
+TEST_F(ImportRoutinesTest, TypecheckErrorIsReportedOnImport) {
+  XLS_ASSERT_OK(WriteModule("c", "pub fn c() -> u32 { u8:0 }"));
+  for (int64_t thread_count : {1, 4}) {
+    ImportData import_data(search_paths_);
+    import_data.set_thread_count(thread_count);
+    EXPECT_THAT(ParseAndTypecheck(top_, "top.x", "top", &import_data),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Return type of function body for 'c'")))
+        << "thread count: " << thread_count;
+  }
+}
+
+}  // namespace
+}  // namespace xls::dslx
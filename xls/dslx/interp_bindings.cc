@@ -46,6 +46,7 @@ namespace xls::dslx {
 InterpBindings::InterpBindings(const InterpBindings* parent) : parent_(parent) {
   if (parent_ != nullptr) {
     fn_ctx_ = parent_->fn_ctx();
+    frame_ = parent_->frame();
   }
 }
 
@@ -54,8 +55,7 @@ void InterpBindings::AddValueTree(NameDefTree* name_def_tree,
   if (name_def_tree->is_leaf()) {
     NameDefTree::Leaf leaf = name_def_tree->leaf();
     if (absl::holds_alternative<NameDef*>(leaf)) {
-      NameDef* name_def = absl::get<NameDef*>(leaf);
-      AddValue(name_def->identifier(), value);
+      AddNameDefValue(absl::get<NameDef*>(leaf), std::move(value));
     }
     return;
   }
@@ -149,6 +149,13 @@ absl::flat_hash_set<std::string> InterpBindings::GetKeys() const {
   for (const auto& item : map_) {
     result.insert(item.first);
   }
+  if (frame_ != nullptr) {
+    for (const InterpFrame::Slot& slot : frame_->slots()) {
+      if (slot.name_def != nullptr) {
+        result.insert(slot.name_def->identifier());
+      }
+    }
+  }
   if (parent_ != nullptr) {
     absl::flat_hash_set<std::string> parent_keys = parent_->GetKeys();
     result.insert(parent_keys.begin(), parent_keys.end());
@@ -16,9 +16,11 @@
 #define XLS_DSLX_INTERP_BINDINGS_H_
 
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/types/optional.h"
 #include "absl/types/variant.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/interp_value.h"
@@ -39,12 +41,62 @@ struct FnCtx {
   }
 };
 
+// Array-indexed storage for the values bound within a single function
+// invocation, indexed by the frame slots the parser assigned to the function's
+// NameDefs (see FrameLayout).
+//
+// A frame is shared by all of the (nested) InterpBindings created while
+// evaluating the function body, so entering a new `let` / `for` / `match` scope
+// does not need to allocate a new identifier mapping.
+class InterpFrame {
+ public:
+  // A frame slot: the NameDef currently bound in it, and its value.
+  struct Slot {
+    const NameDef* name_def = nullptr;
+    absl::optional<InterpValue> value;
+  };
+
+  explicit InterpFrame(int64_t size) : slots_(size) {}
+
+  // Stores "value" in the slot for "name_def" -- returns false if "name_def"
+  // has no slot in this frame.
+  bool Store(const NameDef* name_def, InterpValue value) {
+    int64_t slot = name_def->frame_slot();
+    if (slot < 0 || slot >= slots_.size()) {
+      return false;
+    }
+    slots_[slot].name_def = name_def;
+    slots_[slot].value = std::move(value);
+    return true;
+  }
+
+  // Returns the value currently bound to "name_def", or nullptr if it has no
+  // slot or has not been bound yet.
+  const InterpValue* Lookup(const NameDef* name_def) const {
+    int64_t slot = name_def->frame_slot();
+    if (slot < 0 || slot >= slots_.size() ||
+        slots_[slot].name_def != name_def) {
+      return nullptr;
+    }
+    return &slots_[slot].value.value();
+  }
+
+  const std::vector<Slot>& slots() const { return slots_; }
+
+ private:
+  std::vector<Slot> slots_;
+};
+
 // Represents the set of bindings (ident: value mappings) for evaluation.
 //
 //   Acts as a {ident: Value} mapping that can easily "chain" onto an existing
 //   set of bindings when you enter a new binding scope; e.g. new bindings may
 //   be created in a loop body that you want to discard when you proceed past
 //   the loop body.
+//
+//   When an InterpFrame is attached (see set_frame()), NameDefs that have a
+//   frame slot are bound in the frame instead of the identifier mapping, and
+//   name references to them are resolved by slot.
 class InterpBindings {
  public:
   using Entry =
@@ -74,6 +126,15 @@ class InterpBindings {
   //     if the name_def_tree is (a, b, c) this should be a three-value tuple.
   void AddValueTree(NameDefTree* name_def_tree, InterpValue value);
 
+  // Binds "name_def" to "value" -- in the attached frame if name_def has a
+  // frame slot, otherwise by identifier.
+  void AddNameDefValue(NameDef* name_def, InterpValue value) {
+    if (frame_ != nullptr && frame_->Store(name_def, value)) {
+      return;
+    }
+    AddValue(name_def->identifier(), std::move(value));
+  }
+
   void AddValue(std::string identifier, InterpValue value) {
     map_.insert_or_assign(std::move(identifier), Entry(std::move(value)));
   }
@@ -104,6 +165,14 @@ class InterpBindings {
 
   // Resolves a name reference to an interpreter value.
   absl::StatusOr<InterpValue> ResolveValue(NameRef* name_ref) const {
+    if (frame_ != nullptr) {
+      AnyNameDef any_name_def = name_ref->name_def();
+      if (auto* name_def = absl::get_if<NameDef*>(&any_name_def)) {
+        if (const InterpValue* value = frame_->Lookup(*name_def)) {
+          return *value;
+        }
+      }
+    }
     return ResolveValueFromIdentifier(name_ref->identifier(),
                                       &name_ref->span());
   }
@@ -133,6 +202,12 @@ class InterpBindings {
   void set_fn_ctx(absl::optional<FnCtx> value) { fn_ctx_ = std::move(value); }
   const absl::optional<FnCtx>& fn_ctx() const { return fn_ctx_; }
 
+  // Attaches the frame that slotted names are bound in; it is inherited by
+  // bindings that are subsequently chained onto this one, and must outlive
+  // them.
+  void set_frame(InterpFrame* frame) { frame_ = frame; }
+  InterpFrame* frame() const { return frame_; }
+
  private:
   // Bindings from the outer scope, may be nullptr.
   const InterpBindings* parent_;
@@ -143,6 +218,10 @@ class InterpBindings {
   // The current (module name, function name, symbolic bindings) that these
   // Bindings are being used with.
   absl::optional<FnCtx> fn_ctx_;
+
+  // Slot storage for the function invocation these bindings are being used
+  // with, may be nullptr.
+  InterpFrame* frame_ = nullptr;
 };
 
 }  // namespace xls::dslx
@@ -14,6 +14,9 @@
 
 #include "xls/dslx/interp_value.h"
 
+#include <utility>
+
+#include "xls/common/bits_util.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/bits_ops.h"
@@ -270,6 +273,17 @@ absl::StatusOr<InterpValue> InterpValue::Lt(const InterpValue& other) const {
   return Compare(*this, other, &bits_ops::ULessThan, &bits_ops::SLessThan);
 }
 
+// Helper for binary operations on bits-holding values: returns references to
+// the bits held by "lhs" and "rhs" (rather than copying them as GetBits()
+// does) or an error if either does not hold bits.
+static absl::StatusOr<std::pair<const Bits*, const Bits*>> GetBitsOperands(
+    const InterpValue& lhs, const InterpValue& rhs) {
+  if (!lhs.HasBits() || !rhs.HasBits()) {
+    return absl::InvalidArgumentError("Value does not contain bits.");
+  }
+  return std::make_pair(&lhs.GetBitsOrDie(), &rhs.GetBitsOrDie());
+}
+
 absl::StatusOr<InterpValue> InterpValue::BitwiseNegate() const {
   XLS_ASSIGN_OR_RETURN(Bits b, GetBits());
   return InterpValue(tag_, bits_ops::Not(b));
@@ -277,29 +291,27 @@ absl::StatusOr<InterpValue> InterpValue::BitwiseNegate() const {
 
 absl::StatusOr<InterpValue> InterpValue::BitwiseXor(
     const InterpValue& other) const {
-  XLS_ASSIGN_OR_RETURN(Bits lhs, GetBits());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
-  return InterpValue(tag_, bits_ops::Xor(lhs, rhs));
+  XLS_ASSIGN_OR_RETURN(auto operands, GetBitsOperands(*this, other));
+  return InterpValue(tag_, bits_ops::Xor(*operands.first, *operands.second));
 }
 
 absl::StatusOr<InterpValue> InterpValue::BitwiseOr(
     const InterpValue& other) const {
-  XLS_ASSIGN_OR_RETURN(Bits lhs, GetBits());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
-  return InterpValue(tag_, bits_ops::Or(lhs, rhs));
+  XLS_ASSIGN_OR_RETURN(auto operands, GetBitsOperands(*this, other));
+  return InterpValue(tag_, bits_ops::Or(*operands.first, *operands.second));
 }
 
 absl::StatusOr<InterpValue> InterpValue::BitwiseAnd(
     const InterpValue& other) const {
   XLS_RET_CHECK_EQ(tag(), other.tag());
-  XLS_ASSIGN_OR_RETURN(Bits lhs, GetBits());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
-  return InterpValue(tag_, bits_ops::And(lhs, rhs));
+  XLS_ASSIGN_OR_RETURN(auto operands, GetBitsOperands(*this, other));
+  return InterpValue(tag_, bits_ops::And(*operands.first, *operands.second));
 }
 
 absl::StatusOr<InterpValue> InterpValue::Sub(const InterpValue& other) const {
-  XLS_ASSIGN_OR_RETURN(Bits lhs, GetBits());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
+  XLS_ASSIGN_OR_RETURN(auto operands, GetBitsOperands(*this, other));
+  const Bits& lhs = *operands.first;
+  const Bits& rhs = *operands.second;
   if (lhs.bit_count() != rhs.bit_count()) {
     return absl::InvalidArgumentError(
         absl::StrFormat("Interpreter value sub requires lhs and rhs to have "
@@ -312,9 +324,9 @@ absl::StatusOr<InterpValue> InterpValue::Sub(const InterpValue& other) const {
 absl::StatusOr<InterpValue> InterpValue::Add(const InterpValue& other) const {
   XLS_RET_CHECK(IsBits() && other.IsBits());
   XLS_RET_CHECK_EQ(tag(), other.tag());
-  XLS_RET_CHECK_EQ(GetBitCount().value(), other.GetBitCount().value());
-  XLS_ASSIGN_OR_RETURN(Bits lhs, GetBits());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
+  const Bits& lhs = GetBitsOrDie();
+  const Bits& rhs = other.GetBitsOrDie();
+  XLS_RET_CHECK_EQ(lhs.bit_count(), rhs.bit_count());
   return InterpValue(tag_, bits_ops::Add(lhs, rhs));
 }
 
@@ -341,13 +353,22 @@ absl::StatusOr<InterpValue> InterpValue::SCmp(const InterpValue& other,
 }
 
 absl::StatusOr<InterpValue> InterpValue::Mul(const InterpValue& other) const {
-  XLS_ASSIGN_OR_RETURN(Bits lhs, GetBits());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
+  XLS_ASSIGN_OR_RETURN(auto operands, GetBitsOperands(*this, other));
+  const Bits& lhs = *operands.first;
+  const Bits& rhs = *operands.second;
   if (lhs.bit_count() != rhs.bit_count()) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Cannot mul different width values: lhs %d bits, rhs %d bits",
         lhs.bit_count(), rhs.bit_count()));
   }
+  if (lhs.bit_count() <= 64) {
+    // The low bits of the product are the same for signed and unsigned
+    // operands, and we only keep the low bits -- the wrapping machine multiply
+    // gives them to us directly.
+    uint64_t product = lhs.ToUint64().value() * rhs.ToUint64().value();
+    return InterpValue(tag_,
+                       UBits(product & Mask(lhs.bit_count()), lhs.bit_count()));
+  }
   return InterpValue(tag_, bits_ops::UMul(lhs, rhs).Slice(0, lhs.bit_count()));
 }
 
@@ -419,8 +440,7 @@ absl::StatusOr<InterpValue> InterpValue::Slice(
 absl::StatusOr<InterpValue> InterpValue::Index(const InterpValue& other) const {
   XLS_RET_CHECK(other.IsUBits());
   XLS_ASSIGN_OR_RETURN(const std::vector<InterpValue>* lhs, GetValues());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
-  XLS_ASSIGN_OR_RETURN(uint64_t index, rhs.ToUint64());
+  XLS_ASSIGN_OR_RETURN(uint64_t index, other.GetBitsOrDie().ToUint64());
   if (lhs->size() <= index) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Index out of bounds: %d >= %d elements", index, lhs->size()));
@@ -466,23 +486,23 @@ static int64_t ClampedUnsignedValue(const Bits& bits, int64_t limit) {
 }
 
 absl::StatusOr<InterpValue> InterpValue::Shl(const InterpValue& other) const {
-  XLS_ASSIGN_OR_RETURN(Bits lhs, GetBits());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
-  int64_t amount64 = ClampedUnsignedValue(rhs, lhs.bit_count());
+  XLS_ASSIGN_OR_RETURN(auto operands, GetBitsOperands(*this, other));
+  const Bits& lhs = *operands.first;
+  int64_t amount64 = ClampedUnsignedValue(*operands.second, lhs.bit_count());
   return InterpValue(tag_, bits_ops::ShiftLeftLogical(lhs, amount64));
 }
 
 absl::StatusOr<InterpValue> InterpValue::Shrl(const InterpValue& other) const {
-  XLS_ASSIGN_OR_RETURN(Bits lhs, GetBits());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
-  int64_t amount64 = ClampedUnsignedValue(rhs, lhs.bit_count());
+  XLS_ASSIGN_OR_RETURN(auto operands, GetBitsOperands(*this, other));
+  const Bits& lhs = *operands.first;
+  int64_t amount64 = ClampedUnsignedValue(*operands.second, lhs.bit_count());
   return InterpValue(tag_, bits_ops::ShiftRightLogical(lhs, amount64));
 }
 
 absl::StatusOr<InterpValue> InterpValue::Shra(const InterpValue& other) const {
-  XLS_ASSIGN_OR_RETURN(Bits lhs, GetBits());
-  XLS_ASSIGN_OR_RETURN(Bits rhs, other.GetBits());
-  int64_t amount64 = ClampedUnsignedValue(rhs, lhs.bit_count());
+  XLS_ASSIGN_OR_RETURN(auto operands, GetBitsOperands(*this, other));
+  const Bits& lhs = *operands.first;
+  int64_t amount64 = ClampedUnsignedValue(*operands.second, lhs.bit_count());
   return InterpValue(tag_, bits_ops::ShiftRightArith(lhs, amount64));
 }
 
@@ -573,8 +593,10 @@ absl::StatusOr<InterpValue> InterpValue::Flatten() const {
 }
 
 absl::StatusOr<int64_t> InterpValue::GetBitCount() const {
-  XLS_ASSIGN_OR_RETURN(Bits b, GetBits());
-  return b.bit_count();
+  if (!HasBits()) {
+    return absl::InvalidArgumentError("Value does not contain bits.");
+  }
+  return GetBitsOrDie().bit_count();
 }
 
 absl::StatusOr<int64_t> InterpValue::GetBitValueCheckSign() const {
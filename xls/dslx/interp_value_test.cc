@@ -14,9 +14,13 @@
 
 #include "xls/dslx/interp_value.h"
 
+#include <limits>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
 
 namespace xls::dslx {
 namespace {
@@ -137,6 +141,46 @@ TEST(InterpValueTest, SampleOps) {
   EXPECT_EQ(szero, sample_ops(sone));
 }
 
+TEST(InterpValueTest, MulWrapsAtBitCount) {
+  auto u8_max = InterpValue::MakeUBits(/*bit_count=*/8, 0xff);
+  EXPECT_THAT(u8_max.Mul(u8_max),
+              IsOkAndHolds(InterpValue::MakeUBits(/*bit_count=*/8, 1)));
+
+  auto s8_neg_two = InterpValue::MakeSigned(SBits(-2, /*bit_count=*/8));
+  auto s8_three = InterpValue::MakeSigned(SBits(3, /*bit_count=*/8));
+  EXPECT_THAT(
+      s8_neg_two.Mul(s8_three),
+      IsOkAndHolds(InterpValue::MakeSigned(SBits(-6, /*bit_count=*/8))));
+
+  auto u64_big = InterpValue::MakeUBits(/*bit_count=*/64, int64_t{1} << 62);
+  EXPECT_THAT(u64_big.Mul(InterpValue::MakeUBits(/*bit_count=*/64, 6)),
+              IsOkAndHolds(InterpValue::MakeUBits(
+                  /*bit_count=*/64, int64_t{1} << 63)));
+
+  // Wider than a machine word takes the general path.
+  auto u65_one = InterpValue::MakeBits(
+      InterpValueTag::kUBits, bits_ops::ZeroExtend(UBits(1, 1), 65));
+  ASSERT_TRUE(u65_one.ok());
+  EXPECT_THAT(u65_one->Mul(*u65_one), IsOkAndHolds(*u65_one));
+}
+
+TEST(InterpValueTest, WideComparisons) {
+  auto u64_max = InterpValue::MakeUBits(/*bit_count=*/64, -1);
+  auto u64_one = InterpValue::MakeUBits(/*bit_count=*/64, 1);
+  auto s64_neg_one = InterpValue::MakeSBits(/*bit_count=*/64, -1);
+  auto s64_one = InterpValue::MakeSBits(/*bit_count=*/64, 1);
+
+  EXPECT_THAT(u64_max.Gt(u64_one), IsOkAndHolds(InterpValue::MakeBool(true)));
+  EXPECT_THAT(u64_max.Le(u64_one), IsOkAndHolds(InterpValue::MakeBool(false)));
+  EXPECT_THAT(s64_neg_one.Lt(s64_one),
+              IsOkAndHolds(InterpValue::MakeBool(true)));
+  EXPECT_THAT(s64_neg_one.Ge(s64_neg_one),
+              IsOkAndHolds(InterpValue::MakeBool(true)));
+  EXPECT_THAT(u64_max.FloorDiv(InterpValue::MakeUBits(/*bit_count=*/64, 2)),
+              IsOkAndHolds(InterpValue::MakeUBits(
+                  /*bit_count=*/64, std::numeric_limits<int64_t>::max())));
+}
+
 TEST(InterpValueTest, ArrayOfU32HumanStr) {
   auto array =
       InterpValue::MakeArray({InterpValue::MakeU32(2), InterpValue::MakeU32(3),
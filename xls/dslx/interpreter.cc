@@ -170,6 +170,8 @@ absl::Status Interpreter::RunTest(absl::string_view name) {
   InterpBindings bindings(/*parent=*/top_level_bindings);
   bindings.set_fn_ctx(
       FnCtx{entry_module_->name(), absl::StrFormat("%s__test", name)});
+  InterpFrame frame(test->fn()->frame_size());
+  bindings.set_frame(&frame);
   absl::StatusOr<InterpValue> result_or =
       Evaluate(test->body(), &bindings, /*type_context=*/nullptr);
   if (!result_or.status().ok()) {
@@ -0,0 +1,159 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the throughput of the DSLX interpreter when repeatedly invoking a
+// function (by default fp_fast_rsqrt_32) on random arguments.
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/get_runfile_path.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dslx/command_line_utils.h"
+#include "xls/dslx/concrete_type.h"
+#include "xls/dslx/import_data.h"
+#include "xls/dslx/interp_value.h"
+#include "xls/dslx/interpreter.h"
+#include "xls/dslx/parse_and_typecheck.h"
+#include "xls/ir/bits.h"
+
+ABSL_FLAG(std::string, input, "xls/modules/fp_fast_rsqrt_32.x",
+          "DSLX module containing the function to benchmark; relative paths "
+          "are resolved against the XLS runfiles.");
+ABSL_FLAG(std::string, entry, "fp_fast_rsqrt_32",
+          "Function in the module to invoke; its parameters must be bits, "
+          "tuples or structs thereof.");
+ABSL_FLAG(int64_t, iterations, 1000,
+          "Number of invocations (each with distinct random arguments) per "
+          "repetition.");
+ABSL_FLAG(int64_t, repetitions, 5,
+          "Number of times to repeat the measurement; the fastest is "
+          "reported.");
+
+namespace xls::dslx {
+namespace {
+
+absl::StatusOr<InterpValue> RandomValue(const ConcreteType& type,
+                                        absl::BitGen& bitgen) {
+  if (auto* bits_type = dynamic_cast<const BitsType*>(&type)) {
+    XLS_ASSIGN_OR_RETURN(int64_t bit_count, bits_type->size().GetAsInt64());
+    XLS_RET_CHECK_LE(bit_count, 64)
+        << "Unsupported parameter type: " << type.ToString();
+    uint64_t value = absl::Uniform<uint64_t>(bitgen);
+    if (bit_count < 64) {
+      value &= (uint64_t{1} << bit_count) - 1;
+    }
+    return InterpValue::MakeBits(bits_type->is_signed(),
+                                 UBits(value, bit_count));
+  }
+  std::vector<InterpValue> members;
+  if (auto* struct_type = dynamic_cast<const StructType*>(&type)) {
+    for (int64_t i = 0; i < struct_type->size(); ++i) {
+      XLS_ASSIGN_OR_RETURN(
+          InterpValue member,
+          RandomValue(struct_type->GetMemberType(i), bitgen));
+      members.push_back(std::move(member));
+    }
+    return InterpValue::MakeTuple(std::move(members));
+  }
+  if (auto* tuple_type = dynamic_cast<const TupleType*>(&type)) {
+    for (int64_t i = 0; i < tuple_type->size(); ++i) {
+      XLS_ASSIGN_OR_RETURN(InterpValue member,
+                           RandomValue(tuple_type->GetMemberType(i), bitgen));
+      members.push_back(std::move(member));
+    }
+    return InterpValue::MakeTuple(std::move(members));
+  }
+  return absl::UnimplementedError(
+      absl::StrCat("Unsupported parameter type: ", type.ToString()));
+}
+
+absl::Status RealMain(const std::filesystem::path& input_path,
+                      absl::string_view entry, int64_t iterations,
+                      int64_t repetitions) {
+  XLS_ASSIGN_OR_RETURN(std::string program, GetFileContents(input_path));
+  XLS_ASSIGN_OR_RETURN(std::string module_name, PathToName(input_path.c_str()));
+  ImportData import_data;
+  absl::Time start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(TypecheckedModule tm,
+                       ParseAndTypecheck(program, input_path.c_str(),
+                                         module_name, &import_data));
+  std::cout << "Parse and typecheck time: " << absl::Now() - start << "\n";
+
+  XLS_ASSIGN_OR_RETURN(Function * f, tm.module->GetFunctionOrError(entry));
+  absl::BitGen bitgen;
+  std::vector<std::vector<InterpValue>> args(iterations);
+  for (std::vector<InterpValue>& invocation_args : args) {
+    for (Param* param : f->params()) {
+      absl::optional<ConcreteType*> type = tm.type_info->GetItem(param);
+      XLS_RET_CHECK(type.has_value());
+      XLS_ASSIGN_OR_RETURN(InterpValue arg, RandomValue(**type, bitgen));
+      invocation_args.push_back(std::move(arg));
+    }
+  }
+
+  Interpreter interpreter(tm.module, /*typecheck=*/nullptr, &import_data);
+  absl::Duration best_time = absl::InfiniteDuration();
+  for (int64_t repetition = 0; repetition < repetitions; ++repetition) {
+    start = absl::Now();
+    for (const std::vector<InterpValue>& invocation_args : args) {
+      XLS_RETURN_IF_ERROR(
+          interpreter.RunFunction(entry, invocation_args).status());
+    }
+    absl::Duration time = absl::Now() - start;
+    best_time = std::min(best_time, time);
+    std::cout << "Repetition " << repetition << ": " << time << ", "
+              << time / iterations << "/call\n";
+  }
+  std::cout << "Best: " << best_time / iterations << "/call, "
+            << iterations / absl::ToDoubleSeconds(best_time) << " calls/s\n";
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls::dslx
+
+int main(int argc, char* argv[]) {
+  xls::InitXls(argv[0], argc, argv);
+
+  std::filesystem::path input_path = absl::GetFlag(FLAGS_input);
+  XLS_QCHECK(!input_path.empty()) << "--input must be specified.";
+  if (input_path.is_relative()) {
+    absl::StatusOr<std::filesystem::path> runfile_path =
+        xls::GetXlsRunfilePath(input_path);
+    XLS_QCHECK_OK(runfile_path.status());
+    input_path = runfile_path.value();
+  }
+
+  int64_t iterations = absl::GetFlag(FLAGS_iterations);
+  XLS_QCHECK_GT(iterations, 0) << "--iterations must be positive.";
+  int64_t repetitions = absl::GetFlag(FLAGS_repetitions);
+  XLS_QCHECK_GT(repetitions, 0) << "--repetitions must be positive.";
+
+  XLS_QCHECK_OK(xls::dslx::RealMain(input_path, absl::GetFlag(FLAGS_entry),
+                                    iterations, repetitions));
+  return 0;
+}
@@ -64,6 +64,40 @@ TEST(InterpreterTest, RunTokenIdentityFn) {
   EXPECT_EQ(result.ToString(), tok.ToString());
 }
 
+TEST(InterpreterTest, ShadowedBindingsInLoopAndMatch) {
+  const std::string kProgram = R"(
+const K = u32:3;
+
+fn f(x: u32) -> u32 {
+  let x = x + K;
+  let y = for (i, x): (u32, u32) in range(u32:0, u32:4) {
+    let x = x + i;
+    match i {
+      u32:2 => x * u32:2,
+      j => x + j,
+    }
+  }(x);
+  x + y
+}
+)";
+  ImportData import_data;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(kProgram, "test.x", "test", &import_data));
+  Interpreter interp(tm.module, /*typecheck=*/nullptr,
+                     /*import_data=*/&import_data);
+  // x = 4; loop: (4+0)+0 = 4, (4+1)+1 = 6, (6+2)*2 = 16, (16+3)+3 = 22.
+  XLS_ASSERT_OK_AND_ASSIGN(InterpValue result,
+                           interp.RunFunction("f", {InterpValue::MakeU32(1)}));
+  EXPECT_TRUE(result.Eq(InterpValue::MakeU32(26))) << result.ToString();
+  // Run a second time to make sure nothing from the previous invocation's
+  // frame leaks into this one.
+  XLS_ASSERT_OK_AND_ASSIGN(result,
+                           interp.RunFunction("f", {InterpValue::MakeU32(0)}));
+  // x = 3; loop: 3, 5, 14, 20.
+  EXPECT_TRUE(result.Eq(InterpValue::MakeU32(23))) << result.ToString();
+}
+
 TEST(InterpreterTest, FailureBacktrace) {
   const std::string kProgram = R"(
 fn failer(x: u32) -> u1 {
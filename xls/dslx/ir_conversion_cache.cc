@@ -0,0 +1,157 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/ir_conversion_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <system_error>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/random/random.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "openssl/sha.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls::dslx {
+
+// An entry file holds the number of dependencies on its first line, followed
+// by a "<content hash> <path>" line per dependency, followed by the IR.
+absl::StatusOr<absl::optional<std::string>> IrConversionCache::Lookup(
+    absl::string_view key) const {
+  std::filesystem::path entry_path = GetEntryPath(key);
+  if (!FileExists(entry_path).ok()) {
+    return absl::nullopt;
+  }
+  XLS_ASSIGN_OR_RETURN(std::string entry, GetFileContents(entry_path));
+
+  absl::string_view rest = entry;
+  auto pop_line = [&rest]() -> absl::optional<absl::string_view> {
+    size_t newline = rest.find('\n');
+    if (newline == absl::string_view::npos) {
+      return absl::nullopt;
+    }
+    absl::string_view line = rest.substr(0, newline);
+    rest.remove_prefix(newline + 1);
+    return line;
+  };
+  // A malformed entry (e.g. from a different version of this format) is
+  // treated as a miss, and is replaced by the next Store().
+  auto malformed = [&entry_path]() -> absl::optional<std::string> {
+    XLS_VLOG(1) << "Ignoring malformed cache entry " << entry_path;
+    return absl::nullopt;
+  };
+
+  absl::optional<absl::string_view> line = pop_line();
+  int64_t dependency_count;
+  if (!line.has_value() || !absl::SimpleAtoi(*line, &dependency_count)) {
+    return malformed();
+  }
+  for (int64_t i = 0; i < dependency_count; ++i) {
+    line = pop_line();
+    if (!line.has_value()) {
+      return malformed();
+    }
+    std::vector<absl::string_view> pieces =
+        absl::StrSplit(*line, absl::MaxSplits(' ', 1));
+    if (pieces.size() != 2) {
+      return malformed();
+    }
+    std::filesystem::path dependency = std::string(pieces[1]);
+    absl::StatusOr<std::string> contents = GetFileContents(dependency);
+    if (!contents.ok() || ContentHash(*contents) != pieces[0]) {
+      XLS_VLOG(1) << "Cache entry " << entry_path << " is stale: "
+                  << dependency << " has changed";
+      return absl::nullopt;
+    }
+  }
+  return std::string(rest);
+}
+
+absl::Status IrConversionCache::Store(
+    absl::string_view key, absl::Span<const std::filesystem::path> dependencies,
+    absl::string_view ir) const {
+  std::string entry = absl::StrCat(dependencies.size(), "\n");
+  for (const std::filesystem::path& dependency : dependencies) {
+    XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(dependency));
+    absl::StrAppend(&entry, ContentHash(contents), " ", dependency.string(),
+                    "\n");
+  }
+  absl::StrAppend(&entry, ir);
+
+  // Write to a unique temporary file and rename it into place, so a
+  // concurrent Lookup() never observes a partially written entry.
+  XLS_RETURN_IF_ERROR(RecursivelyCreateDir(directory_));
+  std::filesystem::path entry_path = GetEntryPath(key);
+  absl::BitGen bitgen;
+  std::filesystem::path temp_path =
+      absl::StrFormat("%s.%016x.tmp", entry_path.string(),
+                      absl::Uniform<uint64_t>(bitgen));
+  XLS_RETURN_IF_ERROR(SetFileContents(temp_path, entry));
+  std::error_code ec;
+  std::filesystem::rename(temp_path, entry_path, ec);
+  if (ec) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to rename %s to %s: %s", temp_path.string(),
+                        entry_path.string(), ec.message()));
+  }
+  return absl::OkStatus();
+}
+
+std::filesystem::path IrConversionCache::GetEntryPath(
+    absl::string_view key) const {
+  return directory_ / absl::StrCat(ContentHash(key), ".ir");
+}
+
+std::string ContentHash(absl::string_view data) {
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const uint8_t*>(data.data()), data.size(), digest);
+  return absl::BytesToHexString(absl::string_view(
+      reinterpret_cast<const char*>(digest), SHA256_DIGEST_LENGTH));
+}
+
+absl::StatusOr<std::vector<std::filesystem::path>> GetImportedPaths(
+    Module* module, ImportData* import_data) {
+  std::vector<std::filesystem::path> paths;
+  absl::flat_hash_set<Module*> seen = {module};
+  std::vector<Module*> worklist = {module};
+  while (!worklist.empty()) {
+    Module* m = worklist.back();
+    worklist.pop_back();
+    for (const auto& [name, import] : m->GetImportByName()) {
+      XLS_ASSIGN_OR_RETURN(const ModuleInfo* info,
+                           import_data->Get(ImportTokens(import->subject())));
+      Module* imported = info->module.get();
+      if (!seen.insert(imported).second) {
+        continue;
+      }
+      if (!imported->fs_path().has_value()) {
+        return absl::FailedPreconditionError(absl::StrFormat(
+            "Imported module %s was not parsed from a file", imported->name()));
+      }
+      paths.push_back(*imported->fs_path());
+      worklist.push_back(imported);
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+}  // namespace xls::dslx
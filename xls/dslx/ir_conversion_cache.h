@@ -0,0 +1,79 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DSLX_IR_CONVERSION_CACHE_H_
+#define XLS_DSLX_IR_CONVERSION_CACHE_H_
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "xls/dslx/ast.h"
+#include "xls/dslx/import_data.h"
+
+namespace xls::dslx {
+
+// Persistent (on-disk) cache of DSLX-to-IR conversion results, so that tools
+// invoked repeatedly on unchanged sources (e.g. as build actions) can skip
+// parsing, typechecking and converting them.
+//
+// Entries are keyed by a caller-provided key, which should cover the tool
+// options and the contents of the input files (see ContentHash()), and record
+// the content hash of every file in the inputs' transitive import DAG. An entry
+// is only used while all of those files still have the recorded contents, so
+// editing any (transitively) imported module invalidates it; the next Store()
+// for the key replaces it.
+//
+// The AST and TypeInfo have no serialized form (the latter is keyed by AST node
+// pointers), so the cached artifact is the converted IR text.
+//
+// Entries are written atomically, so concurrent processes can share a cache
+// directory.
+class IrConversionCache {
+ public:
+  explicit IrConversionCache(std::filesystem::path directory)
+      : directory_(std::move(directory)) {}
+
+  // Returns the IR stored for "key", or nullopt if there is no entry for it or
+  // any of the files it depends on has changed (or no longer exists).
+  absl::StatusOr<absl::optional<std::string>> Lookup(
+      absl::string_view key) const;
+
+  // Stores "ir" for "key", recording the current contents of "dependencies".
+  absl::Status Store(absl::string_view key,
+                     absl::Span<const std::filesystem::path> dependencies,
+                     absl::string_view ir) const;
+
+ private:
+  std::filesystem::path GetEntryPath(absl::string_view key) const;
+
+  std::filesystem::path directory_;
+};
+
+// Returns a (hex-encoded) SHA-256 digest of "data".
+std::string ContentHash(absl::string_view data);
+
+// Returns the paths of the files that the modules in the transitive import DAG
+// of "module" were parsed from (not including "module" itself). "module" must
+// have been typechecked with "import_data".
+absl::StatusOr<std::vector<std::filesystem::path>> GetImportedPaths(
+    Module* module, ImportData* import_data);
+
+}  // namespace xls::dslx
+
+#endif  // XLS_DSLX_IR_CONVERSION_CACHE_H_
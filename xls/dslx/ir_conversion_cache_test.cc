@@ -0,0 +1,142 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/ir_conversion_cache.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/dslx/ir_converter.h"
+#include "xls/dslx/parse_and_typecheck.h"
+
+namespace xls::dslx {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using testing::ElementsAre;
+using testing::HasSubstr;
+using testing::Optional;
+
+class IrConversionCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    XLS_ASSERT_OK_AND_ASSIGN(temp_dir_, TempDirectory::Create());
+    search_paths_ = {temp_dir_->path()};
+    XLS_ASSERT_OK(WriteModule("leaf", "pub fn leaf() -> u32 { u32:42 }"));
+    XLS_ASSERT_OK(WriteModule(
+        "mid", "import leaf\npub fn mid() -> u32 { leaf::leaf() }"));
+    XLS_ASSERT_OK(
+        WriteModule("top", "import mid\nfn top() -> u32 { mid::mid() }"));
+  }
+
+  absl::Status WriteModule(absl::string_view name, absl::string_view text) {
+    return SetFileContents(ModulePath(name), text);
+  }
+
+  std::filesystem::path ModulePath(absl::string_view name) {
+    return temp_dir_->path() / absl::StrCat(name, ".x");
+  }
+
+  // Converts the "top" module the way ir_converter_main does: the cache is
+  // consulted first, and the module is only parsed, typechecked and converted
+  // (counted in "conversions_") on a miss.
+  absl::StatusOr<std::string> ConvertTop(const IrConversionCache& cache) {
+    XLS_ASSIGN_OR_RETURN(std::string text, GetFileContents(ModulePath("top")));
+    std::string key = ContentHash(text);
+    XLS_ASSIGN_OR_RETURN(absl::optional<std::string> cached,
+                         cache.Lookup(key));
+    if (cached.has_value()) {
+      return *cached;
+    }
+
+    ++conversions_;
+    ImportData import_data(search_paths_);
+    XLS_ASSIGN_OR_RETURN(TypecheckedModule tm,
+                         ParseAndTypecheck(text, ModulePath("top").string(),
+                                           "top", &import_data));
+    XLS_ASSIGN_OR_RETURN(
+        std::string ir,
+        ConvertModule(tm.module, &import_data, ConvertOptions{}));
+    XLS_ASSIGN_OR_RETURN(std::vector<std::filesystem::path> dependencies,
+                         GetImportedPaths(tm.module, &import_data));
+    XLS_RETURN_IF_ERROR(cache.Store(key, dependencies, ir));
+    return ir;
+  }
+
+  absl::optional<TempDirectory> temp_dir_;
+  std::vector<std::filesystem::path> search_paths_;
+  int64_t conversions_ = 0;
+};
+
+TEST_F(IrConversionCacheTest, GetImportedPathsIsTransitive) {
+  ImportData import_data(search_paths_);
+  XLS_ASSERT_OK_AND_ASSIGN(std::string text,
+                           GetFileContents(ModulePath("top")));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(text, ModulePath("top").string(), "top", &import_data));
+  EXPECT_THAT(GetImportedPaths(tm.module, &import_data),
+              IsOkAndHolds(ElementsAre(ModulePath("leaf"), ModulePath("mid"))));
+}
+
+TEST_F(IrConversionCacheTest, SecondRunSkipsConversion) {
+  IrConversionCache cache(temp_dir_->path() / "cache");
+  XLS_ASSERT_OK_AND_ASSIGN(std::string first, ConvertTop(cache));
+  EXPECT_EQ(conversions_, 1);
+  EXPECT_THAT(first, HasSubstr("fn __top__top"));
+
+  // A second "invocation" (with a fresh cache object, as a new process would
+  // have) is served from disk without parsing or typechecking anything.
+  IrConversionCache reopened(temp_dir_->path() / "cache");
+  XLS_ASSERT_OK_AND_ASSIGN(std::string second, ConvertTop(reopened));
+  EXPECT_EQ(conversions_, 1);
+  EXPECT_EQ(first, second);
+}
+
+TEST_F(IrConversionCacheTest, ChangedTransitiveImportInvalidates) {
+  IrConversionCache cache(temp_dir_->path() / "cache");
+  XLS_ASSERT_OK_AND_ASSIGN(std::string first, ConvertTop(cache));
+  EXPECT_THAT(first, HasSubstr("value=42"));
+
+  // "top" itself is unchanged, but a module two imports away is not.
+  XLS_ASSERT_OK(WriteModule("leaf", "pub fn leaf() -> u32 { u32:64 }"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string second, ConvertTop(cache));
+  EXPECT_EQ(conversions_, 2);
+  EXPECT_THAT(second, HasSubstr("value=64"));
+
+  // The refreshed entry is then reused.
+  XLS_ASSERT_OK_AND_ASSIGN(std::string third, ConvertTop(cache));
+  EXPECT_EQ(conversions_, 2);
+  EXPECT_EQ(second, third);
+}
+
+TEST_F(IrConversionCacheTest, MissingDependencyOrMalformedEntryIsAMiss) {
+  IrConversionCache cache(temp_dir_->path() / "cache");
+  XLS_ASSERT_OK(cache.Store("key", {ModulePath("leaf")}, "ir text"));
+  EXPECT_THAT(cache.Lookup("key"), IsOkAndHolds(Optional(HasSubstr("ir"))));
+  EXPECT_THAT(cache.Lookup("other key"), IsOkAndHolds(absl::nullopt));
+
+  std::filesystem::remove(ModulePath("leaf"));
+  EXPECT_THAT(cache.Lookup("key"), IsOkAndHolds(absl::nullopt));
+
+  std::filesystem::path entry_path =
+      temp_dir_->path() / "cache" / absl::StrCat(ContentHash("key"), ".ir");
+  XLS_ASSERT_OK(SetFileContents(entry_path, "not a cache entry"));
+  EXPECT_THAT(cache.Lookup("key"), IsOkAndHolds(absl::nullopt));
+}
+
+}  // namespace
+}  // namespace xls::dslx
@@ -24,10 +24,16 @@
 
 #include "xls/dslx/ir_converter.h"
 
+#include <algorithm>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/substitute.h"
 #include "absl/types/variant.h"
+#include "xls/common/thread_pool.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/deduce_ctx.h"
 #include "xls/dslx/dslx_builtins.h"
@@ -37,18 +43,110 @@
 #include "xls/ir/bits.h"
 #include "xls/ir/function.h"
 #include "xls/ir/lsb_or_msb.h"
+#include "xls/ir/value_helpers.h"
 
 namespace xls::dslx {
 namespace {
 
+// Name of the (single) source file that IR source locations refer to.
+//
+// TODO(leary): 2019-07-19 Create a way to get the file path from the module.
+constexpr absl::string_view kFakeFilename = "fake_file.x";
+
 // Bundles together a package pointer with a supplementary map we keep that
 // shows the DSLX function that led to IR functions in the package.
 struct PackageData {
   Package* package;
   absl::flat_hash_map<xls::Function*, dslx::Function*> ir_to_dslx;
   absl::flat_hash_set<xls::Function*> wrappers;
+
+  // Index of the package's functions by name; see GetPackageFunction().
+  absl::flat_hash_map<std::string, xls::Function*> functions_by_name;
+  int64_t indexed_function_count = 0;
+
+  // Set when converting into a scratch package whose functions are later
+  // merged into "parent" (see ConvertCallGraph()). Functions of the parent are
+  // then referred to via signature-only stubs in the scratch package, and
+  // names that could not be resolved at all are recorded, since they may be
+  // defined by a function merged into the parent in the meantime.
+  const PackageData* parent = nullptr;
+  absl::flat_hash_map<xls::Function*, xls::Function*> stub_to_parent;
+  absl::flat_hash_set<std::string> missing_functions;
 };
 
+// Adds the functions appended to the package since the last call to the
+// name index.
+void IndexPackageFunctions(PackageData& package_data) {
+  absl::Span<const std::unique_ptr<xls::Function>> functions =
+      package_data.package->functions();
+  for (; package_data.indexed_function_count < functions.size();
+       ++package_data.indexed_function_count) {
+    xls::Function* f = functions[package_data.indexed_function_count].get();
+    // Note: like Package::GetFunction(), the first function with a given name
+    // wins.
+    package_data.functions_by_name.emplace(f->name(), f);
+  }
+}
+
+// Returns a function in "package" with the same signature as "f" (from
+// another package), which can stand in for "f" as the target of invokes and
+// maps.
+absl::StatusOr<xls::Function*> MakeStubFunction(xls::Function* f,
+                                                Package* package) {
+  FunctionBuilder fb(f->name(), package);
+  for (xls::Param* param : f->params()) {
+    XLS_ASSIGN_OR_RETURN(Type * type,
+                         package->MapTypeFromOtherPackage(param->GetType()));
+    fb.Param(param->name(), type);
+  }
+  XLS_ASSIGN_OR_RETURN(
+      Type * return_type,
+      package->MapTypeFromOtherPackage(f->return_value()->GetType()));
+  return fb.BuildWithReturnValue(fb.Literal(ZeroOfType(return_type)));
+}
+
+// Returns the function named "name" in the package, or nullptr if there is
+// none.
+//
+// Package::GetFunction() is a linear scan, which makes resolving callees
+// quadratic when converting modules with many (e.g. parametric) functions.
+// Functions are only ever appended to the package during conversion, so we
+// just index the ones added since the last lookup.
+//
+// When converting into a scratch package, functions of the parent package are
+// returned as stubs (see PackageData).
+absl::StatusOr<xls::Function*> GetPackageFunction(PackageData& package_data,
+                                                  absl::string_view name) {
+  IndexPackageFunctions(package_data);
+  auto it = package_data.functions_by_name.find(name);
+  if (package_data.parent != nullptr) {
+    // The parent's functions come first, so they take precedence.
+    auto parent_it = package_data.parent->functions_by_name.find(name);
+    if (parent_it != package_data.parent->functions_by_name.end()) {
+      if (it != package_data.functions_by_name.end()) {
+        XLS_RET_CHECK(package_data.stub_to_parent.contains(it->second));
+        return it->second;
+      }
+      xls::Function* f = parent_it->second;
+      XLS_ASSIGN_OR_RETURN(xls::Function * stub,
+                           MakeStubFunction(f, package_data.package));
+      package_data.stub_to_parent[stub] = f;
+      auto dslx_it = package_data.parent->ir_to_dslx.find(f);
+      if (dslx_it != package_data.parent->ir_to_dslx.end()) {
+        package_data.ir_to_dslx[stub] = dslx_it->second;
+      }
+      return stub;
+    }
+  }
+  if (it == package_data.functions_by_name.end()) {
+    if (package_data.parent != nullptr) {
+      package_data.missing_functions.insert(std::string(name));
+    }
+    return nullptr;
+  }
+  return it->second;
+}
+
 // Returns a status that indicates an error in the IR conversion process.
 absl::Status ConversionErrorStatus(const absl::optional<Span>& span,
                                    absl::string_view message) {
@@ -770,9 +868,7 @@ FunctionConverter::FunctionConverter(PackageData& package_data, Module* module,
       module_(module),
       import_data_(import_data),
       options_(std::move(options)),
-      // TODO(leary): 2019-07-19 Create a way to get the file path from the
-      // module.
-      fileno_(package_data.package->GetOrCreateFileno("fake_file.x")) {
+      fileno_(package_data.package->GetOrCreateFileno(kFakeFilename)) {
   XLS_VLOG(5) << "Constructed IR converter: " << this;
 }
 
@@ -1695,7 +1791,9 @@ absl::StatusOr<BValue> FunctionConverter::DefMapWithBuiltin(
   XLS_VLOG(5) << "Mapping with builtin; arg: "
               << arg_value.GetType()->ToString();
   auto* array_type = arg_value.GetType()->AsArrayOrDie();
-  if (!package()->HasFunctionWithName(mangled_name)) {
+  XLS_ASSIGN_OR_RETURN(xls::Function * f,
+                       GetPackageFunction(package_data_, mangled_name));
+  if (f == nullptr) {
     FunctionBuilder fb(mangled_name, package());
     BValue param = fb.Param("arg", array_type->element_type());
     const std::string& builtin_name = node->identifier();
@@ -1708,10 +1806,9 @@ absl::StatusOr<BValue> FunctionConverter::DefMapWithBuiltin(
       return absl::InternalError("Invalid builtin name for map: " +
                                  builtin_name);
     }
-    XLS_RETURN_IF_ERROR(fb.Build().status());
+    XLS_ASSIGN_OR_RETURN(f, fb.Build());
   }
 
-  XLS_ASSIGN_OR_RETURN(xls::Function * f, package()->GetFunction(mangled_name));
   return Def(parent_node, [&](absl::optional<SourceLocation> loc) {
     return function_builder_->Map(arg_value, f);
   });
@@ -1758,7 +1855,13 @@ absl::StatusOr<BValue> FunctionConverter::HandleMap(Invocation* node) {
                      convention, free_set, node_sym_bindings.value()));
   XLS_VLOG(5) << "Getting function with mangled name: " << mangled_name
               << " from package: " << package()->name();
-  XLS_ASSIGN_OR_RETURN(xls::Function * f, package()->GetFunction(mangled_name));
+  XLS_ASSIGN_OR_RETURN(xls::Function * f,
+                       GetPackageFunction(package_data_, mangled_name));
+  if (f == nullptr) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Package %s does not have a function with name: \"%s\"",
+        package()->name(), mangled_name));
+  }
   return Def(node, [&](absl::optional<SourceLocation> loc) -> BValue {
     return function_builder_->Map(arg, f, loc);
   });
@@ -1955,11 +2058,11 @@ absl::Status FunctionConverter::HandleInvocation(Invocation* node) {
     return values;
   };
 
-  if (package()->HasFunctionWithName(called_name)) {
-    XLS_ASSIGN_OR_RETURN(xls::Function * f,
-                         package()->GetFunction(called_name));
+  XLS_ASSIGN_OR_RETURN(xls::Function * callee,
+                       GetPackageFunction(package_data_, called_name));
+  if (callee != nullptr) {
     XLS_ASSIGN_OR_RETURN(std::vector<BValue> args, accept_args());
-    return HandleUdfInvocation(node, f, std::move(args));
+    return HandleUdfInvocation(node, callee, std::move(args));
   }
 
   // A few builtins are handled specially.
@@ -2935,10 +3038,145 @@ absl::Status ConvertOneFunctionInternal(
   return absl::OkStatus();
 }
 
+// Moves the functions converted into the scratch package of "scratch" (other
+// than stubs) into the package of "package_data", in order. Nodes are
+// renumbered to the ids they would have had if they had been converted
+// directly into "package_data", so the result is identical to that of a
+// serial conversion.
+absl::Status MergeScratchPackage(const PackageData& scratch,
+                                 PackageData& package_data) {
+  Package* package = package_data.package;
+  XLS_RET_CHECK_EQ(package->GetOrCreateFileno(kFakeFilename),
+                   scratch.package->GetOrCreateFileno(kFakeFilename));
+
+  // Node ids skip over the nodes of the stubs, which only exist in the scratch
+  // package.
+  std::vector<int64_t> stub_node_ids;
+  for (const auto& item : scratch.stub_to_parent) {
+    for (Node* node : item.first->nodes()) {
+      stub_node_ids.push_back(node->id());
+    }
+  }
+  absl::c_sort(stub_node_ids);
+  const int64_t base_id = package->next_node_id() - 1;
+  auto merged_id = [&](Node* node) {
+    return base_id + node->id() -
+           (absl::c_lower_bound(stub_node_ids, node->id()) -
+            stub_node_ids.begin());
+  };
+  // Nodes are temporarily given fresh ids above the merged ones as they are
+  // created, so that ids are unique at all times.
+  const int64_t next_id =
+      base_id + scratch.package->next_node_id() - stub_node_ids.size();
+  package->set_next_node_id(next_id);
+
+  absl::flat_hash_map<const xls::Function*, xls::Function*> function_map(
+      scratch.stub_to_parent.begin(), scratch.stub_to_parent.end());
+  auto map_function = [&](xls::Function* f) { return function_map.at(f); };
+  for (const std::unique_ptr<xls::Function>& f : scratch.package->functions()) {
+    if (scratch.stub_to_parent.contains(f.get())) {
+      continue;
+    }
+    xls::Function* merged = package->AddFunction(
+        absl::make_unique<xls::Function>(f->name(), package));
+    absl::flat_hash_map<Node*, Node*> node_map;
+    // Nodes are created in the same order as in the scratch function (which
+    // is topological, as the function was built with a FunctionBuilder) to
+    // keep the order in which they are printed.
+    for (Node* node : f->nodes()) {
+      std::vector<Node*> operands;
+      for (Node* operand : node->operands()) {
+        XLS_RET_CHECK(node_map.contains(operand)) << node->GetName();
+        operands.push_back(node_map.at(operand));
+      }
+      // Unnamed nodes are named after their ids, so they must stay unnamed.
+      std::string name = node->HasAssignedName() ? node->GetName() : "";
+      Node* clone;
+      switch (node->op()) {
+        case Op::kCountedFor: {
+          auto* counted_for = node->As<CountedFor>();
+          XLS_ASSIGN_OR_RETURN(
+              clone, merged->MakeNodeWithName<CountedFor>(
+                         node->loc(), operands[0],
+                         absl::Span<Node* const>(operands).subspan(1),
+                         counted_for->trip_count(), counted_for->stride(),
+                         map_function(counted_for->body()), name));
+          break;
+        }
+        case Op::kMap: {
+          XLS_ASSIGN_OR_RETURN(
+              clone, merged->MakeNodeWithName<Map>(
+                         node->loc(), operands[0],
+                         map_function(node->As<Map>()->to_apply()), name));
+          break;
+        }
+        case Op::kInvoke: {
+          XLS_ASSIGN_OR_RETURN(
+              clone, merged->MakeNodeWithName<Invoke>(
+                         node->loc(), operands,
+                         map_function(node->As<Invoke>()->to_apply()),
+                         name));
+          break;
+        }
+        default: {
+          XLS_ASSIGN_OR_RETURN(clone,
+                               node->CloneInNewFunction(operands, merged));
+          break;
+        }
+      }
+      clone->SetId(merged_id(node));
+      node_map[node] = clone;
+    }
+    XLS_RETURN_IF_ERROR(
+        merged->set_return_value(node_map.at(f->return_value())));
+
+    function_map[f.get()] = merged;
+    if (scratch.wrappers.contains(f.get())) {
+      package_data.wrappers.insert(merged);
+    }
+    auto it = scratch.ir_to_dslx.find(f.get());
+    if (it != scratch.ir_to_dslx.end()) {
+      package_data.ir_to_dslx[merged] = it->second;
+    }
+  }
+  package->set_next_node_id(next_id);
+  return absl::OkStatus();
+}
+
+// Splits "records" into runs of consecutive records that don't call each
+// other, and so can be converted concurrently.
+std::vector<std::vector<const ConversionRecord*>> GetConversionBatches(
+    absl::Span<const ConversionRecord* const> records) {
+  std::vector<std::vector<const ConversionRecord*>> batches;
+  absl::flat_hash_set<std::pair<FunctionBase*, SymbolicBindings>> batch_keys;
+  for (const ConversionRecord* record : records) {
+    bool calls_batch = batches.empty();
+    for (const Callee& callee : record->callees()) {
+      calls_batch |= batch_keys.contains({callee.fb(), callee.sym_bindings()});
+    }
+    if (calls_batch) {
+      batches.emplace_back();
+      batch_keys.clear();
+    }
+    batches.back().push_back(record);
+    batch_keys.insert({record->fb(), record->symbolic_bindings()});
+  }
+  return batches;
+}
+
 }  // namespace
 
 // Converts the functions in the call graph in a specified order.
 //
+// When the import data allows for more than one thread, consecutive functions
+// that don't call each other are converted concurrently, each into its own
+// scratch package, and are then merged into the output package in order. A
+// scratch conversion that may have gone differently when converted serially
+// (because it failed to resolve a function that an earlier record of the same
+// batch defines, or because it failed outright) is redone directly in the
+// output package, so the result is always the same as that of a serial
+// conversion.
+//
 // Args:
 //   order: order for conversion
 //   import_data: Contains type information used in conversion.
@@ -2955,16 +3193,70 @@ static absl::Status ConvertCallGraph(absl::Span<const ConversionRecord> order,
                        absl::StrAppend(out, record.ToString());
                      })
               << "]";
+  std::vector<const ConversionRecord*> records;
   for (const ConversionRecord& record : order) {
-    XLS_VLOG(3) << "Converting to IR: " << record.ToString();
     if (dynamic_cast<Proc*>(record.fb()) != nullptr) {
       XLS_LOG(INFO) << "Skipping " << record.fb()->identifier() << " : "
                     << "Procs are not yet supported for IR conversion.";
       continue;
     }
-    XLS_RETURN_IF_ERROR(ConvertOneFunctionInternal(
-        package_data, record.module(), dynamic_cast<Function*>(record.fb()),
-        record.type_info(), import_data, &record.symbolic_bindings(), options));
+    records.push_back(&record);
+  }
+  auto convert = [&](const ConversionRecord& record, PackageData& data) {
+    XLS_VLOG(3) << "Converting to IR: " << record.ToString();
+    return ConvertOneFunctionInternal(
+        data, record.module(), dynamic_cast<Function*>(record.fb()),
+        record.type_info(), import_data, &record.symbolic_bindings(), options);
+  };
+
+  // When converting serially, each record is a batch of its own.
+  std::vector<std::vector<const ConversionRecord*>> batches;
+  if (import_data != nullptr && import_data->thread_count() > 1) {
+    batches = GetConversionBatches(records);
+  } else {
+    for (const ConversionRecord* record : records) {
+      batches.push_back({record});
+    }
+  }
+  for (absl::Span<const ConversionRecord* const> batch : batches) {
+    if (batch.size() == 1) {
+      XLS_RETURN_IF_ERROR(convert(*batch[0], package_data));
+      continue;
+    }
+
+    // The output package is only read while the batch is being converted.
+    IndexPackageFunctions(package_data);
+    std::vector<std::unique_ptr<Package>> scratch_packages;
+    std::vector<PackageData> scratch_data;
+    scratch_data.reserve(batch.size());
+    for (int64_t i = 0; i < batch.size(); ++i) {
+      scratch_packages.push_back(
+          absl::make_unique<Package>(package_data.package->name()));
+      scratch_data.push_back(PackageData{scratch_packages.back().get()});
+      scratch_data.back().parent = &package_data;
+    }
+    std::vector<absl::Status> statuses(batch.size());
+    import_data->GetThreadPool().ParallelFor(batch.size(), [&](int64_t i) {
+      statuses[i] = convert(*batch[i], scratch_data[i]);
+    });
+
+    for (int64_t i = 0; i < batch.size(); ++i) {
+      // Channels are numbered per package, so functions that declare them
+      // are converted in place.
+      bool redo =
+          !statuses[i].ok() || !scratch_data[i].package->channels().empty();
+      for (const std::string& name : scratch_data[i].missing_functions) {
+        XLS_ASSIGN_OR_RETURN(xls::Function * f,
+                             GetPackageFunction(package_data, name));
+        redo |= f != nullptr;
+      }
+      if (redo) {
+        XLS_VLOG(3) << "Redoing conversion of " << batch[i]->ToString();
+        XLS_RETURN_IF_ERROR(convert(*batch[i], package_data));
+      } else {
+        XLS_RETURN_IF_ERROR(MergeScratchPackage(scratch_data[i], package_data));
+      }
+    }
   }
 
   XLS_VLOG(3) << "Verifying converted package";
@@ -12,15 +12,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <filesystem>
+#include <memory>
 #include <string>
+#include <system_error>
+#include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
+#include "absl/types/optional.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/dslx/command_line_utils.h"
 #include "xls/dslx/error_printer.h"
+#include "xls/dslx/ir_conversion_cache.h"
 #include "xls/dslx/ir_converter.h"
 #include "xls/dslx/parser.h"
 #include "xls/dslx/scanner.h"
@@ -38,6 +47,11 @@ ABSL_FLAG(
 
 ABSL_FLAG(bool, emit_fail_as_assert, true,
           "Feature flag for emitting fail!() in the DSL as an assert IR op.");
+ABSL_FLAG(std::string, cache_dir, "",
+          "Directory of a persistent cache of conversion results; when given, "
+          "an invocation whose inputs, (transitively) imported modules and "
+          "flags are unchanged since a previous one reuses its output instead "
+          "of parsing and typechecking anything.");
 
 namespace xls::dslx {
 namespace {
@@ -83,10 +97,15 @@ absl::StatusOr<std::string> PathToName(absl::string_view path) {
 
 // Adds IR-converted symbols from the module specified by "path" to the given
 // "package".
+//
+// "import_data" is shared across all the paths given on the command line, so
+// modules they have in common in their import DAG (e.g. the standard library)
+// are only parsed and typechecked once. The parsed module for "path" is
+// appended to "modules", which must outlive "import_data".
 static absl::Status AddPathToPackage(
     absl::string_view path, absl::optional<absl::string_view> entry,
-    const ConvertOptions& convert_options,
-    absl::Span<const std::filesystem::path> dslx_paths, Package* package,
+    const ConvertOptions& convert_options, ImportData* import_data,
+    std::vector<std::unique_ptr<Module>>* modules, Package* package,
     bool* printed_error) {
   // Read the `.x` contents.
   XLS_ASSIGN_OR_RETURN(std::string text, GetFileContents(path));
@@ -97,14 +116,9 @@ static absl::Status AddPathToPackage(
                        ParseText(text, module_name, /*print_on_error=*/true,
                                  /*filename=*/path, printed_error));
 
-  // TODO(leary): 2021-07-21 We should be able to reuse the type checking if
-  // there are overlapping nodes in the module DAG between files to process. For
-  // now we throw it away for each file and re-derive it (we need to refactor to
-  // make the modules outlive any given AddPathToPackage() if we want to
-  // appropriately reuse things in ImportData).
-  ImportData import_data(dslx_paths);
-  absl::StatusOr<TypeInfo*> type_info_or =
-      CheckModule(module.get(), &import_data);
+  Module* m = module.get();
+  modules->push_back(std::move(module));
+  absl::StatusOr<TypeInfo*> type_info_or = CheckModule(m, import_data);
   if (!type_info_or.ok()) {
     *printed_error = TryPrintError(type_info_or.status());
     return type_info_or.status();
@@ -112,22 +126,74 @@ static absl::Status AddPathToPackage(
 
   if (entry.has_value()) {
     XLS_RETURN_IF_ERROR(ConvertOneFunctionIntoPackage(
-        module.get(), entry.value(),
-        /*import_data=*/&import_data,
+        m, entry.value(), import_data,
         /*symbolic_bindings=*/nullptr, convert_options, package));
   } else {
-    XLS_RETURN_IF_ERROR(
-        ConvertModuleIntoPackage(module.get(), &import_data, convert_options,
-                                 /*traverse_tests=*/false, package));
+    XLS_RETURN_IF_ERROR(ConvertModuleIntoPackage(m, import_data,
+                                                 convert_options,
+                                                 /*traverse_tests=*/false,
+                                                 package));
   }
   return absl::OkStatus();
 }
 
+// Returns the key for the conversion of "paths" (with the given flags) in an
+// IrConversionCache. Besides the flags and the contents of the inputs, this
+// covers the identity of the converter binary itself, so rebuilding it
+// invalidates previous results.
+static absl::StatusOr<std::string> GetCacheKey(
+    absl::Span<const absl::string_view> paths,
+    absl::optional<absl::string_view> entry,
+    absl::optional<absl::string_view> package_name,
+    absl::Span<const std::filesystem::path> dslx_paths,
+    bool emit_fail_as_assert) {
+  XLS_ASSIGN_OR_RETURN(std::filesystem::path binary_path,
+                       GetRealPath("/proc/self/exe"));
+  std::error_code ec;
+  uintmax_t binary_size = std::filesystem::file_size(binary_path, ec);
+  auto binary_time = std::filesystem::last_write_time(binary_path, ec);
+  if (ec) {
+    return absl::InternalError(absl::StrFormat(
+        "Could not stat %s: %s", binary_path.string(), ec.message()));
+  }
+  std::string key = absl::StrFormat(
+      "binary=%s:%d:%d\nentry=%s\npackage_name=%s\nemit_fail_as_assert=%d\n",
+      binary_path.string(), binary_size,
+      binary_time.time_since_epoch().count(), entry.value_or(""),
+      package_name.value_or(""), emit_fail_as_assert);
+  for (const std::filesystem::path& dslx_path : dslx_paths) {
+    absl::StrAppend(&key, "dslx_path=", dslx_path.string(), "\n");
+  }
+  for (absl::string_view path : paths) {
+    XLS_ASSIGN_OR_RETURN(std::string text, GetFileContents(path));
+    absl::StrAppend(&key, "input=", path, ":", ContentHash(text), "\n");
+  }
+  return key;
+}
+
 absl::Status RealMain(absl::Span<const absl::string_view> paths,
                       absl::optional<absl::string_view> entry,
                       absl::optional<absl::string_view> package_name,
                       absl::Span<const std::filesystem::path> dslx_paths,
-                      bool emit_fail_as_assert, bool* printed_error) {
+                      bool emit_fail_as_assert,
+                      absl::optional<std::filesystem::path> cache_dir,
+                      bool* printed_error) {
+  absl::optional<IrConversionCache> cache;
+  std::string cache_key;
+  if (cache_dir.has_value()) {
+    cache.emplace(*cache_dir);
+    XLS_ASSIGN_OR_RETURN(cache_key,
+                         GetCacheKey(paths, entry, package_name, dslx_paths,
+                                     emit_fail_as_assert));
+    XLS_ASSIGN_OR_RETURN(absl::optional<std::string> cached_ir,
+                         cache->Lookup(cache_key));
+    if (cached_ir.has_value()) {
+      XLS_VLOG(1) << "Using cached conversion result from " << *cache_dir;
+      std::cout << *cached_ir;
+      return absl::OkStatus();
+    }
+  }
+
   absl::optional<xls::Package> package;
   if (package_name.has_value()) {
     package.emplace(package_name.value());
@@ -151,12 +217,36 @@ absl::Status RealMain(absl::Span<const absl::string_view> paths,
       .emit_positions = true,
       .emit_fail_as_assert = emit_fail_as_assert,
   };
+  // Note: "modules" is declared before "import_data" so that the type
+  // information in the latter is destroyed before the AST it refers to.
+  std::vector<std::unique_ptr<Module>> modules;
+  ImportData import_data(dslx_paths);
   for (absl::string_view path : paths) {
     XLS_RETURN_IF_ERROR(AddPathToPackage(path, entry, convert_options,
-                                         dslx_paths, &package.value(),
-                                         printed_error));
+                                         &import_data, &modules,
+                                         &package.value(), printed_error));
+  }
+  std::string ir = package->DumpIr();
+
+  if (cache.has_value()) {
+    std::vector<std::filesystem::path> dependencies(paths.begin(), paths.end());
+    for (const std::unique_ptr<Module>& module : modules) {
+      XLS_ASSIGN_OR_RETURN(std::vector<std::filesystem::path> imported,
+                           GetImportedPaths(module.get(), &import_data));
+      dependencies.insert(dependencies.end(), imported.begin(), imported.end());
+    }
+    std::sort(dependencies.begin(), dependencies.end());
+    dependencies.erase(std::unique(dependencies.begin(), dependencies.end()),
+                       dependencies.end());
+    // Failing to populate the cache only costs a future invocation time, so it
+    // doesn't fail this one.
+    if (absl::Status status = cache->Store(cache_key, dependencies, ir);
+        !status.ok()) {
+      XLS_LOG(WARNING) << "Could not store conversion result in cache: "
+                       << status;
+    }
   }
-  std::cout << package->DumpIr();
+  std::cout << ir;
 
   return absl::OkStatus();
 }
@@ -192,10 +282,16 @@ int main(int argc, char* argv[]) {
   }
 
   bool emit_fail_as_assert = absl::GetFlag(FLAGS_emit_fail_as_assert);
+
+  absl::optional<std::filesystem::path> cache_dir;
+  if (!absl::GetFlag(FLAGS_cache_dir).empty()) {
+    cache_dir = absl::GetFlag(FLAGS_cache_dir);
+  }
+
   bool printed_error = false;
   absl::Status status =
       xls::dslx::RealMain(args, entry, package_name, dslx_paths,
-                          emit_fail_as_assert, &printed_error);
+                          emit_fail_as_assert, cache_dir, &printed_error);
   if (printed_error) {
     return EXIT_FAILURE;
   }
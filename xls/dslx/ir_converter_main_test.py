@@ -32,8 +32,11 @@ class IrConverterMainTest(test_base.TestCase):
 
   def _ir_convert(self,
                   dslx_contents: Dict[str, str],
-                  package_name: Optional[str] = None) -> str:
-    tempdir = self.create_tempdir()
+                  package_name: Optional[str] = None,
+                  tempdir: Optional[str] = None,
+                  cache_dir: Optional[str] = None) -> str:
+    if tempdir is None:
+      tempdir = self.create_tempdir().full_path
     tempfiles = []
     for filename, contents in dslx_contents.items():
       path = os.path.join(tempdir, filename)
@@ -43,6 +46,8 @@ class IrConverterMainTest(test_base.TestCase):
     cmd = [self.IR_CONVERTER_MAIN_PATH] + tempfiles
     if package_name is not None:
       cmd.append('--package_name=' + package_name)
+    if cache_dir is not None:
+      cmd.append('--cache_dir=' + cache_dir)
     return subprocess.check_output(cmd, encoding='utf-8')
 
   def test_a_dot_x(self) -> None:
@@ -86,6 +91,35 @@ class IrConverterMainTest(test_base.TestCase):
     }
     """))
 
+  def test_cache_dir(self) -> None:
+    tempdir = self.create_tempdir().full_path
+    cache_dir = self.create_tempdir().full_path
+    first = self._ir_convert({'a.x': self.A_DOT_X},
+                             tempdir=tempdir,
+                             cache_dir=cache_dir)
+    self.assertIn('literal(value=42', first)
+
+    # Tamper with the cached IR: the second invocation printing it shows that
+    # the module was not converted again.
+    [entry] = os.listdir(cache_dir)
+    entry_path = os.path.join(cache_dir, entry)
+    with open(entry_path) as f:
+      contents = f.read()
+    with open(entry_path, 'w') as f:
+      f.write(contents.replace('value=42', 'value=43'))
+    self.assertEqual(
+        self._ir_convert({'a.x': self.A_DOT_X},
+                         tempdir=tempdir,
+                         cache_dir=cache_dir),
+        first.replace('value=42', 'value=43'))
+
+    # Changing the input invalidates the entry.
+    self.assertIn(
+        'literal(value=64',
+        self._ir_convert({'a.x': self.B_DOT_X},
+                         tempdir=tempdir,
+                         cache_dir=cache_dir))
+
 
 if __name__ == '__main__':
   test_base.main()
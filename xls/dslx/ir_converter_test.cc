@@ -1452,6 +1452,62 @@ fn main(x:u32) -> () {
   ExpectIr(converted, TestName());
 }
 
+TEST(IrConverterTest, ConcurrentConversionMatchesSerial) {
+  // Independent functions (which are converted concurrently) that instantiate
+  // the same parametrics, map the same builtin, contain loops, fail and
+  // declare channels, and are invoked from several levels up.
+  const std::string kProgram = R"(
+fn double<N: u32>(x: bits[N]) -> bits[N] { x + x }
+
+fn clzs(x: u8[4]) -> u8[4] { map(x, clz) }
+
+fn ctzs(x: u8[4]) -> u8[4] { map(x, ctz) }
+
+fn more_clzs(x: u8[4]) -> u8[4] { map(x, clz) }
+
+fn sum(x: u8[4]) -> u8 {
+  for (i, accum): (u32, u8) in range(u32:0, u32:4) {
+    accum + x[i]
+  }(u8:0)
+}
+
+fn checked(x: u8) -> u8 { fail!(x) if x == u8:0 else double(x) }
+
+fn chans() -> () {
+  let (p, c) = chan u32;
+  ()
+}
+
+fn a(x: u8[4]) -> u8 { sum(clzs(x)) + double(x[u32:0]) }
+
+fn b(x: u8[4]) -> u8 { sum(ctzs(x)) + checked(x[u32:1]) }
+
+fn c(x: u8[4]) -> u16 { double(sum(more_clzs(x)) as u16) }
+
+fn main(x: u8[4]) -> u16 {
+  let _ = chans();
+  (a(x) + b(x)) as u16 + c(x)
+}
+)";
+
+  // The channels are never used, which the verifier rejects.
+  ConvertOptions options;
+  options.verify_ir = false;
+  ImportData serial_import_data;
+  serial_import_data.set_thread_count(1);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::string serial,
+      ConvertModuleForTest(kProgram, options, &serial_import_data));
+  for (int64_t thread_count : {2, 4, 8}) {
+    ImportData import_data;
+    import_data.set_thread_count(thread_count);
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::string concurrent,
+        ConvertModuleForTest(kProgram, options, &import_data));
+    EXPECT_EQ(serial, concurrent) << "thread count: " << thread_count;
+  }
+}
+
 }  // namespace
 }  // namespace xls::dslx
 
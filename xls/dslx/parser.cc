@@ -20,6 +20,7 @@
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/dslx/ast.h"
+#include "xls/dslx/frame_layout.h"
 #include "xls/dslx/scanner.h"
 
 namespace xls::dslx {
@@ -1049,9 +1050,11 @@ absl::StatusOr<Function*> Parser::ParseFunctionInternal(
       Token end_brace,
       PopTokenOrError(TokenKind::kCBrace, nullptr,
                       "Expected '}' at end of function body."));
-  return module_->Make<Function>(Span(start_pos, end_brace.span().limit()),
-                                 name_def, parametric_bindings, params,
-                                 return_type, body, is_public);
+  Function* f = module_->Make<Function>(
+      Span(start_pos, end_brace.span().limit()), name_def, parametric_bindings,
+      params, return_type, body, is_public);
+  FrameLayout::AssignFrameSlots(f);
+  return f;
 }
 
 absl::StatusOr<QuickCheck*> Parser::ParseQuickCheck(
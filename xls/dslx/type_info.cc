@@ -32,6 +32,7 @@ std::string InstantiationData::ToString() const {
 // -- class TypeInfoOwner
 
 absl::StatusOr<TypeInfo*> TypeInfoOwner::New(Module* module, TypeInfo* parent) {
+  absl::MutexLock lock(&mutex_);
   // Note: private constructor so not using make_unique.
   type_infos_.push_back(absl::WrapUnique(new TypeInfo(module, parent)));
   TypeInfo* result = type_infos_.back().get();
@@ -52,6 +53,7 @@ absl::StatusOr<TypeInfo*> TypeInfoOwner::New(Module* module, TypeInfo* parent) {
 }
 
 absl::StatusOr<TypeInfo*> TypeInfoOwner::GetRootTypeInfo(Module* module) {
+  absl::MutexLock lock(&mutex_);
   auto it = module_to_root_.find(module);
   if (it == module_to_root_.end()) {
     return absl::NotFoundError(absl::StrCat(
@@ -63,10 +65,12 @@ absl::StatusOr<TypeInfo*> TypeInfoOwner::GetRootTypeInfo(Module* module) {
 // -- class TypeInfo
 
 void TypeInfo::NoteConstExpr(Expr* const_expr, InterpValue value) {
+  absl::MutexLock lock(&mutex_);
   const_exprs_.insert({const_expr, value});
 }
 
 absl::optional<InterpValue> TypeInfo::GetConstExpr(Expr* const_expr) {
+  absl::ReaderMutexLock lock(&mutex_);
   if (auto it = const_exprs_.find(const_expr); it != const_exprs_.end()) {
     return it->second;
   }
@@ -75,10 +79,17 @@ absl::optional<InterpValue> TypeInfo::GetConstExpr(Expr* const_expr) {
 
 bool TypeInfo::Contains(AstNode* key) const {
   XLS_CHECK_EQ(key->owner(), module_);
-  return dict_.contains(key) || (parent_ != nullptr && parent_->Contains(key));
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    if (dict_.contains(key)) {
+      return true;
+    }
+  }
+  return parent_ != nullptr && parent_->Contains(key);
 }
 
 std::string TypeInfo::GetImportsDebugString() const {
+  absl::ReaderMutexLock lock(&mutex_);
   return absl::StrFormat(
       "module %s imports:\n  %s", module()->name(),
       absl::StrJoin(imports_, "\n  ", [](std::string* out, const auto& item) {
@@ -90,9 +101,12 @@ absl::optional<ConcreteType*> TypeInfo::GetItem(AstNode* key) const {
   XLS_CHECK_EQ(key->owner(), module_)
       << key->owner()->name() << " vs " << module_->name()
       << " key: " << key->ToString();
-  auto it = dict_.find(key);
-  if (it != dict_.end()) {
-    return it->second.get();
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = dict_.find(key);
+    if (it != dict_.end()) {
+      return it->second.get();
+    }
   }
   if (parent_ != nullptr) {
     return parent_->GetItem(key);
@@ -110,9 +124,10 @@ void TypeInfo::AddInstantiationCallBindings(Instantiation* call,
               << call->ToString() << " @ " << call->span()
               << " caller: " << caller.ToString()
               << " callee: " << callee.ToString();
+  absl::MutexLock lock(&top->mutex_);
   auto it = top->instantiations_.find(call);
   if (it == top->instantiations_.end()) {
-    absl::flat_hash_map<SymbolicBindings, SymbolicBindings> symbind_map;
+    absl::node_hash_map<SymbolicBindings, SymbolicBindings> symbind_map;
     symbind_map.emplace(std::move(caller), std::move(callee));
     top->instantiations_[call] =
         InstantiationData{call, std::move(symbind_map)};
@@ -131,10 +146,39 @@ bool TypeInfo::HasInstantiation(Instantiation* instantiation,
   return GetInstantiationTypeInfo(instantiation, caller).has_value();
 }
 
+void TypeInfo::NoteParametricInstance(FunctionBase* f,
+                                      SymbolicBindings callee,
+                                      TypeInfo* type_info) {
+  XLS_CHECK_EQ(f->owner(), module_);
+  TypeInfo* top = GetRoot();
+  absl::MutexLock lock(&top->mutex_);
+  auto [it, inserted] = top->parametric_instances_.insert(
+      {{f, std::move(callee)}, type_info});
+  if (inserted) {
+    top->parametric_instance_stats_.instantiations++;
+  }
+}
+
+absl::optional<TypeInfo*> TypeInfo::GetParametricInstance(
+    FunctionBase* f, const SymbolicBindings& callee) {
+  XLS_CHECK_EQ(f->owner(), module_);
+  TypeInfo* top = GetRoot();
+  absl::MutexLock lock(&top->mutex_);
+  auto it = top->parametric_instances_.find(std::make_pair(f, callee));
+  if (it == top->parametric_instances_.end()) {
+    return absl::nullopt;
+  }
+  top->parametric_instance_stats_.cache_hits++;
+  XLS_VLOG(5) << "Reusing parametric instance of " << f->identifier()
+              << " with bindings " << callee << ": " << it->second;
+  return it->second;
+}
+
 absl::optional<bool> TypeInfo::GetRequiresImplicitToken(FunctionBase* f) const {
   XLS_CHECK_EQ(f->owner(), module_) << "function owner: " << f->owner()->name()
                                     << " module: " << module_->name();
   const TypeInfo* root = GetRoot();
+  absl::ReaderMutexLock lock(&root->mutex_);
   const absl::flat_hash_map<FunctionBase*, bool>& map =
       root->requires_implicit_token_;
   auto it = map.find(f);
@@ -153,6 +197,7 @@ void TypeInfo::NoteRequiresImplicitToken(FunctionBase* f, bool is_required) {
   XLS_VLOG(6) << absl::StreamFormat(
       "NoteRequiresImplicitToken %p: %s::%s => %s", root, f->owner()->name(),
       f->identifier(), is_required ? "true" : "false");
+  absl::MutexLock lock(&root->mutex_);
   root->requires_implicit_token_.emplace(f, is_required);
 }
 
@@ -161,6 +206,7 @@ absl::optional<TypeInfo*> TypeInfo::GetInstantiationTypeInfo(
   XLS_CHECK_EQ(instantiation->owner(), module_)
       << instantiation->owner()->name() << " vs " << module_->name();
   const TypeInfo* top = GetRoot();
+  absl::ReaderMutexLock lock(&top->mutex_);
   auto it = top->instantiations_.find(instantiation);
   if (it == top->instantiations_.end()) {
     XLS_VLOG(5) << "Could not find instantiation for invocation: "
@@ -183,6 +229,7 @@ void TypeInfo::SetInstantiationTypeInfo(Instantiation* instantiation,
                                         TypeInfo* type_info) {
   XLS_CHECK_EQ(instantiation->owner(), module_);
   TypeInfo* top = GetRoot();
+  absl::MutexLock lock(&top->mutex_);
   InstantiationData& data = top->instantiations_[instantiation];
   data.instantiations[caller] = type_info;
 }
@@ -197,8 +244,9 @@ TypeInfo::GetInstantiationCalleeBindings(Instantiation* instantiation,
       "TypeInfo %p getting instantiation symbolic bindings: %p %s @ %s %s", top,
       instantiation, instantiation->ToString(),
       instantiation->span().ToString(), caller.ToString());
-  auto it = top->instantiations().find(instantiation);
-  if (it == top->instantiations().end()) {
+  absl::ReaderMutexLock lock(&top->mutex_);
+  auto it = top->instantiations_.find(instantiation);
+  if (it == top->instantiations_.end()) {
     XLS_VLOG(3) << "Could not find instantiation " << instantiation
                 << " in top-level type info: " << top;
     return absl::nullopt;
@@ -223,6 +271,7 @@ void TypeInfo::AddSliceStartAndWidth(Slice* node,
                                      StartAndWidth start_width) {
   XLS_CHECK_EQ(node->owner(), module_);
   TypeInfo* top = GetRoot();
+  absl::MutexLock lock(&top->mutex_);
   auto it = top->slices_.find(node);
   if (it == top->slices_.end()) {
     top->slices_[node] =
@@ -237,6 +286,7 @@ absl::optional<StartAndWidth> TypeInfo::GetSliceStartAndWidth(
     Slice* node, const SymbolicBindings& symbolic_bindings) const {
   XLS_CHECK_EQ(node->owner(), module_);
   const TypeInfo* top = GetRoot();
+  absl::ReaderMutexLock lock(&top->mutex_);
   auto it = top->slices_.find(node);
   if (it == top->slices_.end()) {
     return absl::nullopt;
@@ -251,7 +301,9 @@ absl::optional<StartAndWidth> TypeInfo::GetSliceStartAndWidth(
 
 void TypeInfo::AddImport(Import* import, Module* module, TypeInfo* type_info) {
   XLS_CHECK_EQ(import->owner(), module_);
-  GetRoot()->imports_[import] = ImportedInfo{module, type_info};
+  TypeInfo* root = GetRoot();
+  absl::MutexLock lock(&root->mutex_);
+  root->imports_[import] = ImportedInfo{module, type_info};
 }
 
 absl::optional<const ImportedInfo*> TypeInfo::GetImported(
@@ -260,6 +312,7 @@ absl::optional<const ImportedInfo*> TypeInfo::GetImported(
       << "Import node from: " << import->owner()->name() << " vs TypeInfo for "
       << module_->name();
   auto* self = GetRoot();
+  absl::ReaderMutexLock lock(&self->mutex_);
   auto it = self->imports_.find(import);
   if (it == self->imports_.end()) {
     return absl::nullopt;
@@ -275,6 +328,7 @@ absl::optional<TypeInfo*> TypeInfo::GetImportedTypeInfo(Module* m) {
   if (m == module()) {
     return this;
   }
+  absl::ReaderMutexLock lock(&mutex_);
   for (auto& [import, info] : imports_) {
     if (info.module == m) {
       return info.type_info;
@@ -285,14 +339,17 @@ absl::optional<TypeInfo*> TypeInfo::GetImportedTypeInfo(Module* m) {
 
 absl::optional<Expr*> TypeInfo::GetConstant(NameDef* name_def) const {
   XLS_CHECK_EQ(name_def->owner(), module_);
-  auto it = name_to_const_.find(name_def);
-  if (it == name_to_const_.end()) {
-    if (parent_ != nullptr) {
-      return parent_->GetConstant(name_def);
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = name_to_const_.find(name_def);
+    if (it != name_to_const_.end()) {
+      return it->second->value();
     }
-    return absl::nullopt;
   }
-  return it->second->value();
+  if (parent_ != nullptr) {
+    return parent_->GetConstant(name_def);
+  }
+  return absl::nullopt;
 }
 
 TypeInfo::TypeInfo(Module* module, TypeInfo* parent)
@@ -17,6 +17,10 @@
 #ifndef XLS_DSLX_TYPE_INFO_H_
 #define XLS_DSLX_TYPE_INFO_H_
 
+#include <utility>
+
+#include "absl/container/node_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/dslx/ast.h"
 #include "xls/dslx/concrete_type.h"
 #include "xls/dslx/symbolic_bindings.h"
@@ -51,8 +55,9 @@ struct InstantiationData {
   // Invocation/Spawn AST node.
   Instantiation* node;
   // Map from symbolic bindings in the caller to the corresponding symbolic
-  // bindings in the callee for this invocation.
-  absl::flat_hash_map<SymbolicBindings, SymbolicBindings> symbolic_bindings_map;
+  // bindings in the callee for this invocation. (Node-based, as
+  // GetInstantiationCalleeBindings() hands out pointers to the values.)
+  absl::node_hash_map<SymbolicBindings, SymbolicBindings> symbolic_bindings_map;
   // Type information that is specialized for a particular parametric
   // instantiation of an invocation.
   absl::flat_hash_map<SymbolicBindings, TypeInfo*> instantiations;
@@ -81,16 +86,24 @@ class TypeInfoOwner {
   absl::StatusOr<TypeInfo*> GetRootTypeInfo(Module* module);
 
  private:
+  absl::Mutex mutex_;
+
   // Mapping from module to the "root" (or "parentmost") type info -- these have
   // nullptr as their parent. There should only be one of these for any given
   // module.
-  absl::flat_hash_map<Module*, TypeInfo*> module_to_root_;
+  absl::flat_hash_map<Module*, TypeInfo*> module_to_root_
+      ABSL_GUARDED_BY(mutex_);
 
   // Owned type information objects -- TypeInfoOwner is the lifetime owner for
   // these.
-  std::vector<std::unique_ptr<TypeInfo>> type_infos_;
+  std::vector<std::unique_ptr<TypeInfo>> type_infos_ ABSL_GUARDED_BY(mutex_);
 };
 
+// Note on threading: modules that don't (transitively) import each other are
+// typechecked concurrently (see PrefetchImports()), and parametric
+// instantiations of a common import's functions note their information in that
+// import's root type info, so the accessors below are safe to call from
+// multiple threads.
 class TypeInfo {
  public:
   // Type information can be "differential"; e.g. when we obtain type
@@ -153,10 +166,52 @@ class TypeInfo {
   absl::optional<TypeInfo*> GetInstantiationTypeInfo(
       Instantiation* instantiation, const SymbolicBindings& caller) const;
 
+  // Notes the derived type information that was determined for parametric
+  // function "f" instantiated with "callee" symbolic bindings.
+  //
+  // Unlike SetInstantiationTypeInfo() this is not tied to any particular
+  // invocation: the type information of an instantiated body only depends on
+  // the callee's symbolic bindings, so later invocations of "f" with the same
+  // bindings (from anywhere in the module DAG) can reuse it instead of
+  // typechecking the body again. Lives on the root type info of f's module.
+  void NoteParametricInstance(FunctionBase* f, SymbolicBindings callee,
+                              TypeInfo* type_info);
+
+  // Retrieves type information noted via NoteParametricInstance(), if present.
+  // Lookups are counted in the instance stats below.
+  absl::optional<TypeInfo*> GetParametricInstance(
+      FunctionBase* f, const SymbolicBindings& callee);
+
+  // Held by an importer while it typechecks a parametric instantiation of one
+  // of this module's functions, so that concurrently typechecked importers
+  // don't both instantiate (and note partial information for) the same
+  // function body: the second one finds the complete instance instead.
+  absl::Mutex& instantiation_mutex() { return GetRoot()->instantiation_mutex_; }
+
+  // Instrumentation for the parametric instance memo above.
+  struct ParametricInstanceStats {
+    // Number of distinct (function, symbolic bindings) instantiations that had
+    // their bodies typechecked.
+    int64_t instantiations = 0;
+    // Number of invocations that reused a previously noted instantiation.
+    int64_t cache_hits = 0;
+  };
+  const ParametricInstanceStats& parametric_instance_stats() const {
+    return GetRoot()->parametric_instance_stats_;
+  }
+
   // Sets the type associated with the given AST node.
+  //
+  // A previously set type is kept if it is equal to "value": other threads may
+  // be holding on to it (e.g. from GetItem() on an imported module's node that
+  // is deduced again during a parametric instantiation).
   void SetItem(AstNode* key, const ConcreteType& value) {
     XLS_CHECK_EQ(key->owner(), module_);
-    dict_[key] = value.CloneToUnique();
+    absl::MutexLock lock(&mutex_);
+    std::unique_ptr<ConcreteType>& slot = dict_[key];
+    if (slot == nullptr || *slot != value) {
+      slot = value.CloneToUnique();
+    }
   }
 
   // Attempts to resolve AST node 'key' in the node-to-type dictionary.
@@ -210,6 +265,7 @@ class TypeInfo {
 
   // Notes a constant definition associated with a given NameDef AST node.
   void NoteConstant(NameDef* name_def, ConstantDef* constant_def) {
+    absl::MutexLock lock(&mutex_);
     name_to_const_[name_def] = constant_def;
   }
 
@@ -232,8 +288,9 @@ class TypeInfo {
   // which imported modules are present, suitable for debugging.
   std::string GetImportsDebugString() const;
 
-  const absl::flat_hash_map<Instantiation*, InstantiationData>& instantiations()
-      const {
+  // Note: not synchronized, only for use once typechecking has completed.
+  const absl::node_hash_map<Instantiation*, InstantiationData>&
+  instantiations() const {
     return instantiations_;
   }
 
@@ -264,13 +321,20 @@ class TypeInfo {
   }
 
   Module* module_;
+  // Guards the maps below (but note that most of them are only used on the
+  // root, see GetRoot()).
+  mutable absl::Mutex mutex_;
+  absl::Mutex instantiation_mutex_;
   absl::flat_hash_map<AstNode*, std::unique_ptr<ConcreteType>> dict_;
   absl::flat_hash_map<Import*, ImportedInfo> imports_;
   absl::flat_hash_map<NameDef*, ConstantDef*> name_to_const_;
-  absl::flat_hash_map<Instantiation*, InstantiationData> instantiations_;
+  absl::node_hash_map<Instantiation*, InstantiationData> instantiations_;
   absl::flat_hash_map<Slice*, SliceData> slices_;
   absl::flat_hash_map<Expr*, InterpValue> const_exprs_;
   absl::flat_hash_map<FunctionBase*, bool> requires_implicit_token_;
+  absl::flat_hash_map<std::pair<FunctionBase*, SymbolicBindings>, TypeInfo*>
+      parametric_instances_;
+  ParametricInstanceStats parametric_instance_stats_;
   TypeInfo* parent_;  // Note: may be nullptr.
 };
 
@@ -14,6 +14,7 @@
 
 #include "xls/dslx/typecheck.h"
 
+#include "absl/synchronization/mutex.h"
 #include "absl/types/variant.h"
 #include "xls/dslx/deduce.h"
 #include "xls/dslx/deduce_ctx.h"
@@ -218,6 +219,7 @@ static absl::StatusOr<NameDef*> InstantiateBuiltinParametricMap(
     absl::optional<const ImportedInfo*> import_info =
         ctx->type_info()->GetImported(*import);
     XLS_RET_CHECK(import_info.has_value());
+    absl::MutexLock lock(&(*import_info)->type_info->instantiation_mutex());
 
     XLS_ASSIGN_OR_RETURN(
         TypeInfo * invocation_imported_type_info,
@@ -849,6 +851,10 @@ absl::StatusOr<TypeInfo*> CheckModule(Module* module, ImportData* import_data) {
                        /*typecheck_module=*/ftypecheck, import_data);
   DeduceCtx* ctx = &deduce_ctx;
 
+  // Parse and typecheck the modules in our import DAG up front, in parallel,
+  // so the imports encountered below are already done.
+  PrefetchImports(module, import_data, ftypecheck);
+
   // First, populate type info with constants, enums, resolved imports, and
   // non-parametric functions.
   for (ModuleMember& member : *module->mutable_top()) {
@@ -1138,6 +1138,51 @@ fn main() {
 )"));
 }
 
+TEST(TypecheckTest, ParametricInstancesAreReusedAcrossInvocations) {
+  absl::string_view text = R"(
+fn p<N: u32>(x: bits[N]) -> bits[N] { x + bits[N]:1 }
+fn f() -> u32 { p(u32:1) + p(u32:2) }
+fn g() -> u8 { p(u8:1) }
+)";
+  ImportData import_data;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(text, "fake.x", "fake", &import_data));
+  // The body of `p` is only typechecked for N=32 and N=8; the second N=32
+  // invocation reuses the first one's type information.
+  const TypeInfo::ParametricInstanceStats& stats =
+      tm.type_info->parametric_instance_stats();
+  EXPECT_EQ(stats.instantiations, 2);
+  EXPECT_GE(stats.cache_hits, 1);
+}
+
+TEST(TypecheckTest, ImportDagIsPrefetched) {
+  // float32 and bfloat16 both import apfloat, which imports std.
+  absl::string_view text = R"(
+import bfloat16
+import float32
+import std
+
+fn f(x: float32::F32, y: bfloat16::BF16) -> u1 {
+  std::lsb(x.sign) | y.sign
+}
+)";
+  ImportData import_data;
+  XLS_ASSERT_OK(
+      ParseAndTypecheck(text, "fake.x", "fake", &import_data).status());
+  for (absl::string_view subject : {"bfloat16", "float32", "apfloat", "std"}) {
+    ImportTokens tokens(std::vector<std::string>{std::string(subject)});
+    EXPECT_TRUE(import_data.Contains(tokens)) << subject;
+    EXPECT_FALSE(import_data.IsPrefetched(tokens)) << subject;
+  }
+}
+
+TEST(TypecheckTest, MissingImportInDagIsReported) {
+  EXPECT_THAT(Typecheck("import std\nimport this_module_does_not_exist"),
+              StatusIs(absl::StatusCode::kNotFound,
+                       HasSubstr("Could not find DSLX file for import")));
+}
+
 TEST(TypecheckParametricStructInstanceTest, BadReturnType) {
   EXPECT_THAT(
       TypecheckParametricStructInstance(
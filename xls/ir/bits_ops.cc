@@ -256,6 +256,10 @@ Bits UDiv(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits::AllOnes(lhs.bit_count());
   }
+  if (lhs.bit_count() <= 64 && rhs.bit_count() <= 64) {
+    return UBits(lhs.ToUint64().value() / rhs.ToUint64().value(),
+                 lhs.bit_count());
+  }
   BigInt quotient =
       BigInt::Div(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
   return ZeroExtend(quotient.ToUnsignedBits(), lhs.bit_count());
@@ -265,6 +269,10 @@ Bits UMod(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits(rhs.bit_count());
   }
+  if (lhs.bit_count() <= 64 && rhs.bit_count() <= 64) {
+    return UBits(lhs.ToUint64().value() % rhs.ToUint64().value(),
+                 rhs.bit_count());
+  }
   BigInt modulo =
       BigInt::Mod(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
   return ZeroExtend(modulo.ToUnsignedBits(), rhs.bit_count());
@@ -299,6 +307,9 @@ Bits SMod(const Bits& lhs, const Bits& rhs) {
 }
 
 bool UEqual(const Bits& lhs, const Bits& rhs) {
+  if (lhs.bit_count() <= 64 && rhs.bit_count() <= 64) {
+    return lhs.ToUint64().value() == rhs.ToUint64().value();
+  }
   return BigInt::MakeUnsigned(lhs) == BigInt::MakeUnsigned(rhs);
 }
 
@@ -321,6 +332,9 @@ bool ULessThanOrEqual(const Bits& lhs, const Bits& rhs) {
 }
 
 bool ULessThan(const Bits& lhs, const Bits& rhs) {
+  if (lhs.bit_count() <= 64 && rhs.bit_count() <= 64) {
+    return lhs.ToUint64().value() < rhs.ToUint64().value();
+  }
   return BigInt::LessThan(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
 }
 
@@ -345,6 +359,9 @@ bool ULessThan(const Bits& lhs, int64_t rhs) {
 }
 
 bool SEqual(const Bits& lhs, const Bits& rhs) {
+  if (lhs.bit_count() <= 64 && rhs.bit_count() <= 64) {
+    return lhs.ToInt64().value() == rhs.ToInt64().value();
+  }
   return BigInt::MakeSigned(lhs) == BigInt::MakeSigned(rhs);
 }
 
@@ -88,7 +88,16 @@ absl::StatusOr<Function*> Function::Clone(
   }
   Function* cloned_function = target_package->AddFunction(
       absl::make_unique<Function>(new_name, target_package));
+  // Clone the params first so that they keep their order, which the
+  // topological sort below doesn't preserve.
+  for (Param* param : params()) {
+    XLS_ASSIGN_OR_RETURN(original_to_clone[param],
+                         param->CloneInNewFunction({}, cloned_function));
+  }
   for (Node* node : TopoSort(const_cast<Function*>(this))) {
+    if (node->Is<Param>()) {
+      continue;
+    }
     std::vector<Node*> cloned_operands;
     for (Node* operand : node->operands()) {
       cloned_operands.push_back(original_to_clone.at(operand));
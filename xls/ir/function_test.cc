@@ -74,6 +74,21 @@ TEST_F(FunctionTest, CloneSimpleFunctionToDifferentPackage) {
   EXPECT_EQ(func_clone->package(), new_package.get());
 }
 
+TEST_F(FunctionTest, ClonePreservesParamOrder) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
+fn sub(x: bits[32], y: bits[32]) -> bits[32] {
+  ret sub.3: bits[32] = sub(y, x)
+}
+)",
+                                                          p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func_clone, func->Clone("foobar"));
+  ASSERT_EQ(func_clone->params().size(), 2);
+  EXPECT_EQ(func_clone->param(0)->GetName(), "x");
+  EXPECT_EQ(func_clone->param(1)->GetName(), "y");
+  EXPECT_EQ(func_clone->return_value()->operand(0), func_clone->param(1));
+}
+
 TEST_F(FunctionTest, DumpIrWhenParamIsRetval) {
   auto p = CreatePackage();
   FunctionBuilder b("f", p.get());
@@ -22,6 +22,7 @@
 #include "absl/strings/str_format.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/netlist/function_parser.h"
 #include "xls/netlist/netlist.pb.h"
 
 namespace xls {
@@ -120,8 +121,73 @@ absl::StatusOr<StateTableSignalProto> ProtoFromStateTableSignal(
   }
 }
 
+// Evaluates "ast" with the given input values; see ComputeTruthTable().
+absl::StatusOr<bool> EvaluateFunction(
+    const function::Ast& ast, const StateTable::InputStimulus& stimulus,
+    const StateTable* state_table) {
+  switch (ast.kind()) {
+    case function::Ast::Kind::kIdentifier: {
+      auto iter = stimulus.find(ast.name());
+      if (iter != stimulus.end()) {
+        return iter->second;
+      }
+      if (state_table != nullptr &&
+          state_table->internal_signals().contains(ast.name())) {
+        return state_table->GetSignalValue(stimulus, ast.name());
+      }
+      return absl::NotFoundError(absl::StrFormat(
+          "Identifier \"%s\" is not an input or internal signal.",
+          ast.name()));
+    }
+    case function::Ast::Kind::kLiteralZero:
+      return false;
+    case function::Ast::Kind::kLiteralOne:
+      return true;
+    case function::Ast::Kind::kNot: {
+      XLS_ASSIGN_OR_RETURN(
+          bool value,
+          EvaluateFunction(ast.children()[0], stimulus, state_table));
+      return !value;
+    }
+    case function::Ast::Kind::kAnd:
+    case function::Ast::Kind::kOr:
+    case function::Ast::Kind::kXor: {
+      XLS_ASSIGN_OR_RETURN(
+          bool lhs, EvaluateFunction(ast.children()[0], stimulus, state_table));
+      XLS_ASSIGN_OR_RETURN(
+          bool rhs, EvaluateFunction(ast.children()[1], stimulus, state_table));
+      if (ast.kind() == function::Ast::Kind::kAnd) {
+        return lhs && rhs;
+      }
+      return ast.kind() == function::Ast::Kind::kOr ? lhs || rhs : lhs != rhs;
+    }
+  }
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Unknown AST element type: %d", static_cast<int>(ast.kind())));
+}
+
 }  // namespace
 
+absl::StatusOr<uint64_t> ComputeTruthTable(
+    absl::string_view function, absl::Span<const std::string> input_names,
+    const StateTable* state_table) {
+  XLS_RET_CHECK_LE(input_names.size(), kMaxTruthTableInputs);
+  XLS_ASSIGN_OR_RETURN(
+      function::Ast ast,
+      function::Parser::ParseFunction(std::string(function)));
+  uint64_t truth_table = 0;
+  StateTable::InputStimulus stimulus;
+  for (uint64_t row = 0; row < (uint64_t{1} << input_names.size()); ++row) {
+    for (int64_t i = 0; i < input_names.size(); ++i) {
+      stimulus[input_names[i]] = (row >> i) & 1;
+    }
+    XLS_ASSIGN_OR_RETURN(bool value,
+                         EvaluateFunction(ast, stimulus, state_table));
+    truth_table |= static_cast<uint64_t>(value) << row;
+  }
+  return truth_table;
+}
+
 std::string CellKindToString(CellKind kind) {
   switch (kind) {
     case CellKind::kFlop:
@@ -366,8 +432,45 @@ absl::StatusOr<StateTableProto> StateTable::ToProto() const {
                          StateTable::FromProto(proto.state_table()));
   }
 
-  return CellLibraryEntry(cell_kind, proto.name(), proto.input_names(), pins,
-                          state_table);
+  CellLibraryEntry entry(cell_kind, proto.name(), proto.input_names(), pins,
+                         state_table);
+  // Tables stored by a preprocessing step take precedence over any computed
+  // on construction.
+  for (const auto& pin : output_pin_list.pins()) {
+    if (pin.has_truth_table()) {
+      entry.output_pin_to_truth_table_[pin.name()] = pin.truth_table();
+    }
+  }
+  return entry;
+}
+
+void CellLibraryEntry::ComputeTruthTables() {
+  if (input_names_.size() > kMaxTruthTableInputs) {
+    return;
+  }
+  const StateTable* state_table =
+      state_table_.has_value() ? &state_table_.value() : nullptr;
+  for (const auto& [pin_name, function] : output_pin_to_function_) {
+    if (function.empty()) {
+      continue;
+    }
+    // Functions which can't be tabulated are left for evaluators to handle
+    // (and report errors for) as they see fit.
+    absl::StatusOr<uint64_t> truth_table =
+        ComputeTruthTable(function, input_names_, state_table);
+    if (truth_table.ok()) {
+      output_pin_to_truth_table_[pin_name] = truth_table.value();
+    }
+  }
+}
+
+absl::optional<uint64_t> CellLibraryEntry::GetTruthTable(
+    absl::string_view pin_name) const {
+  auto iter = output_pin_to_truth_table_.find(pin_name);
+  if (iter == output_pin_to_truth_table_.end()) {
+    return absl::nullopt;
+  }
+  return iter->second;
 }
 
 absl::StatusOr<CellLibraryEntryProto> CellLibraryEntry::ToProto() const {
@@ -412,6 +515,10 @@ absl::StatusOr<CellLibraryEntryProto> CellLibraryEntry::ToProto() const {
     OutputPinProto* pin_proto = pin_list->add_pins();
     pin_proto->set_name(kv.first);
     pin_proto->set_function(kv.second);
+    absl::optional<uint64_t> truth_table = GetTruthTable(kv.first);
+    if (truth_table.has_value()) {
+      pin_proto->set_truth_table(truth_table.value());
+    }
   }
   return proto;
 }
@@ -15,12 +15,16 @@
 #ifndef XLS_NETLIST_CELL_LIBRARY_H_
 #define XLS_NETLIST_CELL_LIBRARY_H_
 
+#include <cstdint>
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "xls/netlist/netlist.pb.h"
 
 namespace xls {
@@ -141,6 +145,20 @@ class StateTable {
   std::vector<Row> rows_;
 };
 
+// Cells with at most this many inputs have their output functions precomputed
+// into truth tables; see ComputeTruthTable().
+constexpr int64_t kMaxTruthTableInputs = 6;
+
+// Evaluates "function" (a Liberty "function" attribute string) over every
+// combination of values of "input_names", returning the results packed into a
+// word: bit i of the result is the value of the function when input j has the
+// value of bit j of i. Identifiers that aren't inputs are looked up as internal
+// signals of "state_table", if provided, as Interpreter does.
+// "input_names" may hold at most kMaxTruthTableInputs entries.
+absl::StatusOr<uint64_t> ComputeTruthTable(
+    absl::string_view function, absl::Span<const std::string> input_names,
+    const StateTable* state_table = nullptr);
+
 // Represents an entry in the cell library, listing inputs/outputs an the name
 // of the cell module.
 class CellLibraryEntry {
@@ -163,7 +181,9 @@ class CellLibraryEntry {
         input_names_(input_names.begin(), input_names.end()),
         output_pin_to_function_(output_pin_to_function),
         state_table_(state_table),
-        clock_name_(clock_name) {}
+        clock_name_(clock_name) {
+    ComputeTruthTables();
+  }
 
   CellKind kind() const { return kind_; }
   const std::string& name() const { return name_; }
@@ -174,15 +194,26 @@ class CellLibraryEntry {
   const absl::optional<StateTable>& state_table() const { return state_table_; }
   absl::optional<std::string> clock_name() const { return clock_name_; }
 
+  // Returns the truth table (as described at ComputeTruthTable(), over
+  // input_names()) of the given output pin's function, if one could be
+  // computed: the cell must have at most kMaxTruthTableInputs inputs and the
+  // function must be well-formed and combinational.
+  absl::optional<uint64_t> GetTruthTable(absl::string_view pin_name) const;
+
   absl::StatusOr<CellLibraryEntryProto> ToProto() const;
 
  private:
+  // Populates output_pin_to_truth_table_ for every output pin whose function
+  // can be tabulated.
+  void ComputeTruthTables();
+
   CellKind kind_;
   std::string name_;
   std::vector<std::string> input_names_;
   OutputPinToFunction output_pin_to_function_;
   absl::optional<StateTable> state_table_;
   absl::optional<std::string> clock_name_;
+  absl::flat_hash_map<std::string, uint64_t> output_pin_to_truth_table_;
 };
 
 // Represents a library of cells. The definitions (represented in
@@ -163,6 +163,53 @@ TEST(CellLibraryTest, LutStateTable) {
   EXPECT_THAT(table.GetSignalValue(stimulus, "X"), IsOkAndHolds(false));
 }
 
+TEST(CellLibraryTest, TruthTables) {
+  CellLibraryEntry::OutputPinToFunction pins;
+  pins["Z"] = "A&B";
+  pins["ZN"] = "!((A*B)|C)";
+  pins["X"] = "!";
+  pins["Y"] = "D";
+  CellLibraryEntry entry(CellKind::kOther, "CELL",
+                         std::vector<std::string>{"A", "B", "C"}, pins,
+                         absl::nullopt);
+  // Bit i of each table is the output when A, B, and C are bits 0, 1, and 2
+  // of i.
+  EXPECT_EQ(entry.GetTruthTable("Z"), 0b10001000);
+  EXPECT_EQ(entry.GetTruthTable("ZN"), 0b00000111);
+  // Malformed functions and unknown identifiers aren't tabulated.
+  EXPECT_EQ(entry.GetTruthTable("X"), absl::nullopt);
+  EXPECT_EQ(entry.GetTruthTable("Y"), absl::nullopt);
+
+  // Tables survive a round trip through the proto.
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryEntryProto proto, entry.ToProto());
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibraryEntry from_proto,
+                           CellLibraryEntry::FromProto(proto));
+  EXPECT_EQ(from_proto.GetTruthTable("Z"), 0b10001000);
+  EXPECT_EQ(from_proto.GetTruthTable("ZN"), 0b00000111);
+  EXPECT_EQ(from_proto.GetTruthTable("X"), absl::nullopt);
+}
+
+TEST(CellLibraryTest, NoTruthTablesForWideCells) {
+  CellLibraryEntry::OutputPinToFunction pins;
+  pins["Z"] = "A&B&C&D&E&F&G";
+  CellLibraryEntry entry(
+      CellKind::kOther, "AND7",
+      std::vector<std::string>{"A", "B", "C", "D", "E", "F", "G"}, pins,
+      absl::nullopt);
+  EXPECT_EQ(entry.GetTruthTable("Z"), absl::nullopt);
+}
+
+// Functions of a state table's internal signals are tabulated by evaluating
+// the table.
+TEST(CellLibraryTest, StateTableTruthTable) {
+  CellLibraryEntry::OutputPinToFunction pins;
+  pins["O"] = "X";
+  CellLibraryEntry entry(CellKind::kOther, "LUT4",
+                         std::vector<std::string>{"I0", "I1", "I2", "I3"},
+                         pins, StateTable::FromLutMask(0x6996));
+  EXPECT_EQ(entry.GetTruthTable("O"), 0x6996);
+}
+
 }  // namespace
 }  // namespace netlist
 }  // namespace xls
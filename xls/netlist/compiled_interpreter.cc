@@ -0,0 +1,563 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "xls/netlist/compiled_interpreter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/optional.h"
+#include "absl/types/variant.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/union_find_map.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+// Buffer indices of the constant nets, shared by all (sub)modules.
+constexpr int64_t kZeroIndex = 0;
+constexpr int64_t kOneIndex = 1;
+
+}  // namespace
+
+struct CompiledInterpreter::FlatCell {
+  const rtl::Cell* cell;
+  // Pin name and buffer index for each input and output pin.
+  std::vector<std::pair<std::string, int64_t>> inputs;
+  std::vector<std::pair<std::string, int64_t>> outputs;
+  // True if this is a flop evaluated as a register (FlopMode::kRegistered).
+  bool registered = false;
+};
+
+absl::StatusOr<std::unique_ptr<CompiledInterpreter>>
+CompiledInterpreter::Create(const rtl::Netlist* netlist,
+                            const rtl::Module* module, FlopMode flop_mode) {
+  auto interpreter = absl::WrapUnique(new CompiledInterpreter(module));
+  interpreter->flop_mode_ = flop_mode;
+
+  // Top-level nets are allocated first so that GetNetIndex() can find them.
+  interpreter->net_count_ = 2;
+  XLS_ASSIGN_OR_RETURN(rtl::NetRef net_0, module->ResolveNumber(0));
+  XLS_ASSIGN_OR_RETURN(rtl::NetRef net_1, module->ResolveNumber(1));
+  absl::flat_hash_map<rtl::NetRef, int64_t> net_indices = {
+      {net_0, kZeroIndex}, {net_1, kOneIndex}};
+  for (const auto& net : module->nets()) {
+    if (!net_indices.contains(net.get())) {
+      net_indices[net.get()] = interpreter->net_count_++;
+    }
+  }
+  interpreter->top_net_indices_ = net_indices;
+
+  std::vector<FlatCell> cells;
+  XLS_RETURN_IF_ERROR(
+      interpreter->Flatten(netlist, module, std::move(net_indices), &cells));
+  XLS_ASSIGN_OR_RETURN(std::vector<const FlatCell*> order,
+                       interpreter->Levelize(cells));
+  std::vector<int64_t> cell_clusters = interpreter->Partition(cells);
+
+  // Most netlists instantiate a handful of cell types many times over, so
+  // only parse each cell function once.
+  AstCache asts;
+  int64_t cluster_count = 0;
+  for (int64_t cluster : cell_clusters) {
+    cluster_count = std::max(cluster_count, cluster + 1);
+  }
+  std::vector<Program> clusters(cluster_count);
+  for (const FlatCell* cell : order) {
+    XLS_RETURN_IF_ERROR(interpreter->CompileCell(
+        *cell, &asts, &clusters[cell_clusters[cell - cells.data()]]));
+  }
+  // Registered flops are assigned clusters, but compiled separately below.
+  clusters.erase(std::remove_if(clusters.begin(), clusters.end(),
+                                [](const Program& p) { return p.empty(); }),
+                 clusters.end());
+  std::sort(clusters.begin(), clusters.end(),
+            [](const Program& a, const Program& b) {
+              return a.size() > b.size();
+            });
+  interpreter->clusters_ = std::move(clusters);
+
+  // Registered flops compute their next state into scratch entries, so that
+  // flops feeding other flops see the current state.
+  for (const FlatCell& cell : cells) {
+    if (!cell.registered) {
+      continue;
+    }
+    FlatCell next_state_cell = cell;
+    for (auto& output : next_state_cell.outputs) {
+      int64_t scratch = interpreter->net_count_++;
+      interpreter->latches_.push_back({scratch, output.second});
+      output.second = scratch;
+    }
+    XLS_RETURN_IF_ERROR(interpreter->CompileCell(next_state_cell, &asts,
+                                                 &interpreter->next_state_));
+  }
+
+  return interpreter;
+}
+
+absl::Status CompiledInterpreter::CompileCell(const FlatCell& cell,
+                                              AstCache* asts,
+                                              Program* program) {
+  const CellLibraryEntry* entry = cell.cell->cell_library_entry();
+  for (const auto& [pin_name, net_index] : cell.outputs) {
+    if (!cell.cell->internal_pins().empty()) {
+      // State table lookups can't be expressed in terms of the cell's
+      // function, but are tabulated along with it.
+      absl::optional<uint64_t> truth_table = entry->GetTruthTable(pin_name);
+      if (!truth_table.has_value()) {
+        return absl::UnimplementedError(absl::StrFormat(
+            "Cell %s (%s) has internal pins but no truth table for output "
+            "%s; it can't be compiled.",
+            cell.cell->name(), entry->name(), pin_name));
+      }
+      CompileTruthTable(cell, truth_table.value(), cell.inputs.size(),
+                        /*depth=*/0, program);
+      program->push_back({Opcode::kStore, net_index});
+      continue;
+    }
+
+    auto key = std::make_pair(entry, pin_name);
+    auto iter = asts->find(key);
+    if (iter == asts->end()) {
+      auto function_iter = entry->output_pin_to_function().find(pin_name);
+      if (function_iter == entry->output_pin_to_function().end()) {
+        return absl::NotFoundError(
+            absl::StrFormat("Output pin \"%s\" of cell %s has no function.",
+                            pin_name, cell.cell->name()));
+      }
+      XLS_ASSIGN_OR_RETURN(
+          function::Ast ast,
+          function::Parser::ParseFunction(function_iter->second));
+      iter = asts->emplace(key, std::move(ast)).first;
+    }
+    XLS_RETURN_IF_ERROR(
+        CompileFunction(cell, iter->second, /*depth=*/0, program));
+    program->push_back({Opcode::kStore, net_index});
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CompiledInterpreter::Flatten(
+    const rtl::Netlist* netlist, const rtl::Module* module,
+    absl::flat_hash_map<rtl::NetRef, int64_t> net_indices,
+    std::vector<FlatCell>* cells) {
+  for (const auto& net : module->nets()) {
+    if (!net_indices.contains(net.get())) {
+      net_indices[net.get()] = net_count_++;
+    }
+  }
+
+  for (const auto& cell : module->cells()) {
+    absl::StatusOr<const rtl::Module*> status_or_submodule =
+        netlist->GetModule(cell->cell_library_entry()->name());
+    if (!status_or_submodule.ok()) {
+      FlatCell flat_cell{cell.get()};
+      flat_cell.registered = flop_mode_ == FlopMode::kRegistered &&
+                             cell->kind() == CellKind::kFlop;
+      for (const auto& input : cell->inputs()) {
+        flat_cell.inputs.push_back({input.name, net_indices.at(input.netref)});
+      }
+      for (const auto& output : cell->outputs()) {
+        flat_cell.outputs.push_back(
+            {output.name, output.netref == module->GetDummyRef()
+                              ? net_count_++
+                              : net_indices.at(output.netref)});
+      }
+      cells->push_back(std::move(flat_cell));
+      continue;
+    }
+
+    // Submodule instance: bind the child's ports to this module's nets by
+    // name (as Interpreter::InterpretCell() does) and inline its cells.
+    const rtl::Module* submodule = status_or_submodule.value();
+    XLS_ASSIGN_OR_RETURN(rtl::NetRef child_0, submodule->ResolveNumber(0));
+    XLS_ASSIGN_OR_RETURN(rtl::NetRef child_1, submodule->ResolveNumber(1));
+    absl::flat_hash_map<rtl::NetRef, int64_t> child_indices = {
+        {child_0, kZeroIndex}, {child_1, kOneIndex}};
+
+    const std::vector<rtl::NetRef>& child_inputs = submodule->inputs();
+    absl::Span<const std::string> child_input_names =
+        submodule->AsCellLibraryEntry()->input_names();
+    for (const auto& input : cell->inputs()) {
+      auto iter = std::find(child_input_names.begin(), child_input_names.end(),
+                            input.name);
+      XLS_RET_CHECK(iter != child_input_names.end()) << absl::StrFormat(
+          "Could not find input pin \"%s\" in module \"%s\", referenced in "
+          "cell \"%s\"!",
+          input.name, submodule->name(), cell->name());
+      child_indices[child_inputs[iter - child_input_names.begin()]] =
+          net_indices.at(input.netref);
+    }
+    for (const rtl::NetRef child_output : submodule->outputs()) {
+      for (const auto& output : cell->outputs()) {
+        if (output.name == child_output->name()) {
+          child_indices[child_output] = net_indices.at(output.netref);
+          break;
+        }
+      }
+    }
+
+    XLS_RETURN_IF_ERROR(
+        Flatten(netlist, submodule, std::move(child_indices), cells));
+  }
+
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<const CompiledInterpreter::FlatCell*>>
+CompiledInterpreter::Levelize(absl::Span<const FlatCell> cells) const {
+  // Kahn's algorithm over the flattened cells: a cell is ready once every
+  // (distinct) net it reads has been driven.
+  std::vector<std::vector<int64_t>> consumers(net_count_);
+  std::vector<int64_t> pending_inputs(cells.size());
+  for (int64_t i = 0; i < cells.size(); ++i) {
+    std::vector<int64_t> input_nets;
+    for (const auto& input : cells[i].inputs) {
+      input_nets.push_back(input.second);
+    }
+    std::sort(input_nets.begin(), input_nets.end());
+    input_nets.erase(std::unique(input_nets.begin(), input_nets.end()),
+                     input_nets.end());
+    for (int64_t net : input_nets) {
+      consumers[net].push_back(i);
+    }
+    pending_inputs[i] = input_nets.size();
+  }
+
+  std::vector<bool> available(net_count_, false);
+  std::deque<int64_t> active_nets = {kZeroIndex, kOneIndex};
+  for (const rtl::NetRef input : module_->inputs()) {
+    active_nets.push_back(top_net_indices_.at(input));
+  }
+  for (const FlatCell& cell : cells) {
+    if (cell.registered) {
+      for (const auto& output : cell.outputs) {
+        active_nets.push_back(output.second);
+      }
+    }
+  }
+  std::vector<const FlatCell*> order;
+  order.reserve(cells.size());
+  auto schedule = [&](int64_t cell_index) {
+    if (cells[cell_index].registered) {
+      return;
+    }
+    order.push_back(&cells[cell_index]);
+    for (const auto& output : cells[cell_index].outputs) {
+      active_nets.push_back(output.second);
+    }
+  };
+  for (int64_t i = 0; i < cells.size(); ++i) {
+    if (pending_inputs[i] == 0) {
+      schedule(i);
+    }
+  }
+
+  while (!active_nets.empty()) {
+    int64_t net = active_nets.front();
+    active_nets.pop_front();
+    if (available[net]) {
+      continue;
+    }
+    available[net] = true;
+    for (int64_t cell_index : consumers[net]) {
+      if (--pending_inputs[cell_index] == 0) {
+        schedule(cell_index);
+      }
+    }
+  }
+
+  for (int64_t i = 0; i < cells.size(); ++i) {
+    if (pending_inputs[i] != 0) {
+      const rtl::Cell* cell = cells[i].cell;
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Netlist contains unconnected subgraphs and cannot be translated. "
+          "Example: cell %s, output %s.",
+          cell->name(),
+          cell->outputs().empty() ? "<none>"
+                                  : cell->outputs()[0].netref->name()));
+    }
+  }
+  for (const rtl::NetRef output : module_->outputs()) {
+    if (!available[top_net_indices_.at(output)]) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Module %s output %s is not driven.", module_->name(),
+          output->name()));
+    }
+  }
+
+  return order;
+}
+
+std::vector<int64_t> CompiledInterpreter::Partition(
+    absl::Span<const FlatCell> cells) const {
+  // As in FindLogicClouds(), registered flops bound the clusters: their
+  // outputs are state, fixed for the cycle. Unlike there, cells which merely
+  // read a common net aren't merged; only driver/reader pairs need to be
+  // evaluated together, in order. The constant nets are never driven by cells,
+  // and dummy net outputs were given private entries by Flatten(), so none of
+  // them join clusters together.
+  auto merge_monostate = [](absl::monostate x, absl::monostate y) {
+    return absl::monostate();
+  };
+  auto is_constant = [](int64_t net) {
+    return net == kZeroIndex || net == kOneIndex;
+  };
+  std::vector<int64_t> drivers(net_count_, -1);
+  UnionFindMap<int64_t, absl::monostate> sets;
+  for (int64_t i = 0; i < cells.size(); ++i) {
+    sets.Insert(i, absl::monostate());
+  }
+  for (int64_t i = 0; i < cells.size(); ++i) {
+    if (cells[i].registered) {
+      continue;
+    }
+    for (const auto& output : cells[i].outputs) {
+      if (is_constant(output.second)) {
+        continue;
+      }
+      if (drivers[output.second] == -1) {
+        drivers[output.second] = i;
+      } else {
+        // Multiply-driven nets would race if their drivers ran concurrently.
+        sets.Union(i, drivers[output.second], merge_monostate);
+      }
+    }
+  }
+  for (int64_t i = 0; i < cells.size(); ++i) {
+    if (cells[i].registered) {
+      continue;
+    }
+    for (const auto& input : cells[i].inputs) {
+      if (!is_constant(input.second) && drivers[input.second] != -1) {
+        sets.Union(i, drivers[input.second], merge_monostate);
+      }
+    }
+  }
+
+  absl::flat_hash_map<int64_t, int64_t> representative_to_cluster;
+  std::vector<int64_t> cell_clusters(cells.size());
+  for (int64_t i = 0; i < cells.size(); ++i) {
+    int64_t representative = sets.Find(i)->first;
+    auto iter = representative_to_cluster
+                    .insert({representative, representative_to_cluster.size()})
+                    .first;
+    cell_clusters[i] = iter->second;
+  }
+  return cell_clusters;
+}
+
+absl::Status CompiledInterpreter::CompileFunction(const FlatCell& cell,
+                                                  const function::Ast& ast,
+                                                  int64_t depth,
+                                                  Program* program) {
+  max_stack_depth_ = std::max(max_stack_depth_, depth + 1);
+  switch (ast.kind()) {
+    case function::Ast::Kind::kIdentifier: {
+      for (const auto& input : cell.inputs) {
+        if (input.first == ast.name()) {
+          program->push_back({Opcode::kLoad, input.second});
+          return absl::OkStatus();
+        }
+      }
+      return absl::NotFoundError(
+          absl::StrFormat("Identifier \"%s\" not found in cell %s's inputs.",
+                          ast.name(), cell.cell->name()));
+    }
+    case function::Ast::Kind::kLiteralZero:
+      program->push_back({Opcode::kZero, 0});
+      return absl::OkStatus();
+    case function::Ast::Kind::kLiteralOne:
+      program->push_back({Opcode::kOne, 0});
+      return absl::OkStatus();
+    case function::Ast::Kind::kNot:
+      XLS_RETURN_IF_ERROR(
+          CompileFunction(cell, ast.children()[0], depth, program));
+      program->push_back({Opcode::kNot, 0});
+      return absl::OkStatus();
+    case function::Ast::Kind::kAnd:
+    case function::Ast::Kind::kOr:
+    case function::Ast::Kind::kXor: {
+      XLS_RETURN_IF_ERROR(
+          CompileFunction(cell, ast.children()[0], depth, program));
+      XLS_RETURN_IF_ERROR(
+          CompileFunction(cell, ast.children()[1], depth + 1, program));
+      Opcode opcode = ast.kind() == function::Ast::Kind::kAnd  ? Opcode::kAnd
+                      : ast.kind() == function::Ast::Kind::kOr ? Opcode::kOr
+                                                               : Opcode::kXor;
+      program->push_back({opcode, 0});
+      return absl::OkStatus();
+    }
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unknown AST element type: ", static_cast<int>(ast.kind())));
+}
+
+void CompiledInterpreter::CompileTruthTable(const FlatCell& cell,
+                                            uint64_t truth_table,
+                                            int64_t input_count, int64_t depth,
+                                            Program* program) {
+  max_stack_depth_ = std::max(max_stack_depth_, depth + 1);
+  int64_t row_count = int64_t{1} << input_count;
+  uint64_t mask =
+      row_count == 64 ? ~uint64_t{0} : (uint64_t{1} << row_count) - 1;
+  truth_table &= mask;
+  if (truth_table == 0) {
+    program->push_back({Opcode::kZero, 0});
+    return;
+  }
+  if (truth_table == mask) {
+    program->push_back({Opcode::kOne, 0});
+    return;
+  }
+
+  // Shannon expansion around the last input:
+  //   f = (x & f|x=1) | (~x & f|x=0)
+  // skipping the input entirely if f doesn't depend on it.
+  int64_t half = row_count / 2;
+  uint64_t low_cofactor = truth_table & ((uint64_t{1} << half) - 1);
+  uint64_t high_cofactor = truth_table >> half;
+  if (low_cofactor == high_cofactor) {
+    CompileTruthTable(cell, low_cofactor, input_count - 1, depth, program);
+    return;
+  }
+  int64_t input = cell.inputs[input_count - 1].second;
+  program->push_back({Opcode::kLoad, input});
+  CompileTruthTable(cell, high_cofactor, input_count - 1, depth + 1,
+                      program);
+  program->push_back({Opcode::kAnd, 0});
+  program->push_back({Opcode::kLoad, input});
+  program->push_back({Opcode::kNot, 0});
+  CompileTruthTable(cell, low_cofactor, input_count - 1, depth + 2,
+                      program);
+  program->push_back({Opcode::kAnd, 0});
+  program->push_back({Opcode::kOr, 0});
+}
+
+absl::StatusOr<int64_t> CompiledInterpreter::GetNetIndex(
+    rtl::NetRef net) const {
+  auto iter = top_net_indices_.find(net);
+  if (iter == top_net_indices_.end()) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Net %s is not part of module %s.", net->name(), module_->name()));
+  }
+  return iter->second;
+}
+
+void CompiledInterpreter::Execute(const Program& program,
+                                  absl::Span<uint64_t> net_values,
+                                  absl::Span<uint64_t> stack) {
+  int64_t top = -1;
+  for (const Instruction& instruction : program) {
+    switch (instruction.opcode) {
+      case Opcode::kLoad:
+        stack[++top] = net_values[instruction.net];
+        break;
+      case Opcode::kZero:
+        stack[++top] = 0;
+        break;
+      case Opcode::kOne:
+        stack[++top] = ~uint64_t{0};
+        break;
+      case Opcode::kNot:
+        stack[top] = ~stack[top];
+        break;
+      case Opcode::kAnd:
+        stack[top - 1] &= stack[top];
+        --top;
+        break;
+      case Opcode::kOr:
+        stack[top - 1] |= stack[top];
+        --top;
+        break;
+      case Opcode::kXor:
+        stack[top - 1] ^= stack[top];
+        --top;
+        break;
+      case Opcode::kStore:
+        net_values[instruction.net] = stack[top--];
+        break;
+    }
+  }
+}
+
+void CompiledInterpreter::Run(absl::Span<uint64_t> net_values,
+                              ThreadPool* thread_pool) const {
+  XLS_CHECK_EQ(static_cast<int64_t>(net_values.size()), net_count_);
+  net_values[kZeroIndex] = 0;
+  net_values[kOneIndex] = ~uint64_t{0};
+
+  // Clusters write disjoint nets and read only module inputs, flop outputs and
+  // their own nets, so they can be claimed by threads in any order. Largest
+  // first keeps the threads evenly loaded.
+  std::atomic<int64_t> next_cluster(0);
+  auto worker = [&]() {
+    std::vector<uint64_t> stack(max_stack_depth_);
+    for (int64_t i = next_cluster++; i < cluster_count(); i = next_cluster++) {
+      Execute(clusters_[i], net_values, absl::MakeSpan(stack));
+    }
+  };
+  if (thread_pool == nullptr) {
+    worker();
+  } else {
+    thread_pool->ParallelFor(
+        std::min(thread_pool->thread_count(), cluster_count()),
+        [&](int64_t) { worker(); });
+  }
+
+  if (flop_mode_ == FlopMode::kRegistered) {
+    std::vector<uint64_t> stack(max_stack_depth_);
+    Execute(next_state_, net_values, absl::MakeSpan(stack));
+    for (const auto& [scratch, output] : latches_) {
+      net_values[output] = net_values[scratch];
+    }
+  }
+}
+
+absl::StatusOr<absl::flat_hash_map<const rtl::NetRef, uint64_t>>
+CompiledInterpreter::InterpretModule(
+    const absl::flat_hash_map<const rtl::NetRef, uint64_t>& inputs) const {
+  std::vector<uint64_t> net_values(net_count_, 0);
+  for (const rtl::NetRef input : module_->inputs()) {
+    auto iter = inputs.find(input);
+    if (iter == inputs.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("No value provided for module %s input %s.",
+                          module_->name(), input->name()));
+    }
+    net_values[top_net_indices_.at(input)] = iter->second;
+  }
+
+  Run(absl::MakeSpan(net_values));
+
+  absl::flat_hash_map<const rtl::NetRef, uint64_t> outputs;
+  outputs.reserve(module_->outputs().size());
+  for (const rtl::NetRef output : module_->outputs()) {
+    outputs[output] = net_values[top_net_indices_.at(output)];
+  }
+  return outputs;
+}
+
+}  // namespace netlist
+}  // namespace xls
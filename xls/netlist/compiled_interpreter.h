@@ -0,0 +1,183 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef XLS_NETLIST_COMPILED_INTERPRETER_H_
+#define XLS_NETLIST_COMPILED_INTERPRETER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/common/thread_pool.h"
+#include "xls/netlist/function_parser.h"
+#include "xls/netlist/netlist.h"
+
+namespace xls {
+namespace netlist {
+
+// Bit-parallel netlist evaluator.
+//
+// Where Interpreter walks the netlist (and re-parses each cell's function) on
+// every evaluation, CompiledInterpreter does that work once: submodule
+// instances are flattened, every net is assigned a dense index, and cells are
+// levelized into straight-line programs of word-wide boolean operations. Each
+// net's value is held in a uint64_t whose bit i is the value of the net for
+// input vector i, so every Run() evaluates kLaneCount input vectors at once.
+//
+// Cells are partitioned into clusters which share no combinational paths -
+// with registered flops, these are the flop-bounded logic clouds of
+// FindLogicClouds() - each compiled to its own program, so that Run() can
+// evaluate them concurrently.
+//
+// Cells whose functions refer to internal ("statetable") pins are compiled
+// from their precomputed truth tables (see CellLibraryEntry::GetTruthTable());
+// such cells with too many inputs to tabulate are not supported.
+class CompiledInterpreter {
+ public:
+  // The number of input vectors evaluated by each Run().
+  static constexpr int64_t kLaneCount = 64;
+
+  // How cells of kind CellKind::kFlop are evaluated.
+  enum class FlopMode {
+    // Flops pass their inputs straight through, as in Interpreter, so Run()
+    // evaluates the module as purely combinational logic.
+    kTransparent,
+    // Flop outputs hold state: each Run() evaluates one clock cycle, computing
+    // all logic from the module inputs and the current flop outputs, and then
+    // latching each flop's next state into its outputs.
+    kRegistered,
+  };
+
+  // Compiles "module", a module of "netlist".
+  static absl::StatusOr<std::unique_ptr<CompiledInterpreter>> Create(
+      const rtl::Netlist* netlist, const rtl::Module* module,
+      FlopMode flop_mode = FlopMode::kTransparent);
+
+  // The number of words in the value buffer passed to Run().
+  int64_t net_count() const { return net_count_; }
+
+  // The number of independently-evaluable clusters the cells were partitioned
+  // into, i.e., the maximum useful thread count for Run().
+  int64_t cluster_count() const { return clusters_.size(); }
+
+  // Returns the index of the given top-module net in the value buffer.
+  absl::StatusOr<int64_t> GetNetIndex(rtl::NetRef net) const;
+
+  // Evaluates the netlist in place over "net_values", which must hold
+  // net_count() words and have its top-module input entries (and, with
+  // registered flops, its flop output entries) already set. The entries of all
+  // cell-driven nets are overwritten. If "thread_pool" is given, clusters are
+  // spread across its threads; the pool is meant to be created once and reused
+  // across calls. Safe to call concurrently on distinct buffers, though calls
+  // sharing a busy pool then evaluate their clusters serially.
+  void Run(absl::Span<uint64_t> net_values,
+           ThreadPool* thread_pool = nullptr) const;
+
+  // Convenience wrapper around Run(), in the style of
+  // Interpreter::InterpretModule(): "inputs" must map every module input to
+  // its lanes; the result maps every module output to its lanes. Registered
+  // flops start from zero.
+  absl::StatusOr<absl::flat_hash_map<const rtl::NetRef, uint64_t>>
+  InterpretModule(
+      const absl::flat_hash_map<const rtl::NetRef, uint64_t>& inputs) const;
+
+ private:
+  // Stack-machine operations making up the compiled programs. Loads and
+  // stores refer to indices into the value buffer.
+  enum class Opcode : uint8_t {
+    kLoad,
+    kZero,
+    kOne,
+    kNot,
+    kAnd,
+    kOr,
+    kXor,
+    kStore,
+  };
+
+  struct Instruction {
+    Opcode opcode;
+    int64_t net;
+  };
+  using Program = std::vector<Instruction>;
+
+  // A cell instance with its pins resolved to value buffer indices.
+  struct FlatCell;
+
+  using AstCache =
+      absl::flat_hash_map<std::pair<const CellLibraryEntry*, std::string>,
+                          function::Ast>;
+
+  explicit CompiledInterpreter(const rtl::Module* module) : module_(module) {}
+
+  // Assigns buffer indices to the nets of "module" (beyond those already in
+  // "net_indices", i.e., its ports) and appends its leaf cells to "cells",
+  // recursing into submodule instances. Cell outputs tied to the module's
+  // dummy net are each given a private scratch entry instead, so that
+  // otherwise unrelated cells don't share a driven net.
+  absl::Status Flatten(const rtl::Netlist* netlist, const rtl::Module* module,
+                       absl::flat_hash_map<rtl::NetRef, int64_t> net_indices,
+                       std::vector<FlatCell>* cells);
+
+  // Orders the combinational cells of "cells" such that every cell follows the
+  // drivers of its inputs. Registered flops are left out of the order, their
+  // outputs being available from the start.
+  absl::StatusOr<std::vector<const FlatCell*>> Levelize(
+      absl::Span<const FlatCell> cells) const;
+
+  // Returns the index of the cluster (see above) of each cell in "cells".
+  std::vector<int64_t> Partition(absl::Span<const FlatCell> cells) const;
+
+  // Appends instructions computing and storing every output of "cell".
+  absl::Status CompileCell(const FlatCell& cell, AstCache* asts,
+                           Program* program);
+
+  // Appends instructions evaluating "ast" over the inputs of "cell", leaving
+  // the result on top of the stack; "depth" is the stack depth on entry.
+  absl::Status CompileFunction(const FlatCell& cell, const function::Ast& ast,
+                               int64_t depth, Program* program);
+
+  // As CompileFunction(), but for a function of the first "input_count"
+  // inputs of "cell" given as a truth table.
+  void CompileTruthTable(const FlatCell& cell, uint64_t truth_table,
+                         int64_t input_count, int64_t depth,
+                         Program* program);
+
+  // Runs "program" over "net_values"; "stack" must hold max_stack_depth_
+  // words.
+  static void Execute(const Program& program, absl::Span<uint64_t> net_values,
+                      absl::Span<uint64_t> stack);
+
+  const rtl::Module* module_;
+  FlopMode flop_mode_ = FlopMode::kTransparent;
+  absl::flat_hash_map<rtl::NetRef, int64_t> top_net_indices_;
+  int64_t net_count_ = 0;
+  // Programs of the independent clusters, largest first.
+  std::vector<Program> clusters_;
+  // With registered flops, computes every flop's next state into a scratch
+  // entry of the value buffer, run after all clusters; "latches_" then lists
+  // the (scratch, flop output) index pairs to copy.
+  Program next_state_;
+  std::vector<std::pair<int64_t, int64_t>> latches_;
+  int64_t max_stack_depth_ = 0;
+};
+
+}  // namespace netlist
+}  // namespace xls
+
+#endif  // XLS_NETLIST_COMPILED_INTERPRETER_H_
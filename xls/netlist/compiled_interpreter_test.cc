@@ -0,0 +1,325 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "xls/netlist/compiled_interpreter.h"
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/thread_pool.h"
+#include "xls/netlist/fake_cell_library.h"
+#include "xls/netlist/interpreter.h"
+#include "xls/netlist/netlist.h"
+#include "xls/netlist/netlist_parser.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+// Returns a word whose lane i holds bit "input_index" of i, so that lanes
+// enumerate every combination of up to six inputs.
+uint64_t EnumeratingLanes(int64_t input_index) {
+  uint64_t result = 0;
+  for (int64_t lane = 0; lane < CompiledInterpreter::kLaneCount; ++lane) {
+    result |= static_cast<uint64_t>((lane >> input_index) & 1) << lane;
+  }
+  return result;
+}
+
+TEST(CompiledInterpreterTest, Submodules) {
+  std::string module_text = R"(
+module submodule_0 (i2_0, i2_1, o2_0);
+  input i2_0, i2_1;
+  output o2_0;
+
+  AND and0( .A(i2_0), .B(i2_1), .Z(o2_0) );
+endmodule
+
+module submodule_1 (i2_2, i2_3, o2_1);
+  input i2_2, i2_3;
+  output o2_1;
+
+  OR or0( .A(i2_2), .B(i2_3), .Z(o2_1) );
+endmodule
+
+module submodule_2 (i1_0, i1_1, i1_2, i1_3, o1_0);
+  input i1_0, i1_1, i1_2, i1_3;
+  output o1_0;
+  wire res0, res1;
+
+  submodule_0 and0 ( .i2_0(i1_0), .i2_1(i1_1), .o2_0(res0) );
+  submodule_1 or0 ( .i2_2(i1_2), .i2_3(i1_3), .o2_1(res1) );
+  XOR xor0 ( .A(res0), .B(res1), .Z(o1_0) );
+endmodule
+
+module main (i0, i1, i2, i3, o0);
+  input i0, i1, i2, i3;
+  output o0;
+
+  submodule_2 bleh( .i1_0(i0), .i1_1(i1), .i1_2(i2), .i1_3(i3), .o1_0(o0) );
+endmodule
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  rtl::Scanner scanner(module_text);
+  XLS_ASSERT_OK_AND_ASSIGN(auto netlist,
+                           rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(auto interpreter,
+                           CompiledInterpreter::Create(netlist.get(), module));
+
+  absl::flat_hash_map<const rtl::NetRef, uint64_t> inputs;
+  for (int64_t i = 0; i < 4; ++i) {
+    inputs[module->inputs()[i]] = EnumeratingLanes(i);
+  }
+  using OutputT = absl::flat_hash_map<const rtl::NetRef, uint64_t>;
+  XLS_ASSERT_OK_AND_ASSIGN(OutputT outputs,
+                           interpreter->InterpretModule(inputs));
+
+  EXPECT_EQ(outputs.size(), 1);
+  EXPECT_EQ(outputs[module->outputs()[0]],
+            (EnumeratingLanes(0) & EnumeratingLanes(1)) ^
+                (EnumeratingLanes(2) | EnumeratingLanes(3)));
+}
+
+// Checks every lane of the compiled interpreter against the reference
+// Interpreter on a netlist exercising each function operator and constant.
+TEST(CompiledInterpreterTest, MatchesInterpreter) {
+  std::string module_text = R"(
+module main(i0, i1, i2, i3, i4, i5, o0, o1);
+  input i0, i1, i2, i3, i4, i5;
+  output o0, o1;
+  wire aoi_out, nand_out, inv_out, one_out, nor_out;
+
+  AOI21 aoi ( .A(i0), .B(i1), .C(i2), .ZN(aoi_out) );
+  NAND nand0 ( .A(aoi_out), .B(i3), .ZN(nand_out) );
+  INV inv ( .A(i4), .ZN(inv_out) );
+  LOGIC_ONE one ( .O(one_out) );
+  NOR4 nor0 ( .A(nand_out), .B(inv_out), .C(i5), .D(i5), .ZN(nor_out) );
+  XOR xor0 ( .A(nor_out), .B(one_out), .Z(o0) );
+  AND and0 ( .A(nand_out), .B(aoi_out), .Z(o1) );
+endmodule
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  rtl::Scanner scanner(module_text);
+  XLS_ASSERT_OK_AND_ASSIGN(auto netlist,
+                           rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(auto compiled,
+                           CompiledInterpreter::Create(netlist.get(), module));
+
+  // Drive the buffer directly, as a bulk-simulation client would.
+  std::vector<uint64_t> net_values(compiled->net_count());
+  for (int64_t i = 0; i < module->inputs().size(); ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(int64_t index,
+                             compiled->GetNetIndex(module->inputs()[i]));
+    net_values[index] = EnumeratingLanes(i);
+  }
+  compiled->Run(absl::MakeSpan(net_values));
+
+  Interpreter interpreter(netlist.get());
+  for (int64_t lane = 0; lane < CompiledInterpreter::kLaneCount; ++lane) {
+    absl::flat_hash_map<const rtl::NetRef, bool> inputs;
+    for (int64_t i = 0; i < module->inputs().size(); ++i) {
+      inputs[module->inputs()[i]] = (lane >> i) & 1;
+    }
+    using OutputT = absl::flat_hash_map<const rtl::NetRef, bool>;
+    XLS_ASSERT_OK_AND_ASSIGN(OutputT expected,
+                             interpreter.InterpretModule(module, inputs));
+    for (const rtl::NetRef output : module->outputs()) {
+      XLS_ASSERT_OK_AND_ASSIGN(int64_t index, compiled->GetNetIndex(output));
+      EXPECT_EQ((net_values[index] >> lane) & 1, expected.at(output))
+          << "lane " << lane << ", output " << output->name();
+    }
+  }
+}
+
+TEST(CompiledInterpreterTest, UnconnectedSubgraph) {
+  std::string module_text = R"(
+module main(i0, o0);
+  input i0;
+  output o0;
+  wire floating;
+
+  AND and0 ( .A(i0), .B(floating), .Z(o0) );
+endmodule
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  rtl::Scanner scanner(module_text);
+  XLS_ASSERT_OK_AND_ASSIGN(auto netlist,
+                           rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  EXPECT_THAT(CompiledInterpreter::Create(netlist.get(), module),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("unconnected subgraphs")));
+}
+
+// Verifies that cells driven by [combinational] state tables are compiled from
+// their truth tables.
+TEST(CompiledInterpreterTest, StateTables) {
+  std::string module_text = R"(
+module main(i0, i1, i2, i3, o0);
+  input i0, i1, i2, i3;
+  output o0;
+  wire and0_out, and1_out;
+
+  AND and0 ( .A(i0), .B(i1), .Z(and0_out) );
+  STATETABLE_AND and1 (.A(i2), .B(i3), .Z(and1_out) );
+  AND and2 ( .A(and0_out), .B(and1_out), .Z(o0) );
+endmodule
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  rtl::Scanner scanner(module_text);
+  XLS_ASSERT_OK_AND_ASSIGN(auto netlist,
+                           rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(auto interpreter,
+                           CompiledInterpreter::Create(netlist.get(), module));
+
+  absl::flat_hash_map<const rtl::NetRef, uint64_t> inputs;
+  for (int64_t i = 0; i < 4; ++i) {
+    inputs[module->inputs()[i]] = EnumeratingLanes(i);
+  }
+  using OutputT = absl::flat_hash_map<const rtl::NetRef, uint64_t>;
+  XLS_ASSERT_OK_AND_ASSIGN(OutputT outputs,
+                           interpreter->InterpretModule(inputs));
+  EXPECT_EQ(outputs.at(module->outputs()[0]),
+            EnumeratingLanes(0) & EnumeratingLanes(1) & EnumeratingLanes(2) &
+                EnumeratingLanes(3));
+}
+
+// Clocks a two-stage shift register, checking that each Run() advances every
+// flop by exactly one stage.
+TEST(CompiledInterpreterTest, RegisteredFlops) {
+  std::string module_text = R"(
+module main(clk, i0, o0, o1);
+  input clk, i0;
+  output o0, o1;
+  wire q0, q0n;
+
+  DFF dff_0(.D(i0), .Q(q0), .CLK(clk));
+  INV inv(.A(q0), .ZN(q0n));
+  DFF dff_1(.D(q0n), .Q(o0), .CLK(clk));
+  XOR xor0(.A(q0), .B(o0), .Z(o1));
+endmodule
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  rtl::Scanner scanner(module_text);
+  XLS_ASSERT_OK_AND_ASSIGN(auto netlist,
+                           rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto interpreter,
+      CompiledInterpreter::Create(
+          netlist.get(), module,
+          CompiledInterpreter::FlopMode::kRegistered));
+
+  std::vector<uint64_t> net_values(interpreter->net_count());
+  XLS_ASSERT_OK_AND_ASSIGN(int64_t i0, interpreter->GetNetIndex(
+                                           module->inputs()[1]));
+  XLS_ASSERT_OK_AND_ASSIGN(int64_t o0, interpreter->GetNetIndex(
+                                           module->outputs()[0]));
+  XLS_ASSERT_OK_AND_ASSIGN(int64_t o1, interpreter->GetNetIndex(
+                                           module->outputs()[1]));
+  const std::vector<uint64_t> stimulus = {0x0123456789abcdefULL,
+                                          0xfedcba9876543210ULL,
+                                          0x5555aaaa5555aaaaULL, 0};
+  // Flops start from zero.
+  uint64_t q0 = 0;
+  uint64_t q1 = 0;
+  for (uint64_t value : stimulus) {
+    net_values[i0] = value;
+    interpreter->Run(absl::MakeSpan(net_values));
+    // o1 is combinational, so reflects the flop outputs before the clock edge.
+    EXPECT_EQ(net_values[o1], q0 ^ q1);
+    q1 = ~q0;
+    q0 = value;
+    EXPECT_EQ(net_values[o0], q1);
+  }
+}
+
+// Verifies that independent logic cones are compiled into separate clusters,
+// and that evaluating them concurrently gives the same results.
+TEST(CompiledInterpreterTest, MultithreadedRun) {
+  std::string module_text = R"(
+module main(clk, i0, i1, i2, i3, o0, o1, o2);
+  input clk, i0, i1, i2, i3;
+  output o0, o1, o2;
+  wire a, b, q;
+
+  AND and0 ( .A(i0), .B(i1), .Z(a) );
+  XOR xor0 ( .A(a), .B(i2), .Z(o0) );
+  OR or0 ( .A(i2), .B(i3), .Z(b) );
+  DFF dff_0(.D(b), .Q(q), .CLK(clk));
+  INV inv ( .A(q), .ZN(o1) );
+  NAND nand0 ( .A(i0), .B(i3), .ZN(o2) );
+  AND unused0 ( .A(i0), .B(i1) );
+  OR unused1 ( .A(i2), .B(i3) );
+endmodule
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  rtl::Scanner scanner(module_text);
+  XLS_ASSERT_OK_AND_ASSIGN(auto netlist,
+                           rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto interpreter,
+      CompiledInterpreter::Create(
+          netlist.get(), module,
+          CompiledInterpreter::FlopMode::kRegistered));
+  // {and0, xor0}, {or0}, {inv}, {nand0}, {unused0} and {unused1}; the flop
+  // separates or0 and inv, and the unused outputs, though all tied to the
+  // dummy net, don't join their cells together.
+  EXPECT_EQ(interpreter->cluster_count(), 6);
+
+  std::vector<uint64_t> single_threaded(interpreter->net_count());
+  std::vector<uint64_t> multithreaded(interpreter->net_count());
+  for (int64_t i = 1; i < module->inputs().size(); ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(int64_t index,
+                             interpreter->GetNetIndex(module->inputs()[i]));
+    single_threaded[index] = EnumeratingLanes(i - 1);
+    multithreaded[index] = EnumeratingLanes(i - 1);
+  }
+  // The pool is reused across cycles.
+  ThreadPool thread_pool(4);
+  for (int64_t cycle = 0; cycle < 3; ++cycle) {
+    interpreter->Run(absl::MakeSpan(single_threaded));
+    interpreter->Run(absl::MakeSpan(multithreaded), &thread_pool);
+    EXPECT_EQ(single_threaded, multithreaded);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(int64_t o1,
+                           interpreter->GetNetIndex(module->outputs()[1]));
+  EXPECT_EQ(multithreaded[o1], ~(EnumeratingLanes(2) | EnumeratingLanes(3)));
+}
+
+}  // namespace
+}  // namespace netlist
+}  // namespace xls
@@ -19,10 +19,12 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_split.h"
+#include "absl/types/optional.h"
 #include "absl/types/variant.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/netlist/cell_library.h"
 #include "xls/netlist/lib_parser.h"
 #include "xls/netlist/netlist.pb.h"
 
@@ -261,6 +263,22 @@ absl::Status ExtractFromCell(const cell_lib::Block& cell,
     }
   }
 
+  // Record the truth tables of small cells so that consumers of the
+  // preprocessed library needn't evaluate the functions themselves. Cells
+  // which can't be represented as a CellLibraryEntry are left untouched.
+  absl::StatusOr<CellLibraryEntry> library_entry =
+      CellLibraryEntry::FromProto(*entry_proto);
+  if (library_entry.ok()) {
+    for (OutputPinProto& pin :
+         *entry_proto->mutable_output_pin_list()->mutable_pins()) {
+      absl::optional<uint64_t> truth_table =
+          library_entry->GetTruthTable(pin.name());
+      if (truth_table.has_value()) {
+        pin.set_truth_table(truth_table.value());
+      }
+    }
+  }
+
   return absl::OkStatus();
 }
 
@@ -272,7 +290,7 @@ absl::StatusOr<CellLibraryProto> ExtractFunctions(
   absl::flat_hash_set<std::string> kind_allowlist(
       {"library", "cell", "pin", "direction", "function", "ff", "next_state",
        "statetable"});
-  cell_lib::Parser parser(&scanner);
+  cell_lib::Parser parser(&scanner, std::move(kind_allowlist));
 
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<cell_lib::Block> block,
                        parser.ParseLibrary());
@@ -62,6 +62,8 @@ library (blah) {
   OutputPinProto output_pin = entry.output_pin_list().pins(0);
   ASSERT_EQ(output_pin.name(), "o");
   ASSERT_EQ(output_pin.function(), "meow");
+  // "meow" isn't a function of the cell's inputs, so can't be tabulated.
+  EXPECT_FALSE(output_pin.has_truth_table());
 }
 
 TEST(FunctionExtractorTest, HippetyHoppetyTestTheFlippetyFloppety) {
@@ -101,6 +103,7 @@ library (blah) {
   OutputPinProto output_pin = entry.output_pin_list().pins(0);
   ASSERT_EQ(output_pin.name(), "q");
   ASSERT_EQ(output_pin.function(), "i0|i1");
+  EXPECT_EQ(output_pin.truth_table(), 0b1110);
 }
 
 TEST(FunctionExtractorTest, HandlesStatetables) {
@@ -213,8 +213,27 @@ absl::Status Interpreter::InterpretCell(
     return absl::OkStatus();
   }
 
+  // Row of the cell's truth tables selected by its current inputs. Cell inputs
+  // are ordered as the entry's input names, as are the tables.
+  int64_t truth_table_row = 0;
+  if (cell.inputs().size() <= kMaxTruthTableInputs) {
+    for (int i = 0; i < cell.inputs().size(); i++) {
+      truth_table_row |=
+          static_cast<int64_t>(processed_wires->at(cell.inputs()[i].netref))
+          << i;
+    }
+  }
+
   const auto& pins = entry->output_pin_to_function();
   for (int i = 0; i < cell.outputs().size(); i++) {
+    absl::optional<uint64_t> truth_table =
+        entry->GetTruthTable(cell.outputs()[i].name);
+    if (truth_table.has_value()) {
+      (*processed_wires)[cell.outputs()[i].netref] =
+          (truth_table.value() >> truth_table_row) & 1;
+      continue;
+    }
+
     XLS_ASSIGN_OR_RETURN(
         function::Ast ast,
         function::Parser::ParseFunction(pins.at(cell.outputs()[i].name)));
@@ -24,18 +24,30 @@ namespace cell_lib {
 
 /* static */ absl::StatusOr<CharStream> CharStream::FromPath(
     absl::string_view path) {
-  std::ifstream file_stream{std::string(path)};
-  if (file_stream.is_open()) {
-    return CharStream(std::move(file_stream));
-  }
-  return absl::NotFoundError(
-      absl::StrCat("Could not open file at path: ", path));
+  XLS_ASSIGN_OR_RETURN(MappedFile mapped_file,
+                       MappedFile::Open(std::string(path)));
+  return CharStream(std::move(mapped_file));
 }
 
 /* static */ absl::StatusOr<CharStream> CharStream::FromText(std::string text) {
   return CharStream(std::move(text));
 }
 
+CharStream::CharStream(CharStream&& other)
+    : pos_(other.pos_),
+      mapped_file_(std::move(other.mapped_file_)),
+      owned_text_(std::move(other.owned_text_)),
+      cursor_(other.cursor_),
+      last_colno_(other.last_colno_) {
+  // A moved string's characters may not stay put (e.g., if stored inline), so
+  // re-point the view at wherever the text now lives.
+  if (mapped_file_.has_value()) {
+    text_ = mapped_file_->contents();
+  } else {
+    text_ = owned_text_;
+  }
+}
+
 std::string TokenKindToString(TokenKind kind) {
   switch (kind) {
     case TokenKind::kIdentifier:
@@ -64,58 +76,109 @@ std::string TokenKindToString(TokenKind kind) {
 
 absl::StatusOr<Token> Scanner::ScanIdentifier() {
   const Pos start_pos = cs_->GetPos();
+  const int64_t start = cs_->cursor();
   XLS_CHECK(IsIdentifierStart(cs_->PeekCharOrDie()));
-  absl::InlinedVector<char, 16> chars;
   while (!cs_->AtEof() && IsIdentifierRest(cs_->PeekCharOrDie())) {
-    chars.push_back(cs_->PopCharOrDie());
+    cs_->DropCharOrDie();
   }
-  return Token::Identifier(
-      start_pos, std::string(absl::string_view(chars.data(), chars.size())));
+  return Token::Identifier(start_pos, cs_->TextSince(start));
 }
 
 // Scans a number token.
 absl::StatusOr<Token> Scanner::ScanNumber() {
   const Pos start_pos = cs_->GetPos();
+  const int64_t start = cs_->cursor();
   XLS_CHECK(std::isdigit(cs_->PeekCharOrDie()));
-  absl::InlinedVector<char, 16> chars;
   while (!cs_->AtEof()) {
     if (IsNumberRest(cs_->PeekCharOrDie())) {
-      chars.push_back(cs_->PopCharOrDie());
+      cs_->DropCharOrDie();
     } else if (cs_->TryDropChars('e', '-')) {
-      chars.push_back('e');
-      chars.push_back('-');
+      continue;
     } else {
       break;
     }
   }
-  return Token::Number(
-      start_pos, std::string(absl::string_view(chars.data(), chars.size())));
+  return Token::Number(start_pos, cs_->TextSince(start));
 }
 
 // Scans a string token.
 absl::StatusOr<Token> Scanner::ScanQuotedString() {
   const Pos start_pos = cs_->GetPos();
   XLS_CHECK(cs_->TryDropChar('"'));
-  absl::InlinedVector<char, 16> chars;
+  const int64_t start = cs_->cursor();
   while (true) {
     if (cs_->AtEof()) {
       return absl::InvalidArgumentError(
           "Unexpected end-of-file in string token starting @ " +
           start_pos.ToHumanString());
     }
-    char c = cs_->PopCharOrDie();
-    if (c == '"') {
+    if (cs_->PeekCharOrDie() == '"') {
       break;
     }
-    chars.push_back(c);
+    cs_->DropCharOrDie();
   }
-  return Token::QuotedString(
-      start_pos, std::string(absl::string_view(chars.data(), chars.size())));
+  absl::string_view contents = cs_->TextSince(start);
+  cs_->DropCharOrDie();
+  return Token::QuotedString(start_pos, contents);
+}
+
+absl::Status Scanner::SkipBlockBody() {
+  XLS_ASSIGN_OR_RETURN(const Token* peek, Peek());
+  const Pos start_pos = peek->pos();
+  if (peek->kind() != TokenKind::kOpenCurl) {
+    return absl::InvalidArgumentError(
+        "Expected open-curl to start block body @ " +
+        start_pos.ToHumanString());
+  }
+  lookahead_ = absl::nullopt;
+
+  // The character stream is just past the opening brace (and any whitespace
+  // following it). Only strings and comments can hide braces.
+  int64_t depth = 1;
+  while (depth > 0) {
+    if (cs_->AtEof()) {
+      return absl::InvalidArgumentError(
+          "Unexpected end-of-file in block body starting @ " +
+          start_pos.ToHumanString());
+    }
+    if (cs_->TryDropChars('/', '*')) {
+      while (!cs_->AtEof() && !cs_->TryDropChars('*', '/')) {
+        cs_->DropCharOrDie();
+      }
+      continue;
+    }
+    if (cs_->TryDropChars('/', '/')) {
+      while (!cs_->AtEof() && !cs_->TryDropChar('\n')) {
+        cs_->DropCharOrDie();
+      }
+      continue;
+    }
+    switch (cs_->PopCharOrDie()) {
+      case '"':
+        while (!cs_->AtEof() && !cs_->TryDropChar('"')) {
+          cs_->DropCharOrDie();
+        }
+        break;
+      case '{':
+        ++depth;
+        break;
+      case '}':
+        --depth;
+        break;
+      default:
+        break;
+    }
+  }
+  DropWhitespaceAndComments();
+  return absl::OkStatus();
 }
 
 absl::Status Scanner::PeekInternal() {
   XLS_DCHECK(!lookahead_.has_value());
-  XLS_DCHECK(!cs_->AtEof());
+  if (cs_->AtEof()) {
+    return absl::InvalidArgumentError("Unexpected end-of-file @ " +
+                                      cs_->GetPos().ToHumanString());
+  }
   if (IsIdentifierStart(cs_->PeekCharOrDie())) {
     XLS_ASSIGN_OR_RETURN(lookahead_, ScanIdentifier());
     DropWhitespaceAndComments();
@@ -247,7 +310,7 @@ absl::Status Parser::DropTokenOrError(TokenKind kind) {
   return absl::OkStatus();
 }
 absl::Status Parser::DropIdentifierOrError(absl::string_view target) {
-  XLS_ASSIGN_OR_RETURN(std::string identifier, PopIdentifierOrError());
+  XLS_ASSIGN_OR_RETURN(absl::string_view identifier, PopIdentifierOrError());
   if (identifier != target) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Expected identifier '%s'; got '%s'", target, identifier));
@@ -255,17 +318,17 @@ absl::Status Parser::DropIdentifierOrError(absl::string_view target) {
   return absl::OkStatus();
 }
 
-absl::StatusOr<std::string> Parser::PopIdentifierOrError() {
+absl::StatusOr<absl::string_view> Parser::PopIdentifierOrError() {
   XLS_ASSIGN_OR_RETURN(Token t, scanner_->Pop());
   if (t.kind() != TokenKind::kIdentifier) {
     return absl::InvalidArgumentError(
         absl::StrFormat("Expected an identifier; got %s @ %s",
                         TokenKindToString(t.kind()), t.pos().ToHumanString()));
   }
-  return t.PopPayload();
+  return t.payload();
 }
 
-absl::StatusOr<std::string> Parser::PopValueOrError(Pos* last_pos) {
+absl::StatusOr<absl::string_view> Parser::PopValueOrError(Pos* last_pos) {
   XLS_ASSIGN_OR_RETURN(Token t, scanner_->Pop());
   if (last_pos != nullptr) {
     *last_pos = t.pos();
@@ -274,7 +337,7 @@ absl::StatusOr<std::string> Parser::PopValueOrError(Pos* last_pos) {
     case TokenKind::kNumber:
     case TokenKind::kQuotedString:
     case TokenKind::kIdentifier:
-      return std::string(t.payload());
+      return t.payload();
     default:
       return absl::InvalidArgumentError(absl::StrFormat(
           "Expected a value; got %s @ %s", TokenKindToString(t.kind()),
@@ -291,12 +354,13 @@ absl::StatusOr<std::vector<BlockEntry>> Parser::ParseEntries() {
     if (dropped_curl) {
       break;
     }
-    XLS_ASSIGN_OR_RETURN(std::string identifier, PopIdentifierOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view identifier, PopIdentifierOrError());
     XLS_ASSIGN_OR_RETURN(bool dropped_colon, TryDropToken(TokenKind::kColon));
     if (dropped_colon) {
       Pos last_pos;
-      XLS_ASSIGN_OR_RETURN(std::string value, PopValueOrError(&last_pos));
-      result.push_back(KVEntry{identifier, value});
+      XLS_ASSIGN_OR_RETURN(absl::string_view value,
+                           PopValueOrError(&last_pos));
+      result.push_back(KVEntry{std::string(identifier), std::string(value)});
       XLS_ASSIGN_OR_RETURN(bool dropped_semi, TryDropToken(TokenKind::kSemi));
       if (!dropped_semi) {
         if (scanner_->GetPos().lineno == last_pos.lineno) {
@@ -330,16 +394,16 @@ absl::StatusOr<absl::InlinedVector<std::string, 4>> Parser::ParseValues(
     } else if (!result.empty()) {
       XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kComma));
     }
-    XLS_ASSIGN_OR_RETURN(std::string value, PopValueOrError());
-    result.push_back(value);
+    XLS_ASSIGN_OR_RETURN(absl::string_view value, PopValueOrError());
+    result.push_back(std::string(value));
   }
   return result;
 }
 
 absl::StatusOr<std::unique_ptr<Block>> Parser::ParseBlock(
-    std::string identifier) {
+    absl::string_view identifier) {
   auto block = absl::make_unique<Block>();
-  block->kind = std::move(identifier);
+  block->kind = std::string(identifier);
 
   // Once we've seen the block kind we know whether it's in the allowlist or
   // not.
@@ -365,11 +429,12 @@ absl::StatusOr<std::unique_ptr<Block>> Parser::ParseBlock(
     }
   }
 
-  XLS_ASSIGN_OR_RETURN(block->entries, ParseEntries());
   if (!kind_allowed) {
-    // Save memory on disallowed blocks by clearing out its entries.
-    block->entries.clear();
+    // Nothing inside a disallowed block is kept, so don't bother parsing it.
+    XLS_RETURN_IF_ERROR(scanner_->SkipBlockBody());
+    return block;
   }
+  XLS_ASSIGN_OR_RETURN(block->entries, ParseEntries());
   return block;
 }
 
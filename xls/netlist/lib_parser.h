@@ -20,7 +20,6 @@
 #ifndef XLS_NETLIST_LIB_PARSER_H_
 #define XLS_NETLIST_LIB_PARSER_H_
 
-#include <fstream>
 #include <string>
 
 #include "absl/container/flat_hash_set.h"
@@ -29,6 +28,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
 
@@ -46,33 +46,20 @@ struct Pos {
   }
 };
 
-// Wraps a file as a character stream with a 1- or 2-character lookahead
-// interface.
+// Wraps text (in memory or a memory-mapped file) as a character stream with a
+// 1- or 2-character lookahead interface.
 class CharStream {
  public:
+  // Maps the file at "path" into memory, rather than reading it onto the heap;
+  // pages are brought in as the stream advances.
   static absl::StatusOr<CharStream> FromPath(absl::string_view path);
   static absl::StatusOr<CharStream> FromText(std::string text);
 
-  ~CharStream() {
-    if (if_.has_value()) {
-      if_->close();
-    }
-  }
-
-  CharStream(CharStream&& other) = default;
+  CharStream(CharStream&& other);
 
   Pos GetPos() const { return pos_; }
-  bool AtEof() const {
-    if (if_.has_value()) {
-      return if_->eof();
-    }
-    return cursor_ >= text_.size();
-  }
+  bool AtEof() const { return cursor_ >= text_.size(); }
   char PeekCharOrDie() {
-    if (if_.has_value()) {
-      XLS_DCHECK(!if_->eof());
-      return if_->peek();
-    }
     XLS_DCHECK_LT(cursor_, text_.size());
     return text_[cursor_];
   }
@@ -109,9 +96,21 @@ class CharStream {
     return false;
   }
 
+  // Offset of the next character in the stream, for use with TextSince().
+  int64_t cursor() const { return cursor_; }
+
+  // Returns a view of the characters popped since the cursor was at "start".
+  // Valid as long as this stream is.
+  absl::string_view TextSince(int64_t start) const {
+    return text_.substr(start, cursor_ - start);
+  }
+
  private:
-  CharStream(std::ifstream file_stream) : if_(std::move(file_stream)) {}
-  CharStream(std::string text) : text_(std::move(text)) {}
+  explicit CharStream(MappedFile mapped_file)
+      : mapped_file_(std::move(mapped_file)),
+        text_(mapped_file_->contents()) {}
+  explicit CharStream(std::string text)
+      : owned_text_(std::move(text)), text_(owned_text_) {}
 
   void Unget(char c) {
     cursor_--;
@@ -121,9 +120,6 @@ class CharStream {
     } else {
       pos_.colno--;
     }
-    if (if_.has_value()) {
-      if_->unget();
-    }
   }
 
   void BumpPos(char c) {
@@ -139,13 +135,12 @@ class CharStream {
 
   Pos pos_ = {0, 0};
 
-  // We have both ifstream mode and text mode data, we store both inline.
-
-  // ifstream mode
-  absl::optional<std::ifstream> if_;
+  // The text is held either by a mapping or by a string; text_ views
+  // whichever holds it.
+  absl::optional<MappedFile> mapped_file_;
+  std::string owned_text_;
+  absl::string_view text_;
 
-  // text mode
-  std::string text_;
   int64_t cursor_ = 0;
   int64_t last_colno_ = 0;
 };
@@ -165,22 +160,23 @@ enum class TokenKind {
 
 std::string TokenKindToString(TokenKind kind);
 
-// Represents a token in the file's token stream.
+// Represents a token in the file's token stream. Payloads refer into the
+// CharStream's text, so tokens must not outlive it.
 class Token {
  public:
-  static Token Identifier(Pos pos, std::string s) {
+  static Token Identifier(Pos pos, absl::string_view s) {
     return Token(TokenKind::kIdentifier, pos, s);
   }
-  static Token QuotedString(Pos pos, std::string s) {
+  static Token QuotedString(Pos pos, absl::string_view s) {
     return Token(TokenKind::kQuotedString, pos, s);
   }
-  static Token Number(Pos pos, std::string s) {
+  static Token Number(Pos pos, absl::string_view s) {
     return Token(TokenKind::kNumber, pos, s);
   }
   static Token Simple(Pos pos, TokenKind kind) { return Token(kind, pos); }
 
   Token(TokenKind kind, Pos pos,
-        absl::optional<std::string> payload = absl::nullopt)
+        absl::optional<absl::string_view> payload = absl::nullopt)
       : kind_(kind), pos_(pos), payload_(payload) {}
 
   std::string ToString() const {
@@ -192,12 +188,11 @@ class Token {
   TokenKind kind() const { return kind_; }
   const Pos& pos() const { return pos_; }
   absl::string_view payload() const { return payload_.value(); }
-  std::string PopPayload() { return std::move(payload_.value()); }
 
  private:
   TokenKind kind_;
   Pos pos_;
-  absl::optional<std::string> payload_;
+  absl::optional<absl::string_view> payload_;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Token& token) {
@@ -235,6 +230,11 @@ class Scanner {
     return cs_->GetPos();
   }
 
+  // Skips the body of a block without tokenizing it: the next token must be
+  // the opening curly brace, and scanning resumes after the matching closing
+  // brace.
+  absl::Status SkipBlockBody();
+
  private:
   static bool IsIdentifierStart(char c) { return std::isalpha(c); }
   static bool IsIdentifierRest(char c) {
@@ -376,14 +376,14 @@ class Parser {
   absl::Status DropIdentifierOrError(absl::string_view target);
 
   // Pops an identifier token and returns its payload, or errors.
-  absl::StatusOr<std::string> PopIdentifierOrError();
+  absl::StatusOr<absl::string_view> PopIdentifierOrError();
 
   // Pops a value token and returns its payload, or errors.
   //
   // If last_pos is provided it is populated with the position of the last value
   // token. (This is useful for checking for newline termination in lieu of
   // semicolons.)
-  absl::StatusOr<std::string> PopValueOrError(Pos* last_pos = nullptr);
+  absl::StatusOr<absl::string_view> PopValueOrError(Pos* last_pos = nullptr);
 
   // Parses all of the entries contained within a block -- includes key/value
   // entries as well as sub-blocks.
@@ -397,17 +397,19 @@ class Parser {
   //
   // If the identifier is provided by the caller it is not scanned out of the
   // token stream.
-  absl::StatusOr<std::unique_ptr<Block>> ParseBlock(std::string identifier);
+  absl::StatusOr<std::unique_ptr<Block>> ParseBlock(
+      absl::string_view identifier);
 
   Scanner* scanner_;
 
   // Optional allowlist of keys (including block kinds) that we're interested in
-  // keeping in the result data structure. "Denied" (non-allowed) block kinds
-  // are still parsed properly, but then may have incomplete data (or not be
-  // present at all) in the resulting data structure.
+  // keeping in the result data structure. "Denied" (non-allowed) blocks keep
+  // their kind and arguments, but their bodies are skipped over without being
+  // tokenized, so have no entries in the resulting data structure.
   //
-  // This is very useful for minimizing memory usage when we're interested in
-  // just a subset of particular fields, e.g. as part of a query.
+  // This is very useful for minimizing memory usage and parse time when we're
+  // interested in just a subset of particular fields, e.g. as part of a query;
+  // in real libraries, timing and power tables dominate the file.
   absl::optional<absl::flat_hash_set<std::string>> kind_allowlist_;
 };
 
@@ -19,6 +19,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
+#include "xls/common/file/temp_file.h"
 #include "xls/common/status/matchers.h"
 
 namespace xls {
@@ -26,6 +27,9 @@ namespace netlist {
 namespace cell_lib {
 namespace {
 
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
 TEST(LibParserTest, ScanSimple) {
   std::string text = "{}()";
   XLS_ASSERT_OK_AND_ASSIGN(auto cs, CharStream::FromText(text));
@@ -159,6 +163,71 @@ library (foo) {
             "))");
 }
 
+// Disallowed blocks are skipped without being tokenized, so must still find
+// their end past braces in strings and comments - and past content the
+// scanner would reject.
+TEST(LibParserTest, AllowlistSkipsNestedBlocks) {
+  std::string text = R"lib(
+library (foo) {
+  cell (AND2) {
+    pin (o) {
+      function : "(a * b)";
+      timing () {
+        related_pin : "a";
+        cell_rise (tbl) {
+          index_1 ("0.1, 0.2");
+          values ("1.0, 2.0", \
+                  "3.0, 4.0");
+        }
+        sdf_cond : "{ not a brace";  /* } also not a brace */
+        // } nor this one
+        @#$ unscannable: [ ];
+      }
+    }
+  }
+  cell (INV) {}
+}
+)lib";
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Block> library,
+      Parse(text,
+            absl::flat_hash_set<std::string>{"library", "cell", "pin"}));
+  EXPECT_EQ(library->ToString(),
+            "(block library (foo) ("
+            "(block cell (AND2) ("
+            "(block pin (o) ((function \"(a * b)\") (block timing () ()))))) "
+            "(block cell (INV) ())"
+            "))");
+}
+
+TEST(LibParserTest, AllowlistSkipsUnterminatedBlock) {
+  std::string text = "library (foo) { timing () { a : b; ";
+  EXPECT_THAT(
+      Parse(text, absl::flat_hash_set<std::string>{"library"}).status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Unexpected end-of-file in block body")));
+}
+
+TEST(LibParserTest, UnterminatedLibrary) {
+  EXPECT_THAT(Parse("library (foo) { a : b;").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unexpected end-of-file")));
+}
+
+TEST(LibParserTest, FromPath) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TempFile temp_file,
+      TempFile::CreateWithContent("library (foo) { cell (INV) { area: 1; } }"));
+  XLS_ASSERT_OK_AND_ASSIGN(auto cs, CharStream::FromPath(
+                                        temp_file.path().string()));
+  Scanner scanner(&cs);
+  Parser parser(&scanner);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Block> library,
+                           parser.ParseLibrary());
+  EXPECT_EQ(library->ToString(),
+            "(block library (foo) ((block cell (INV) ((area \"1\")))))");
+}
+
 }  // namespace
 }  // namespace cell_lib
 }  // namespace netlist
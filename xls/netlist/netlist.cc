@@ -63,45 +63,44 @@ absl::StatusOr<NetRef> Module::ResolveNumber(int64_t number) const {
 }
 
 absl::StatusOr<NetRef> Module::ResolveNet(absl::string_view name) const {
-  for (const auto& net : nets_) {
-    if (net->name() == name) {
-      return net.get();
-    }
+  auto iter = name_to_net_.find(name);
+  if (iter != name_to_net_.end()) {
+    return iter->second;
   }
 
   return absl::NotFoundError(absl::StrCat("Could not find net: ", name));
 }
 
 absl::StatusOr<Cell*> Module::ResolveCell(absl::string_view name) const {
-  for (const auto& cell : cells_) {
-    if (cell->name() == name) {
-      return cell.get();
-    }
+  auto iter = name_to_cell_.find(name);
+  if (iter != name_to_cell_.end()) {
+    return iter->second;
   }
   return absl::NotFoundError(
       absl::StrCat("Could not find cell with name: ", name));
 }
 
 absl::StatusOr<Cell*> Module::AddCell(Cell cell) {
-  auto status_or_cell = ResolveCell(cell.name());
-  if (status_or_cell.status().ok()) {
+  if (name_to_cell_.contains(cell.name())) {
     return absl::InvalidArgumentError(
         absl::StrCat("Module already has a cell with name: ", cell.name()));
   }
 
-  cells_.push_back(absl::make_unique<Cell>(cell));
-  return cells_.back().get();
+  cells_.push_back(absl::make_unique<Cell>(std::move(cell)));
+  Cell* cell_ptr = cells_.back().get();
+  name_to_cell_[cell_ptr->name()] = cell_ptr;
+  return cell_ptr;
 }
 
 absl::Status Module::AddNetDecl(NetDeclKind kind, absl::string_view name) {
-  auto status_or_net = ResolveNet(name);
-  if (status_or_net.status().ok()) {
+  if (name_to_net_.contains(name)) {
     return absl::InvalidArgumentError(
         absl::StrCat("Module already has a net/wire decl with name: ", name));
   }
 
   nets_.emplace_back(absl::make_unique<NetDef>(name));
   NetRef ref = nets_.back().get();
+  name_to_net_[ref->name()] = ref;
   switch (kind) {
     case NetDeclKind::kInput:
       inputs_.push_back(ref);
@@ -150,6 +149,7 @@ absl::StatusOr<std::vector<Cell*>> NetDef::GetConnectedCellsSans(
   };
 
   std::vector<Pin> cell_inputs;
+  cell_inputs.reserve(cell_library_entry->input_names().size());
   for (const std::string& input : cell_library_entry->input_names()) {
     auto it = named_parameter_assignments.find(input);
     if (it == named_parameter_assignments.end()) {
@@ -166,6 +166,7 @@ absl::StatusOr<std::vector<Cell*>> NetDef::GetConnectedCellsSans(
   const CellLibraryEntry::OutputPinToFunction& output_pins =
       cell_library_entry->output_pin_to_function();
   std::vector<Pin> cell_outputs;
+  cell_outputs.reserve(output_pins.size());
   for (const auto& kv : output_pins) {
     Pin cell_output;
     cell_output.name = kv.first;
@@ -205,7 +206,7 @@ void Netlist::AddModule(std::unique_ptr<Module> module) {
 }
 
 absl::StatusOr<const Module*> Netlist::GetModule(
-    const std::string& module_name) const {
+    absl::string_view module_name) const {
   for (const auto& module : modules_) {
     if (module->name() == module_name) {
       return module.get();
@@ -76,8 +76,8 @@ class Cell {
 
  private:
   Cell(const CellLibraryEntry* cell_library_entry, absl::string_view name,
-       const std::vector<Pin>& inputs, const std::vector<Pin>& outputs,
-       const std::vector<Pin>& internal_pins, absl::optional<NetRef> clock)
+       std::vector<Pin> inputs, std::vector<Pin> outputs,
+       std::vector<Pin> internal_pins, absl::optional<NetRef> clock)
       : cell_library_entry_(cell_library_entry),
         name_(name),
         inputs_(std::move(inputs)),
@@ -183,6 +183,11 @@ class Module {
   std::vector<NetRef> wires_;
   std::vector<std::unique_ptr<NetDef>> nets_;
   std::vector<std::unique_ptr<Cell>> cells_;
+  // Name indices for resolution during parsing, which would otherwise be
+  // quadratic in module size. Keys refer to the names held by the nets and
+  // cells themselves.
+  absl::flat_hash_map<absl::string_view, NetRef> name_to_net_;
+  absl::flat_hash_map<absl::string_view, Cell*> name_to_cell_;
   NetRef zero_;
   NetRef one_;
   NetRef dummy_;
@@ -194,7 +199,7 @@ class Module {
 class Netlist {
  public:
   void AddModule(std::unique_ptr<Module> module);
-  absl::StatusOr<const Module*> GetModule(const std::string& module_name) const;
+  absl::StatusOr<const Module*> GetModule(absl::string_view module_name) const;
   const absl::Span<const std::unique_ptr<Module>> modules() { return modules_; }
   absl::StatusOr<const CellLibraryEntry*> GetOrCreateLut4CellEntry(
       int64_t lut_mask);
@@ -17,7 +17,9 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/variant.h"
 #include "xls/common/logging/logging.h"
@@ -179,9 +181,7 @@ absl::StatusOr<Token> Scanner::Pop() {
   return result;
 }
 
-absl::StatusOr<Token> Scanner::ScanNumber(char startc, Pos pos) {
-  std::string chars;
-  chars.push_back(startc);
+absl::StatusOr<Token> Scanner::ScanNumber(int64_t start_index, Pos pos) {
   bool seen_separator = false;
   auto is_hex_char = [](char c) {
     return absl::ascii_isxdigit(absl::ascii_toupper(c));
@@ -196,20 +196,19 @@ absl::StatusOr<Token> Scanner::ScanNumber(char startc, Pos pos) {
   while (!AtEofInternal()) {
     char c = PeekCharOrDie();
     if (is_hex_char(c)) {
-      chars.push_back(PopCharOrDie());
+      DropCharOrDie();
     } else if (c == '\'' && !seen_separator) {
       // If we see a base separator, pop it, then the optional signedness
       // indicator (s|S), then the base indicator (d|b|o|h|D|B|O|H).
-      chars.push_back(PopCharOrDie());
+      DropCharOrDie();
       XLS_RET_CHECK(!AtEofInternal()) << "Saw EOF while scanning number base!";
-      chars.push_back(PopCharOrDie());
-      if (chars.back() == 's' || chars.back() == 'S') {
+      c = PopCharOrDie();
+      if (c == 's' || c == 'S') {
         XLS_RET_CHECK(!AtEofInternal())
             << "Saw EOF while scanning number base (post-signedness)!";
-        chars.push_back(PopCharOrDie());
+        c = PopCharOrDie();
       }
 
-      c = chars.back();
       XLS_RET_CHECK(c == 'd' || c == 'b' || c == 'o' || c == 'h' || c == 'D' ||
                     c == 'B' || c == 'O' || c == 'H')
           << "Expected [dbohDBOH], saw '" << c << "'";
@@ -220,23 +219,24 @@ absl::StatusOr<Token> Scanner::ScanNumber(char startc, Pos pos) {
     }
   }
 
-  return Token{TokenKind::kNumber, pos, chars};
+  return Token{TokenKind::kNumber, pos,
+               text_.substr(start_index, index_ - start_index)};
 }
 
-absl::StatusOr<Token> Scanner::ScanName(char startc, Pos pos, bool is_escaped) {
-  std::string chars;
-  chars.push_back(startc);
+absl::StatusOr<Token> Scanner::ScanName(int64_t start_index, Pos pos,
+                                        bool is_escaped) {
   while (!AtEofInternal()) {
     char c = PeekCharOrDie();
     bool is_whitespace = c == ' ' || c == '\t' || c == '\n';
     if ((is_escaped && !is_whitespace) || isalpha(c) || isdigit(c) ||
         c == '_') {
-      chars.push_back(PopCharOrDie());
+      DropCharOrDie();
     } else {
       break;
     }
   }
-  return Token{TokenKind::kName, pos, chars};
+  return Token{TokenKind::kName, pos,
+               text_.substr(start_index, index_ - start_index)};
 }
 
 absl::StatusOr<Token> Scanner::PeekInternal() {
@@ -245,6 +245,7 @@ absl::StatusOr<Token> Scanner::PeekInternal() {
     return absl::FailedPreconditionError("Scan has reached EOF.");
   }
   auto pos = GetPos();
+  int64_t start_index = index_;
   char c = PopCharOrDie();
   switch (c) {
     case '(':
@@ -275,17 +276,17 @@ absl::StatusOr<Token> Scanner::PeekInternal() {
       [[fallthrough]];
     default:
       if (isdigit(c)) {
-        return ScanNumber(c, pos);
+        return ScanNumber(start_index, pos);
       }
       if (isalpha(c) || c == '\\') {
-        return ScanName(c, pos, c == '\\');
+        return ScanName(start_index, pos, c == '\\');
       }
       return absl::UnimplementedError(absl::StrFormat(
           "Unsupported character: '%c' (%#x) @ %s", c, c, pos.ToHumanString()));
   }
 }
 
-absl::StatusOr<std::string> Parser::PopNameOrError() {
+absl::StatusOr<absl::string_view> Parser::PopNameOrError() {
   XLS_ASSIGN_OR_RETURN(Token token, scanner_->Pop());
   if (token.kind == TokenKind::kName) {
     return token.value;
@@ -298,11 +299,14 @@ absl::StatusOr<int64_t> Parser::PopNumberOrError() {
   // We're assuming we won't see > 64b values. Fine for now, at least.
   XLS_ASSIGN_OR_RETURN(Token token, scanner_->Pop());
   if (token.kind == TokenKind::kNumber) {
-    // Check for the big version first.
+    // Check for the big version first. Most numbers in a netlist are plain
+    // indices, though, so don't bother matching those against the regex.
     std::string width_string, signed_string, base_string, value_string;
-    if (RE2::FullMatch(
-            token.value, R"(([0-9]+)'([Ss]?)([bodhBODH])([0-9a-f]+))",
-            &width_string, &signed_string, &base_string, &value_string)) {
+    if (absl::StrContains(token.value, '\'') &&
+        RE2::FullMatch(std::string(token.value),
+                       R"(([0-9]+)'([Ss]?)([bodhBODH])([0-9a-f]+))",
+                       &width_string, &signed_string, &base_string,
+                       &value_string)) {
       int64_t width;
       XLS_RET_CHECK(
           absl::SimpleAtoi(width_string, reinterpret_cast<int64_t*>(&width)))
@@ -334,9 +338,9 @@ absl::StatusOr<int64_t> Parser::PopNumberOrError() {
 
     int64_t result;
     if (!absl::SimpleAtoi(token.value, &result)) {
-      return absl::InternalError(
-          "Number token's value cannot be parsed as an int64_t: " +
-          token.value);
+      return absl::InternalError(absl::StrCat(
+          "Number token's value cannot be parsed as an int64_t: ",
+          token.value));
     }
     return result;
   }
@@ -344,7 +348,7 @@ absl::StatusOr<int64_t> Parser::PopNumberOrError() {
                                     token.ToString());
 }
 
-absl::StatusOr<absl::variant<std::string, int64_t>>
+absl::StatusOr<absl::variant<absl::string_view, int64_t>>
 Parser::PopNameOrNumberOrError() {
   TokenKind kind = scanner_->Peek()->kind;
   if (kind == TokenKind::kName) {
@@ -366,9 +370,9 @@ absl::Status Parser::DropTokenOrError(TokenKind target) {
       "Want token %s; got %s.", TokenKindToString(target), token.ToString()));
 }
 
-absl::StatusOr<std::vector<std::string>> Parser::PopParenNameList() {
+absl::StatusOr<std::vector<absl::string_view>> Parser::PopParenNameList() {
   XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kOpenParen));
-  std::vector<std::string> results;
+  std::vector<absl::string_view> results;
   bool must_end = false;
   while (true) {
     if (TryDropToken(TokenKind::kCloseParen)) {
@@ -378,7 +382,7 @@ absl::StatusOr<std::vector<std::string>> Parser::PopParenNameList() {
       XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseParen));
       break;
     }
-    XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
     results.push_back(name);
     must_end = !TryDropToken(TokenKind::kComma);
   }
@@ -396,7 +400,7 @@ absl::Status Parser::DropKeywordOrError(absl::string_view target) {
 
 absl::StatusOr<const CellLibraryEntry*> Parser::ParseCellModule(
     Netlist& netlist) {
-  XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+  XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
   auto status_or_module = netlist.GetModule(name);
   if (status_or_module.ok()) {
     return status_or_module.value()->AsCellLibraryEntry();
@@ -404,10 +408,10 @@ absl::StatusOr<const CellLibraryEntry*> Parser::ParseCellModule(
   if (name == "SB_LUT4") {
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kStartParams));
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kDot));
-    XLS_ASSIGN_OR_RETURN(std::string param_name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view param_name, PopNameOrError());
     if (param_name != "LUT_INIT") {
-      return absl::InvalidArgumentError(
-          "Expected a single .LUT_INIT named parameter, got: " + param_name);
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Expected a single .LUT_INIT named parameter, got: ", param_name));
     }
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kOpenParen));
     XLS_ASSIGN_OR_RETURN(int64_t lut_mask, PopNumberOrError());
@@ -419,18 +423,18 @@ absl::StatusOr<const CellLibraryEntry*> Parser::ParseCellModule(
 }
 
 absl::StatusOr<NetRef> Parser::ParseNetRef(Module* module) {
-  using TokenT = absl::variant<std::string, int64_t>;
+  using TokenT = absl::variant<absl::string_view, int64_t>;
   XLS_ASSIGN_OR_RETURN(TokenT token, PopNameOrNumberOrError());
   if (absl::holds_alternative<int64_t>(token)) {
     int64_t value = absl::get<int64_t>(token);
     return module->AddOrResolveNumber(value);
   }
 
-  std::string name = absl::get<std::string>(token);
+  absl::string_view name = absl::get<absl::string_view>(token);
   if (TryDropToken(TokenKind::kOpenBracket)) {
     XLS_ASSIGN_OR_RETURN(int64_t index, PopNumberOrError());
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseBracket));
-    absl::StrAppend(&name, "[", index, "]");
+    return module->ResolveNet(absl::StrCat(name, "[", index, "]"));
   }
   return module->ResolveNet(name);
 }
@@ -440,20 +444,23 @@ absl::Status Parser::ParseInstance(Module* module, Netlist& netlist) {
   const Pos pos = peek.pos;
 
   XLS_ASSIGN_OR_RETURN(const CellLibraryEntry* cle, ParseCellModule(netlist));
-  XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+  XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
   XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kOpenParen));
   // LRM 23.3.2 Calls these "named parameter assignments".
   absl::flat_hash_map<std::string, NetRef> named_parameter_assignments;
   while (true) {
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kDot));
-    XLS_ASSIGN_OR_RETURN(std::string pin_name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view pin_name, PopNameOrError());
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kOpenParen));
     XLS_ASSIGN_OR_RETURN(NetRef net, ParseNetRef(module));
     XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kCloseParen));
     XLS_VLOG(3) << "Adding named parameter assignment: " << pin_name;
-    bool is_new = named_parameter_assignments.insert({pin_name, net}).second;
+    bool is_new =
+        named_parameter_assignments.insert({std::string(pin_name), net})
+            .second;
     if (!is_new) {
-      return absl::InvalidArgumentError("Duplicate port seen: " + pin_name);
+      return absl::InvalidArgumentError(
+          absl::StrCat("Duplicate port seen: ", pin_name));
     }
     if (!TryDropToken(TokenKind::kComma)) {
       break;
@@ -527,9 +534,9 @@ absl::Status Parser::ParseNetDecl(Module* module, NetDeclKind kind) {
     range = {high, low};
   }
 
-  std::vector<std::string> names;
+  std::vector<absl::string_view> names;
   do {
-    XLS_ASSIGN_OR_RETURN(std::string name, PopNameOrError());
+    XLS_ASSIGN_OR_RETURN(absl::string_view name, PopNameOrError());
     names.push_back(name);
   } while (TryDropToken(TokenKind::kComma));
 
@@ -542,7 +549,7 @@ absl::Status Parser::ParseNetDecl(Module* module, NetDeclKind kind) {
         "Multiple declarations for a ranged net is not yet supported.");
   }
 
-  for (const std::string& name : names) {
+  for (absl::string_view name : names) {
     if (range.has_value()) {
       for (int64_t i = range->second; i <= range->first; ++i) {
         XLS_RETURN_IF_ERROR(
@@ -570,9 +577,10 @@ absl::Status Parser::ParseModuleStatement(Module* module, Netlist& netlist) {
 
 absl::StatusOr<std::unique_ptr<Module>> Parser::ParseModule(Netlist& netlist) {
   XLS_RETURN_IF_ERROR(DropKeywordOrError("module"));
-  XLS_ASSIGN_OR_RETURN(std::string module_name, PopNameOrError());
+  XLS_ASSIGN_OR_RETURN(absl::string_view module_name, PopNameOrError());
   auto module = std::make_unique<Module>(module_name);
-  XLS_ASSIGN_OR_RETURN(std::vector<std::string> ports, PopParenNameList());
+  XLS_ASSIGN_OR_RETURN(std::vector<absl::string_view> ports,
+                       PopParenNameList());
   XLS_RETURN_IF_ERROR(DropTokenOrError(TokenKind::kSemicolon));
 
   while (true) {
@@ -17,6 +17,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "xls/netlist/netlist.h"
 
 namespace xls {
@@ -52,15 +53,19 @@ struct Pos {
 };
 
 // Represents a scanned token (that comes from scanning a character stream).
+// Tokens refer into the scanned text rather than copying it, so are cheap to
+// pass around but must not outlive it.
 struct Token {
   TokenKind kind;
   Pos pos;
-  std::string value;
+  absl::string_view value;
 
   std::string ToString() const;
 };
 
-// Token scanner for netlist files.
+// Token scanner for netlist files. "text" must outlive the scanner and any
+// tokens it produces; for large netlists, a MappedFile's contents avoid holding
+// a second copy of the file in memory.
 class Scanner {
  public:
   explicit Scanner(absl::string_view text) : text_(text) {}
@@ -75,8 +80,10 @@ class Scanner {
   }
 
  private:
-  absl::StatusOr<Token> ScanName(char startc, Pos pos, bool is_escaped);
-  absl::StatusOr<Token> ScanNumber(char startc, Pos pos);
+  // Scan the remainder of a name or number token whose first character,
+  // at "start_index", has already been popped.
+  absl::StatusOr<Token> ScanName(int64_t start_index, Pos pos, bool is_escaped);
+  absl::StatusOr<Token> ScanNumber(int64_t start_index, Pos pos);
   absl::StatusOr<Token> PeekInternal();
 
   // Drops any characters that should not be converted to Tokens, including
@@ -137,14 +144,15 @@ class Parser {
 
   // Pops a name token and returns its contents or gives an error status if a
   // name token is not immediately present in the stream.
-  absl::StatusOr<std::string> PopNameOrError();
+  absl::StatusOr<absl::string_view> PopNameOrError();
 
   // Pops a name token and returns its value or gives an error status if a
   // number token is not immediately present in the stream.
   absl::StatusOr<int64_t> PopNumberOrError();
 
   // Pops either a name or number token or returns an error.
-  absl::StatusOr<absl::variant<std::string, int64_t>> PopNameOrNumberOrError();
+  absl::StatusOr<absl::variant<absl::string_view, int64_t>>
+  PopNameOrNumberOrError();
 
   // Drops a token of kind target from the head of the stream or gives an error
   // status.
@@ -163,7 +171,7 @@ class Parser {
 
   // Pops a parenthesized name list from the token stream and returns it as a
   // vector of those names.
-  absl::StatusOr<std::vector<std::string>> PopParenNameList();
+  absl::StatusOr<std::vector<absl::string_view>> PopParenNameList();
 
   // Cell library definitions are resolved against.
   CellLibrary* cell_library_;
@@ -12,10 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <sys/resource.h>
+
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "xls/common/file/filesystem.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
@@ -23,6 +28,8 @@
 #include "xls/netlist/netlist_parser.h"
 
 ABSL_FLAG(bool, show_clusters, false, "Show the logic clusters found.");
+ABSL_FLAG(bool, mmap, true,
+          "Map the netlist into memory rather than reading it onto the heap.");
 
 namespace xls {
 namespace {
@@ -38,11 +45,31 @@ absl::Status RealMain(absl::string_view netlist_path,
                          netlist::CellLibrary::FromProto(cell_library_proto));
   }
 
-  XLS_ASSIGN_OR_RETURN(std::string netlist_text, GetFileContents(netlist_path));
-  netlist::rtl::Scanner scanner(netlist_text);
-  XLS_ASSIGN_OR_RETURN(
-      std::unique_ptr<netlist::rtl::Netlist> netlist,
-      netlist::rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  absl::Time start = absl::Now();
+  std::unique_ptr<netlist::rtl::Netlist> netlist;
+  {
+    // Only the scan refers to the netlist text, so release it right after.
+    std::string netlist_text;
+    absl::optional<MappedFile> mapped_file;
+    absl::string_view text;
+    if (absl::GetFlag(FLAGS_mmap)) {
+      XLS_ASSIGN_OR_RETURN(mapped_file, MappedFile::Open(netlist_path));
+      text = mapped_file->contents();
+    } else {
+      XLS_ASSIGN_OR_RETURN(netlist_text, GetFileContents(netlist_path));
+      text = netlist_text;
+    }
+    netlist::rtl::Scanner scanner(text);
+    XLS_ASSIGN_OR_RETURN(
+        netlist, netlist::rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  }
+  absl::Duration parse_time = absl::Now() - start;
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  std::cout << "parse time: " << parse_time << std::endl;
+  // ru_maxrss is in kilobytes on Linux.
+  std::cout << "peak RSS:   " << usage.ru_maxrss / 1024 << " MiB" << std::endl;
+
   netlist::rtl::Module* module = netlist->modules()[0].get();
   std::cout << "nets:  " << module->nets().size() << std::endl;
   std::cout << "cells: " << module->cells().size() << std::endl;
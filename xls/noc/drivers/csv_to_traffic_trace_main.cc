@@ -0,0 +1,71 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/noc/simulation/traffic_trace.h"
+
+const char kUsage[] = R"(
+Converts the packets sent by a traffic flow from CSV into the binary trace
+format replayed by TrafficFlow::SetTracePath().
+
+Each line of the CSV file describes a packet as
+
+  cycle[,packet_size_bits]
+
+in order of increasing cycle.  Packets without a size have the packet size
+of the flow replaying the trace.
+
+Example invocation:
+
+  csv_to_traffic_trace_main flow0.csv flow0.trace
+)";
+
+namespace xls::noc {
+namespace {
+
+absl::Status RealMain(absl::string_view csv_path,
+                      absl::string_view trace_path) {
+  XLS_ASSIGN_OR_RETURN(int64_t packet_count,
+                       ConvertCsvToTrafficTrace(std::string(csv_path),
+                                                std::string(trace_path)));
+  std::cout << absl::StreamFormat("Wrote %d packets to %s\n", packet_count,
+                                  trace_path);
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls::noc
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+
+  if (positional_arguments.size() != 2) {
+    XLS_LOG(QFATAL) << absl::StreamFormat(
+        "Expected invocation: %s <csv_path> <trace_path>", argv[0]);
+  }
+
+  XLS_QCHECK_OK(
+      xls::noc::RealMain(positional_arguments[0], positional_arguments[1]));
+  return 0;
+}
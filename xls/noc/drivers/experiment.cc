@@ -14,8 +14,19 @@
 
 #include "xls/noc/drivers/experiment.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_set.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/thread.h"
 #include "xls/noc/simulation/common.h"
 #include "xls/noc/simulation/network_graph.h"
 #include "xls/noc/simulation/network_graph_builder.h"
@@ -24,8 +35,30 @@
 #include "xls/noc/simulation/sim_objects.h"
 #include "xls/noc/simulation/simulator_to_traffic_injector_shim.h"
 #include "xls/noc/simulation/traffic_description.h"
+#include "xls/noc/simulation/traffic_models.h"
+#include "xls/noc/simulation/traffic_statistics.h"
 
 namespace xls::noc {
+namespace {
+
+// Records the mean and tail of a latency distribution as metrics
+// named <prefix>:<statistic>Latency.
+void SetLatencyMetrics(absl::string_view prefix,
+                       const LatencyHistogram& latency,
+                       ExperimentMetrics& metrics) {
+  metrics.SetFloatMetric(absl::StrCat(prefix, ":MeanLatency"),
+                         latency.mean());
+  metrics.SetIntegerMetric(absl::StrCat(prefix, ":P50Latency"),
+                           latency.Percentile(50));
+  metrics.SetIntegerMetric(absl::StrCat(prefix, ":P99Latency"),
+                           latency.Percentile(99));
+  metrics.SetIntegerMetric(absl::StrCat(prefix, ":P999Latency"),
+                           latency.Percentile(99.9));
+  metrics.SetIntegerMetric(absl::StrCat(prefix, ":MaxLatency"),
+                           latency.max());
+}
+
+}  // namespace
 
 absl::Status ExperimentMetrics::DebugDump() const {
   XLS_LOG(INFO) << "Dumping Metrics ...";
@@ -76,6 +109,9 @@ absl::StatusOr<ExperimentMetrics> ExperimentRunner::RunExperiment(
 
   // Build simulator objects.
   NocSimulator simulator;
+  // Metrics are computed from the sinks' statistics, so there is no need
+  // to keep the received flits themselves.
+  simulator.SetReceivedTrafficCapacity(0);
   XLS_RET_CHECK_OK(simulator.Initialize(graph, params, routing_table,
                                         graph.GetNetworkIds()[0]));
   simulator.Dump();
@@ -92,7 +128,7 @@ absl::StatusOr<ExperimentMetrics> ExperimentRunner::RunExperiment(
   }
 
   // Obtain metrics.  For now, the runner will measure traffic rate
-  // for each flow, and sink.
+  // and latency for each flow, and sink.
   //
   // TODO(tedhong): 2021-07-13 Factor this out to make it possible for
   //                each experiment to define the set of metrics needed.
@@ -109,6 +145,23 @@ absl::StatusOr<ExperimentMetrics> ExperimentRunner::RunExperiment(
         traffic_injector.MeasuredTrafficRateInMiBps(cycle_time_in_ps_, i);
 
     metrics.SetFloatMetric(metric_name, traffic_rate);
+
+    // Flows with the same source, sink and vc can't be told apart at the
+    // sink so share latency metrics.
+    const TrafficModel& model = *traffic_injector.GetTrafficModels().at(i);
+    XLS_ASSIGN_OR_RETURN(
+        NetworkComponentId sink_id,
+        routing_table.GetSinkIndices().GetNetworkComponentByIndex(
+            model.GetDestinationIndex()));
+    XLS_ASSIGN_OR_RETURN(SimNetworkInterfaceSink * sink,
+                         simulator.GetSimNetworkInterfaceSink(sink_id));
+    SetLatencyMetrics(
+        absl::StrFormat("Flow:%s",
+                        traffic_manager.GetTrafficFlow(flow_id).GetName()),
+        sink->GetStatistics()
+            .GetFlow(model.GetSourceIndex(), model.GetVCIndex())
+            .latency(),
+        metrics);
   }
 
   for (NetworkComponentId sink_id :
@@ -128,7 +181,10 @@ absl::StatusOr<ExperimentMetrics> ExperimentRunner::RunExperiment(
     metrics.SetFloatMetric(metric_name, traffic_rate);
 
     metric_name = absl::StrFormat("Sink:%s:FlitCount", nc_name);
-    metrics.SetIntegerMetric(metric_name, sink->GetReceivedTraffic().size());
+    metrics.SetIntegerMetric(metric_name,
+                             sink->GetStatistics().GetTotal().flit_count());
+    SetLatencyMetrics(absl::StrFormat("Sink:%s", nc_name),
+                      sink->GetStatistics().GetTotal().latency(), metrics);
 
     // Per VC Metrics
     int64_t vc_count =
@@ -138,10 +194,79 @@ absl::StatusOr<ExperimentMetrics> ExperimentRunner::RunExperiment(
           absl::StrFormat("Sink:%s:VC:%d:TrafficRateInMiBps", nc_name, vc);
       traffic_rate = sink->MeasuredTrafficRateInMiBps(cycle_time_in_ps_, vc);
       metrics.SetFloatMetric(metric_name, traffic_rate);
+      SetLatencyMetrics(absl::StrFormat("Sink:%s:VC:%d", nc_name, vc),
+                        sink->GetStatistics().GetVirtualChannel(vc).latency(),
+                        metrics);
     }
   }
 
   return metrics;
 }
 
+absl::StatusOr<std::vector<ExperimentMetrics>> Experiment::RunAllSteps(
+    int64_t thread_count) const {
+  int64_t step_count = GetStepCount();
+  std::vector<absl::StatusOr<ExperimentMetrics>> results(step_count);
+
+  std::atomic<int64_t> next_step(0);
+  auto worker = [&]() {
+    for (int64_t step = next_step++; step < step_count; step = next_step++) {
+      results[step] = RunStep(step);
+    }
+  };
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int64_t i = 1; i < std::min(thread_count, step_count); ++i) {
+    threads.push_back(std::make_unique<Thread>(worker));
+  }
+  worker();
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+
+  std::vector<ExperimentMetrics> metrics;
+  metrics.reserve(step_count);
+  for (absl::StatusOr<ExperimentMetrics>& result : results) {
+    XLS_ASSIGN_OR_RETURN(ExperimentMetrics step_metrics, std::move(result));
+    metrics.push_back(std::move(step_metrics));
+  }
+  return metrics;
+}
+
+std::string ExperimentMetricsToCsv(absl::Span<const ExperimentMetrics> steps) {
+  absl::btree_set<std::string> float_columns;
+  absl::btree_set<std::string> integer_columns;
+  for (const ExperimentMetrics& metrics : steps) {
+    for (const auto& [name, value] : metrics.GetFloatMetrics()) {
+      float_columns.insert(name);
+    }
+    for (const auto& [name, value] : metrics.GetIntegerMetrics()) {
+      integer_columns.insert(name);
+    }
+  }
+
+  std::vector<std::string> row = {"Step"};
+  row.insert(row.end(), float_columns.begin(), float_columns.end());
+  row.insert(row.end(), integer_columns.begin(), integer_columns.end());
+  std::string csv = absl::StrJoin(row, ",") + "\n";
+
+  for (int64_t step = 0; step < steps.size(); ++step) {
+    row = {absl::StrFormat("%d", step)};
+    for (const std::string& name : float_columns) {
+      auto iter = steps[step].GetFloatMetrics().find(name);
+      row.push_back(iter == steps[step].GetFloatMetrics().end()
+                        ? ""
+                        : absl::StrFormat("%g", iter->second));
+    }
+    for (const std::string& name : integer_columns) {
+      auto iter = steps[step].GetIntegerMetrics().find(name);
+      row.push_back(iter == steps[step].GetIntegerMetrics().end()
+                        ? ""
+                        : absl::StrFormat("%d", iter->second));
+    }
+    absl::StrAppend(&csv, absl::StrJoin(row, ","), "\n");
+  }
+
+  return csv;
+}
+
 }  // namespace xls::noc
@@ -16,10 +16,12 @@
 #define XLS_NOC_EXPERIMENT_H_
 
 #include <queue>
+#include <string>
 #include <vector>
 
 #include "absl/container/btree_map.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -114,6 +116,16 @@ class ExperimentMetrics {
     return float_metrics_.at(metric);
   }
 
+  // Returns all floating point metrics, ordered by name.
+  const absl::btree_map<std::string, double>& GetFloatMetrics() const {
+    return float_metrics_;
+  }
+
+  // Returns all integer metrics, ordered by name.
+  const absl::btree_map<std::string, int64_t>& GetIntegerMetrics() const {
+    return integer_metrics_;
+  }
+
   // Prints out the metrics and values stored.
   absl::Status DebugDump() const;
 
@@ -167,6 +179,12 @@ class ExperimentRunner {
   std::string mode_name_;
 };
 
+// Formats the metrics of each step of a sweep, such as returned by
+// Experiment::RunAllSteps(), as a CSV table.  The table has a row per step
+// and a column per metric set by any step.  Metrics a step did not set are
+// left empty.
+std::string ExperimentMetricsToCsv(absl::Span<const ExperimentMetrics> steps);
+
 class ExperimentBuilderBase;
 
 // A description of an experiment.
@@ -194,6 +212,18 @@ class Experiment {
     return metrics;
   }
 
+  // Run the simulation for every step, spreading steps across up to
+  // thread_count threads (including the calling one).
+  //
+  // Each step builds its own network, routing table, traffic injector and
+  // simulator, seeded with the seed of the runner as in RunStep(), so
+  // results do not depend on the number of threads.
+  //
+  // Returns the metrics of each step, indexed by step, or the error of the
+  // first step that failed.
+  absl::StatusOr<std::vector<ExperimentMetrics>> RunAllSteps(
+      int64_t thread_count = 1) const;
+
   // Get the configuration for step N.
   absl::StatusOr<ExperimentConfig> GetConfigForStep(int64_t step) const {
     XLS_RET_CHECK(step >= 0 && step < GetStepCount());
@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/str_format.h"
@@ -185,5 +187,20 @@ TEST(ExperimentsTest, ExperimentMetrics) {
   XLS_EXPECT_OK(metrics.DebugDump());
 }
 
+TEST(ExperimentsTest, ExperimentMetricsToCsv) {
+  std::vector<ExperimentMetrics> steps(3);
+  steps[0].SetFloatMetric("Rate", 1.5);
+  steps[0].SetIntegerMetric("Count", 10);
+  steps[1].SetIntegerMetric("Count", 20);
+  steps[2].SetFloatMetric("Rate", 0.25);
+  steps[2].SetFloatMetric("Latency", 7);
+
+  EXPECT_EQ(ExperimentMetricsToCsv(steps),
+            "Step,Latency,Rate,Count\n"
+            "0,,1.5,10\n"
+            "1,,,20\n"
+            "2,7,0.25,\n");
+}
+
 }  // namespace
 }  // namespace xls::noc
@@ -0,0 +1,272 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures how many cycles per second NocSimulator simulates on the sample
+// networks of sample_network_graphs.h.  The networks are small, so the
+// measurement is dominated by the per-flit and per-component overhead of the
+// simulation objects rather than by the scheduling of components.
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/noc/config/network_config.pb.h"
+#include "xls/noc/simulation/common.h"
+#include "xls/noc/simulation/flit.h"
+#include "xls/noc/simulation/global_routing_table.h"
+#include "xls/noc/simulation/network_graph.h"
+#include "xls/noc/simulation/network_graph_builder.h"
+#include "xls/noc/simulation/parameters.h"
+#include "xls/noc/simulation/sample_network_graphs.h"
+#include "xls/noc/simulation/sim_objects.h"
+#include "xls/noc/simulation/simulator_shims.h"
+#include "xls/noc/simulation/traffic_statistics.h"
+
+ABSL_FLAG(int64_t, cycles, 200'000, "Number of cycles to simulate per run.");
+ABSL_FLAG(int64_t, repetitions, 5,
+          "Number of runs of each configuration; the fastest is reported.");
+ABSL_FLAG(std::vector<std::string>, injection_rates,
+          std::vector<std::string>({"0.1", "0.5", "1.0"}),
+          "Flits injected by each source per cycle.");
+
+const char kUsage[] = R"(
+Reports the number of cycles per second NocSimulator simulates on each of
+the sample networks, with every source sending flits to the sinks it can
+reach in turn, alternating between virtual channels.
+
+Example invocation:
+
+  noc_sample_network_benchmark --cycles=1000000 --injection_rates=0.25,1.0
+)";
+
+namespace xls::noc {
+namespace {
+
+struct SampleNetwork {
+  std::string name;
+  absl::Status (*build)(NetworkConfigProto* nc_proto, NetworkManager* graph,
+                        NocParameters* params);
+
+  // Sinks reachable from each source, by name.
+  std::vector<std::pair<std::string, std::vector<std::string>>> flows;
+};
+
+std::vector<SampleNetwork> GetSampleNetworks() {
+  return {
+      {"Linear000", BuildNetworkGraphLinear000, {{"SendPort0", {"RecvPort0"}}}},
+      {"Tree000",
+       BuildNetworkGraphTree000,
+       {{"SendPort0", {"RecvPort0", "RecvPort1", "RecvPort2", "RecvPort3"}},
+        {"SendPort1", {"RecvPort0", "RecvPort1", "RecvPort2", "RecvPort3"}},
+        {"SendPort2", {"RecvPort1", "RecvPort2", "RecvPort3"}}}},
+      {"Tree001",
+       BuildNetworkGraphTree001,
+       {{"SendPort0", {"RecvPort0", "RecvPort1"}},
+        {"SendPort1", {"RecvPort0", "RecvPort1"}}}},
+  };
+}
+
+// Hands flits to the sources at the start of each cycle, injection_rate
+// per source per cycle on average.
+class FlitInjector : public NocSimulatorServiceShim {
+ public:
+  FlitInjector(NocSimulator& simulator, double injection_rate,
+               int64_t vc_count)
+      : simulator_(&simulator),
+        injection_rate_(injection_rate),
+        vc_count_(vc_count) {}
+
+  void AddSource(SimNetworkInterfaceSrc* src, int64_t source_index,
+                 std::vector<int64_t> destination_indices) {
+    sources_.push_back({src, source_index, std::move(destination_indices)});
+  }
+
+  absl::Status RunCycle() override {
+    int64_t cycle = simulator_->GetCurrentCycle();
+    for (Source& source : sources_) {
+      source.pending_flits += injection_rate_;
+      for (; source.pending_flits >= 1.0; source.pending_flits -= 1.0) {
+        int64_t destination_index =
+            source.destination_indices[source.sent_count %
+                                       source.destination_indices.size()];
+        XLS_ASSIGN_OR_RETURN(
+            TimedDataFlit flit,
+            DataFlitBuilder()
+                .Cycle(cycle)
+                .Type(FlitType::kTail)
+                .VirtualChannel(source.sent_count % vc_count_)
+                .SourceIndex(source.source_index)
+                .DestinationIndex(destination_index)
+                .Data(UBits(source.sent_count, 64))
+                .BuildTimedFlit());
+        XLS_RETURN_IF_ERROR(source.src->SendFlitAtTime(flit));
+        ++source.sent_count;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  struct Source {
+    SimNetworkInterfaceSrc* src;
+    int64_t source_index;
+    std::vector<int64_t> destination_indices;
+    double pending_flits = 0.0;
+    int64_t sent_count = 0;
+  };
+
+  NocSimulator* simulator_;
+  double injection_rate_;
+  int64_t vc_count_;
+  std::vector<Source> sources_;
+};
+
+struct RunResult {
+  absl::Duration time;
+  int64_t flits_received;
+  double mean_latency;
+};
+
+absl::StatusOr<RunResult> Simulate(const SampleNetwork& network,
+                                   double injection_rate, int64_t cycles) {
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  XLS_RETURN_IF_ERROR(network.build(&proto, &graph, &params));
+  NetworkId network_id = graph.GetNetworkIds()[0];
+
+  DistributedRoutingTableBuilderForTrees route_builder;
+  XLS_ASSIGN_OR_RETURN(
+      DistributedRoutingTable routing_table,
+      route_builder.BuildNetworkRoutingTables(network_id, graph, params));
+
+  NocSimulator simulator;
+  simulator.SetReceivedTrafficCapacity(0);
+  XLS_RETURN_IF_ERROR(
+      simulator.Initialize(graph, params, routing_table, network_id));
+
+  FlitInjector injector(
+      simulator, injection_rate,
+      params.GetNetworkParam(network_id)->VirtualChannelCount());
+  for (const auto& [src_name, sink_names] : network.flows) {
+    XLS_ASSIGN_OR_RETURN(NetworkComponentId src_id,
+                         FindNetworkComponentByName(src_name, graph, params));
+    XLS_ASSIGN_OR_RETURN(
+        int64_t source_index,
+        routing_table.GetSourceIndices().GetNetworkComponentIndex(src_id));
+    XLS_ASSIGN_OR_RETURN(SimNetworkInterfaceSrc * src,
+                         simulator.GetSimNetworkInterfaceSrc(src_id));
+    std::vector<int64_t> destination_indices;
+    for (const std::string& sink_name : sink_names) {
+      XLS_ASSIGN_OR_RETURN(
+          NetworkComponentId sink_id,
+          FindNetworkComponentByName(sink_name, graph, params));
+      XLS_ASSIGN_OR_RETURN(
+          int64_t sink_index,
+          routing_table.GetSinkIndices().GetNetworkComponentIndex(sink_id));
+      destination_indices.push_back(sink_index);
+    }
+    injector.AddSource(src, source_index, std::move(destination_indices));
+  }
+  simulator.RegisterPreCycleService(injector);
+
+  absl::Time start = absl::Now();
+  for (int64_t i = 0; i < cycles; ++i) {
+    XLS_RETURN_IF_ERROR(simulator.RunCycle());
+  }
+
+  RunResult result{absl::Now() - start, 0, 0.0};
+  double total_latency = 0.0;
+  for (NetworkComponentId sink_id :
+       routing_table.GetSinkIndices().GetNetworkComponents()) {
+    XLS_ASSIGN_OR_RETURN(SimNetworkInterfaceSink * sink,
+                         simulator.GetSimNetworkInterfaceSink(sink_id));
+    const TrafficStatistics& total = sink->GetStatistics().GetTotal();
+    result.flits_received += total.flit_count();
+    total_latency += total.latency().mean() * total.flit_count();
+  }
+  if (result.flits_received > 0) {
+    result.mean_latency = total_latency / result.flits_received;
+  }
+  return result;
+}
+
+absl::Status RealMain(int64_t cycles, int64_t repetitions,
+                      absl::Span<const double> injection_rates) {
+  std::cout << absl::StreamFormat("%-10s %6s | %12s %10s %10s\n", "network",
+                                  "rate", "cycles/sec", "flits", "latency");
+
+  for (const SampleNetwork& network : GetSampleNetworks()) {
+    for (double injection_rate : injection_rates) {
+      RunResult fastest;
+      for (int64_t i = 0; i < repetitions; ++i) {
+        XLS_ASSIGN_OR_RETURN(RunResult run,
+                             Simulate(network, injection_rate, cycles));
+        if (i == 0 || run.time < fastest.time) {
+          fastest = run;
+        }
+      }
+      std::cout << absl::StreamFormat(
+          "%-10s %6.3f | %12.0f %10d %10.2f\n", network.name, injection_rate,
+          cycles / absl::ToDoubleSeconds(fastest.time),
+          fastest.flits_received, fastest.mean_latency);
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<double>> ParseDoubles(
+    const std::vector<std::string>& values) {
+  std::vector<double> result;
+  for (const std::string& value : values) {
+    double parsed;
+    XLS_RET_CHECK(absl::SimpleAtod(value, &parsed)) << value;
+    result.push_back(parsed);
+  }
+  return result;
+}
+
+}  // namespace
+}  // namespace xls::noc
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: " << positional_arguments.size();
+
+  absl::StatusOr<std::vector<double>> injection_rates =
+      xls::noc::ParseDoubles(absl::GetFlag(FLAGS_injection_rates));
+  XLS_QCHECK_OK(injection_rates.status());
+
+  XLS_QCHECK_OK(xls::noc::RealMain(absl::GetFlag(FLAGS_cycles),
+                                   absl::GetFlag(FLAGS_repetitions),
+                                   injection_rates.value()));
+  return 0;
+}
@@ -0,0 +1,441 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the cost of simulating a cycle of a network with NocSimulator,
+// comparing the worklist engine against full sweeps of every component, while
+// sweeping the size and depth of the network and the rate at which traffic is
+// injected.
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/noc/config/network_config.pb.h"
+#include "xls/noc/config/network_config_proto_builder.h"
+#include "xls/noc/simulation/common.h"
+#include "xls/noc/simulation/global_routing_table.h"
+#include "xls/noc/simulation/network_graph.h"
+#include "xls/noc/simulation/network_graph_builder.h"
+#include "xls/noc/simulation/noc_traffic_injector.h"
+#include "xls/noc/simulation/parameters.h"
+#include "xls/noc/simulation/random_number_interface.h"
+#include "xls/noc/simulation/sim_objects.h"
+#include "xls/noc/simulation/simulator_to_traffic_injector_shim.h"
+#include "xls/noc/simulation/traffic_description.h"
+
+ABSL_FLAG(int64_t, cycles, 10'000, "Number of cycles to simulate per run.");
+ABSL_FLAG(int64_t, repetitions, 3,
+          "Number of runs of each configuration; the fastest is reported.");
+ABSL_FLAG(std::vector<std::string>, router_counts,
+          std::vector<std::string>({"2", "4", "8", "16"}),
+          "Numbers of ingress (and egress) routers of the simulated networks.");
+ABSL_FLAG(std::vector<std::string>, hop_counts,
+          std::vector<std::string>({"0", "8"}),
+          "Numbers of routers between each ingress (egress) router and the "
+          "central router.");
+ABSL_FLAG(int64_t, endpoints_per_router, 4,
+          "Number of sources (and sinks) attached to each ingress (egress) "
+          "router.");
+ABSL_FLAG(std::vector<std::string>, injection_rates,
+          std::vector<std::string>({"0.01", "0.05", "0.2", "0.5"}),
+          "Traffic injected by each source, as a fraction of link bandwidth.");
+ABSL_FLAG(std::vector<std::string>, thread_counts,
+          std::vector<std::string>({"1", "2", "4", "8"}),
+          "Numbers of threads to run the worklist engine with.");
+ABSL_FLAG(int64_t, seed, 100, "Seed of the traffic generators.");
+
+const char kUsage[] = R"(
+Compares the worklist and full sweep engines of NocSimulator on two-level tree
+networks of increasing size and load, reporting the time and number of
+component ticks per simulated cycle, then reports how the worklist engine
+scales with the number of threads.
+
+Example invocation:
+
+  noc_simulator_benchmark --router_counts=4,16,64 --hop_counts=0,16 \
+    --injection_rates=0.01,0.1 --thread_counts=1,16,32,64
+)";
+
+namespace xls::noc {
+namespace {
+
+constexpr int64_t kCycleTimeInPs = 500;
+constexpr int64_t kPhitBitWidth = 128;
+
+// Builds a network where each of the router_count ingress routers aggregates
+// the traffic of endpoints_per_router sources into a central router, which
+// distributes it to router_count egress routers each serving
+// endpoints_per_router sinks:
+//
+//   SendPort0 .. SendPortK-1     ...
+//     [ Ingress0 ]               ...  [ IngressN-1 ]
+//                  \                 /
+//                    [   Central   ]
+//                  /                 \
+//     [ Egress0 ]                ...  [ EgressN-1 ]
+//   RecvPort0 .. RecvPortK-1     ...
+//
+// Each ingress and egress router is connected to the central router through
+// a chain of hop_count single input, single output routers, which increases
+// the depth of the network without changing its bandwidth.
+//
+// Every route is unique, so the tree routing table builder can be used.
+absl::StatusOr<NetworkConfigProto> BuildNetworkConfig(
+    int64_t router_count, int64_t endpoints_per_router, int64_t hop_count) {
+  NetworkConfigProtoBuilder builder("NocSimulatorBenchmark");
+  builder.WithVirtualChannel("VC0").WithDepth(8);
+
+  auto add_link = [&](absl::string_view source, absl::string_view sink) {
+    builder.WithLink(absl::StrFormat("Link_%s_%s", source, sink))
+        .WithSourcePort(source)
+        .WithSinkPort(sink)
+        .WithPhitBitWidth(kPhitBitWidth)
+        .WithSourceSinkPipelineStage(1)
+        .WithSinkSourcePipelineStage(1);
+  };
+
+  // Links source to sink through hop_count routers.
+  auto add_hops = [&](absl::string_view name, absl::string_view source,
+                      absl::string_view sink) {
+    std::string previous(source);
+    for (int64_t h = 0; h < hop_count; ++h) {
+      std::string hop_name = absl::StrFormat("%sHop%d", name, h);
+      auto hop = builder.WithRouter(hop_name);
+      hop.WithInputPort(hop_name + "In").WithVirtualChannel("VC0");
+      hop.WithOutputPort(hop_name + "Out").WithVirtualChannel("VC0");
+      add_link(previous, hop_name + "In");
+      previous = hop_name + "Out";
+    }
+    add_link(previous, sink);
+  };
+
+  auto central = builder.WithRouter("Central");
+  for (int64_t r = 0; r < router_count; ++r) {
+    std::string central_in = absl::StrFormat("CentralIn%d", r);
+    std::string central_out = absl::StrFormat("CentralOut%d", r);
+    central.WithInputPort(central_in).WithVirtualChannel("VC0");
+    central.WithOutputPort(central_out).WithVirtualChannel("VC0");
+
+    std::string ingress_name = absl::StrFormat("Ingress%d", r);
+    auto ingress = builder.WithRouter(ingress_name);
+    std::string ingress_out = ingress_name + "Out";
+    ingress.WithOutputPort(ingress_out).WithVirtualChannel("VC0");
+    add_hops(ingress_name, ingress_out, central_in);
+
+    std::string egress_name = absl::StrFormat("Egress%d", r);
+    auto egress = builder.WithRouter(egress_name);
+    std::string egress_in = egress_name + "In";
+    egress.WithInputPort(egress_in).WithVirtualChannel("VC0");
+    add_hops(egress_name, central_out, egress_in);
+
+    for (int64_t e = 0; e < endpoints_per_router; ++e) {
+      int64_t endpoint = r * endpoints_per_router + e;
+
+      std::string send_port = absl::StrFormat("SendPort%d", endpoint);
+      std::string ingress_in = absl::StrFormat("%sIn%d", ingress_name, e);
+      builder.WithPort(send_port).AsInputDirection().WithVirtualChannel("VC0");
+      ingress.WithInputPort(ingress_in).WithVirtualChannel("VC0");
+      add_link(send_port, ingress_in);
+
+      std::string recv_port = absl::StrFormat("RecvPort%d", endpoint);
+      std::string egress_out = absl::StrFormat("%sOut%d", egress_name, e);
+      builder.WithPort(recv_port).AsOutputDirection().WithVirtualChannel(
+          "VC0");
+      egress.WithOutputPort(egress_out).WithVirtualChannel("VC0");
+      add_link(egress_out, recv_port);
+    }
+  }
+
+  return builder.Build();
+}
+
+// Adds a flow from every source to the sink half way around the network,
+// so that all traffic crosses the central router.
+absl::StatusOr<TrafficModeId> BuildTraffic(int64_t endpoint_count,
+                                           double injection_rate,
+                                           NocTrafficManager& traffic_mgr) {
+  XLS_ASSIGN_OR_RETURN(TrafficModeId mode_id, traffic_mgr.CreateTrafficMode());
+  TrafficMode& mode = traffic_mgr.GetTrafficMode(mode_id);
+  mode.SetName("Main");
+
+  // Rate in bits per 1000 cycles, to keep small rates representable.
+  int64_t bits = static_cast<int64_t>(
+      std::round(injection_rate * kPhitBitWidth * 1000.0));
+  for (int64_t i = 0; i < endpoint_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(TrafficFlowId flow_id,
+                         traffic_mgr.CreateTrafficFlow());
+    traffic_mgr.GetTrafficFlow(flow_id)
+        .SetName(absl::StrFormat("flow_%d", i))
+        .SetSource(absl::StrFormat("SendPort%d", i))
+        .SetDestination(absl::StrFormat("RecvPort%d",
+                                        (i + endpoint_count / 2) %
+                                            endpoint_count))
+        .SetVC("VC0")
+        .SetTrafficRateInBitsPerPS(bits, 1000 * kCycleTimeInPs)
+        .SetPacketSizeInBits(kPhitBitWidth)
+        .SetBurstProbInMils(7);
+    mode.RegisterTrafficFlow(flow_id);
+  }
+  return mode_id;
+}
+
+struct RunResult {
+  absl::Duration time;
+  int64_t component_ticks;
+  int64_t component_count;
+  int64_t partition_count;
+  int64_t flits_received;
+  // Hash of every flit received along with the sink and cycle it was
+  // received on.
+  size_t received_digest;
+};
+
+absl::StatusOr<RunResult> Simulate(const NetworkConfigProto& proto,
+                                   const NocTrafficManager& traffic_mgr,
+                                   TrafficModeId mode_id, bool full_sweep_mode,
+                                   int64_t worker_thread_count, int64_t cycles,
+                                   int64_t seed) {
+  NetworkManager graph;
+  NocParameters params;
+  XLS_RETURN_IF_ERROR(BuildNetworkGraphFromProto(proto, &graph, &params));
+  NetworkId network_id = graph.GetNetworkIds()[0];
+
+  DistributedRoutingTableBuilderForTrees route_builder;
+  XLS_ASSIGN_OR_RETURN(
+      DistributedRoutingTable routing_table,
+      route_builder.BuildNetworkRoutingTables(network_id, graph, params));
+
+  RandomNumberInterface rnd;
+  rnd.SetSeed(seed);
+  XLS_ASSIGN_OR_RETURN(
+      NocTrafficInjector traffic_injector,
+      NocTrafficInjectorBuilder().Build(
+          kCycleTimeInPs, mode_id,
+          routing_table.GetSourceIndices().GetNetworkComponents(),
+          routing_table.GetSinkIndices().GetNetworkComponents(),
+          params.GetNetworkParam(network_id)->GetVirtualChannels(),
+          traffic_mgr, graph, params, rnd));
+
+  NocSimulator simulator;
+  simulator.SetFullSweepMode(full_sweep_mode);
+  simulator.SetWorkerThreadCount(worker_thread_count);
+  XLS_RETURN_IF_ERROR(
+      simulator.Initialize(graph, params, routing_table, network_id));
+
+  NocSimulatorToNocTrafficInjectorShim injector_shim(simulator,
+                                                     traffic_injector);
+  traffic_injector.SetSimulatorShim(injector_shim);
+  simulator.RegisterPreCycleService(injector_shim);
+
+  absl::Time start = absl::Now();
+  for (int64_t i = 0; i < cycles; ++i) {
+    XLS_RETURN_IF_ERROR(simulator.RunCycle());
+  }
+
+  RunResult result;
+  result.time = absl::Now() - start;
+  result.component_ticks = simulator.GetComponentTickCount();
+  result.component_count =
+      graph.GetNetwork(network_id).GetNetworkComponentCount();
+  result.partition_count = simulator.GetPartitionCount();
+  result.flits_received = 0;
+  result.received_digest = 0;
+  absl::Hash<std::tuple<size_t, uint64_t, int64_t, Bits>> hasher;
+  for (NetworkComponentId sink_id :
+       routing_table.GetSinkIndices().GetNetworkComponents()) {
+    XLS_ASSIGN_OR_RETURN(SimNetworkInterfaceSink * sink,
+                         simulator.GetSimNetworkInterfaceSink(sink_id));
+    result.flits_received += sink->GetReceivedTraffic().size();
+    for (const TimedDataFlit& flit : sink->GetReceivedTraffic()) {
+      result.received_digest = hasher(std::make_tuple(
+          result.received_digest, sink_id.AsUInt64(), flit.cycle,
+          flit.flit.data));
+    }
+  }
+  return result;
+}
+
+absl::StatusOr<std::vector<int64_t>> ParseIntegers(
+    const std::vector<std::string>& values) {
+  std::vector<int64_t> result;
+  for (const std::string& value : values) {
+    int64_t parsed;
+    XLS_RET_CHECK(absl::SimpleAtoi(value, &parsed)) << value;
+    result.push_back(parsed);
+  }
+  return result;
+}
+
+absl::StatusOr<std::vector<double>> ParseDoubles(
+    const std::vector<std::string>& values) {
+  std::vector<double> result;
+  for (const std::string& value : values) {
+    double parsed;
+    XLS_RET_CHECK(absl::SimpleAtod(value, &parsed)) << value;
+    result.push_back(parsed);
+  }
+  return result;
+}
+
+absl::Status RealMain(int64_t cycles, int64_t repetitions,
+                      absl::Span<const int64_t> router_counts,
+                      absl::Span<const int64_t> hop_counts,
+                      int64_t endpoints_per_router,
+                      absl::Span<const double> injection_rates,
+                      absl::Span<const int64_t> thread_counts, int64_t seed) {
+  std::cout << absl::StreamFormat(
+      "%7s %5s %9s %6s %10s | %12s %12s | %12s %12s | %8s\n", "routers",
+      "hops", "endpoints", "rate", "components", "sweep us/cyc",
+      "sweep tk/cyc", "wlist us/cyc", "wlist tk/cyc", "speedup");
+
+  // Rows of the thread scaling table, printed once all engines are compared.
+  std::vector<std::string> scaling_rows;
+
+  for (int64_t router_count : router_counts) {
+    for (int64_t hop_count : hop_counts) {
+      XLS_ASSIGN_OR_RETURN(
+          NetworkConfigProto proto,
+          BuildNetworkConfig(router_count, endpoints_per_router, hop_count));
+      int64_t endpoint_count = router_count * endpoints_per_router;
+
+      for (double injection_rate : injection_rates) {
+        NocTrafficManager traffic_mgr;
+        XLS_ASSIGN_OR_RETURN(
+            TrafficModeId mode_id,
+            BuildTraffic(endpoint_count, injection_rate, traffic_mgr));
+
+        // Alternate between the engines and keep the fastest run of each to
+        // reduce noise.
+        RunResult sweep;
+        RunResult worklist;
+        for (int64_t i = 0; i < repetitions; ++i) {
+          XLS_ASSIGN_OR_RETURN(
+              RunResult sweep_run,
+              Simulate(proto, traffic_mgr, mode_id,
+                       /*full_sweep_mode=*/true, /*worker_thread_count=*/1,
+                       cycles, seed));
+          XLS_ASSIGN_OR_RETURN(
+              RunResult worklist_run,
+              Simulate(proto, traffic_mgr, mode_id,
+                       /*full_sweep_mode=*/false, /*worker_thread_count=*/1,
+                       cycles, seed));
+
+          // Both engines must simulate the same behavior.
+          XLS_RET_CHECK_EQ(sweep_run.received_digest,
+                           worklist_run.received_digest);
+
+          if (i == 0 || sweep_run.time < sweep.time) {
+            sweep = sweep_run;
+          }
+          if (i == 0 || worklist_run.time < worklist.time) {
+            worklist = worklist_run;
+          }
+        }
+
+        std::cout << absl::StreamFormat(
+            "%7d %5d %9d %6.3f %10d | %12.3f %12.1f | %12.3f %12.1f | "
+            "%7.2fx\n",
+            router_count, hop_count, endpoint_count, injection_rate,
+            worklist.component_count,
+            absl::ToDoubleMicroseconds(sweep.time) / cycles,
+            static_cast<double>(sweep.component_ticks) / cycles,
+            absl::ToDoubleMicroseconds(worklist.time) / cycles,
+            static_cast<double>(worklist.component_ticks) / cycles,
+            absl::FDivDuration(sweep.time, worklist.time));
+
+        for (int64_t thread_count : thread_counts) {
+          RunResult parallel;
+          for (int64_t i = 0; i < repetitions; ++i) {
+            XLS_ASSIGN_OR_RETURN(
+                RunResult run,
+                Simulate(proto, traffic_mgr, mode_id,
+                         /*full_sweep_mode=*/false, thread_count, cycles,
+                         seed));
+
+            // Partitioning must not change what is simulated.
+            XLS_RET_CHECK_EQ(run.received_digest, worklist.received_digest);
+
+            if (i == 0 || run.time < parallel.time) {
+              parallel = run;
+            }
+          }
+          scaling_rows.push_back(absl::StrFormat(
+              "%7d %5d %9d %6.3f %7d %10d | %12.3f | %7.2fx", router_count,
+              hop_count, endpoint_count, injection_rate, thread_count,
+              parallel.partition_count,
+              absl::ToDoubleMicroseconds(parallel.time) / cycles,
+              absl::FDivDuration(worklist.time, parallel.time)));
+        }
+      }
+    }
+  }
+
+  if (!scaling_rows.empty()) {
+    std::cout << absl::StreamFormat("\n%7s %5s %9s %6s %7s %10s | %12s | %8s\n",
+                                    "routers", "hops", "endpoints", "rate",
+                                    "threads", "partitions", "wlist us/cyc",
+                                    "speedup");
+    for (const std::string& row : scaling_rows) {
+      std::cout << row << "\n";
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls::noc
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: " << positional_arguments.size();
+
+  absl::StatusOr<std::vector<int64_t>> router_counts =
+      xls::noc::ParseIntegers(absl::GetFlag(FLAGS_router_counts));
+  XLS_QCHECK_OK(router_counts.status());
+  absl::StatusOr<std::vector<int64_t>> hop_counts =
+      xls::noc::ParseIntegers(absl::GetFlag(FLAGS_hop_counts));
+  XLS_QCHECK_OK(hop_counts.status());
+  absl::StatusOr<std::vector<double>> injection_rates =
+      xls::noc::ParseDoubles(absl::GetFlag(FLAGS_injection_rates));
+  XLS_QCHECK_OK(injection_rates.status());
+  absl::StatusOr<std::vector<int64_t>> thread_counts =
+      xls::noc::ParseIntegers(absl::GetFlag(FLAGS_thread_counts));
+  XLS_QCHECK_OK(thread_counts.status());
+
+  XLS_QCHECK_OK(xls::noc::RealMain(
+      absl::GetFlag(FLAGS_cycles), absl::GetFlag(FLAGS_repetitions),
+      router_counts.value(), hop_counts.value(),
+      absl::GetFlag(FLAGS_endpoints_per_router), injection_rates.value(),
+      thread_counts.value(), absl::GetFlag(FLAGS_seed)));
+  return 0;
+}
@@ -14,6 +14,8 @@
 
 #include "xls/noc/drivers/sample_experiments.h"
 
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/str_format.h"
@@ -84,6 +86,24 @@ TEST(SampleExperimentsTest, SimpleVCExperiment) {
                                                   "Sink:RecvPort0:FlitCount"));
   EXPECT_EQ(ex0_flits / 1000, 16);
 
+  XLS_ASSERT_OK_AND_ASSIGN(
+      int64_t ex0_p50_latency,
+      metrics.at(0).GetIntegerMetric("Sink:RecvPort0:P50Latency"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      int64_t ex0_p99_latency,
+      metrics.at(0).GetIntegerMetric("Sink:RecvPort0:P99Latency"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      int64_t ex0_max_latency,
+      metrics.at(0).GetIntegerMetric("Sink:RecvPort0:MaxLatency"));
+  EXPECT_GT(ex0_p50_latency, 0);
+  EXPECT_LE(ex0_p50_latency, ex0_p99_latency);
+  EXPECT_LE(ex0_p99_latency, ex0_max_latency);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      double ex0_flow0_latency,
+      metrics.at(0).GetFloatMetric("Flow:flow_0:MeanLatency"));
+  EXPECT_GT(ex0_flow0_latency, 0.0);
+
   XLS_ASSERT_OK_AND_ASSIGN(
       double ex0_vc0_traffic_rate,
       metrics.at(0).GetFloatMetric("Sink:RecvPort0:VC:0:TrafficRateInMiBps"));
@@ -177,6 +197,17 @@ TEST(SampleExperimentsTest, AggregateTreeTest) {
     EXPECT_GE(prior_traffic_rate, next_traffic_rate);
     prior_traffic_rate = next_traffic_rate;
   }
+
+  // Running the steps in parallel gives the same results.
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<ExperimentMetrics> parallel_metrics,
+                           experiment.RunAllSteps(/*thread_count=*/4));
+  ASSERT_EQ(parallel_metrics.size(), step_count);
+  for (int64_t i = 0; i < step_count; ++i) {
+    EXPECT_EQ(parallel_metrics.at(i).GetFloatMetrics(),
+              metrics.at(i).GetFloatMetrics());
+    EXPECT_EQ(parallel_metrics.at(i).GetIntegerMetrics(),
+              metrics.at(i).GetIntegerMetrics());
+  }
 }
 
 }  // namespace
@@ -238,11 +238,13 @@ class DataFlitBuilder {
     return flit_;
   }
 
-  // Builds a flit with an associated time.
+  // Builds a flit with an associated time, which is also recorded as
+  // the time it is injected into the network.
   absl::StatusOr<TimedDataFlit> BuildTimedFlit() {
     TimedDataFlit timed_flit;
 
     timed_flit.cycle = cycle_;
+    timed_flit.metadata.injection_cycle_time = cycle_;
     XLS_ASSIGN_OR_RETURN(timed_flit.flit, BuildFlit());
 
     return timed_flit;
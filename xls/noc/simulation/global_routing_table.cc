@@ -14,13 +14,18 @@
 
 #include "xls/noc/simulation/global_routing_table.h"
 
+#include <array>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/variant.h"
 #include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
 #include "xls/noc/config/network_config.pb.h"
 #include "xls/noc/simulation/common.h"
 #include "xls/noc/simulation/network_graph.h"
@@ -29,6 +34,50 @@
 namespace xls {
 namespace noc {
 
+namespace {
+
+// Directions of the neighbors of a router in a mesh.
+enum MeshDirection { kEast = 0, kWest, kNorth, kSouth, kMeshDirectionCount };
+
+// Information about a router of a mesh.
+struct MeshRouter {
+  int64_t x;
+  int64_t y;
+
+  // Output port leading to the adjacent router in each direction.
+  std::array<PortId, kMeshDirectionCount> neighbor_ports;
+};
+
+// Returns the input port of the first router or network interface reached
+// by traffic leaving from output_port, skipping over links.
+//
+// Returns PortId::kInvalid if output_port is not connected.
+PortId GetDownstreamPort(NetworkManager& network_manager, PortId output_port) {
+  PortId port = output_port;
+  while (true) {
+    ConnectionId connection = network_manager.GetPort(port).connection();
+    if (!connection.IsValid()) {
+      return PortId::kInvalid;
+    }
+
+    PortId sink_port = network_manager.GetConnection(connection).sink();
+    NetworkComponent& nc =
+        network_manager.GetNetworkComponent(sink_port.GetNetworkComponentId());
+    if (nc.kind() != NetworkComponentKind::kLink) {
+      return sink_port;
+    }
+
+    // Links have a single output port.
+    std::vector<PortId> link_outputs = nc.GetOutputPortIds();
+    if (link_outputs.size() != 1) {
+      return PortId::kInvalid;
+    }
+    port = link_outputs[0];
+  }
+}
+
+}  // namespace
+
 absl::StatusOr<std::vector<NetworkComponentId>>
 DistributedRoutingTable::ComputeRoute(NetworkComponentId source,
                                       NetworkComponentId sink,
@@ -174,6 +223,26 @@ DistributedRoutingTable::GetRouterOutputPortByIndex(PortAndVCIndex from,
       sink.AsUInt64()));
 }
 
+std::vector<PortAndVCIndex>
+DistributedRoutingTable::GetRouterOutputPortsByIndex(
+    PortAndVCIndex from, int64_t destination_index) {
+  std::vector<PortAndVCIndex> ports;
+
+  NetworkComponentId nc_id = from.port_id_.GetNetworkComponentId();
+  RouterRoutingTable& table = GetRoutingTable(nc_id);
+  if (from.port_id_.id() >= table.routes.size() ||
+      from.vc_index_ >= table.routes[from.port_id_.id()].size()) {
+    return ports;
+  }
+
+  for (std::pair<int64_t, PortAndVCIndex>& hop : GetRoutingList(from)) {
+    if (hop.first == destination_index) {
+      ports.push_back(hop.second);
+    }
+  }
+  return ports;
+}
+
 void DistributedRoutingTable::AllocateTableForNetwork(NetworkId network_id,
                                                       int64_t component_count) {
   int64_t network_index = network_id.id();
@@ -186,7 +255,7 @@ void DistributedRoutingTable::AllocateTableForNetwork(NetworkId network_id,
 }
 
 absl::StatusOr<DistributedRoutingTable>
-DistributedRoutingTableBuilderForTrees::BuildNetworkRoutingTables(
+DistributedRoutingTableBuilderBase::BuildNetworkRoutingTables(
     NetworkId network_id, NetworkManager& network_manager,
     NocParameters& network_parameters) {
   DistributedRoutingTable routing_table;
@@ -197,13 +266,16 @@ DistributedRoutingTableBuilderForTrees::BuildNetworkRoutingTables(
   XLS_RET_CHECK_OK(BuildNetworkInterfaceIndices(network_id, &routing_table));
   XLS_RET_CHECK_OK(
       BuildPortAndVirtualChannelIndices(network_id, &routing_table));
-  XLS_RET_CHECK_OK(BuildRoutingTable(network_id, &routing_table));
+
+  routing_table.AllocateTableForNetwork(
+      network_id,
+      network_manager.GetNetwork(network_id).GetNetworkComponentCount());
+  XLS_RETURN_IF_ERROR(BuildRoutingTable(network_id, &routing_table));
 
   return routing_table;
 }
 
-absl::Status
-DistributedRoutingTableBuilderForTrees::BuildNetworkInterfaceIndices(
+absl::Status DistributedRoutingTableBuilderBase::BuildNetworkInterfaceIndices(
     NetworkId network_id, DistributedRoutingTable* routing_table) {
   NetworkComponentIndexMapBuilder source_index_builder;
   NetworkComponentIndexMapBuilder sink_index_builder;
@@ -235,7 +307,7 @@ DistributedRoutingTableBuilderForTrees::BuildNetworkInterfaceIndices(
 }
 
 absl::Status
-DistributedRoutingTableBuilderForTrees::BuildPortAndVirtualChannelIndices(
+DistributedRoutingTableBuilderBase::BuildPortAndVirtualChannelIndices(
     NetworkId network_id, DistributedRoutingTable* routing_table) {
   PortIndexMapBuilder port_index_builder;
   VirtualChannelIndexMapBuilder vc_index_builder;
@@ -285,13 +357,6 @@ DistributedRoutingTableBuilderForTrees::BuildPortAndVirtualChannelIndices(
 
 absl::Status DistributedRoutingTableBuilderForTrees::BuildRoutingTable(
     NetworkId network_id, DistributedRoutingTable* routing_table) {
-  NetworkManager* network_manager = routing_table->network_manager_;
-
-  int64_t component_count =
-      network_manager->GetNetwork(network_id).GetNetworkComponentCount();
-
-  routing_table->AllocateTableForNetwork(network_id, component_count);
-
   const NetworkComponentIndexMap& sink_indices =
       routing_table->GetSinkIndices();
 
@@ -309,59 +374,72 @@ absl::Status DistributedRoutingTableBuilderForTrees::BuildRoutingTable(
   return absl::OkStatus();
 }
 
+absl::Status DistributedRoutingTableBuilderBase::AddRoute(
+    int64_t destination_index, PortId from_port, PortId via_port,
+    DistributedRoutingTable* routing_table) {
+  NetworkManager& network_manager = GetNetworkManager(routing_table);
+  NocParameters& network_parameters = GetNocParameters(routing_table);
+
+  NetworkComponentId nc_id = from_port.GetNetworkComponentId();
+  NetworkComponent& nc = network_manager.GetNetworkComponent(nc_id);
+
+  // Size routing table appropriately.
+  DistributedRoutingTable::RouterRoutingTable& table =
+      routing_table->GetRoutingTable(nc_id);
+  table.routes.resize(nc.GetPortCount());
+
+  XLS_ASSIGN_OR_RETURN(PortParam from_port_param,
+                       network_parameters.GetPortParam(from_port));
+  XLS_ASSIGN_OR_RETURN(PortParam via_port_param,
+                       network_parameters.GetPortParam(via_port));
+
+  // TODO(tedhong): 2020-01-15 Support other VC mapping strategies.
+  int64_t from_port_vc_count = from_port_param.VirtualChannelCount();
+  int64_t via_port_vc_count = via_port_param.VirtualChannelCount();
+
+  if (from_port_vc_count != via_port_vc_count) {
+    return absl::UnimplementedError(absl::StrFormat(
+        "VC route inference is unimplemented "
+        " when vc count changes on path between"
+        " port %s and port %s",
+        from_port_param.GetName(), via_port_param.GetName()));
+  }
+
+  if (from_port_param.VirtualChannelCount() == 0 &&
+      via_port_param.VirtualChannelCount() == 0) {
+    int64_t default_vc = 0;
+    table.routes[from_port.id()].resize(1);
+    table.routes[from_port.id()][default_vc].emplace_back(
+        destination_index, PortAndVCIndex{via_port, default_vc});
+  } else {
+    // VCs are mapped in-order,
+    // ie traffic is rouded from the vc at index 0 to the
+    //    vc at index 0 of the next port.
+    // TODO(tedhong): 2020-01-15 Update this to use global virtual
+    //                           channels to allow for more flexiblity.
+    table.routes[from_port.id()].resize(from_port_vc_count);
+    for (int64_t i = 0; i < from_port_vc_count; ++i) {
+      table.routes[from_port.id()][i].emplace_back(destination_index,
+                                                   PortAndVCIndex{via_port, i});
+    }
+  }
+
+  return absl::OkStatus();
+}
+
 absl::Status DistributedRoutingTableBuilderForTrees::AddRoutes(
     int64_t destination_index, NetworkComponentId nc_id, PortId via_port,
     DistributedRoutingTable* routing_table) {
-  NetworkManager* network_manager = routing_table->network_manager_;
-  NocParameters* network_parameters = routing_table->network_parameters_;
+  NetworkManager& network_manager = GetNetworkManager(routing_table);
 
-  NetworkComponent& nc = network_manager->GetNetworkComponent(nc_id);
+  NetworkComponent& nc = network_manager.GetNetworkComponent(nc_id);
 
   if (nc.kind() == NetworkComponentKind::kRouter) {
-    // Size routing table appropriately.
-    DistributedRoutingTable::RouterRoutingTable& table =
-        routing_table->GetRoutingTable(nc_id);
-    table.routes.resize(nc.GetPortCount());
-
     // Update routing table.
     for (Port& port : nc.GetPorts()) {
       if (port.direction() == PortDirection::kInput) {
-        PortId from_port = port.id();
-        XLS_ASSIGN_OR_RETURN(PortParam from_port_param,
-                             network_parameters->GetPortParam(from_port));
-        XLS_ASSIGN_OR_RETURN(PortParam via_port_param,
-                             network_parameters->GetPortParam(via_port));
-
-        // TODO(tedhong): 2020-01-15 Support other VC mapping strategies.
-        int64_t from_port_vc_count = from_port_param.VirtualChannelCount();
-        int64_t via_port_vc_count = via_port_param.VirtualChannelCount();
-
-        if (from_port_vc_count != via_port_vc_count) {
-          return absl::UnimplementedError(absl::StrFormat(
-              "VC route inference is unimplemented "
-              " when vc count changes on path between"
-              " port %s and port %s",
-              from_port_param.GetName(), via_port_param.GetName()));
-        }
-
-        if (from_port_param.VirtualChannelCount() == 0 &&
-            via_port_param.VirtualChannelCount() == 0) {
-          int64_t default_vc = 0;
-          table.routes[from_port.id()].resize(1);
-          table.routes[from_port.id()][default_vc].emplace_back(
-              destination_index, PortAndVCIndex{via_port, default_vc});
-        } else {
-          // VCs are mapped in-order,
-          // ie traffic is rouded from the vc at index 0 to the
-          //    vc at index 0 of the next port.
-          // TODO(tedhong): 2020-01-15 Update this to use global virtual
-          //                           channels to allow for more flexiblity.
-          table.routes[from_port.id()].resize(from_port_vc_count);
-          for (int64_t i = 0; i < from_port_vc_count; ++i) {
-            table.routes[from_port.id()][i].emplace_back(
-                destination_index, PortAndVCIndex{via_port, i});
-          }
-        }
+        XLS_RETURN_IF_ERROR(
+            AddRoute(destination_index, port.id(), via_port, routing_table));
       }
     }
   }
@@ -373,7 +451,7 @@ absl::Status DistributedRoutingTableBuilderForTrees::AddRoutes(
       if (port.direction() == PortDirection::kInput &&
           port.connection().IsValid()) {
         PortId prior_port =
-            network_manager->GetConnection(port.connection()).src();
+            network_manager.GetConnection(port.connection()).src();
         NetworkComponentId prior_component = prior_port.GetNetworkComponentId();
         // std::cout << absl::StrFormat("Traversing to port %x component %x",
         //  prior_port.AsUInt64(), prior_component.AsUInt64()) << std::endl;
@@ -387,5 +465,157 @@ absl::Status DistributedRoutingTableBuilderForTrees::AddRoutes(
   return absl::OkStatus();
 }
 
+absl::Status DistributedRoutingTableBuilderForMeshes::BuildRoutingTable(
+    NetworkId network_id, DistributedRoutingTable* routing_table) {
+  NetworkManager& network_manager = GetNetworkManager(routing_table);
+  NocParameters& network_parameters = GetNocParameters(routing_table);
+  Network& network = network_manager.GetNetwork(network_id);
+
+  // Place each router of the network.
+  absl::flat_hash_map<NetworkComponentId, MeshRouter> routers;
+  absl::flat_hash_map<std::pair<int64_t, int64_t>, NetworkComponentId>
+      routers_by_coordinate;
+
+  for (NetworkComponentId nc_id : network.GetNetworkComponentIds()) {
+    if (network.GetNetworkComponent(nc_id).kind() !=
+        NetworkComponentKind::kRouter) {
+      continue;
+    }
+
+    XLS_ASSIGN_OR_RETURN(NetworkComponentParam param,
+                         network_parameters.GetNetworkComponentParam(nc_id));
+    absl::string_view name = absl::get<RouterParam>(param).GetName();
+
+    auto coordinate = coordinates_.find(name);
+    if (coordinate == coordinates_.end()) {
+      return absl::NotFoundError(
+          absl::StrFormat("No mesh coordinate given for router %s", name));
+    }
+    if (!routers_by_coordinate.insert({coordinate->second, nc_id}).second) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Router %s placed at (%d, %d) which is already occupied", name,
+          coordinate->second.first, coordinate->second.second));
+    }
+
+    routers[nc_id] = MeshRouter{coordinate->second.first,
+                                coordinate->second.second,
+                                {}};
+  }
+
+  // Find the neighbors of each router and the router each sink is
+  // connected to.
+  absl::flat_hash_map<NetworkComponentId, PortId> sink_ports;
+
+  for (auto& [nc_id, router] : routers) {
+    for (PortId port :
+         network.GetNetworkComponent(nc_id).GetOutputPortIds()) {
+      PortId downstream_port = GetDownstreamPort(network_manager, port);
+      if (!downstream_port.IsValid()) {
+        continue;
+      }
+
+      NetworkComponentId downstream_id =
+          downstream_port.GetNetworkComponentId();
+      NetworkComponentKind downstream_kind =
+          network_manager.GetNetworkComponent(downstream_id).kind();
+
+      if (downstream_kind == NetworkComponentKind::kNISink) {
+        if (!sink_ports.insert({downstream_id, port}).second) {
+          return absl::InvalidArgumentError(absl::StrFormat(
+              "Sink %x is connected to more than one router",
+              downstream_id.AsUInt64()));
+        }
+      } else if (downstream_kind == NetworkComponentKind::kRouter) {
+        const MeshRouter& neighbor = routers.at(downstream_id);
+        int64_t dx = neighbor.x - router.x;
+        int64_t dy = neighbor.y - router.y;
+
+        MeshDirection direction;
+        if (dx == 1 && dy == 0) {
+          direction = kEast;
+        } else if (dx == -1 && dy == 0) {
+          direction = kWest;
+        } else if (dx == 0 && dy == 1) {
+          direction = kNorth;
+        } else if (dx == 0 && dy == -1) {
+          direction = kSouth;
+        } else {
+          return absl::InvalidArgumentError(absl::StrFormat(
+              "Router at (%d, %d) is connected to non-adjacent router at "
+              "(%d, %d)",
+              router.x, router.y, neighbor.x, neighbor.y));
+        }
+        router.neighbor_ports[direction] = port;
+      }
+    }
+  }
+
+  // Algorithm:
+  //  For each sink
+  //   For each router
+  //     Record the (minimal) hops allowed by the routing algorithm
+  const NetworkComponentIndexMap& sink_indices =
+      routing_table->GetSinkIndices();
+
+  for (int64_t i = 0; i < sink_indices.NetworkComponentCount(); ++i) {
+    XLS_ASSIGN_OR_RETURN(NetworkComponentId sink_id,
+                         sink_indices.GetNetworkComponentByIndex(i));
+
+    auto sink_port = sink_ports.find(sink_id);
+    if (sink_port == sink_ports.end()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Sink %x is not connected to a router", sink_id.AsUInt64()));
+    }
+    const MeshRouter& destination =
+        routers.at(sink_port->second.GetNetworkComponentId());
+
+    for (auto& [nc_id, router] : routers) {
+      int64_t dx = destination.x - router.x;
+      int64_t dy = destination.y - router.y;
+
+      std::vector<PortId> via_ports;
+      if (dx == 0 && dy == 0) {
+        via_ports.push_back(sink_port->second);
+      } else {
+        std::vector<MeshDirection> directions;
+        if (dx < 0) {
+          directions.push_back(kWest);
+        } else if (algorithm_ == MeshRoutingAlgorithm::kDimensionOrder ||
+                   dy == 0) {
+          directions.push_back(dx > 0 ? kEast : (dy > 0 ? kNorth : kSouth));
+        } else {
+          // West-first: once traffic no longer needs to travel west, it
+          // may take any productive direction.
+          if (dx > 0) {
+            directions.push_back(kEast);
+          }
+          directions.push_back(dy > 0 ? kNorth : kSouth);
+        }
+
+        for (MeshDirection direction : directions) {
+          PortId via_port = router.neighbor_ports[direction];
+          if (!via_port.IsValid()) {
+            return absl::InvalidArgumentError(absl::StrFormat(
+                "Router at (%d, %d) has no neighbor in the direction of "
+                "(%d, %d)",
+                router.x, router.y, destination.x, destination.y));
+          }
+          via_ports.push_back(via_port);
+        }
+      }
+
+      for (PortId from_port :
+           network.GetNetworkComponent(nc_id).GetInputPortIds()) {
+        for (PortId via_port : via_ports) {
+          XLS_RETURN_IF_ERROR(
+              AddRoute(i, from_port, via_port, routing_table));
+        }
+      }
+    }
+  }
+
+  return absl::OkStatus();
+}
+
 }  // namespace noc
 }  // namespace xls
@@ -19,6 +19,12 @@
 #ifndef XLS_NOC_SIMULATION_GLOBAL_ROUTING_TABLE_H_
 #define XLS_NOC_SIMULATION_GLOBAL_ROUTING_TABLE_H_
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "xls/noc/simulation/common.h"
 #include "xls/noc/simulation/indexer.h"
 #include "xls/noc/simulation/parameters.h"
@@ -58,6 +64,10 @@ class DistributedRoutingTable {
   // a specific destination
   //   1. Retrieve the associated PortRoutingList
   //   2. Find the tuple that matched the given destination within the list.
+  //
+  // Adaptive routing algorithms may store several tuples for the same
+  // destination, in which case the flit may take any of them.  The
+  // tuples are stored in order of preference.
   using PortRoutingList = std::vector<std::pair<int64_t, PortAndVCIndex>>;
 
   // See comment above.
@@ -98,6 +108,14 @@ class DistributedRoutingTable {
   absl::StatusOr<PortAndVCIndex> GetRouterOutputPortByIndex(
       PortAndVCIndex from, int64_t destination_index);
 
+  // Given an input port (of a router), a local virtual channel, and
+  // final destination index (sink), return all the output ports and vcs
+  // the data may go out on, in order of preference.
+  //
+  // Returns an empty list if there is no route.
+  std::vector<PortAndVCIndex> GetRouterOutputPortsByIndex(
+      PortAndVCIndex from, int64_t destination_index);
+
   // TODO(tedhong): 2020-01-25 Add indexer for input/output ports of a router
   //                          and support routing directly via indices.
 
@@ -116,7 +134,7 @@ class DistributedRoutingTable {
   const NetworkComponentIndexMap& GetSinkIndices() { return sink_indices_; }
 
  private:
-  friend class DistributedRoutingTableBuilderForTrees;
+  friend class DistributedRoutingTableBuilderBase;
 
   // Resize routing_tables to accomondate the number of networks and
   // number of components in a network.
@@ -152,13 +170,44 @@ class DistributedRoutingTable {
   std::vector<std::vector<RouterRoutingTable>> routing_tables_;
 };
 
-// Build a routing table given a network with a tree topology.
-class DistributedRoutingTableBuilderForTrees {
+// Base class of the builders of routing tables.
+//
+// Derived classes implement BuildRoutingTable() to populate the routes of
+// each router.
+class DistributedRoutingTableBuilderBase {
  public:
+  virtual ~DistributedRoutingTableBuilderBase() = default;
+
   absl::StatusOr<DistributedRoutingTable> BuildNetworkRoutingTables(
       NetworkId network_id, NetworkManager& network_manager,
       NocParameters& network_parameters);
 
+ protected:
+  // Setup the routes of all routers in the network.
+  //
+  // Called once the source, sink, port, and vc indices of routing_table
+  // are setup.
+  virtual absl::Status BuildRoutingTable(
+      NetworkId network_id, DistributedRoutingTable* routing_table) = 0;
+
+  // Adds a route to the routing table of the router owning from_port so
+  // that traffic arriving on from_port for destination_index leaves
+  // via via_port.
+  //
+  // Routes added for the same from_port and destination are kept in the
+  // order they are added.
+  absl::Status AddRoute(int64_t destination_index, PortId from_port,
+                        PortId via_port,
+                        DistributedRoutingTable* routing_table);
+
+  NetworkManager& GetNetworkManager(DistributedRoutingTable* routing_table) {
+    return *routing_table->network_manager_;
+  }
+
+  NocParameters& GetNocParameters(DistributedRoutingTable* routing_table) {
+    return *routing_table->network_parameters_;
+  }
+
  private:
   // Setup source_indicies_ and sink_indices_ for network.
   absl::Status BuildNetworkInterfaceIndices(
@@ -167,10 +216,15 @@ class DistributedRoutingTableBuilderForTrees {
   // Setup port_indices_ and vc_indices_ for network.
   absl::Status BuildPortAndVirtualChannelIndices(
       NetworkId network_id, DistributedRoutingTable* routing_table);
+};
 
+// Build a routing table given a network with a tree topology.
+class DistributedRoutingTableBuilderForTrees
+    : public DistributedRoutingTableBuilderBase {
+ private:
   // Trace and setup routing table for tree-based topologies.
-  absl::Status BuildRoutingTable(NetworkId network_id,
-                                 DistributedRoutingTable* routing_table);
+  absl::Status BuildRoutingTable(
+      NetworkId network_id, DistributedRoutingTable* routing_table) override;
 
   // Updates routing table of nc for routes that travel to destination via_port.
   absl::Status AddRoutes(int64_t destination_index, NetworkComponentId nc,
@@ -178,6 +232,48 @@ class DistributedRoutingTableBuilderForTrees {
                          DistributedRoutingTable* routing_table);
 };
 
+// Routing algorithms for two-dimensional meshes.
+enum class MeshRoutingAlgorithm {
+  // Deterministic XY routing: flits first travel along the x dimension
+  // then along the y dimension.
+  kDimensionOrder,
+
+  // Minimal adaptive routing following the west-first turn model: flits
+  // headed west travel west first, others may take any minimal path to
+  // the destination, preferring the x dimension.
+  kWestFirst,
+};
+
+// Build a routing table given a network whose routers are laid out as a
+// two-dimensional mesh.
+//
+// Each router is given a coordinate, x increasing to the east and y to the
+// north.  Routers must be connected (via links) to the routers adjacent to
+// them, and each sink must be connected to a single router.  Both
+// algorithms only take minimal paths and are free of deadlock without the
+// use of additional virtual channels.
+class DistributedRoutingTableBuilderForMeshes
+    : public DistributedRoutingTableBuilderBase {
+ public:
+  explicit DistributedRoutingTableBuilderForMeshes(
+      MeshRoutingAlgorithm algorithm)
+      : algorithm_(algorithm) {}
+
+  // Sets the coordinate of the router named router_name.
+  DistributedRoutingTableBuilderForMeshes& SetRouterCoordinate(
+      absl::string_view router_name, int64_t x, int64_t y) {
+    coordinates_[router_name] = {x, y};
+    return *this;
+  }
+
+ private:
+  absl::Status BuildRoutingTable(
+      NetworkId network_id, DistributedRoutingTable* routing_table) override;
+
+  MeshRoutingAlgorithm algorithm_;
+  absl::flat_hash_map<std::string, std::pair<int64_t, int64_t>> coordinates_;
+};
+
 }  // namespace noc
 }  // namespace xls
 
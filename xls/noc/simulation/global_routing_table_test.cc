@@ -14,18 +14,30 @@
 
 #include "xls/noc/simulation/global_routing_table.h"
 
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/matchers.h"
 #include "xls/noc/config/network_config.pb.h"
 #include "xls/noc/config/network_config_proto_builder.h"
 #include "xls/noc/simulation/network_graph_builder.h"
+#include "xls/noc/simulation/sample_network_graphs.h"
 
 namespace xls {
 namespace noc {
 namespace {
 
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
 TEST(GlobalRoutingTableTest, Index) {
   XLS_LOG(INFO) << "Setting up network ...";
   NetworkConfigProtoBuilder builder("Test");
@@ -213,6 +225,167 @@ TEST(GlobalRoutingTableTest, Index) {
   EXPECT_EQ(route00[4], recvport0);
 }
 
+// Returns a builder of routing tables for Mesh000.
+DistributedRoutingTableBuilderForMeshes MeshBuilder(
+    MeshRoutingAlgorithm algorithm) {
+  DistributedRoutingTableBuilderForMeshes builder(algorithm);
+  for (int64_t x = 0; x < 3; ++x) {
+    for (int64_t y = 0; y < 3; ++y) {
+      builder.SetRouterCoordinate(absl::StrFormat("Router%d%d", x, y), x, y);
+    }
+  }
+  return builder;
+}
+
+// Returns the names of the routers on the route from SendPort<from> to
+// RecvPort<to>.
+absl::StatusOr<std::vector<std::string>> RoutersOnRoute(
+    DistributedRoutingTable& routing_table, absl::string_view from,
+    absl::string_view to, NetworkManager& graph, NocParameters& params) {
+  XLS_ASSIGN_OR_RETURN(
+      NetworkComponentId source,
+      FindNetworkComponentByName(absl::StrCat("SendPort", from), graph,
+                                 params));
+  XLS_ASSIGN_OR_RETURN(
+      NetworkComponentId sink,
+      FindNetworkComponentByName(absl::StrCat("RecvPort", to), graph, params));
+  XLS_ASSIGN_OR_RETURN(std::vector<NetworkComponentId> route,
+                       routing_table.ComputeRoute(source, sink));
+
+  std::vector<std::string> routers;
+  for (NetworkComponentId nc_id : route) {
+    if (graph.GetNetworkComponent(nc_id).kind() ==
+        NetworkComponentKind::kRouter) {
+      XLS_ASSIGN_OR_RETURN(NetworkComponentParam param,
+                           params.GetNetworkComponentParam(nc_id));
+      routers.push_back(std::string(absl::get<RouterParam>(param).GetName()));
+    }
+  }
+  return routers;
+}
+
+TEST(GlobalRoutingTableTest, MeshDimensionOrder) {
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  XLS_ASSERT_OK(BuildNetworkGraphMesh000(&proto, &graph, &params));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      DistributedRoutingTable routing_table,
+      MeshBuilder(MeshRoutingAlgorithm::kDimensionOrder)
+          .BuildNetworkRoutingTables(graph.GetNetworkIds()[0], graph, params));
+
+  EXPECT_THAT(RoutersOnRoute(routing_table, "00", "22", graph, params),
+              IsOkAndHolds(ElementsAre("Router00", "Router10", "Router20",
+                                       "Router21", "Router22")));
+  EXPECT_THAT(RoutersOnRoute(routing_table, "21", "02", graph, params),
+              IsOkAndHolds(ElementsAre("Router21", "Router11", "Router01",
+                                       "Router02")));
+  EXPECT_THAT(RoutersOnRoute(routing_table, "11", "11", graph, params),
+              IsOkAndHolds(ElementsAre("Router11")));
+
+  // Each hop is deterministic.
+  XLS_ASSERT_OK_AND_ASSIGN(PortId in_local,
+                           FindPortByName("Router00InLocal", graph, params));
+  XLS_ASSERT_OK_AND_ASSIGN(PortId out_east,
+                           FindPortByName("Router00OutEast", graph, params));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      NetworkComponentId recv_port_22,
+      FindNetworkComponentByName("RecvPort22", graph, params));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      int64_t dest_index_22,
+      routing_table.GetSinkIndices().GetNetworkComponentIndex(recv_port_22));
+
+  std::vector<PortAndVCIndex> hops = routing_table.GetRouterOutputPortsByIndex(
+      PortAndVCIndex{in_local, 1}, dest_index_22);
+  ASSERT_EQ(hops.size(), 1);
+  EXPECT_EQ(hops[0].port_id_, out_east);
+  EXPECT_EQ(hops[0].vc_index_, 1);
+}
+
+TEST(GlobalRoutingTableTest, MeshWestFirst) {
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  XLS_ASSERT_OK(BuildNetworkGraphMesh000(&proto, &graph, &params));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      DistributedRoutingTable routing_table,
+      MeshBuilder(MeshRoutingAlgorithm::kWestFirst)
+          .BuildNetworkRoutingTables(graph.GetNetworkIds()[0], graph, params));
+
+  // The preferred route is the same as with dimension order routing.
+  EXPECT_THAT(RoutersOnRoute(routing_table, "00", "22", graph, params),
+              IsOkAndHolds(ElementsAre("Router00", "Router10", "Router20",
+                                       "Router21", "Router22")));
+
+  auto sink_index = [&](absl::string_view name) -> int64_t {
+    NetworkComponentId sink_id =
+        FindNetworkComponentByName(name, graph, params).value();
+    return routing_table.GetSinkIndices()
+        .GetNetworkComponentIndex(sink_id)
+        .value();
+  };
+  auto port = [&](absl::string_view name) -> PortId {
+    return FindPortByName(name, graph, params).value();
+  };
+  auto hop_ports = [&](absl::string_view from, absl::string_view to) {
+    std::vector<PortId> ports;
+    for (PortAndVCIndex hop : routing_table.GetRouterOutputPortsByIndex(
+             PortAndVCIndex{port(from), 0}, sink_index(to))) {
+      ports.push_back(hop.port_id_);
+    }
+    return ports;
+  };
+
+  // Traffic not heading west may take either productive direction.
+  EXPECT_THAT(hop_ports("Router00InLocal", "RecvPort22"),
+              ElementsAre(port("Router00OutEast"), port("Router00OutNorth")));
+  EXPECT_THAT(hop_ports("Router02InEast", "RecvPort20"),
+              ElementsAre(port("Router02OutEast"), port("Router02OutSouth")));
+  EXPECT_THAT(hop_ports("Router10InNorth", "RecvPort12"),
+              ElementsAre(port("Router10OutNorth")));
+
+  // Traffic heading west travels west first.
+  EXPECT_THAT(hop_ports("Router22InLocal", "RecvPort00"),
+              ElementsAre(port("Router22OutWest")));
+  EXPECT_THAT(hop_ports("Router12InSouth", "RecvPort01"),
+              ElementsAre(port("Router12OutWest")));
+}
+
+TEST(GlobalRoutingTableTest, MeshErrors) {
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  XLS_ASSERT_OK(BuildNetworkGraphMesh000(&proto, &graph, &params));
+  NetworkId network_id = graph.GetNetworkIds()[0];
+
+  DistributedRoutingTableBuilderForMeshes missing(
+      MeshRoutingAlgorithm::kDimensionOrder);
+  missing.SetRouterCoordinate("Router00", 0, 0);
+  EXPECT_THAT(
+      missing.BuildNetworkRoutingTables(network_id, graph, params).status(),
+      StatusIs(absl::StatusCode::kNotFound,
+               HasSubstr("No mesh coordinate given for router")));
+
+  DistributedRoutingTableBuilderForMeshes duplicate =
+      MeshBuilder(MeshRoutingAlgorithm::kDimensionOrder);
+  duplicate.SetRouterCoordinate("Router00", 1, 1);
+  EXPECT_THAT(
+      duplicate.BuildNetworkRoutingTables(network_id, graph, params).status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("already occupied")));
+
+  DistributedRoutingTableBuilderForMeshes not_adjacent =
+      MeshBuilder(MeshRoutingAlgorithm::kWestFirst);
+  not_adjacent.SetRouterCoordinate("Router00", -1, -1);
+  EXPECT_THAT(
+      not_adjacent.BuildNetworkRoutingTables(network_id, graph, params)
+          .status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("non-adjacent router")));
+}
+
 }  // namespace
 }  // namespace noc
 }  // namespace xls
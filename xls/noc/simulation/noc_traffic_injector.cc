@@ -269,7 +269,16 @@ absl::Status NocTrafficInjectorBuilder::BuildPerFlowTrafficModels(
     int64_t sink_index = injector.flows_index_to_sinks_index_map_.at(i);
     int64_t vc_index = injector.flows_index_to_vc_index_map_.at(i);
 
-    if (flow.IsReplay()) {
+    if (flow.IsTrace()) {
+      XLS_ASSIGN_OR_RETURN(
+          std::unique_ptr<TraceTrafficModel> model,
+          TraceTrafficModelBuilder(bits_per_packet, flow.GetTracePath())
+              .SetVCIndex(vc_index)
+              .SetSourceIndex(source_index)
+              .SetDestinationIndex(sink_index)
+              .Build());
+      injector.traffic_models_.push_back(std::move(model));
+    } else if (flow.IsReplay()) {
       XLS_ASSIGN_OR_RETURN(
           std::unique_ptr<ReplayTrafficModel> model,
           ReplayTrafficModelBuilder(bits_per_packet, flow.GetClockCycleTimes())
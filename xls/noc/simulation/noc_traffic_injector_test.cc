@@ -16,13 +16,16 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "xls/common/file/temp_file.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/matchers.h"
 #include "xls/noc/simulation/packetizer.h"
 #include "xls/noc/simulation/sample_network_graphs.h"
 #include "xls/noc/simulation/sim_objects.h"
 #include "xls/noc/simulation/traffic_description.h"
+#include "xls/noc/simulation/traffic_trace.h"
 
 namespace xls::noc {
 namespace {
@@ -642,5 +645,78 @@ TEST(NocTrafficInjectorTest, ReplaySource) {
   EXPECT_DOUBLE_EQ(replay_model->GetPacketSizeInBits(), 128);
 }
 
+TEST(NocTrafficInjectorTest, TraceSource) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile trace, TempFile::Create(".trace"));
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficTraceWriter writer,
+                           TrafficTraceWriter::Create(trace.path()));
+  for (int64_t cycle = 0; cycle < 5; ++cycle) {
+    XLS_ASSERT_OK(writer.Add({cycle, 0}));
+  }
+  XLS_ASSERT_OK(writer.Close());
+
+  // Construct traffic flows
+  NocTrafficManager traffic_mgr;
+
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficFlowId flow0_id,
+                           traffic_mgr.CreateTrafficFlow());
+  TrafficFlow& flow0 = traffic_mgr.GetTrafficFlow(flow0_id);
+  flow0.SetName("flow0")
+      .SetSource("SendPort0")
+      .SetDestination("RecvPort0")
+      .SetVC("VC0")
+      .SetPacketSizeInBits(128)
+      .SetTracePath(trace.path().string());
+
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficModeId mode0_id,
+                           traffic_mgr.CreateTrafficMode());
+  TrafficMode& mode0 = traffic_mgr.GetTrafficMode(mode0_id);
+  mode0.SetName("Mode 0").RegisterTrafficFlow(flow0_id);
+
+  // Build and assign simulation objects
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  XLS_ASSERT_OK(BuildNetworkGraphLinear000(&proto, &graph, &params));
+
+  // Create global routing table.
+  DistributedRoutingTableBuilderForTrees route_builder;
+  XLS_ASSERT_OK_AND_ASSIGN(DistributedRoutingTable routing_table,
+                           route_builder.BuildNetworkRoutingTables(
+                               graph.GetNetworkIds()[0], graph, params));
+
+  // Build input traffic model
+  RandomNumberInterface rnd;
+  int64_t cycle_time_in_ps = 400;
+  rnd.SetSeed(1000);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      NocTrafficInjector traffic_injector,
+      NocTrafficInjectorBuilder().Build(
+          cycle_time_in_ps, mode0_id,
+          routing_table.GetSourceIndices().GetNetworkComponents(),
+          routing_table.GetSinkIndices().GetNetworkComponents(),
+          params.GetNetworkParam(graph.GetNetworkIds()[0])
+              ->GetVirtualChannels(),
+          traffic_mgr, graph, params, rnd));
+
+  ASSERT_EQ(traffic_injector.GetTrafficModels().size(), 1);
+  TraceTrafficModel* trace_model = dynamic_cast<TraceTrafficModel*>(
+      traffic_injector.GetTrafficModels().at(0).get());
+  ASSERT_NE(trace_model, nullptr);
+  EXPECT_EQ(trace_model->GetPacketSizeInBits(), 128);
+  EXPECT_EQ(trace_model->GetNewCyclePackets(0).size(), 1);
+
+  // A missing trace fails the build of the injector.
+  flow0.SetTracePath(absl::StrCat(trace.path().string(), ".missing"));
+  absl::StatusOr<NocTrafficInjector> missing_trace_injector =
+      NocTrafficInjectorBuilder().Build(
+          cycle_time_in_ps, mode0_id,
+          routing_table.GetSourceIndices().GetNetworkComponents(),
+          routing_table.GetSinkIndices().GetNetworkComponents(),
+          params.GetNetworkParam(graph.GetNetworkIds()[0])
+              ->GetVirtualChannels(),
+          traffic_mgr, graph, params, rnd);
+  EXPECT_FALSE(missing_trace_injector.ok());
+}
+
 }  // namespace
 }  // namespace xls::noc
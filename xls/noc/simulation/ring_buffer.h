@@ -0,0 +1,128 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_NOC_SIMULATION_RING_BUFFER_H_
+#define XLS_NOC_SIMULATION_RING_BUFFER_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "xls/common/logging/logging.h"
+
+namespace xls::noc {
+
+// A set of fixed-capacity fifos whose elements share a single contiguous
+// allocation.
+//
+// Used by simulation objects to store the flits of all their buffers
+// and pipeline stages, so that no memory is allocated once the simulation
+// has started and the state of a component is close together in memory.
+//
+// Fifos are referred to by index rather than by pointer so the array can be
+// copied along with the object owning it.
+template <typename T>
+class RingBufferArray {
+ public:
+  // A view of a single fifo, valid until the array is copied or destroyed.
+  class Queue {
+   public:
+    int64_t capacity() const { return state_->capacity; }
+    int64_t size() const { return state_->size; }
+    bool empty() const { return state_->size == 0; }
+    bool full() const { return state_->size == state_->capacity; }
+
+    // Returns the oldest element.  The fifo must not be empty.
+    T& front() const {
+      XLS_DCHECK(!empty());
+      return elements_[state_->head];
+    }
+
+    // Returns the i-th oldest element, i < size().
+    T& operator[](int64_t i) const {
+      XLS_DCHECK_LT(i, size());
+      int64_t index = state_->head + i;
+      if (index >= state_->capacity) {
+        index -= state_->capacity;
+      }
+      return elements_[index];
+    }
+
+    // Appends an element.  The fifo must not be full.
+    void push(T value) const {
+      XLS_CHECK(!full()) << "Fifo of capacity " << capacity() << " overflowed";
+      int64_t tail = state_->head + state_->size;
+      if (tail >= state_->capacity) {
+        tail -= state_->capacity;
+      }
+      elements_[tail] = std::move(value);
+      ++state_->size;
+    }
+
+    // Removes the oldest element.  The fifo must not be empty.
+    void pop() const {
+      XLS_DCHECK(!empty());
+      if (++state_->head == state_->capacity) {
+        state_->head = 0;
+      }
+      --state_->size;
+    }
+
+   private:
+    friend class RingBufferArray;
+
+    struct State {
+      int64_t offset;
+      int64_t capacity;
+      int64_t head;
+      int64_t size;
+    };
+
+    Queue(T* elements, State* state) : elements_(elements), state_(state) {}
+
+    T* elements_;
+    State* state_;
+  };
+
+  RingBufferArray() = default;
+
+  // Creates one empty fifo for each of the given capacities.
+  explicit RingBufferArray(absl::Span<const int64_t> capacities) {
+    int64_t offset = 0;
+    states_.reserve(capacities.size());
+    for (int64_t capacity : capacities) {
+      XLS_CHECK_GE(capacity, 0);
+      states_.push_back({offset, capacity, 0, 0});
+      offset += capacity;
+    }
+    elements_.resize(offset);
+  }
+
+  // Number of fifos.
+  int64_t size() const { return states_.size(); }
+
+  Queue operator[](int64_t index) {
+    typename Queue::State& state = states_[index];
+    return Queue(elements_.data() + state.offset, &state);
+  }
+
+ private:
+  std::vector<T> elements_;
+  std::vector<typename Queue::State> states_;
+};
+
+}  // namespace xls::noc
+
+#endif  // XLS_NOC_SIMULATION_RING_BUFFER_H_
@@ -0,0 +1,102 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/noc/simulation/ring_buffer.h"
+
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace xls::noc {
+namespace {
+
+TEST(RingBufferTest, Fifo) {
+  RingBufferArray<int64_t> buffers(std::vector<int64_t>{3});
+  ASSERT_EQ(buffers.size(), 1);
+
+  RingBufferArray<int64_t>::Queue queue = buffers[0];
+  EXPECT_EQ(queue.capacity(), 3);
+  EXPECT_TRUE(queue.empty());
+
+  // Wrap around the end of the buffer a few times.
+  int64_t next_in = 0;
+  int64_t next_out = 0;
+  for (int64_t i = 0; i < 4; ++i) {
+    queue.push(next_in++);
+    queue.push(next_in++);
+    EXPECT_EQ(queue.size(), 2);
+    EXPECT_EQ(queue.front(), next_out);
+    queue.pop();
+    ++next_out;
+    queue.push(next_in++);
+    queue.push(next_in++);
+    EXPECT_TRUE(queue.full());
+    for (int64_t j = 0; j < queue.size(); ++j) {
+      EXPECT_EQ(queue[j], next_out + j);
+    }
+    while (!queue.empty()) {
+      EXPECT_EQ(queue.front(), next_out++);
+      queue.pop();
+    }
+  }
+  EXPECT_EQ(next_out, next_in);
+}
+
+TEST(RingBufferTest, FifosAreIndependent) {
+  std::vector<int64_t> capacities = {1, 0, 4, 2};
+  RingBufferArray<int64_t> buffers(capacities);
+  std::vector<std::queue<int64_t>> expected(capacities.size());
+
+  std::mt19937_64 engine(0);
+  for (int64_t i = 0; i < 1000; ++i) {
+    int64_t index = engine() % capacities.size();
+    RingBufferArray<int64_t>::Queue queue = buffers[index];
+    EXPECT_EQ(queue.capacity(), capacities[index]);
+    if (!queue.full() && (queue.empty() || engine() % 2 == 0)) {
+      queue.push(i);
+      expected[index].push(i);
+    } else if (!queue.empty()) {
+      EXPECT_EQ(queue.front(), expected[index].front());
+      queue.pop();
+      expected[index].pop();
+    }
+    EXPECT_EQ(queue.size(), expected[index].size());
+  }
+}
+
+TEST(RingBufferTest, CopiesAreIndependent) {
+  RingBufferArray<int64_t> buffers(std::vector<int64_t>{2});
+  buffers[0].push(1);
+
+  RingBufferArray<int64_t> copy = buffers;
+  copy[0].pop();
+  copy[0].push(2);
+
+  EXPECT_EQ(buffers[0].size(), 1);
+  EXPECT_EQ(buffers[0].front(), 1);
+  EXPECT_EQ(copy[0].size(), 1);
+  EXPECT_EQ(copy[0].front(), 2);
+}
+
+TEST(RingBufferDeathTest, Overflow) {
+  RingBufferArray<int64_t> buffers(std::vector<int64_t>{1});
+  buffers[0].push(1);
+  EXPECT_DEATH(buffers[0].push(2), "overflowed");
+}
+
+}  // namespace
+}  // namespace xls::noc
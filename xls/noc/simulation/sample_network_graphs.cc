@@ -14,9 +14,11 @@
 
 #include "xls/noc/simulation/sample_network_graphs.h"
 
+#include <string>
 #include <vector>
 
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/noc/config/network_config.pb.h"
@@ -214,4 +216,99 @@ absl::Status BuildNetworkGraphTree001(NetworkConfigProto* nc_proto,
   return absl::OkStatus();
 }
 
+absl::Status BuildNetworkGraphMesh000(NetworkConfigProto* nc_proto,
+                                      NetworkManager* graph,
+                                      NocParameters* params) {
+  XLS_LOG(INFO) << "Setting up network ...";
+  NetworkConfigProtoBuilder builder("Test");
+
+  constexpr int64_t kMeshSize = 3;
+
+  builder.WithVirtualChannel("VC0").WithDepth(3);
+  builder.WithVirtualChannel("VC1").WithDepth(3);
+
+  struct Neighbor {
+    const char* direction;
+    const char* opposite_direction;
+    int64_t dx;
+    int64_t dy;
+  };
+  const Neighbor kNeighbors[] = {{"East", "West", 1, 0},
+                                 {"West", "East", -1, 0},
+                                 {"North", "South", 0, 1},
+                                 {"South", "North", 0, -1}};
+
+  for (int64_t x = 0; x < kMeshSize; ++x) {
+    for (int64_t y = 0; y < kMeshSize; ++y) {
+      std::string name = absl::StrFormat("%d%d", x, y);
+
+      builder.WithPort(absl::StrCat("SendPort", name))
+          .AsInputDirection()
+          .WithVirtualChannel("VC0")
+          .WithVirtualChannel("VC1");
+      builder.WithPort(absl::StrCat("RecvPort", name))
+          .AsOutputDirection()
+          .WithVirtualChannel("VC0")
+          .WithVirtualChannel("VC1");
+
+      auto router = builder.WithRouter(absl::StrCat("Router", name));
+      router.WithInputPort(absl::StrCat("Router", name, "InLocal"))
+          .WithVirtualChannel("VC0")
+          .WithVirtualChannel("VC1");
+      router.WithOutputPort(absl::StrCat("Router", name, "OutLocal"))
+          .WithVirtualChannel("VC0")
+          .WithVirtualChannel("VC1");
+
+      builder.WithLink(absl::StrCat("LinkSend", name))
+          .WithSourcePort(absl::StrCat("SendPort", name))
+          .WithSinkPort(absl::StrCat("Router", name, "InLocal"))
+          .WithPhitBitWidth(128);
+      builder.WithLink(absl::StrCat("LinkRecv", name))
+          .WithSourcePort(absl::StrCat("Router", name, "OutLocal"))
+          .WithSinkPort(absl::StrCat("RecvPort", name))
+          .WithPhitBitWidth(128);
+
+      for (const Neighbor& neighbor : kNeighbors) {
+        int64_t nx = x + neighbor.dx;
+        int64_t ny = y + neighbor.dy;
+        if (nx < 0 || nx >= kMeshSize || ny < 0 || ny >= kMeshSize) {
+          continue;
+        }
+        std::string neighbor_name = absl::StrFormat("%d%d", nx, ny);
+
+        router
+            .WithInputPort(
+                absl::StrCat("Router", name, "In", neighbor.direction))
+            .WithVirtualChannel("VC0")
+            .WithVirtualChannel("VC1");
+        router
+            .WithOutputPort(
+                absl::StrCat("Router", name, "Out", neighbor.direction))
+            .WithVirtualChannel("VC0")
+            .WithVirtualChannel("VC1");
+
+        builder.WithLink(absl::StrCat("Link", name, neighbor_name))
+            .WithSourcePort(
+                absl::StrCat("Router", name, "Out", neighbor.direction))
+            .WithSinkPort(absl::StrCat("Router", neighbor_name, "In",
+                                       neighbor.opposite_direction))
+            .WithPhitBitWidth(128)
+            .WithSourceSinkPipelineStage(1)
+            .WithSinkSourcePipelineStage(1);
+      }
+    }
+  }
+
+  XLS_ASSIGN_OR_RETURN(*nc_proto, builder.Build());
+  XLS_LOG(INFO) << nc_proto->DebugString();
+  XLS_LOG(INFO) << "Done ...";
+
+  // Build and assign simulation objects
+  XLS_RETURN_IF_ERROR(BuildNetworkGraphFromProto(*nc_proto, graph, params));
+  graph->Dump();
+  XLS_LOG(INFO) << "Network Graph Complete ...";
+
+  return absl::OkStatus();
+}
+
 }  // namespace xls::noc
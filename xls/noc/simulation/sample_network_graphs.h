@@ -81,6 +81,28 @@ absl::Status BuildNetworkGraphTree001(NetworkConfigProto* nc_proto,
                                       NetworkManager* graph,
                                       NocParameters* params);
 
+// Builds Sample Mesh Network 000
+//
+//   [ Router02 ] <--> [ Router12 ] <--> [ Router22 ]
+//         ^                 ^                 ^
+//         |                 |                 |
+//         v                 v                 v
+//   [ Router01 ] <--> [ Router11 ] <--> [ Router21 ]
+//         ^                 ^                 ^
+//         |                 |                 |
+//         v                 v                 v
+//   [ Router00 ] <--> [ Router10 ] <--> [ Router20 ]
+//
+// Routerxy is at coordinate (x, y) with x increasing to the east and y to
+// the north.  Each router is also connected to the network interfaces
+// SendPortxy and RecvPortxy.  Links between routers have a single pipeline
+// stage in each direction, so that the simulator does not see the cycles
+// of the mesh as combinational loops, and all ports have two virtual
+// channels.
+absl::Status BuildNetworkGraphMesh000(NetworkConfigProto* nc_proto,
+                                      NetworkManager* graph,
+                                      NocParameters* params);
+
 }  // namespace xls::noc
 
 #endif  // XLS_NOC_SIMULATION_SAMPLE_NETWORK_GRAPHS_H_
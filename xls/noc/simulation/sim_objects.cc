@@ -14,18 +14,29 @@
 
 #include "xls/noc/simulation/sim_objects.h"
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/numeric/bits.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/logging/vlog_is_on.h"
 #include "xls/common/status/ret_check.h"
+#include "xls/common/thread.h"
 #include "xls/ir/bits.h"
 #include "xls/noc/config/network_config.pb.h"
 #include "xls/noc/simulation/common.h"
 #include "xls/noc/simulation/flit.h"
 #include "xls/noc/simulation/network_graph.h"
 #include "xls/noc/simulation/parameters.h"
+#include "xls/noc/simulation/ring_buffer.h"
 
 namespace xls {
 namespace noc {
@@ -41,7 +52,7 @@ class SimplePipelineImpl {
  public:
   SimplePipelineImpl(int64_t stage_count, DataTimePhitT& from_channel,
                      DataTimePhitT& to_channel,
-                     std::queue<DataTimePhitT>& state)
+                     typename RingBufferArray<DataTimePhitT>::Queue state)
       : stage_count_(stage_count),
         from_(from_channel),
         to_(to_channel),
@@ -49,12 +60,23 @@ class SimplePipelineImpl {
 
   bool TryPropagation(NocSimulator& simulator);
 
+  // Splits TryPropagation() in two for pipelines with at least one stage,
+  // whose output does not depend on their input of the same cycle.
+  // DriveOutput() sends the flit leaving the last stage for the current
+  // cycle, and LatchInput() then accepts the input of the given cycle.
+  void DriveOutput(NocSimulator& simulator);
+  void LatchInput(int64_t cycle);
+
  private:
+  // Sends the oldest flit in the pipeline if there are more than
+  // in_flight_count, otherwise an invalid flit.
+  void SendOutput(int64_t cycle, int64_t in_flight_count);
+
   int64_t stage_count_;
   DataTimePhitT& from_;
   DataTimePhitT& to_;
   // TODO(vmirian) 09-07-21 Optimize to select flit data and its metadata
-  std::queue<DataTimePhitT>& state_;
+  typename RingBufferArray<DataTimePhitT>::Queue state_;
 };
 
 template <typename DataTimePhitT>
@@ -67,32 +89,127 @@ bool SimplePipelineImpl<DataTimePhitT>::TryPropagation(
       return true;
     }
 
-    state_.push(from_);
+    LatchInput(current_cycle);
+    SendOutput(current_cycle, stage_count_);
+    return true;
+  }
 
-    XLS_VLOG(2) << absl::StreamFormat("... link received data %s type %d",
-                                      from_.flit.data.ToString(),
-                                      from_.flit.type);
-    if (state_.size() > stage_count_) {
-      to_.flit = state_.front().flit;
-      to_.cycle = current_cycle;
-      to_.metadata = state_.front().metadata;
-      state_.pop();
-    } else {
-      to_.flit.type = FlitType::kInvalid;
-      to_.flit.data = Bits(32);
-      to_.cycle = current_cycle;
-    }
+  return false;
+}
 
-    XLS_VLOG(2) << absl::StreamFormat(
-        "... link sending data %s type %d connection", to_.flit.data.ToString(),
-        to_.flit.type);
+template <typename DataTimePhitT>
+void SimplePipelineImpl<DataTimePhitT>::DriveOutput(NocSimulator& simulator) {
+  XLS_DCHECK_GT(stage_count_, 0);
+  // The input of the current cycle is not in the pipeline yet.
+  SendOutput(simulator.GetCurrentCycle(), stage_count_ - 1);
+}
+
+template <typename DataTimePhitT>
+void SimplePipelineImpl<DataTimePhitT>::LatchInput(int64_t cycle) {
+  XLS_DCHECK_EQ(from_.cycle, cycle);
+  state_.push(from_);
+
+  XLS_VLOG(2) << absl::StreamFormat("... link received data %s type %d",
+                                    from_.flit.data.ToString(),
+                                    from_.flit.type);
+}
+
+template <typename DataTimePhitT>
+void SimplePipelineImpl<DataTimePhitT>::SendOutput(int64_t cycle,
+                                                   int64_t in_flight_count) {
+  if (state_.size() > in_flight_count) {
+    to_.flit = state_.front().flit;
+    to_.cycle = cycle;
+    to_.metadata = state_.front().metadata;
+    state_.pop();
+  } else {
+    to_.flit.type = FlitType::kInvalid;
+    to_.flit.data = Bits(32);
+    to_.cycle = cycle;
   }
 
-  return false;
+  XLS_VLOG(2) << absl::StreamFormat(
+      "... link sending data %s type %d connection", to_.flit.data.ToString(),
+      to_.flit.type);
 }
 
 }  // namespace
 
+// Runs a function for each partition index, on count - 1 threads that
+// persist across cycles along with the calling thread.
+class NocSimulator::WorkerPool {
+ public:
+  explicit WorkerPool(int64_t count) {
+    for (int64_t i = 1; i < count; ++i) {
+      threads_.push_back(std::make_unique<Thread>([this, i]() { Work(i); }));
+    }
+  }
+
+  ~WorkerPool() {
+    {
+      absl::MutexLock lock(&mutex_);
+      shutdown_ = true;
+    }
+    for (std::unique_ptr<Thread>& thread : threads_) {
+      thread->Join();
+    }
+  }
+
+  // Calls fn(i) for every index and returns once all calls have completed.
+  void Run(const std::function<void(int64_t)>& fn) {
+    {
+      absl::MutexLock lock(&mutex_);
+      fn_ = &fn;
+      pending_ = threads_.size();
+      ++generation_;
+    }
+    fn(0);
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        +[](int64_t* pending) { return *pending == 0; }, &pending_));
+  }
+
+ private:
+  void Work(int64_t index) {
+    int64_t generation = 0;
+    while (true) {
+      const std::function<void(int64_t)>* fn;
+      {
+        absl::MutexLock lock(&mutex_);
+        auto ready = [&]() { return shutdown_ || generation_ != generation; };
+        mutex_.Await(absl::Condition(&ready));
+        if (shutdown_) {
+          return;
+        }
+        generation = generation_;
+        fn = fn_;
+      }
+      (*fn)(index);
+      absl::MutexLock lock(&mutex_);
+      --pending_;
+    }
+  }
+
+  absl::Mutex mutex_;
+  const std::function<void(int64_t)>* fn_ ABSL_GUARDED_BY(mutex_) = nullptr;
+  int64_t generation_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t pending_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<std::unique_ptr<Thread>> threads_;
+};
+
+NocSimulator::NocSimulator()
+    : mgr_(nullptr),
+      params_(nullptr),
+      routing_(nullptr),
+      cycle_(-1),
+      full_sweep_mode_(false),
+      worker_thread_count_(1),
+      received_traffic_capacity_(-1),
+      component_tick_count_(0) {}
+
+NocSimulator::~NocSimulator() = default;
+
 absl::Status NocSimulator::CreateSimulationObjects(NetworkId network) {
   Network& network_obj = mgr_->GetNetwork(network);
 
@@ -108,6 +225,209 @@ absl::Status NocSimulator::CreateSimulationObjects(NetworkId network) {
     XLS_RETURN_IF_ERROR(CreateNetworkComponent(id));
   }
 
+  return BuildComponentGraph();
+}
+
+absl::Status NocSimulator::BuildComponentGraph() {
+  components_.clear();
+  for (SimNetworkInterfaceSrc& nc : network_interface_sources_) {
+    components_.push_back(&nc);
+  }
+  for (SimLink& nc : links_) {
+    components_.push_back(&nc);
+  }
+  for (SimInputBufferedVCRouter& nc : routers_) {
+    components_.push_back(&nc);
+  }
+  for (SimNetworkInterfaceSink& nc : network_interface_sinks_) {
+    components_.push_back(&nc);
+  }
+  int64_t component_count = components_.size();
+
+  // Links with registered outputs are advanced separately, which also
+  // breaks the cycles of topologies such as meshes that would otherwise
+  // never converge.
+  std::vector<bool> registered(component_count, false);
+  if (!full_sweep_mode_) {
+    for (int64_t i = 0; i < links_.size(); ++i) {
+      registered[network_interface_sources_.size() + i] =
+          links_[i].HasRegisteredOutputs();
+    }
+  }
+
+  // Components attached to the src and sink of each connection, and the
+  // connections attached to the inputs and outputs of each component.
+  std::vector<int64_t> connection_src(connections_.size(), -1);
+  std::vector<int64_t> connection_sink(connections_.size(), -1);
+  std::vector<std::vector<int64_t>> inputs(component_count);
+  std::vector<std::vector<int64_t>> outputs(component_count);
+  for (int64_t i = 0; i < component_count; ++i) {
+    NetworkComponent& network_component =
+        mgr_->GetNetworkComponent(components_[i]->GetId());
+    for (const Port& port : network_component.GetPorts()) {
+      auto iter = connection_index_map_.find(port.connection());
+      if (iter == connection_index_map_.end()) {
+        continue;
+      }
+      if (port.direction() == PortDirection::kOutput) {
+        connection_src[iter->second] = i;
+        outputs[i].push_back(iter->second);
+      } else {
+        connection_sink[iter->second] = i;
+        inputs[i].push_back(iter->second);
+      }
+    }
+  }
+
+  std::vector<std::vector<int64_t>> neighbors(component_count);
+  for (int64_t c = 0; c < connections_.size(); ++c) {
+    int64_t src = connection_src[c];
+    int64_t sink = connection_sink[c];
+    if (src >= 0 && sink >= 0 && !registered[src] && !registered[sink]) {
+      neighbors[src].push_back(sink);
+      neighbors[sink].push_back(src);
+    }
+  }
+
+  // Find the regions of components connected other than through registered
+  // links, weighted by their number of connections.
+  std::vector<int64_t> region(component_count, -1);
+  std::vector<int64_t> region_weight;
+  for (int64_t i = 0; i < component_count; ++i) {
+    if (registered[i] || region[i] >= 0) {
+      continue;
+    }
+    int64_t r = region_weight.size();
+    region_weight.push_back(0);
+    std::vector<int64_t> stack = {i};
+    region[i] = r;
+    while (!stack.empty()) {
+      int64_t j = stack.back();
+      stack.pop_back();
+      region_weight[r] += 1 + neighbors[j].size();
+      for (int64_t k : neighbors[j]) {
+        if (region[k] < 0) {
+          region[k] = r;
+          stack.push_back(k);
+        }
+      }
+    }
+  }
+
+  // Assign the heaviest regions first, each to the lightest partition.
+  int64_t partition_count = std::max<int64_t>(
+      1, std::min<int64_t>(worker_thread_count_, region_weight.size()));
+  std::vector<int64_t> regions_by_weight(region_weight.size());
+  for (int64_t r = 0; r < region_weight.size(); ++r) {
+    regions_by_weight[r] = r;
+  }
+  std::stable_sort(regions_by_weight.begin(), regions_by_weight.end(),
+                   [&](int64_t a, int64_t b) {
+                     return region_weight[a] > region_weight[b];
+                   });
+  std::vector<int64_t> region_partition(region_weight.size());
+  std::vector<int64_t> partition_weight(partition_count, 0);
+  for (int64_t r : regions_by_weight) {
+    int64_t p = std::min_element(partition_weight.begin(),
+                                 partition_weight.end()) -
+                partition_weight.begin();
+    region_partition[r] = p;
+    partition_weight[p] += region_weight[r];
+  }
+
+  partitions_.assign(partition_count, Partition());
+  std::vector<int64_t> local_index(component_count, -1);
+  int64_t registered_count = 0;
+  for (int64_t i = 0; i < component_count; ++i) {
+    if (registered[i]) {
+      Partition& partition = partitions_[registered_count % partition_count];
+      partition.registered_links.push_back(
+          static_cast<SimLink*>(components_[i]));
+      ++registered_count;
+      continue;
+    }
+    Partition& partition = partitions_[region_partition[region[i]]];
+    local_index[i] = partition.components.size();
+    partition.components.push_back(i);
+  }
+
+  connection_src_.assign(connections_.size(), -1);
+  connection_sink_.assign(connections_.size(), -1);
+  for (int64_t c = 0; c < connections_.size(); ++c) {
+    if (connection_src[c] >= 0) {
+      connection_src_[c] = local_index[connection_src[c]];
+    }
+    if (connection_sink[c] >= 0) {
+      connection_sink_[c] = local_index[connection_sink[c]];
+    }
+  }
+
+  int64_t first_link = network_interface_sources_.size();
+  int64_t last_link = first_link + links_.size();
+  for (Partition& partition : partitions_) {
+    for (int64_t i : partition.components) {
+      std::vector<int64_t>& local_neighbors =
+          partition.neighbors.emplace_back();
+      for (int64_t j : neighbors[i]) {
+        local_neighbors.push_back(local_index[j]);
+      }
+      partition.inputs.push_back(inputs[i]);
+      partition.outputs.push_back(outputs[i]);
+
+      // Credits returned by a component pass through links within the same
+      // cycle.
+      std::vector<int64_t>& upstream = partition.upstream.emplace_back();
+      std::vector<int64_t> stack = inputs[i];
+      while (!stack.empty()) {
+        int64_t src = connection_src[stack.back()];
+        stack.pop_back();
+        if (src < 0 || registered[src]) {
+          continue;
+        }
+        upstream.push_back(local_index[src]);
+        if (src >= first_link && src < last_link) {
+          stack.insert(stack.end(), inputs[src].begin(), inputs[src].end());
+        }
+      }
+
+      if (i < first_link) {
+        partition.sources.push_back(local_index[i]);
+      }
+    }
+    int64_t partition_component_count = partition.components.size();
+    partition.converged_cycle.assign(partition_component_count, -1);
+    partition.live_cycle.assign(partition_component_count, -1);
+    partition.flit_cycle.assign(partition_component_count, -1);
+  }
+
+  // Record the components on either side of links with registered outputs,
+  // in the partitions of those components.
+  for (int64_t i = first_link; i < last_link; ++i) {
+    if (!registered[i]) {
+      continue;
+    }
+    for (int64_t c : inputs[i]) {
+      int64_t src = connection_src[c];
+      if (src >= 0 && !registered[src]) {
+        partitions_[region_partition[region[src]]]
+            .registered_link_inputs.push_back({c, local_index[src]});
+      }
+    }
+    for (int64_t c : outputs[i]) {
+      int64_t sink = connection_sink[c];
+      if (sink >= 0 && !registered[sink]) {
+        partitions_[region_partition[region[sink]]]
+            .registered_link_outputs.push_back({c, local_index[sink]});
+      }
+    }
+  }
+
+  if (partition_count > 1) {
+    worker_pool_ = std::make_unique<WorkerPool>(partition_count);
+  } else {
+    worker_pool_.reset();
+  }
+
   return absl::OkStatus();
 }
 
@@ -228,38 +548,166 @@ absl::Status NocSimulator::RunCycle(int64_t max_ticks) {
     XLS_RET_CHECK_OK(svc->RunCycle());
   }
 
+  XLS_ASSIGN_OR_RETURN(int64_t nticks, full_sweep_mode_
+                                           ? RunFullSweeps(max_ticks)
+                                           : RunPartitions(max_ticks));
+  XLS_VLOG(2) << absl::StreamFormat("Cycle %d converged after %d ticks",
+                                    cycle_, nticks);
+
+  if (XLS_VLOG_IS_ON(2)) {
+    for (int64_t i = 0; i < connections_.size(); ++i) {
+      XLS_VLOG(2) << absl::StreamFormat("  Connection %d (%x)", i,
+                                        connections_[i].id.AsUInt64());
+
+      XLS_VLOG(2) << absl::StreamFormat("    FWD %s",
+                                        connections_[i].forward_channels);
+
+      for (int64_t vc = 0; vc < connections_[i].reverse_channels.size();
+           ++vc) {
+        XLS_VLOG(2) << absl::StreamFormat(
+            "    REV %d %s", vc, connections_[i].reverse_channels[vc]);
+      }
+    }
+  }
+
+  for (NocSimulatorServiceShim* svc : post_cycle_services_) {
+    XLS_RET_CHECK_OK(svc->RunCycle());
+  }
+
+  return absl::OkStatus();
+}
+
+absl::StatusOr<int64_t> NocSimulator::RunFullSweeps(int64_t max_ticks) {
   bool converged = false;
   int64_t nticks = 0;
   while (!converged) {
+    if (nticks >= max_ticks) {
+      return absl::InternalError(absl::StrFormat(
+          "Simulator unable to converge after %d ticks for cycle %d", nticks,
+          cycle_));
+    }
     XLS_VLOG(2) << absl::StreamFormat("Tick %d", nticks);
     converged = Tick();
     ++nticks;
   }
+  return nticks;
+}
 
-  for (int64_t i = 0; i < connections_.size(); ++i) {
-    XLS_VLOG(2) << absl::StreamFormat("  Connection %d (%x)", i,
-                                      connections_[i].id.AsUInt64());
-
-    XLS_VLOG(2) << absl::StreamFormat("    FWD %s",
-                                      connections_[i].forward_channels);
+absl::StatusOr<int64_t> NocSimulator::RunPartitions(int64_t max_ticks) {
+  if (partitions_.size() == 1) {
+    for (SimLink* link : partitions_[0].registered_links) {
+      link->AdvanceRegisteredStages(*this);
+    }
+    XLS_ASSIGN_OR_RETURN(int64_t nticks,
+                         RunWorklist(partitions_[0], max_ticks));
+    component_tick_count_ +=
+        partitions_[0].tick_count + partitions_[0].registered_links.size();
+    return nticks;
+  }
 
-    for (int64_t vc = 0; vc < connections_[i].reverse_channels.size(); ++vc) {
-      XLS_VLOG(2) << absl::StreamFormat("    REV %d %s", vc,
-                                        connections_[i].reverse_channels[vc]);
+  // Registered links must drive their outputs before any partition reads
+  // them, and can only latch their inputs once every partition is done with
+  // the previous cycle.
+  worker_pool_->Run([this](int64_t p) {
+    for (SimLink* link : partitions_[p].registered_links) {
+      link->AdvanceRegisteredStages(*this);
     }
+  });
+
+  std::vector<absl::StatusOr<int64_t>> results(partitions_.size());
+  worker_pool_->Run([&](int64_t p) {
+    results[p] = RunWorklist(partitions_[p], max_ticks);
+  });
 
+  int64_t nticks = 0;
+  for (int64_t p = 0; p < partitions_.size(); ++p) {
+    XLS_ASSIGN_OR_RETURN(int64_t partition_nticks, results[p]);
+    nticks = std::max(nticks, partition_nticks);
+    component_tick_count_ += partitions_[p].tick_count +
+                             partitions_[p].registered_links.size();
+  }
+  return nticks;
+}
+
+absl::StatusOr<int64_t> NocSimulator::RunWorklist(Partition& partition,
+                                                  int64_t max_ticks) {
+  // A component that has not converged can only make progress once a
+  // component it is connected to has completed forward or reverse
+  // propagation, so after the first tick only those are ticked again.
+  // Both neighbors are woken regardless of the direction that completed, as
+  // some components (e.g. sinks returning credits) update their input
+  // connections during forward propagation.
+  //
+  // Scheduled components are kept as bitsets indexed like
+  // partition.components and visited in increasing order, as a full sweep
+  // would: a component woken by one earlier in the order runs in the same
+  // tick, otherwise it runs in the next one.
+  int64_t component_count = partition.components.size();
+  int64_t word_count = (component_count + 63) / 64;
+  std::vector<uint64_t>& scheduled = partition.scheduled;
+  std::vector<uint64_t>& next_scheduled = partition.next_scheduled;
+  scheduled.assign(word_count, 0);
+  next_scheduled.assign(word_count, 0);
+  for (int64_t i = 0; i < component_count; ++i) {
+    scheduled[i / 64] |= uint64_t{1} << (i % 64);
+  }
+
+  std::vector<int64_t>& converged_cycle = partition.converged_cycle;
+  int64_t unconverged_count = component_count;
+  int64_t nticks = 0;
+  partition.tick_count = 0;
+  while (unconverged_count > 0) {
     if (nticks >= max_ticks) {
       return absl::InternalError(absl::StrFormat(
           "Simulator unable to converge after %d ticks for cycle %d", nticks,
           cycle_));
     }
-  }
+    XLS_VLOG(2) << absl::StreamFormat("Tick %d", nticks);
 
-  for (NocSimulatorServiceShim* svc : post_cycle_services_) {
-    XLS_RET_CHECK_OK(svc->RunCycle());
+    bool any_scheduled = false;
+    for (int64_t word = 0; word < word_count; ++word) {
+      while (scheduled[word] != 0) {
+        int64_t bit = absl::countr_zero(scheduled[word]);
+        scheduled[word] &= scheduled[word] - 1;
+        any_scheduled = true;
+
+        int64_t i = word * 64 + bit;
+        SimNetworkComponentBase& nc = *components_[partition.components[i]];
+        bool forward_before = nc.HasForwardPropagated(cycle_);
+        bool reverse_before = nc.HasReversePropagated(cycle_);
+        bool converged = nc.Tick(*this);
+        ++partition.tick_count;
+        XLS_VLOG(2) << absl::StreamFormat(" NC %x Converged %d",
+                                          nc.GetId().AsUInt64(), converged);
+
+        if (converged && converged_cycle[i] != cycle_) {
+          converged_cycle[i] = cycle_;
+          --unconverged_count;
+        }
+        if ((!forward_before && nc.HasForwardPropagated(cycle_)) ||
+            (!reverse_before && nc.HasReversePropagated(cycle_))) {
+          for (int64_t j : partition.neighbors[i]) {
+            if (converged_cycle[j] != cycle_) {
+              std::vector<uint64_t>& target =
+                  j > i ? scheduled : next_scheduled;
+              target[j / 64] |= uint64_t{1} << (j % 64);
+            }
+          }
+        }
+      }
+    }
+    ++nticks;
+
+    if (!any_scheduled) {
+      return absl::InternalError(absl::StrFormat(
+          "Simulator unable to converge for cycle %d, %d components "
+          "stalled after %d ticks",
+          cycle_, unconverged_count, nticks));
+    }
+    std::swap(scheduled, next_scheduled);
   }
 
-  return absl::OkStatus();
+  return nticks;
 }
 
 bool NocSimulator::Tick() {
@@ -268,33 +716,10 @@ bool NocSimulator::Tick() {
 
   bool converged = true;
 
-  for (SimNetworkInterfaceSrc& nc : network_interface_sources_) {
-    NetworkComponentId id = nc.GetId();
-    bool this_converged = nc.Tick(*this);
-    converged &= this_converged;
-    XLS_VLOG(2) << absl::StreamFormat(" NC %x Converged %d", id.AsUInt64(),
-                                      this_converged);
-  }
-
-  for (SimLink& nc : links_) {
-    NetworkComponentId id = nc.GetId();
-    bool this_converged = nc.Tick(*this);
-    converged &= this_converged;
-    XLS_VLOG(2) << absl::StreamFormat(" NC %x Converged %d", id.AsUInt64(),
-                                      this_converged);
-  }
-
-  for (SimInputBufferedVCRouter& nc : routers_) {
-    NetworkComponentId id = nc.GetId();
-    bool this_converged = nc.Tick(*this);
-    converged &= this_converged;
-    XLS_VLOG(2) << absl::StreamFormat(" NC %x Converged %d", id.AsUInt64(),
-                                      this_converged);
-  }
-
-  for (SimNetworkInterfaceSink& nc : network_interface_sinks_) {
-    NetworkComponentId id = nc.GetId();
-    bool this_converged = nc.Tick(*this);
+  for (SimNetworkComponentBase* nc : components_) {
+    NetworkComponentId id = nc->GetId();
+    bool this_converged = nc->Tick(*this);
+    ++component_tick_count_;
     converged &= this_converged;
     XLS_VLOG(2) << absl::StreamFormat(" NC %x Converged %d", id.AsUInt64(),
                                       this_converged);
@@ -358,7 +783,12 @@ absl::Status SimLink::InitializeImpl(NocSimulator& simulator) {
   // Create a reverse pipeline stage for each vc.
   SimConnectionState& sink =
       simulator.GetSimConnectionByIndex(sink_connection_index_);
-  reverse_credit_stages_.resize(sink.reverse_channels.size());
+  forward_data_stages_ = RingBufferArray<TimedDataFlit>(
+      std::vector<int64_t>{forward_pipeline_stages_ + 1});
+  reverse_credit_stages_ = RingBufferArray<TimedMetadataFlit>(
+      std::vector<int64_t>(sink.reverse_channels.size(),
+                           reverse_pipeline_stages_ + 1));
+  pending_input_cycle_ = -1;
 
   return absl::OkStatus();
 }
@@ -411,11 +841,11 @@ absl::Status SimNetworkInterfaceSink::InitializeImpl(NocSimulator& simulator) {
   std::vector<VirtualChannelParam> vc_params = port_param.GetVirtualChannels();
   int64_t virtual_channel_count = port_param.VirtualChannelCount();
 
-  input_buffers_.resize(virtual_channel_count);
-
+  std::vector<int64_t> depths(virtual_channel_count);
   for (int64_t vc = 0; vc < virtual_channel_count; ++vc) {
-    input_buffers_[vc].max_queue_size = vc_params[vc].GetDepth();
+    depths[vc] = vc_params[vc].GetDepth();
   }
+  input_buffers_ = RingBufferArray<DataFlitQueueElement>(depths);
 
   NetworkManager* network_manager = simulator.GetNetworkManager();
   PortId src_port =
@@ -424,6 +854,9 @@ absl::Status SimNetworkInterfaceSink::InitializeImpl(NocSimulator& simulator) {
 
   src_connection_index_ = simulator.GetConnectionIndex(src_connection);
 
+  statistics_ = SinkTrafficStatistics(virtual_channel_count);
+  received_traffic_capacity_ = simulator.GetReceivedTrafficCapacity();
+
   return absl::OkStatus();
 }
 
@@ -445,7 +878,8 @@ absl::Status SimInputBufferedVCRouter::InitializeImpl(NocSimulator& simulator) {
   absl::Span<int64_t> input_indices = simulator.GetConnectionIndicesStore(
       input_connection_index_start_, input_connection_count_);
 
-  input_buffers_.resize(input_connection_count_);
+  std::vector<int64_t> depths;
+  input_buffer_index_.resize(input_connection_count_ + 1);
   input_credit_to_send_.resize(input_connection_count_);
   max_vc_ = 0;
   for (int64_t i = 0; i < input_connection_count_; ++i) {
@@ -460,15 +894,17 @@ absl::Status SimInputBufferedVCRouter::InitializeImpl(NocSimulator& simulator) {
     std::vector<VirtualChannelParam> vc_params =
         port_param.GetVirtualChannels();
 
-    input_buffers_[i].resize(port_param.VirtualChannelCount());
+    input_buffer_index_[i] = depths.size();
     for (int64_t vc = 0; vc < port_param.VirtualChannelCount(); ++vc) {
-      input_buffers_[i][vc].max_queue_size = vc_params[vc].GetDepth();
+      depths.push_back(vc_params[vc].GetDepth());
     }
     input_credit_to_send_[i].resize(port_param.VirtualChannelCount());
     if (max_vc_ < port_param.VirtualChannelCount()) {
       max_vc_ = port_param.VirtualChannelCount();
     }
   }
+  input_buffer_index_[input_connection_count_] = depths.size();
+  input_buffers_ = RingBufferArray<DataFlitQueueElement>(depths);
 
   // Setup structures associated with the outputs.
   //  - output to SimConnectionState (output_connection_index_start_ and count_)
@@ -494,6 +930,31 @@ absl::Status SimInputBufferedVCRouter::InitializeImpl(NocSimulator& simulator) {
                              CreditState{simulator.GetCurrentCycle(), 0});
   }
 
+  // Setup the routes of each input buffer.
+  DistributedRoutingTable* routing = simulator.GetRoutingTable();
+  sink_count_ = routing->GetSinkIndices().NetworkComponentCount();
+  route_index_.clear();
+  route_candidates_.clear();
+  for (int64_t i = 0; i < input_connection_count_; ++i) {
+    XLS_ASSIGN_OR_RETURN(
+        PortId port_id,
+        port_indexer.GetPortByIndex(nc.id(), PortDirection::kInput, i));
+    int64_t vc_count = input_buffer_index_[i + 1] - input_buffer_index_[i];
+    for (int64_t vc = 0; vc < vc_count; ++vc) {
+      for (int64_t d = 0; d < sink_count_; ++d) {
+        route_index_.push_back(route_candidates_.size());
+        for (PortAndVCIndex route : routing->GetRouterOutputPortsByIndex(
+                 PortAndVCIndex{port_id, vc}, d)) {
+          XLS_ASSIGN_OR_RETURN(int64_t output_port_index,
+                               port_indexer.GetPortIndex(
+                                   route.port_id_, PortDirection::kOutput));
+          route_candidates_.push_back({output_port_index, route.vc_index_});
+        }
+      }
+    }
+  }
+  route_index_.push_back(route_candidates_.size());
+
   internal_propagated_cycle_ = simulator.GetCurrentCycle();
   utilization_cycle_count_ = 0;
 
@@ -508,7 +969,7 @@ bool SimLink::TryForwardPropagation(NocSimulator& simulator) {
 
   bool did_propagate = SimplePipelineImpl<TimedDataFlit>(
                            forward_pipeline_stages_, src.forward_channels,
-                           sink.forward_channels, forward_data_stages_)
+                           sink.forward_channels, forward_data_stages_[0])
                            .TryPropagation(simulator);
 
   if (did_propagate) {
@@ -532,7 +993,7 @@ bool SimLink::TryReversePropagation(NocSimulator& simulator) {
   for (int64_t vc = 0; vc < vc_count; ++vc) {
     if (SimplePipelineImpl<TimedMetadataFlit>(
             reverse_pipeline_stages_, sink.reverse_channels.at(vc),
-            src.reverse_channels.at(vc), reverse_credit_stages_.at(vc))
+            src.reverse_channels.at(vc), reverse_credit_stages_[vc])
             .TryPropagation(simulator)) {
       ++num_propagated;
       XLS_VLOG(2) << absl::StreamFormat(
@@ -549,6 +1010,37 @@ bool SimLink::TryReversePropagation(NocSimulator& simulator) {
   }
 }
 
+void SimLink::AdvanceRegisteredStages(NocSimulator& simulator) {
+  SimConnectionState& src =
+      simulator.GetSimConnectionByIndex(src_connection_index_);
+  SimConnectionState& sink =
+      simulator.GetSimConnectionByIndex(sink_connection_index_);
+  int64_t vc_count = sink.reverse_channels.size();
+
+  SimplePipelineImpl<TimedDataFlit> forward(
+      forward_pipeline_stages_, src.forward_channels, sink.forward_channels,
+      forward_data_stages_[0]);
+  if (pending_input_cycle_ >= 0) {
+    forward.LatchInput(pending_input_cycle_);
+  }
+  forward.DriveOutput(simulator);
+
+  for (int64_t vc = 0; vc < vc_count; ++vc) {
+    SimplePipelineImpl<TimedMetadataFlit> reverse(
+        reverse_pipeline_stages_, sink.reverse_channels.at(vc),
+        src.reverse_channels.at(vc), reverse_credit_stages_[vc]);
+    if (pending_input_cycle_ >= 0) {
+      reverse.LatchInput(pending_input_cycle_);
+    }
+    reverse.DriveOutput(simulator);
+  }
+
+  int64_t current_cycle = simulator.GetCurrentCycle();
+  forward_propagated_cycle_ = current_cycle;
+  reverse_propagated_cycle_ = current_cycle;
+  pending_input_cycle_ = current_cycle;
+}
+
 bool SimNetworkInterfaceSrc::TryForwardPropagation(NocSimulator& simulator) {
   int64_t current_cycle = simulator.GetCurrentCycle();
   SimConnectionState& sink =
@@ -656,29 +1148,6 @@ bool SimNetworkInterfaceSrc::TryReversePropagation(NocSimulator& simulator) {
   }
 }
 
-absl::StatusOr<SimInputBufferedVCRouter::PortIndexAndVCIndex>
-SimInputBufferedVCRouter::GetDestinationPortIndexAndVcIndex(
-    NocSimulator& simulator, PortIndexAndVCIndex input,
-    int64_t destination_index) {
-  DistributedRoutingTable* routes = simulator.GetRoutingTable();
-
-  XLS_ASSIGN_OR_RETURN(PortId input_port,
-                       routes->GetPortIndices().GetPortByIndex(
-                           GetId(), PortDirection::kInput, input.port_index));
-
-  PortAndVCIndex port_from{input_port, input.vc_index};
-
-  XLS_ASSIGN_OR_RETURN(
-      PortAndVCIndex port_to,
-      routes->GetRouterOutputPortByIndex(port_from, destination_index));
-
-  XLS_ASSIGN_OR_RETURN(int64_t output_port_index,
-                       routes->GetPortIndices().GetPortIndex(
-                           port_to.port_id_, PortDirection::kOutput));
-
-  return PortIndexAndVCIndex{output_port_index, port_to.vc_index_};
-}
-
 bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
   // TODO(tedhong): 2020-02-16 Factor out with strategy pattern.
 
@@ -745,7 +1214,7 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
 
     if (input.forward_channels.flit.type != FlitType::kInvalid) {
       int64_t vc = input.forward_channels.flit.vc;
-      input_buffers_[i][vc].queue.push(
+      GetInputBuffer(i, vc).push(
           {input.forward_channels.flit, input.forward_channels.metadata});
 
       XLS_VLOG(2) << absl::StrFormat(
@@ -758,44 +1227,60 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
   // Use fixed priority to route to output ports.
   // Priority goes to the port with the least vc and the least port index.
   for (int64_t vc = 0; vc < max_vc_; ++vc) {
-    for (int64_t i = 0; i < input_buffers_.size(); ++i) {
-      if (vc >= input_buffers_[i].size()) {
+    for (int64_t i = 0; i < input_connection_count_; ++i) {
+      if (vc >= input_buffer_index_[i + 1] - input_buffer_index_[i]) {
         continue;
       }
 
       // See if we have a flit to route and can route it.
-      if (input_buffers_[i][vc].queue.empty()) {
+      RingBufferArray<DataFlitQueueElement>::Queue input_buffer =
+          GetInputBuffer(i, vc);
+      if (input_buffer.empty()) {
         continue;
       }
 
-      DataFlit flit = input_buffers_[i][vc].queue.front().flit;
-      TimedDataFlitInfo metadata = input_buffers_[i][vc].queue.front().metadata;
+      DataFlit flit = input_buffer.front().flit;
+      TimedDataFlitInfo metadata = input_buffer.front().metadata;
       int64_t destination_index = flit.destination_index;
 
-      PortIndexAndVCIndex input{i, vc};
-      absl::StatusOr<PortIndexAndVCIndex> output_status =
-          GetDestinationPortIndexAndVcIndex(simulator, input,
-                                            destination_index);
-      XLS_CHECK_OK(output_status.status());
-      PortIndexAndVCIndex output = output_status.value();
+      absl::Span<const PortIndexAndVCIndex> routes =
+          GetRoutes(input_buffer_index_[i] + vc, destination_index);
+      XLS_CHECK(!routes.empty()) << absl::StreamFormat(
+          "No route from router %x port index %d vc %d to destination %d",
+          GetId().AsUInt64(), i, vc, destination_index);
+
+      // Of the routes whose output port is still free this cycle, pick the
+      // one with the most credits (ie the least congested), preferring
+      // earlier routes on ties.
+      const PortIndexAndVCIndex* selected = nullptr;
+      for (const PortIndexAndVCIndex& route : routes) {
+        int64_t credit = credit_[route.port_index][route.vc_index];
+        if (credit <= 0 ||
+            (selected != nullptr &&
+             credit <= credit_[selected->port_index][selected->vc_index])) {
+          continue;
+        }
+
+        // Check that no other port has already used the output port
+        // (since this is a router without output buffers.
+        if (simulator
+                .GetSimConnectionByIndex(
+                    output_connection_index[route.port_index])
+                .forward_channels.cycle == current_cycle) {
+          continue;
+        }
+        selected = &route;
+      }
 
-      // Now see if we have sufficient credits.
-      if (credit_.at(output.port_index).at(output.vc_index) <= 0) {
+      if (selected == nullptr) {
         XLS_VLOG(2) << absl::StreamFormat(
-            "... router unable to send data %s vc %d credit now %d"
-            " from port index %d to port index %d.",
-            flit, flit.vc, credit_.at(output.port_index).at(output.vc_index), i,
-            output.port_index);
+            "... router unable to send data %s vc %d from port index %d.", flit,
+            flit.vc, i);
         continue;
       }
-
-      // Check that no other port has already used the output port
-      // (since this is a router without output buffers.
+      PortIndexAndVCIndex output = *selected;
       SimConnectionState& output_state = simulator.GetSimConnectionByIndex(
           output_connection_index.at(output.port_index));
-      if (output_state.forward_channels.cycle == current_cycle) {
-        continue;
-      }
 
       // Now send the flit along.
       output_state.forward_channels.flit = flit;
@@ -808,7 +1293,7 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
 
       // Update credit to send back to input.
       ++input_credit_to_send_[i][vc];
-      input_buffers_[i][vc].queue.pop();
+      input_buffer.pop();
 
       flit_sent = true;
 
@@ -866,7 +1351,7 @@ bool SimInputBufferedVCRouter::TryReversePropagation(NocSimulator& simulator) {
       // Upon reset (cycle-0) a full update of credits is sent.
       if (current_cycle == 0) {
         input.reverse_channels[vc].flit.data =
-            UBits(input_buffers_[i][vc].max_queue_size, 32);
+            UBits(GetInputBuffer(i, vc).capacity(), 32);
       } else {
         input.reverse_channels[vc].flit.data =
             UBits(input_credit_to_send_[i][vc], 32);
@@ -951,12 +1436,22 @@ bool SimNetworkInterfaceSink::TryForwardPropagation(NocSimulator& simulator) {
 
     // TODO(tedhong): 2021-01-31 Support blocking traffic at sink.
     // without blocking, the queue never gets empty so we don't
-    // emplace into input_buffers_[vc].queue.
+    // push into input_buffers_[vc].
     TimedDataFlit received_flit;
     received_flit.cycle = current_cycle;
     received_flit.flit = src.forward_channels.flit;
     received_flit.metadata = src.forward_channels.metadata;
-    received_traffic_.push_back(received_flit);
+    statistics_.Record(received_flit);
+
+    if (received_traffic_capacity_ != 0) {
+      if (received_traffic_capacity_ > 0 &&
+          received_traffic_.size() == 2 * received_traffic_capacity_) {
+        received_traffic_.erase(
+            received_traffic_.begin(),
+            received_traffic_.begin() + received_traffic_capacity_);
+      }
+      received_traffic_.push_back(received_flit);
+    }
 
     // Send one credit back
     src.reverse_channels[vc].cycle = current_cycle;
@@ -976,11 +1471,11 @@ bool SimNetworkInterfaceSink::TryForwardPropagation(NocSimulator& simulator) {
       src.reverse_channels[vc].cycle = current_cycle;
       src.reverse_channels[vc].flit.type = FlitType::kTail;
       src.reverse_channels[vc].flit.data =
-          UBits(input_buffers_[vc].max_queue_size, 32);
+          UBits(input_buffers_[vc].capacity(), 32);
 
       XLS_VLOG(2) << absl::StreamFormat(
           "... sink %x sending %d credit vc %d on %x", GetId().AsUInt64(),
-          input_buffers_[vc].max_queue_size, vc, src.id.AsUInt64());
+          input_buffers_[vc].capacity(), vc, src.id.AsUInt64());
     }
   } else {
     for (int64_t vc = 0; vc < src.reverse_channels.size(); ++vc) {
@@ -15,16 +15,21 @@
 #ifndef XLS_NOC_SIMULATION_SIM_OBJECTS_H_
 #define XLS_NOC_SIMULATION_SIM_OBJECTS_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <queue>
 #include <vector>
 
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/noc/simulation/common.h"
 #include "xls/noc/simulation/flit.h"
 #include "xls/noc/simulation/global_routing_table.h"
 #include "xls/noc/simulation/parameters.h"
+#include "xls/noc/simulation/ring_buffer.h"
 #include "xls/noc/simulation/simulator_shims.h"
+#include "xls/noc/simulation/traffic_statistics.h"
 
 // This file contains classes used to store, access, and define simulation
 // objects.  Each network object (defined network_graph.h) is associated
@@ -48,23 +53,12 @@ struct CreditState {
   int64_t credit;
 };
 
+// Element of the fifos/buffers used to store phits.
 struct DataFlitQueueElement {
   DataFlit flit;
   TimedDataFlitInfo metadata;
 };
 
-// Represents a fifo/buffer used to store phits.
-struct DataFlitQueue {
-  std::queue<DataFlitQueueElement> queue;
-  int64_t max_queue_size;
-};
-
-// Represents a fifo/buffer used to store metadata phits.
-struct MetadataFlitQueue {
-  std::queue<MetadataFlit> queue;
-  int64_t max_queue_size;
-};
-
 class NocSimulator;
 
 // Common functionality and base class for all simulator objects.
@@ -84,6 +78,33 @@ class SimNetworkComponentBase {
   // Returns the associated NetworkComponentId.
   NetworkComponentId GetId() const { return id_; }
 
+  // Returns true if forward propagation has completed for the given cycle.
+  bool HasForwardPropagated(int64_t cycle) const {
+    return forward_propagated_cycle_ == cycle;
+  }
+
+  // Returns true if reverse propagation has completed for the given cycle.
+  bool HasReversePropagated(int64_t cycle) const {
+    return reverse_propagated_cycle_ == cycle;
+  }
+
+  // Returns true if the component has work to do in the given cycle even if
+  // all of its inputs are idle: flits to send or credits to apply.  The
+  // destination indices of the flits it may send are appended to
+  // destinations.
+  //
+  // A component without pending work and with idle inputs leaves its state
+  // unchanged and its outputs idle, so is not ticked by NocSimulator.
+  virtual bool HasPendingWork(int64_t cycle,
+                              std::vector<int64_t>* destinations) {
+    return false;
+  }
+
+  // Appends the indices of the connections a flit to the given destination
+  // may leave this component on.
+  virtual void AppendRoutes(int64_t destination,
+                            std::vector<int64_t>* connections) const {}
+
   virtual ~SimNetworkComponentBase() = default;
 
  protected:
@@ -150,6 +171,19 @@ class SimLink : public SimNetworkComponentBase {
     return ret;
   }
 
+  // Returns true if the link has at least one pipeline stage in each
+  // direction.  The outputs of such a link during a cycle only depend on
+  // what it received in earlier cycles, so the components on either side of
+  // it can be evaluated independently within a cycle.
+  bool HasRegisteredOutputs() const {
+    return forward_pipeline_stages_ > 0 && reverse_pipeline_stages_ > 0;
+  }
+
+  // Used instead of Tick() for a link with registered outputs: latches the
+  // inputs of the previous cycle, if any, and then drives the outputs for
+  // the current cycle.
+  void AdvanceRegisteredStages(NocSimulator& simulator);
+
  private:
   SimLink() = default;
 
@@ -158,6 +192,11 @@ class SimLink : public SimNetworkComponentBase {
   bool TryForwardPropagation(NocSimulator& simulator) override;
   bool TryReversePropagation(NocSimulator& simulator) override;
 
+  bool HasPendingWork(int64_t cycle,
+                      std::vector<int64_t>* destinations) override;
+  void AppendRoutes(int64_t destination,
+                    std::vector<int64_t>* connections) const override;
+
   int64_t forward_pipeline_stages_;
   int64_t reverse_pipeline_stages_;
 
@@ -167,9 +206,15 @@ class SimLink : public SimNetworkComponentBase {
   int64_t src_connection_index_;
   int64_t sink_connection_index_;
 
-  std::queue<TimedDataFlit> forward_data_stages_;
+  // Flits in flight through the forward pipeline, and through the reverse
+  // pipeline of each vc.  Each has room for one more flit than there are
+  // stages, to accept the input of a cycle before sending its output.
+  RingBufferArray<TimedDataFlit> forward_data_stages_;
+  RingBufferArray<TimedMetadataFlit> reverse_credit_stages_;
 
-  std::vector<std::queue<TimedMetadataFlit>> reverse_credit_stages_;
+  // Cycle whose inputs have yet to be latched by AdvanceRegisteredStages(),
+  // or -1 if none.
+  int64_t pending_input_cycle_;
 };
 
 // Source - injects traffic into the network.
@@ -192,6 +237,11 @@ class SimNetworkInterfaceSrc : public SimNetworkComponentBase {
   bool TryForwardPropagation(NocSimulator& simulator) override;
   bool TryReversePropagation(NocSimulator& simulator) override;
 
+  bool HasPendingWork(int64_t cycle,
+                      std::vector<int64_t>* destinations) override;
+  void AppendRoutes(int64_t destination,
+                    std::vector<int64_t>* connections) const override;
+
   int64_t sink_connection_index_;
   std::vector<int64_t> credit_;
   std::vector<CreditState> credit_update_;
@@ -208,12 +258,22 @@ class SimNetworkInterfaceSink : public SimNetworkComponentBase {
     return ret;
   }
 
-  // Returns all traffic received by this sink from the beginning
-  // of the simulation.
+  // Returns the traffic received by this sink from the beginning
+  // of the simulation, or only the most recent flits if the simulator
+  // limits it (see NocSimulator::SetReceivedTrafficCapacity()).
   absl::Span<const TimedDataFlit> GetReceivedTraffic() {
-    return received_traffic_;
+    absl::Span<const TimedDataFlit> traffic = received_traffic_;
+    if (received_traffic_capacity_ >= 0 &&
+        traffic.size() > received_traffic_capacity_) {
+      traffic.remove_prefix(traffic.size() - received_traffic_capacity_);
+    }
+    return traffic;
   }
 
+  // Returns statistics over all traffic received by this sink from the
+  // beginning of the simulation.
+  const SinkTrafficStatistics& GetStatistics() const { return statistics_; }
+
   // Returns the observed rate of traffic in MebiBytes Per Second from the
   // beginning of simulation to the last flit processed by this sink.
   //
@@ -221,21 +281,9 @@ class SimNetworkInterfaceSink : public SimNetworkComponentBase {
   // Negative VC is used to match any vc.
   double MeasuredTrafficRateInMiBps(int64_t cycle_time_ps, int64_t vc = -1) {
     // TODO(tedhong): 2021-07-01 Factor this logic out into common library.
-    int64_t num_bits = 0;
-    int64_t max_cycle = 0;
-    for (TimedDataFlit& f : received_traffic_) {
-      if (vc < 0) {
-        num_bits += f.flit.data_bit_count;
-      } else {
-        if (f.flit.vc == vc) {
-          num_bits += f.flit.data_bit_count;
-        }
-      }
-
-      if (max_cycle < f.cycle) {
-        max_cycle = f.cycle;
-      }
-    }
+    int64_t num_bits = vc < 0 ? statistics_.GetTotal().bit_count()
+                              : statistics_.GetVirtualChannel(vc).bit_count();
+    int64_t max_cycle = std::max<int64_t>(statistics_.last_cycle(), 0);
 
     double total_sec = static_cast<double>(max_cycle + 1) *
                        static_cast<double>(cycle_time_ps) * 1.0e-12;
@@ -251,8 +299,16 @@ class SimNetworkInterfaceSink : public SimNetworkComponentBase {
   bool TryForwardPropagation(NocSimulator& simulator) override;
 
   int64_t src_connection_index_;
-  std::vector<DataFlitQueue> input_buffers_;
+
+  // Input buffer of each vc, sized to its depth.
+  RingBufferArray<DataFlitQueueElement> input_buffers_;
+  SinkTrafficStatistics statistics_;
+
+  // Received flits, of which only the last received_traffic_capacity_
+  // are kept if it is non-negative.  Up to twice as many are stored
+  // so that older ones can be dropped in batches.
   std::vector<TimedDataFlit> received_traffic_;
+  int64_t received_traffic_capacity_;
 };
 
 // Represents an input-buffered, fixed priority, credit-based, virtual-channel
@@ -310,14 +366,22 @@ class SimInputBufferedVCRouter : public SimNetworkComponentBase {
   //  2. Registers credits received from downstream.
   bool TryReversePropagation(NocSimulator& simulator) override;
 
+  bool HasPendingWork(int64_t cycle,
+                      std::vector<int64_t>* destinations) override;
+  void AppendRoutes(int64_t destination,
+                    std::vector<int64_t>* connections) const override;
+
   // Perform the routing function of this router.
   //
-  // Returns a pair of <output_port_index, output_vc_index> -- the
-  // output port and vc a flit should go out on given the input port and vc
-  // along with the eventual flit destination.
-  absl::StatusOr<PortIndexAndVCIndex> GetDestinationPortIndexAndVcIndex(
-      NocSimulator& simulator, PortIndexAndVCIndex input,
-      int64_t destination_index);
+  // Returns the <output_port_index, output_vc_index> pairs, in order of
+  // preference, a flit in the given input buffer (see input_buffer_index_)
+  // may go out on to reach its eventual destination.
+  absl::Span<const PortIndexAndVCIndex> GetRoutes(
+      int64_t input_buffer, int64_t destination_index) const {
+    int64_t i = input_buffer * sink_count_ + destination_index;
+    return absl::MakeConstSpan(route_candidates_)
+        .subspan(route_index_[i], route_index_[i + 1] - route_index_[i]);
+  }
 
   // Index for the input connections associated with this router.
   // Each input port is associated with a single connection.
@@ -333,8 +397,33 @@ class SimInputBufferedVCRouter : public SimNetworkComponentBase {
   // updated its credit count from the updates received in the previous cycle.
   int64_t internal_propagated_cycle_;
 
-  // Stores the input buffers associated with each input port and vc.
-  std::vector<std::vector<DataFlitQueue>> input_buffers_;
+  // Returns the input buffer associated with an input port and vc.
+  RingBufferArray<DataFlitQueueElement>::Queue GetInputBuffer(int64_t port,
+                                                              int64_t vc) {
+    return input_buffers_[input_buffer_index_[port] + vc];
+  }
+
+  // Stores the input buffers associated with each input port and vc,
+  // sized to the depth of the vc.  The buffers of input port i are
+  // [input_buffer_index_[i], input_buffer_index_[i + 1]).
+  RingBufferArray<DataFlitQueueElement> input_buffers_;
+  std::vector<int64_t> input_buffer_index_;
+
+  // Stores the routes of each input buffer and destination, looked up from
+  // the routing table once at initialization.  The routes of input buffer b
+  // to destination d are route_candidates_[route_index_[b * sink_count_ + d]]
+  // up to (but not including) route_candidates_[route_index_[... + 1]].
+  int64_t sink_count_;
+  std::vector<int64_t> route_index_;
+  std::vector<PortIndexAndVCIndex> route_candidates_;
+
+  // Stores the output connections a flit to each destination may leave on,
+  // from any input buffer: those of destination d are
+  // destination_connections_[destination_connection_index_[d]] up to (but
+  // not including) destination_connections_[destination_connection_index_
+  // [d + 1]].
+  std::vector<int64_t> destination_connection_index_;
+  std::vector<int64_t> destination_connections_;
 
   // Stores the credit count associated with each output port and vc.
   // Each cycle, the router updates its credit count from credit_update_.
@@ -359,8 +448,8 @@ class SimInputBufferedVCRouter : public SimNetworkComponentBase {
 // state and objects.
 class NocSimulator {
  public:
-  NocSimulator()
-      : mgr_(nullptr), params_(nullptr), routing_(nullptr), cycle_(-1) {}
+  NocSimulator();
+  ~NocSimulator();
 
   // Creates all simulation objects for a given network.
   // NetworkManager, NocParameters, and DistributedRoutingTable should
@@ -435,11 +524,62 @@ class NocSimulator {
   void Dump();
 
   // Run a single cycle of the simulator.
+  //
+  // Unless full sweep mode is enabled, a cycle is evaluated from a worklist:
+  // every component is ticked once, after which a component is only ticked
+  // again once a component it is connected to has completed forward or
+  // reverse propagation.  Components are still visited in the same order as
+  // Tick(), so results are identical to repeated full sweeps.
+  //
+  // Returns an error if the cycle has not converged after max_ticks passes
+  // over the worklist or if no component can make progress.
   absl::Status RunCycle(int64_t max_ticks = 9999);
 
-  // Runs a single tick of the simulator.
+  // Runs a single tick of the simulator, ticking every component once.
+  // Returns true if all components have converged for the current cycle.
   bool Tick();
 
+  // If enabled, RunCycle() calls Tick() until convergence instead of only
+  // re-evaluating components whose connections changed.  Used as a reference
+  // for testing and benchmarking.
+  //
+  // Full sweeps do not advance links with registered outputs separately so
+  // can only simulate networks without cycles (eg trees, not meshes).
+  void SetFullSweepMode(bool enabled) { full_sweep_mode_ = enabled; }
+
+  // Sets the number of threads, including the calling one, used to run each
+  // cycle.
+  //
+  // Links with registered outputs (see SimLink::HasRegisteredOutputs())
+  // split the network into regions which are distributed across partitions,
+  // one per thread.  Within a cycle each partition runs its own worklist,
+  // after the registered links have driven their outputs, so results are
+  // identical to those of a single thread.
+  //
+  // Must be called before Initialize().  Ignored in full sweep mode.
+  void SetWorkerThreadCount(int64_t count) { worker_thread_count_ = count; }
+
+  // Limits the number of flits each sink keeps to be returned by
+  // SimNetworkInterfaceSink::GetReceivedTraffic() to the most recent
+  // capacity, so long simulations run in constant memory.  Statistics
+  // (SimNetworkInterfaceSink::GetStatistics()) cover all flits regardless.
+  //
+  // A negative capacity, the default, keeps all flits.
+  // Must be called before Initialize().
+  void SetReceivedTrafficCapacity(int64_t capacity) {
+    received_traffic_capacity_ = capacity;
+  }
+  int64_t GetReceivedTrafficCapacity() const {
+    return received_traffic_capacity_;
+  }
+
+  // Returns the number of partitions each cycle is evaluated in.
+  int64_t GetPartitionCount() const { return partitions_.size(); }
+
+  // Returns the number of times any component has been ticked since
+  // the simulator was initialized.
+  int64_t GetComponentTickCount() const { return component_tick_count_; }
+
   // Register a service to run once at the beginning of each cycle.
   // TODO(tedhong): 2021-07-27 Add a scheme to provide a total order
   //                of services.
@@ -472,12 +612,54 @@ class NocSimulator {
   absl::Status CreateLink(NetworkComponentId nc_id);
   absl::Status CreateRouter(NetworkComponentId nc_id);
 
+  // Components evaluated by a single thread from a worklist.
+  struct Partition {
+    // Indices into components_, in tick order.
+    std::vector<int64_t> components;
+
+    // For each entry of components, the indices (into components) of the
+    // components connected to it.
+    std::vector<std::vector<int64_t>> neighbors;
+
+    // For each entry of components, the last cycle it converged on.
+    std::vector<int64_t> converged_cycle;
+
+    // Links with registered outputs separating partitions, advanced by this
+    // partition at the start of each cycle.
+    std::vector<SimLink*> registered_links;
+
+    // Number of components ticked during the last cycle.
+    int64_t tick_count = 0;
+
+    // Bitsets of the components to tick in the current and next pass over
+    // the worklist, kept across cycles so they are only allocated once.
+    std::vector<uint64_t> scheduled;
+    std::vector<uint64_t> next_scheduled;
+  };
+
+  // Runs functions over all partitions in parallel.
+  class WorkerPool;
+
+  // Records the simulation objects in tick order and groups them into
+  // partitions.
+  absl::Status BuildComponentGraph();
+
+  // Ticks components until the current cycle converges.
+  // Returns the number of passes over the components needed.
+  absl::StatusOr<int64_t> RunFullSweeps(int64_t max_ticks);
+  absl::StatusOr<int64_t> RunPartitions(int64_t max_ticks);
+  absl::StatusOr<int64_t> RunWorklist(Partition& partition, int64_t max_ticks);
+
   NetworkManager* mgr_;
   NocParameters* params_;
   DistributedRoutingTable* routing_;
 
   NetworkId network_;
   int64_t cycle_;
+  bool full_sweep_mode_;
+  int64_t worker_thread_count_;
+  int64_t received_traffic_capacity_;
+  int64_t component_tick_count_;
 
   // Map a specific ConnectionId to an index used to access
   // a specific SimConnectionState via the connections_ object.
@@ -508,6 +690,15 @@ class NocSimulator {
   std::vector<SimNetworkInterfaceSink> network_interface_sinks_;
   std::vector<SimInputBufferedVCRouter> routers_;
 
+  // All simulation objects above, in the order they are ticked
+  // (sources, links, routers, then sinks).
+  std::vector<SimNetworkComponentBase*> components_;
+
+  std::vector<Partition> partitions_;
+
+  // Threads running partitions_, if there is more than one.
+  std::unique_ptr<WorkerPool> worker_pool_;
+
   // Shims to services to run at the beginning of each cycle.
   std::vector<NocSimulatorServiceShim*> pre_cycle_services_;
 
@@ -14,19 +14,30 @@
 
 #include "xls/noc/simulation/sim_objects.h"
 
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_format.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/matchers.h"
 #include "xls/noc/config/network_config.pb.h"
 #include "xls/noc/simulation/flit.h"
 #include "xls/noc/simulation/network_graph_builder.h"
 #include "xls/noc/simulation/sample_network_graphs.h"
+#include "xls/noc/simulation/traffic_statistics.h"
 
 namespace xls {
 namespace noc {
 namespace {
 
+using ::testing::UnorderedElementsAreArray;
+
 TEST(SimObjectsTest, BackToBackNetwork0) {
   // Build and assign simulation objects
   NetworkConfigProto proto;
@@ -295,6 +306,346 @@ TEST(SimObjectsTest, TreeNetwork0) {
       38146);
 }
 
+// Received flits as (sink, cycle, data).
+using ReceivedFlits = std::vector<std::tuple<int64_t, int64_t, int64_t>>;
+
+struct TreeNetworkResult {
+  ReceivedFlits received;
+  int64_t tick_count;
+  int64_t partition_count;
+  std::vector<SinkTrafficStatistics> sink_statistics;
+};
+
+// Runs Tree000 with traffic from all sources and returns what each sink
+// received along with statistics of the simulator.
+//
+// If registered_links is true, every link is given a pipeline stage in each
+// direction so that the network can be partitioned across threads.
+//
+// Flit i of each source is injected on cycle 1 + i / 3 and carries
+// data 12 * source + i.
+absl::StatusOr<TreeNetworkResult> RunTreeNetwork(
+    bool full_sweep_mode, int64_t worker_thread_count = 1,
+    bool registered_links = false, int64_t received_traffic_capacity = -1) {
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  if (registered_links) {
+    NetworkManager unregistered_graph;
+    NocParameters unregistered_params;
+    XLS_RETURN_IF_ERROR(BuildNetworkGraphTree000(&proto, &unregistered_graph,
+                                                 &unregistered_params));
+    for (LinkConfigProto& link : *proto.mutable_links()) {
+      link.set_source_sink_pipeline_stage(
+          std::max<int64_t>(link.source_sink_pipeline_stage(), 1));
+      link.set_sink_source_pipeline_stage(1);
+    }
+    XLS_RETURN_IF_ERROR(BuildNetworkGraphFromProto(proto, &graph, &params));
+  } else {
+    XLS_RETURN_IF_ERROR(BuildNetworkGraphTree000(&proto, &graph, &params));
+  }
+
+  DistributedRoutingTableBuilderForTrees route_builder;
+  XLS_ASSIGN_OR_RETURN(DistributedRoutingTable routing_table,
+                       route_builder.BuildNetworkRoutingTables(
+                           graph.GetNetworkIds()[0], graph, params));
+
+  NocSimulator simulator;
+  simulator.SetFullSweepMode(full_sweep_mode);
+  simulator.SetWorkerThreadCount(worker_thread_count);
+  simulator.SetReceivedTrafficCapacity(received_traffic_capacity);
+  XLS_RETURN_IF_ERROR(simulator.Initialize(graph, params, routing_table,
+                                           graph.GetNetworkIds()[0]));
+
+  // SendPort2 can only reach RecvPort1 to RecvPort3.
+  const std::vector<std::pair<std::string, std::vector<std::string>>> flows = {
+      {"SendPort0", {"RecvPort0", "RecvPort1", "RecvPort2", "RecvPort3"}},
+      {"SendPort1", {"RecvPort3", "RecvPort0", "RecvPort2", "RecvPort1"}},
+      {"SendPort2", {"RecvPort1", "RecvPort2", "RecvPort3"}},
+  };
+  int64_t data = 0;
+  for (const auto& [src_name, sink_names] : flows) {
+    XLS_ASSIGN_OR_RETURN(NetworkComponentId src_id,
+                         FindNetworkComponentByName(src_name, graph, params));
+    XLS_ASSIGN_OR_RETURN(
+        int64_t src_index,
+        routing_table.GetSourceIndices().GetNetworkComponentIndex(src_id));
+    XLS_ASSIGN_OR_RETURN(SimNetworkInterfaceSrc * src,
+                         simulator.GetSimNetworkInterfaceSrc(src_id));
+    for (int64_t i = 0; i < 12; ++i) {
+      const std::string& sink_name = sink_names[i % sink_names.size()];
+      XLS_ASSIGN_OR_RETURN(
+          NetworkComponentId sink_id,
+          FindNetworkComponentByName(sink_name, graph, params));
+      XLS_ASSIGN_OR_RETURN(
+          int64_t sink_index,
+          routing_table.GetSinkIndices().GetNetworkComponentIndex(sink_id));
+      XLS_ASSIGN_OR_RETURN(TimedDataFlit flit,
+                           DataFlitBuilder()
+                               .Cycle(1 + i / 3)
+                               .Type(FlitType::kTail)
+                               .VirtualChannel(i % 2)
+                               .SourceIndex(src_index)
+                               .DestinationIndex(sink_index)
+                               .Data(UBits(data++, 64))
+                               .BuildTimedFlit());
+      XLS_RETURN_IF_ERROR(src->SendFlitAtTime(flit));
+    }
+  }
+
+  for (int64_t i = 0; i < 40; ++i) {
+    XLS_RETURN_IF_ERROR(simulator.RunCycle());
+  }
+
+  ReceivedFlits received;
+  std::vector<SinkTrafficStatistics> sink_statistics;
+  for (int64_t i = 0; i < 4; ++i) {
+    XLS_ASSIGN_OR_RETURN(
+        NetworkComponentId sink_id,
+        FindNetworkComponentByName(absl::StrFormat("RecvPort%d", i), graph,
+                                   params));
+    XLS_ASSIGN_OR_RETURN(SimNetworkInterfaceSink * sink,
+                         simulator.GetSimNetworkInterfaceSink(sink_id));
+    for (const TimedDataFlit& flit : sink->GetReceivedTraffic()) {
+      XLS_ASSIGN_OR_RETURN(int64_t value, flit.flit.data.ToInt64());
+      received.push_back({i, flit.cycle, value});
+    }
+    sink_statistics.push_back(sink->GetStatistics());
+  }
+  return TreeNetworkResult{received, simulator.GetComponentTickCount(),
+                           simulator.GetPartitionCount(), sink_statistics};
+}
+
+TEST(SimObjectsTest, WorklistMatchesFullSweeps) {
+  XLS_ASSERT_OK_AND_ASSIGN(TreeNetworkResult full_sweeps,
+                           RunTreeNetwork(/*full_sweep_mode=*/true));
+  XLS_ASSERT_OK_AND_ASSIGN(TreeNetworkResult worklist,
+                           RunTreeNetwork(/*full_sweep_mode=*/false));
+
+  EXPECT_EQ(full_sweeps.received.size(), 36);
+  EXPECT_EQ(worklist.received, full_sweeps.received);
+  EXPECT_LT(worklist.tick_count, full_sweeps.tick_count);
+}
+
+TEST(SimObjectsTest, PartitionsMatchSingleThread) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TreeNetworkResult full_sweeps,
+      RunTreeNetwork(/*full_sweep_mode=*/true, /*worker_thread_count=*/1,
+                     /*registered_links=*/true));
+  EXPECT_EQ(full_sweeps.received.size(), 36);
+
+  for (int64_t thread_count : {1, 2, 3, 8}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        TreeNetworkResult partitioned,
+        RunTreeNetwork(/*full_sweep_mode=*/false, thread_count,
+                       /*registered_links=*/true));
+    // Sources, sinks and routers are each in a region of their own.
+    EXPECT_EQ(partitioned.partition_count, thread_count);
+    EXPECT_EQ(partitioned.received, full_sweeps.received)
+        << "Thread count " << thread_count;
+  }
+}
+
+TEST(SimObjectsTest, SinkStatisticsCoverTrimmedTraffic) {
+  XLS_ASSERT_OK_AND_ASSIGN(TreeNetworkResult all,
+                           RunTreeNetwork(/*full_sweep_mode=*/false));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TreeNetworkResult trimmed,
+      RunTreeNetwork(/*full_sweep_mode=*/false, /*worker_thread_count=*/1,
+                     /*registered_links=*/false,
+                     /*received_traffic_capacity=*/2));
+
+  for (int64_t sink = 0; sink < 4; ++sink) {
+    ReceivedFlits sink_flits;
+    LatencyHistogram latency;
+    for (const auto& [flit_sink, cycle, data] : all.received) {
+      if (flit_sink == sink) {
+        sink_flits.push_back({flit_sink, cycle, data});
+        latency.Record(cycle - (1 + data % 12 / 3));
+      }
+    }
+    ReceivedFlits trimmed_sink_flits;
+    for (const auto& flit : trimmed.received) {
+      if (std::get<0>(flit) == sink) {
+        trimmed_sink_flits.push_back(flit);
+      }
+    }
+    ASSERT_GE(sink_flits.size(), 2);
+    EXPECT_EQ(trimmed_sink_flits,
+              ReceivedFlits(sink_flits.end() - 2, sink_flits.end()));
+
+    const SinkTrafficStatistics& statistics = trimmed.sink_statistics[sink];
+    const TrafficStatistics& total = statistics.GetTotal();
+    EXPECT_EQ(total.flit_count(), sink_flits.size());
+    EXPECT_EQ(total.bit_count(), 64 * sink_flits.size());
+    EXPECT_EQ(total.latency().min(), latency.min());
+    EXPECT_EQ(total.latency().max(), latency.max());
+    EXPECT_DOUBLE_EQ(total.latency().mean(), latency.mean());
+    EXPECT_EQ(statistics.GetVirtualChannel(0).flit_count() +
+                  statistics.GetVirtualChannel(1).flit_count(),
+              sink_flits.size());
+  }
+}
+
+struct MeshNetworkResult {
+  // Data of the flits received by each sink, in order of arrival.
+  std::vector<std::vector<int64_t>> received;
+
+  // Utilization of each router, keyed by router name.
+  absl::flat_hash_map<std::string, int64_t> utilization;
+};
+
+// Runs Mesh000 routed with the given algorithm, where each source sends
+// flit_count flits to each of the given sinks.
+//
+// Flit i of each source is injected on cycle 1 + i / 2 and carries data
+// 1000 * source + i.
+absl::StatusOr<MeshNetworkResult> RunMeshNetwork(
+    MeshRoutingAlgorithm algorithm,
+    const std::vector<std::pair<std::string, std::vector<std::string>>>&
+        flows,
+    int64_t flit_count) {
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  XLS_RETURN_IF_ERROR(BuildNetworkGraphMesh000(&proto, &graph, &params));
+
+  DistributedRoutingTableBuilderForMeshes route_builder(algorithm);
+  for (int64_t x = 0; x < 3; ++x) {
+    for (int64_t y = 0; y < 3; ++y) {
+      route_builder.SetRouterCoordinate(absl::StrFormat("Router%d%d", x, y), x,
+                                        y);
+    }
+  }
+  XLS_ASSIGN_OR_RETURN(DistributedRoutingTable routing_table,
+                       route_builder.BuildNetworkRoutingTables(
+                           graph.GetNetworkIds()[0], graph, params));
+
+  NocSimulator simulator;
+  XLS_RETURN_IF_ERROR(simulator.Initialize(graph, params, routing_table,
+                                           graph.GetNetworkIds()[0]));
+
+  for (int64_t source = 0; source < flows.size(); ++source) {
+    const auto& [src_name, sink_names] = flows[source];
+    XLS_ASSIGN_OR_RETURN(NetworkComponentId src_id,
+                         FindNetworkComponentByName(src_name, graph, params));
+    XLS_ASSIGN_OR_RETURN(
+        int64_t src_index,
+        routing_table.GetSourceIndices().GetNetworkComponentIndex(src_id));
+    XLS_ASSIGN_OR_RETURN(SimNetworkInterfaceSrc * src,
+                         simulator.GetSimNetworkInterfaceSrc(src_id));
+    for (int64_t i = 0; i < flit_count * sink_names.size(); ++i) {
+      XLS_ASSIGN_OR_RETURN(
+          NetworkComponentId sink_id,
+          FindNetworkComponentByName(sink_names[i % sink_names.size()], graph,
+                                     params));
+      XLS_ASSIGN_OR_RETURN(
+          int64_t sink_index,
+          routing_table.GetSinkIndices().GetNetworkComponentIndex(sink_id));
+      XLS_ASSIGN_OR_RETURN(TimedDataFlit flit,
+                           DataFlitBuilder()
+                               .Cycle(1 + i / 2)
+                               .Type(FlitType::kTail)
+                               .VirtualChannel(i % 2)
+                               .SourceIndex(src_index)
+                               .DestinationIndex(sink_index)
+                               .Data(UBits(1000 * source + i, 64))
+                               .BuildTimedFlit());
+      XLS_RETURN_IF_ERROR(src->SendFlitAtTime(flit));
+    }
+  }
+
+  for (int64_t i = 0; i < 200; ++i) {
+    XLS_RETURN_IF_ERROR(simulator.RunCycle());
+  }
+
+  MeshNetworkResult result;
+  for (int64_t x = 0; x < 3; ++x) {
+    for (int64_t y = 0; y < 3; ++y) {
+      XLS_ASSIGN_OR_RETURN(
+          NetworkComponentId sink_id,
+          FindNetworkComponentByName(absl::StrFormat("RecvPort%d%d", x, y),
+                                     graph, params));
+      XLS_ASSIGN_OR_RETURN(SimNetworkInterfaceSink * sink,
+                           simulator.GetSimNetworkInterfaceSink(sink_id));
+      std::vector<int64_t>& received = result.received.emplace_back();
+      for (const TimedDataFlit& flit : sink->GetReceivedTraffic()) {
+        XLS_ASSIGN_OR_RETURN(int64_t value, flit.flit.data.ToInt64());
+        received.push_back(value);
+      }
+    }
+  }
+  for (const SimInputBufferedVCRouter& router : simulator.GetRouters()) {
+    XLS_ASSIGN_OR_RETURN(NetworkComponentParam param,
+                         params.GetNetworkComponentParam(router.GetId()));
+    result.utilization[absl::get<RouterParam>(param).GetName()] =
+        router.GetUtilizationCycleCount();
+  }
+  return result;
+}
+
+TEST(SimObjectsTest, MeshNetworkDeliversAllTraffic) {
+  // Every source sends to every sink.
+  std::vector<std::string> sinks;
+  for (int64_t x = 0; x < 3; ++x) {
+    for (int64_t y = 0; y < 3; ++y) {
+      sinks.push_back(absl::StrFormat("RecvPort%d%d", x, y));
+    }
+  }
+  std::vector<std::pair<std::string, std::vector<std::string>>> flows;
+  for (int64_t x = 0; x < 3; ++x) {
+    for (int64_t y = 0; y < 3; ++y) {
+      std::vector<std::string> rotated_sinks = sinks;
+      std::rotate(rotated_sinks.begin(),
+                  rotated_sinks.begin() + flows.size(), rotated_sinks.end());
+      flows.push_back({absl::StrFormat("SendPort%d%d", x, y), rotated_sinks});
+    }
+  }
+
+  for (MeshRoutingAlgorithm algorithm : {MeshRoutingAlgorithm::kDimensionOrder,
+                                         MeshRoutingAlgorithm::kWestFirst}) {
+    XLS_ASSERT_OK_AND_ASSIGN(MeshNetworkResult result,
+                             RunMeshNetwork(algorithm, flows, 2));
+
+    // Sink s receives flits 2 * 9 * source + 9 * j + (s - source) mod 9.
+    for (int64_t sink = 0; sink < 9; ++sink) {
+      std::vector<int64_t> expected;
+      for (int64_t source = 0; source < 9; ++source) {
+        for (int64_t j = 0; j < 2; ++j) {
+          expected.push_back(1000 * source + 9 * j + (sink - source + 9) % 9);
+        }
+      }
+      EXPECT_THAT(result.received[sink], UnorderedElementsAreArray(expected))
+          << "Sink " << sink;
+    }
+  }
+}
+
+TEST(SimObjectsTest, MeshWestFirstSpreadsTraffic) {
+  // SendPort00 to RecvPort11 may go through either Router10 or Router01.
+  std::vector<std::pair<std::string, std::vector<std::string>>> flows = {
+      {"SendPort00", {"RecvPort11"}}};
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      MeshNetworkResult dimension_order,
+      RunMeshNetwork(MeshRoutingAlgorithm::kDimensionOrder, flows, 16));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      MeshNetworkResult west_first,
+      RunMeshNetwork(MeshRoutingAlgorithm::kWestFirst, flows, 16));
+
+  // RecvPort11 is the fifth sink.
+  EXPECT_EQ(dimension_order.received[4].size(), 16);
+  EXPECT_EQ(west_first.received[4].size(), 16);
+
+  EXPECT_EQ(dimension_order.utilization["Router10"], 16);
+  EXPECT_EQ(dimension_order.utilization["Router01"], 0);
+  EXPECT_GT(west_first.utilization["Router10"], 0);
+  EXPECT_GT(west_first.utilization["Router01"], 0);
+  EXPECT_EQ(west_first.utilization["Router10"] +
+                west_first.utilization["Router01"],
+            16);
+}
+
 }  // namespace
 }  // namespace noc
 }  // namespace xls
@@ -183,6 +183,20 @@ class TrafficFlow {
 
   bool IsReplay() const { return !cycle_times_.empty(); }
 
+  // Get path of the trace file replayed by the flow, empty if none.
+  const std::string& GetTracePath() const { return trace_path_; }
+
+  // Set the path of a trace file (see traffic_trace.h) to replay.
+  //
+  // Unlike replaying clock cycle times, the trace is read as the simulation
+  // progresses so is suitable for traces too large to fit in memory.
+  TrafficFlow& SetTracePath(absl::string_view path) {
+    trace_path_ = std::string(path);
+    return *this;
+  }
+
+  bool IsTrace() const { return !trace_path_.empty(); }
+
  private:
   TrafficFlowId id_;
 
@@ -203,6 +217,9 @@ class TrafficFlow {
   // instances where the source sends a packet to the destination.
   // TODO(vmirian) Add support for clock cycle interval: 09-02-2021.
   std::vector<int64_t> cycle_times_;
+
+  // Trace file to replay.
+  std::string trace_path_;
 };
 
 class NocTrafficManager;
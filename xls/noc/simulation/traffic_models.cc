@@ -162,4 +162,72 @@ absl::Span<const int64_t> ReplayTrafficModel::GetClockCycles() const {
   return clock_cycles_;
 }
 
+TraceTrafficModelBuilder::TraceTrafficModelBuilder(
+    int64_t packet_size_bits, const std::filesystem::path& trace_path)
+    : trace_path_(trace_path) {
+  SetPacketSizeBits(packet_size_bits);
+}
+
+absl::StatusOr<std::unique_ptr<TraceTrafficModel>>
+TraceTrafficModelBuilder::Build() const {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<TraceTrafficModel> model,
+                       TrafficModelBuilder::Build());
+  XLS_ASSIGN_OR_RETURN(TrafficTraceReader reader,
+                       TrafficTraceReader::Open(trace_path_));
+  XLS_RETURN_IF_ERROR(model->SetTrace(std::move(reader)));
+  return model;
+}
+
+absl::Status TraceTrafficModel::SetTrace(TrafficTraceReader reader) {
+  reader_ = std::move(reader);
+  return Advance();
+}
+
+absl::Status TraceTrafficModel::Advance() {
+  XLS_ASSIGN_OR_RETURN(next_record_, reader_->Next());
+  return absl::OkStatus();
+}
+
+std::vector<DataPacket> TraceTrafficModel::GetNewCyclePackets(int64_t cycle) {
+  if (cycle > cycle_count_) {
+    cycle_count_ = cycle;
+  }
+
+  std::vector<DataPacket> packets;
+
+  while (next_record_.has_value() && next_record_->cycle <= cycle) {
+    int64_t packet_size_bits = next_record_->packet_size_bits == 0
+                                   ? packet_size_bits_
+                                   : next_record_->packet_size_bits;
+    XLS_CHECK_LE(packet_size_bits, packet_size_bits_)
+        << "Trace packet at cycle " << next_record_->cycle
+        << " is larger than the packet size of the flow";
+    absl::StatusOr<DataPacket> packet =
+        DataPacketBuilder()
+            .Valid(true)
+            .ZeroedData(packet_size_bits)
+            .VirtualChannel(vc_)
+            .SourceIndex(source_index_)
+            .DestinationIndex(destination_index_)
+            .Build();
+    XLS_CHECK(packet.ok());
+    packets.push_back(std::move(packet.value()));
+    ++packet_count_;
+    bits_sent_ += packet_size_bits;
+
+    absl::Status status = Advance();
+    XLS_CHECK(status.ok()) << status;
+  }
+
+  return packets;
+}
+
+double TraceTrafficModel::ExpectedTrafficRateInMiBps(
+    int64_t cycle_time_ps) const {
+  double total_sec = static_cast<double>(cycle_count_ + 1) *
+                     static_cast<double>(cycle_time_ps) * 1.0e-12;
+  double bits_per_sec = static_cast<double>(bits_sent_) / total_sec;
+  return bits_per_sec / 1024.0 / 1024.0 / 8.0;
+}
+
 }  // namespace xls::noc
@@ -16,6 +16,7 @@
 #define XLS_NOC_SIMULATION_TRAFFIC_MODELS_H_
 
 #include <algorithm>
+#include <filesystem>
 #include <memory>
 #include <queue>
 #include <vector>
@@ -26,6 +27,7 @@
 #include "xls/noc/simulation/common.h"
 #include "xls/noc/simulation/packetizer.h"
 #include "xls/noc/simulation/random_number_interface.h"
+#include "xls/noc/simulation/traffic_trace.h"
 #include "xls/noc/simulation/units.h"
 
 // This file contains classes used to model traffic of a NOC.
@@ -233,6 +235,55 @@ class ReplayTrafficModelBuilder
   std::vector<int64_t> clock_cycles_;
 };
 
+// Models the traffic injected into a single source according to a trace
+// file (see traffic_trace.h).
+//
+// Unlike ReplayTrafficModel, the trace is read a record at a time while the
+// simulation runs, so only a constant amount of memory is used regardless of
+// the length of the trace.
+class TraceTrafficModel : public TrafficModel {
+ public:
+  explicit TraceTrafficModel(int64_t packet_size_bits)
+      : TrafficModel(packet_size_bits) {}
+
+  // Reads packets from the given trace, replacing any previous trace.
+  absl::Status SetTrace(TrafficTraceReader reader);
+
+  // Note: Packets of a cycle skipped by the caller are sent on the next call.
+  std::vector<DataPacket> GetNewCyclePackets(int64_t cycle);
+
+  double ExpectedTrafficRateInMiBps(int64_t cycle_time_ps) const;
+
+  // Returns the count of packets sent so far.
+  int64_t GetPacketCount() const { return packet_count_; }
+
+ private:
+  // Reads the next record of the trace into next_record_.
+  absl::Status Advance();
+
+  absl::optional<TrafficTraceReader> reader_;
+  absl::optional<TrafficTraceRecord> next_record_;
+
+  int64_t cycle_count_ = 0;
+  int64_t packet_count_ = 0;
+  int64_t bits_sent_ = 0;
+};
+
+class TraceTrafficModelBuilder
+    : public TrafficModelBuilder<TraceTrafficModelBuilder, TraceTrafficModel> {
+ public:
+  // packet_size_bits is the size of packets whose size the trace doesn't
+  // specify, and the maximum size of packets in the trace.
+  TraceTrafficModelBuilder(int64_t packet_size_bits,
+                           const std::filesystem::path& trace_path);
+
+  // Returns an error if the trace can't be opened.
+  absl::StatusOr<std::unique_ptr<TraceTrafficModel>> Build() const;
+
+ private:
+  std::filesystem::path trace_path_;
+};
+
 // Measures the traffic injected and computes aggregate statistics.
 class TrafficModelMonitor {
  public:
@@ -16,7 +16,9 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "xls/common/file/temp_file.h"
 #include "xls/common/status/matchers.h"
+#include "xls/noc/simulation/traffic_trace.h"
 
 namespace xls::noc {
 namespace {
@@ -186,5 +188,54 @@ TEST(TrafficModelsTest, ReplayModelClockCycleClearTest) {
   EXPECT_EQ(model.GetClockCycles(), std::vector<int64_t>({6, 7, 8, 9, 10}));
 }
 
+TEST(TrafficModelsTest, TraceModelTest) {
+  int64_t packet_size_bits = 128;
+
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile trace, TempFile::Create(".trace"));
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficTraceWriter writer,
+                           TrafficTraceWriter::Create(trace.path()));
+  XLS_ASSERT_OK(writer.Add({1, 0}));
+  XLS_ASSERT_OK(writer.Add({1, 64}));
+  XLS_ASSERT_OK(writer.Add({4, 0}));
+  XLS_ASSERT_OK(writer.Close());
+
+  TraceTrafficModelBuilder builder(packet_size_bits, trace.path());
+  builder.SetVCIndex(1).SetSourceIndex(10).SetDestinationIndex(3);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TraceTrafficModel> model,
+                           builder.Build());
+
+  EXPECT_EQ(model->GetPacketSizeInBits(), packet_size_bits);
+  EXPECT_EQ(model->GetVCIndex(), 1);
+  EXPECT_EQ(model->GetSourceIndex(), 10);
+  EXPECT_EQ(model->GetDestinationIndex(), 3);
+
+  TrafficModelMonitor monitor;
+  std::vector<int64_t> packets_per_cycle;
+  std::vector<int64_t> packet_sizes;
+
+  for (int64_t cycle = 0; cycle < 6; ++cycle) {
+    std::vector<DataPacket> packets = model->GetNewCyclePackets(cycle);
+    for (DataPacket& p : packets) {
+      EXPECT_EQ(p.vc, 1);
+      EXPECT_EQ(p.source_index, 10);
+      EXPECT_EQ(p.destination_index, 3);
+      packet_sizes.push_back(p.data.bit_count());
+    }
+    packets_per_cycle.push_back(packets.size());
+    monitor.AcceptNewPackets(absl::MakeSpan(packets), cycle);
+  }
+
+  EXPECT_EQ(packets_per_cycle, std::vector<int64_t>({0, 2, 0, 0, 1, 0}));
+  EXPECT_EQ(packet_sizes, std::vector<int64_t>({128, 64, 128}));
+  EXPECT_EQ(model->GetPacketCount(), 3);
+  EXPECT_DOUBLE_EQ(model->ExpectedTrafficRateInMiBps(500),
+                   monitor.MeasuredTrafficRateInMiBps(500));
+}
+
+TEST(TrafficModelsTest, TraceModelBuilderMissingTrace) {
+  TraceTrafficModelBuilder builder(128, "/does/not/exist.trace");
+  EXPECT_FALSE(builder.Build().ok());
+}
+
 }  // namespace
 }  // namespace xls::noc
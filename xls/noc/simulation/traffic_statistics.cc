@@ -0,0 +1,129 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/noc/simulation/traffic_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "xls/common/logging/logging.h"
+#include "xls/common/math_util.h"
+
+namespace xls::noc {
+
+void LatencyHistogram::Record(int64_t value) {
+  XLS_DCHECK_GE(value, 0);
+  value = std::max<int64_t>(value, 0);
+
+  int64_t index = BucketIndex(value);
+  if (index >= bucket_counts_.size()) {
+    bucket_counts_.resize(index + 1, 0);
+  }
+  ++bucket_counts_[index];
+
+  if (count_ == 0) {
+    min_ = value;
+    max_ = value;
+  } else {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  ++count_;
+  double delta = static_cast<double>(value) - mean_;
+  mean_ += delta / static_cast<double>(count_);
+  m2_ += delta * (static_cast<double>(value) - mean_);
+}
+
+double LatencyHistogram::stddev() const {
+  if (count_ == 0) {
+    return 0.0;
+  }
+  return std::sqrt(m2_ / static_cast<double>(count_));
+}
+
+int64_t LatencyHistogram::Percentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+
+  int64_t rank = static_cast<int64_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(count_)));
+  rank = std::clamp<int64_t>(rank, 1, count_);
+
+  int64_t seen = 0;
+  for (int64_t i = 0; i < bucket_counts_.size(); ++i) {
+    seen += bucket_counts_[i];
+    if (seen >= rank) {
+      return std::clamp(BucketUpperBound(i), min_, max_);
+    }
+  }
+  return max_;
+}
+
+// Values below 2^sub_bucket_bits_ map directly to their own bucket.
+// Larger values are shifted right until only their top sub_bucket_bits_ + 1
+// bits remain, with each shift amount owning the next 2^sub_bucket_bits_
+// buckets.
+int64_t LatencyHistogram::BucketIndex(int64_t value) const {
+  if (value < (int64_t{1} << sub_bucket_bits_)) {
+    return value;
+  }
+  int64_t shift = FloorOfLog2(value) - sub_bucket_bits_;
+  return (shift << sub_bucket_bits_) + (value >> shift);
+}
+
+int64_t LatencyHistogram::BucketUpperBound(int64_t index) const {
+  int64_t shift = std::max<int64_t>((index >> sub_bucket_bits_) - 1, 0);
+  uint64_t mantissa = index - (shift << sub_bucket_bits_);
+  return static_cast<int64_t>(((mantissa + 1) << shift) - 1);
+}
+
+void SinkTrafficStatistics::Record(const TimedDataFlit& flit) {
+  int64_t bit_count = flit.flit.data_bit_count;
+  int64_t latency = flit.cycle - flit.metadata.injection_cycle_time;
+  int64_t vc = flit.flit.vc;
+
+  total_.Record(bit_count, latency);
+
+  if (vc >= virtual_channels_.size()) {
+    virtual_channels_.resize(vc + 1);
+  }
+  virtual_channels_[vc].Record(bit_count, latency);
+
+  flows_[{flit.flit.source_index, vc}].Record(bit_count, latency);
+
+  last_cycle_ = std::max(last_cycle_, flit.cycle);
+}
+
+const TrafficStatistics& SinkTrafficStatistics::GetVirtualChannel(
+    int64_t vc) const {
+  static const TrafficStatistics* const kEmpty = new TrafficStatistics();
+  if (vc < 0 || vc >= virtual_channels_.size()) {
+    return *kEmpty;
+  }
+  return virtual_channels_[vc];
+}
+
+const TrafficStatistics& SinkTrafficStatistics::GetFlow(int64_t source_index,
+                                                        int64_t vc) const {
+  static const TrafficStatistics* const kEmpty = new TrafficStatistics();
+  auto iter = flows_.find({source_index, vc});
+  if (iter == flows_.end()) {
+    return *kEmpty;
+  }
+  return iter->second;
+}
+
+}  // namespace xls::noc
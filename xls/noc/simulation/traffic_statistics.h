@@ -0,0 +1,135 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_NOC_SIMULATION_TRAFFIC_STATISTICS_H_
+#define XLS_NOC_SIMULATION_TRAFFIC_STATISTICS_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "xls/noc/simulation/flit.h"
+
+// This file contains classes used to summarize the traffic received
+// during a simulation in constant memory.
+
+namespace xls::noc {
+
+// Distribution of non-negative integer samples (ex. latencies in cycles).
+//
+// Samples are counted in log-linear buckets, in the manner of an
+// HDR histogram: values below 2^sub_bucket_bits each get their own
+// bucket, and above that every power-of-two range is split into
+// 2^sub_bucket_bits buckets.  Percentiles are therefore exact for small
+// values and within a relative error of 2^-sub_bucket_bits otherwise,
+// while memory only grows with the log of the largest sample.
+class LatencyHistogram {
+ public:
+  explicit LatencyHistogram(int64_t sub_bucket_bits = 5)
+      : sub_bucket_bits_(sub_bucket_bits) {}
+
+  // Adds a sample.
+  void Record(int64_t value);
+
+  // Number of samples recorded.
+  int64_t count() const { return count_; }
+
+  // Smallest and largest samples recorded, 0 if there are none.
+  int64_t min() const { return min_; }
+  int64_t max() const { return max_; }
+
+  // Mean and (population) standard deviation of the samples,
+  // 0 if there are none.
+  double mean() const { return mean_; }
+  double stddev() const;
+
+  // Returns the smallest value v such that at least percentile % of
+  // the samples are <= v, up to the resolution of the bucket v falls in.
+  //
+  // Percentile is within [0, 100].  Returns 0 if there are no samples.
+  int64_t Percentile(double percentile) const;
+
+ private:
+  int64_t BucketIndex(int64_t value) const;
+  int64_t BucketUpperBound(int64_t index) const;
+
+  int64_t sub_bucket_bits_;
+  std::vector<int64_t> bucket_counts_;
+
+  int64_t count_ = 0;
+  int64_t min_ = 0;
+  int64_t max_ = 0;
+
+  // Running mean and sum of squared differences from it (Welford).
+  double mean_ = 0.0;
+  double m2_ = 0.0;
+};
+
+// Flit, bit and latency totals over a stream of flits.
+class TrafficStatistics {
+ public:
+  void Record(int64_t bit_count, int64_t latency) {
+    bit_count_ += bit_count;
+    latency_.Record(latency);
+  }
+
+  int64_t flit_count() const { return latency_.count(); }
+  int64_t bit_count() const { return bit_count_; }
+
+  // Distribution of the latency, in cycles, of each flit.
+  const LatencyHistogram& latency() const { return latency_; }
+
+ private:
+  int64_t bit_count_ = 0;
+  LatencyHistogram latency_;
+};
+
+// Statistics of the traffic received by a network interface sink.
+//
+// The latency of a flit is the number of cycles between it being handed to
+// its source network interface (TimedDataFlitInfo::injection_cycle_time)
+// and it being received, so includes any time queued at the source.
+class SinkTrafficStatistics {
+ public:
+  explicit SinkTrafficStatistics(int64_t virtual_channel_count = 0)
+      : virtual_channels_(virtual_channel_count) {}
+
+  // Accounts for a flit received on flit.cycle.
+  void Record(const TimedDataFlit& flit);
+
+  // Statistics over all flits received.
+  const TrafficStatistics& GetTotal() const { return total_; }
+
+  // Statistics over the flits received on a virtual channel.
+  // Empty if no such flit was received.
+  const TrafficStatistics& GetVirtualChannel(int64_t vc) const;
+
+  // Statistics over the flits received from a source (by its index in the
+  // routing table) on a virtual channel.  Empty if no such flit was received.
+  const TrafficStatistics& GetFlow(int64_t source_index, int64_t vc) const;
+
+  // Last cycle a flit was received on, -1 if none were.
+  int64_t last_cycle() const { return last_cycle_; }
+
+ private:
+  TrafficStatistics total_;
+  std::vector<TrafficStatistics> virtual_channels_;
+  absl::flat_hash_map<std::pair<int64_t, int64_t>, TrafficStatistics> flows_;
+  int64_t last_cycle_ = -1;
+};
+
+}  // namespace xls::noc
+
+#endif  // XLS_NOC_SIMULATION_TRAFFIC_STATISTICS_H_
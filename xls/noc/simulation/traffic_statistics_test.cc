@@ -0,0 +1,131 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/noc/simulation/traffic_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/noc/simulation/flit.h"
+
+namespace xls::noc {
+namespace {
+
+TEST(TrafficStatisticsTest, EmptyHistogram) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.min(), 0);
+  EXPECT_EQ(histogram.max(), 0);
+  EXPECT_DOUBLE_EQ(histogram.mean(), 0.0);
+  EXPECT_DOUBLE_EQ(histogram.stddev(), 0.0);
+  EXPECT_EQ(histogram.Percentile(50), 0);
+}
+
+TEST(TrafficStatisticsTest, SmallValuesAreExact) {
+  LatencyHistogram histogram(/*sub_bucket_bits=*/3);
+  for (int64_t i = 1; i <= 4; ++i) {
+    histogram.Record(i);
+  }
+
+  EXPECT_EQ(histogram.count(), 4);
+  EXPECT_EQ(histogram.min(), 1);
+  EXPECT_EQ(histogram.max(), 4);
+  EXPECT_DOUBLE_EQ(histogram.mean(), 2.5);
+  EXPECT_DOUBLE_EQ(histogram.stddev(), std::sqrt(1.25));
+
+  EXPECT_EQ(histogram.Percentile(0), 1);
+  EXPECT_EQ(histogram.Percentile(25), 1);
+  EXPECT_EQ(histogram.Percentile(26), 2);
+  EXPECT_EQ(histogram.Percentile(50), 2);
+  EXPECT_EQ(histogram.Percentile(75), 3);
+  EXPECT_EQ(histogram.Percentile(100), 4);
+}
+
+TEST(TrafficStatisticsTest, PercentilesWithinRelativeError) {
+  constexpr int64_t kSubBucketBits = 5;
+  LatencyHistogram histogram(kSubBucketBits);
+
+  std::mt19937_64 engine(0);
+  std::geometric_distribution<int64_t> distribution(0.001);
+  std::vector<int64_t> samples(100000);
+  for (int64_t& sample : samples) {
+    sample = distribution(engine);
+    histogram.Record(sample);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  EXPECT_EQ(histogram.min(), samples.front());
+  EXPECT_EQ(histogram.max(), samples.back());
+
+  for (double percentile : {1.0, 50.0, 90.0, 99.0, 99.9, 99.99}) {
+    int64_t rank = static_cast<int64_t>(
+        std::ceil(percentile / 100.0 * static_cast<double>(samples.size())));
+    int64_t exact = samples[rank - 1];
+    int64_t estimate = histogram.Percentile(percentile);
+
+    EXPECT_GE(estimate, exact) << percentile;
+    EXPECT_LE(estimate - exact, exact >> kSubBucketBits) << percentile;
+  }
+}
+
+TEST(TrafficStatisticsTest, SinkStatistics) {
+  SinkTrafficStatistics statistics(/*virtual_channel_count=*/2);
+
+  auto record = [&](int64_t source_index, int64_t vc, int64_t injection_cycle,
+                    int64_t cycle) {
+    XLS_ASSERT_OK_AND_ASSIGN(TimedDataFlit flit,
+                             DataFlitBuilder()
+                                 .Type(FlitType::kTail)
+                                 .SourceIndex(source_index)
+                                 .VirtualChannel(vc)
+                                 .Data(UBits(0, 16))
+                                 .Cycle(injection_cycle)
+                                 .BuildTimedFlit());
+    flit.cycle = cycle;
+    statistics.Record(flit);
+  };
+
+  record(/*source_index=*/0, /*vc=*/0, /*injection_cycle=*/0, /*cycle=*/3);
+  record(/*source_index=*/1, /*vc=*/0, /*injection_cycle=*/1, /*cycle=*/9);
+  record(/*source_index=*/1, /*vc=*/1, /*injection_cycle=*/5, /*cycle=*/7);
+  record(/*source_index=*/1, /*vc=*/1, /*injection_cycle=*/6, /*cycle=*/8);
+
+  EXPECT_EQ(statistics.last_cycle(), 9);
+
+  EXPECT_EQ(statistics.GetTotal().flit_count(), 4);
+  EXPECT_EQ(statistics.GetTotal().bit_count(), 64);
+  EXPECT_EQ(statistics.GetTotal().latency().max(), 8);
+  EXPECT_DOUBLE_EQ(statistics.GetTotal().latency().mean(), 15.0 / 4.0);
+
+  EXPECT_EQ(statistics.GetVirtualChannel(0).flit_count(), 2);
+  EXPECT_EQ(statistics.GetVirtualChannel(0).latency().min(), 3);
+  EXPECT_EQ(statistics.GetVirtualChannel(1).flit_count(), 2);
+  EXPECT_EQ(statistics.GetVirtualChannel(1).latency().max(), 2);
+  EXPECT_EQ(statistics.GetVirtualChannel(2).flit_count(), 0);
+
+  EXPECT_EQ(statistics.GetFlow(0, 0).flit_count(), 1);
+  EXPECT_EQ(statistics.GetFlow(1, 0).latency().max(), 8);
+  EXPECT_EQ(statistics.GetFlow(1, 1).flit_count(), 2);
+  EXPECT_EQ(statistics.GetFlow(1, 1).bit_count(), 32);
+  EXPECT_EQ(statistics.GetFlow(0, 1).flit_count(), 0);
+}
+
+}  // namespace
+}  // namespace xls::noc
@@ -0,0 +1,178 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/noc/simulation/traffic_trace.h"
+
+#include <limits>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls::noc {
+namespace {
+
+void AppendVarint(uint64_t value, std::string& buffer) {
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<char>(value));
+}
+
+}  // namespace
+
+/* static */ absl::StatusOr<TrafficTraceWriter> TrafficTraceWriter::Create(
+    const std::filesystem::path& path) {
+  XLS_RETURN_IF_ERROR(SetFileContents(path, kTrafficTraceMagic));
+  return TrafficTraceWriter(path);
+}
+
+absl::Status TrafficTraceWriter::Add(const TrafficTraceRecord& record) {
+  if (record.cycle < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid cycle %d", record.cycle));
+  }
+  if (record.cycle < last_cycle_) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Trace records must be in order of increasing cycle, got cycle %d "
+        "after cycle %d",
+        record.cycle, last_cycle_));
+  }
+  if (record.packet_size_bits < 0) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Invalid packet size %d at cycle %d", record.packet_size_bits,
+        record.cycle));
+  }
+
+  AppendVarint(record.cycle - last_cycle_, buffer_);
+  AppendVarint(record.packet_size_bits, buffer_);
+  last_cycle_ = record.cycle;
+  ++record_count_;
+
+  if (buffer_.size() >= kFlushSize) {
+    return Flush();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status TrafficTraceWriter::Close() { return Flush(); }
+
+absl::Status TrafficTraceWriter::Flush() {
+  XLS_RETURN_IF_ERROR(AppendStringToFile(path_, buffer_));
+  buffer_.clear();
+  return absl::OkStatus();
+}
+
+/* static */ absl::StatusOr<TrafficTraceReader> TrafficTraceReader::Open(
+    const std::filesystem::path& path) {
+  XLS_ASSIGN_OR_RETURN(MappedFile file, MappedFile::Open(path));
+  if (!absl::StartsWith(file.contents(), kTrafficTraceMagic)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("%s is not a traffic trace file", path.string()));
+  }
+  return TrafficTraceReader(std::move(file));
+}
+
+absl::StatusOr<absl::optional<TrafficTraceRecord>> TrafficTraceReader::Next() {
+  if (position_ == file_.contents().size()) {
+    return absl::nullopt;
+  }
+
+  XLS_ASSIGN_OR_RETURN(uint64_t cycle_delta, ReadVarint());
+  XLS_ASSIGN_OR_RETURN(uint64_t packet_size_bits, ReadVarint());
+
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  if (cycle_delta > kMax - last_cycle_ || packet_size_bits > kMax) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Out of range traffic trace record before offset %d", position_));
+  }
+  last_cycle_ += cycle_delta;
+
+  return TrafficTraceRecord{last_cycle_,
+                            static_cast<int64_t>(packet_size_bits)};
+}
+
+absl::StatusOr<uint64_t> TrafficTraceReader::ReadVarint() {
+  absl::string_view contents = file_.contents();
+  uint64_t value = 0;
+  for (int64_t shift = 0; shift < 64; shift += 7) {
+    if (position_ == contents.size()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Truncated traffic trace record at offset %d", position_));
+    }
+    uint8_t byte = static_cast<uint8_t>(contents[position_++]);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Overlong varint in traffic trace at offset %d", position_));
+}
+
+absl::StatusOr<int64_t> ConvertCsvToTrafficTrace(
+    const std::filesystem::path& csv_path,
+    const std::filesystem::path& trace_path) {
+  XLS_ASSIGN_OR_RETURN(MappedFile csv, MappedFile::Open(csv_path));
+  XLS_ASSIGN_OR_RETURN(TrafficTraceWriter writer,
+                       TrafficTraceWriter::Create(trace_path));
+
+  int64_t line_number = 0;
+  bool header_allowed = true;
+  for (absl::string_view line : absl::StrSplit(csv.contents(), '\n')) {
+    ++line_number;
+    line = absl::StripAsciiWhitespace(line);
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    std::pair<absl::string_view, absl::string_view> fields =
+        absl::StrSplit(line, absl::MaxSplits(',', 1));
+    TrafficTraceRecord record{0, 0};
+    if (!absl::SimpleAtoi(absl::StripAsciiWhitespace(fields.first),
+                          &record.cycle)) {
+      if (header_allowed) {
+        header_allowed = false;
+        continue;
+      }
+      return absl::InvalidArgumentError(
+          absl::StrFormat("%s:%d: invalid cycle \"%s\"", csv_path.string(),
+                          line_number, fields.first));
+    }
+    header_allowed = false;
+    absl::string_view size_field = absl::StripAsciiWhitespace(fields.second);
+    if (!size_field.empty() &&
+        !absl::SimpleAtoi(size_field, &record.packet_size_bits)) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("%s:%d: invalid packet size \"%s\"",
+                          csv_path.string(), line_number, size_field));
+    }
+
+    absl::Status status = writer.Add(record);
+    if (!status.ok()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "%s:%d: %s", csv_path.string(), line_number, status.message()));
+    }
+  }
+
+  XLS_RETURN_IF_ERROR(writer.Close());
+  return writer.record_count();
+}
+
+}  // namespace xls::noc
@@ -0,0 +1,125 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_NOC_SIMULATION_TRAFFIC_TRACE_H_
+#define XLS_NOC_SIMULATION_TRAFFIC_TRACE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "xls/common/file/mapped_file.h"
+
+// This file contains classes used to store and read traces of the packets
+// sent by a single traffic flow.
+//
+// A trace file consists of the 8-byte magic kTrafficTraceMagic followed by
+// one record per packet, ordered by cycle.  Each record is two unsigned
+// LEB128 varints:
+//   - the cycle the packet is sent on, minus the cycle of the previous
+//     record (or minus zero for the first record), and
+//   - the size of the packet in bits, or 0 to use the packet size of the
+//     flow replaying the trace.  Packets may not be larger than the packet
+//     size of the flow.
+//
+// Packets sent close together thus take two to three bytes each.
+
+namespace xls::noc {
+
+inline constexpr absl::string_view kTrafficTraceMagic("XLSNOCT1", 8);
+
+// A single packet of a trace.
+struct TrafficTraceRecord {
+  int64_t cycle;
+
+  // Size of the packet in bits, 0 if unspecified.
+  int64_t packet_size_bits;
+};
+
+// Writes a trace file, buffering records in memory so that the file is
+// written in large chunks.
+class TrafficTraceWriter {
+ public:
+  // Creates (or truncates) the trace file at path.
+  static absl::StatusOr<TrafficTraceWriter> Create(
+      const std::filesystem::path& path);
+
+  // Appends a record.  Records must be added in order of increasing cycle.
+  absl::Status Add(const TrafficTraceRecord& record);
+
+  // Writes out any buffered records.  Must be called once all records are
+  // added.
+  absl::Status Close();
+
+  int64_t record_count() const { return record_count_; }
+
+ private:
+  // Number of bytes buffered before being appended to the file.
+  static constexpr int64_t kFlushSize = 1 << 20;
+
+  explicit TrafficTraceWriter(const std::filesystem::path& path)
+      : path_(path) {}
+
+  absl::Status Flush();
+
+  std::filesystem::path path_;
+  std::string buffer_;
+  int64_t last_cycle_ = 0;
+  int64_t record_count_ = 0;
+};
+
+// Reads the records of a trace file one at a time.
+//
+// The file is memory-mapped rather than read into memory, so traces much
+// larger than memory can be replayed.
+class TrafficTraceReader {
+ public:
+  static absl::StatusOr<TrafficTraceReader> Open(
+      const std::filesystem::path& path);
+
+  // Returns the next record of the trace, or absl::nullopt once all records
+  // have been read.
+  absl::StatusOr<absl::optional<TrafficTraceRecord>> Next();
+
+ private:
+  explicit TrafficTraceReader(MappedFile file)
+      : file_(std::move(file)), position_(kTrafficTraceMagic.size()) {}
+
+  absl::StatusOr<uint64_t> ReadVarint();
+
+  MappedFile file_;
+  int64_t position_;
+  int64_t last_cycle_ = 0;
+};
+
+// Converts a trace in CSV format into a trace file.
+//
+// Each line of the CSV file describes a packet as
+//   cycle[,packet_size_bits]
+// in order of increasing cycle.  Empty lines, lines starting with '#' and
+// a header line (a first line not starting with a number) are ignored.
+//
+// Returns the number of packets written.
+absl::StatusOr<int64_t> ConvertCsvToTrafficTrace(
+    const std::filesystem::path& csv_path,
+    const std::filesystem::path& trace_path);
+
+}  // namespace xls::noc
+
+#endif  // XLS_NOC_SIMULATION_TRAFFIC_TRACE_H_
@@ -0,0 +1,166 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/noc/simulation/traffic_trace.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls::noc {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+// Reads all the records of the trace at path.
+absl::StatusOr<std::vector<std::pair<int64_t, int64_t>>> ReadTrace(
+    const std::filesystem::path& path) {
+  XLS_ASSIGN_OR_RETURN(TrafficTraceReader reader,
+                       TrafficTraceReader::Open(path));
+  std::vector<std::pair<int64_t, int64_t>> records;
+  while (true) {
+    XLS_ASSIGN_OR_RETURN(absl::optional<TrafficTraceRecord> record,
+                         reader.Next());
+    if (!record.has_value()) {
+      return records;
+    }
+    records.push_back({record->cycle, record->packet_size_bits});
+  }
+}
+
+TEST(TrafficTraceTest, WriteAndRead) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile trace, TempFile::Create(".trace"));
+
+  // Cycle deltas and sizes needing one, two and many varint bytes.
+  std::vector<std::pair<int64_t, int64_t>> expected = {
+      {0, 0},         {0, 64},
+      {1, 128},       {200, 0},
+      {200, 100'000}, {int64_t{1} << 40, 0},
+      {(int64_t{1} << 40) + 1, 1}};
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficTraceWriter writer,
+                           TrafficTraceWriter::Create(trace.path()));
+  for (auto [cycle, size] : expected) {
+    XLS_ASSERT_OK(writer.Add({cycle, size}));
+  }
+  XLS_ASSERT_OK(writer.Close());
+  EXPECT_EQ(writer.record_count(), expected.size());
+
+  EXPECT_THAT(ReadTrace(trace.path()), IsOkAndHolds(expected));
+}
+
+TEST(TrafficTraceTest, LargeTraceIsCompact) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile trace, TempFile::Create(".trace"));
+
+  // Enough records for the writer to flush several times.
+  constexpr int64_t kRecordCount = 1'000'000;
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficTraceWriter writer,
+                           TrafficTraceWriter::Create(trace.path()));
+  for (int64_t i = 0; i < kRecordCount; ++i) {
+    XLS_ASSERT_OK(writer.Add({3 * i, 0}));
+  }
+  XLS_ASSERT_OK(writer.Close());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::string contents,
+                           GetFileContents(trace.path()));
+  EXPECT_EQ(contents.size(), kTrafficTraceMagic.size() + 2 * kRecordCount);
+
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficTraceReader reader,
+                           TrafficTraceReader::Open(trace.path()));
+  for (int64_t i = 0; i < kRecordCount; ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(absl::optional<TrafficTraceRecord> record,
+                             reader.Next());
+    ASSERT_TRUE(record.has_value());
+    ASSERT_EQ(record->cycle, 3 * i);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(absl::optional<TrafficTraceRecord> end,
+                           reader.Next());
+  EXPECT_FALSE(end.has_value());
+}
+
+TEST(TrafficTraceTest, WriterRejectsOutOfOrderRecords) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile trace, TempFile::Create(".trace"));
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficTraceWriter writer,
+                           TrafficTraceWriter::Create(trace.path()));
+  XLS_ASSERT_OK(writer.Add({5, 0}));
+  EXPECT_THAT(writer.Add({4, 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("increasing cycle")));
+  EXPECT_THAT(writer.Add({5, -1}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("packet size")));
+}
+
+TEST(TrafficTraceTest, ReaderRejectsInvalidFiles) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile not_a_trace,
+                           TempFile::CreateWithContent("0,64\n"));
+  EXPECT_THAT(TrafficTraceReader::Open(not_a_trace.path()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("not a traffic trace")));
+
+  // A record whose size varint is cut off.
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile truncated,
+                           TempFile::CreateWithContent(
+                               absl::StrCat(kTrafficTraceMagic, "\x01\x80")));
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficTraceReader reader,
+                           TrafficTraceReader::Open(truncated.path()));
+  EXPECT_THAT(reader.Next(), StatusIs(absl::StatusCode::kInvalidArgument,
+                                      HasSubstr("Truncated")));
+}
+
+TEST(TrafficTraceTest, ConvertCsv) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile csv, TempFile::CreateWithContent(
+                                             "# Recorded traffic\n"
+                                             "cycle,size\n"
+                                             "0\n"
+                                             "3,64\r\n"
+                                             "\n"
+                                             " 3 , 32 \n"
+                                             "10,\n",
+                                             ".csv"));
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile trace, TempFile::Create(".trace"));
+
+  EXPECT_THAT(ConvertCsvToTrafficTrace(csv.path(), trace.path()),
+              IsOkAndHolds(4));
+  EXPECT_THAT(ReadTrace(trace.path()),
+              IsOkAndHolds(std::vector<std::pair<int64_t, int64_t>>(
+                  {{0, 0}, {3, 64}, {3, 32}, {10, 0}})));
+}
+
+TEST(TrafficTraceTest, ConvertCsvReportsLine) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile trace, TempFile::Create(".trace"));
+
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile bad_cycle,
+                           TempFile::CreateWithContent("0\n1\nfoo\n", ".csv"));
+  EXPECT_THAT(ConvertCsvToTrafficTrace(bad_cycle.path(), trace.path()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr(":3: invalid cycle")));
+
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile unordered,
+                           TempFile::CreateWithContent("5\n4\n", ".csv"));
+  EXPECT_THAT(ConvertCsvToTrafficTrace(unordered.path(), trace.path()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr(":2: Trace records must be in order")));
+}
+
+}  // namespace
+}  // namespace xls::noc
@@ -0,0 +1,152 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/aig.h"
+
+#include <algorithm>
+
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+namespace solvers {
+
+Aig::Aig() { nodes_.push_back({kNoFanin, kNoFanin}); }
+
+AigLiteral Aig::AddInput() {
+  AigLiteral input = NodeLiteral(nodes_.size());
+  nodes_.push_back({kNoFanin, kNoFanin});
+  inputs_.push_back(input);
+  return input;
+}
+
+AigLiteral Aig::And(AigLiteral a, AigLiteral b) {
+  XLS_DCHECK_LT(NodeIndex(a), node_count());
+  XLS_DCHECK_LT(NodeIndex(b), node_count());
+  if (a > b) {
+    std::swap(a, b);
+  }
+  if (a == kFalse) {
+    return kFalse;
+  }
+  if (a == kTrue) {
+    return b;
+  }
+  if (a == b) {
+    return a;
+  }
+  if (a == Not(b)) {
+    return kFalse;
+  }
+  return RewriteAnd(a, b);
+}
+
+AigLiteral Aig::RewriteAnd(AigLiteral a, AigLiteral b) {
+  // Rules for one operand being an AND (or NAND) of the other or its
+  // complement.
+  for (auto [x, y] : {std::make_pair(a, b), std::make_pair(b, a)}) {
+    if (!IsAnd(NodeIndex(x))) {
+      continue;
+    }
+    AigLiteral x0 = fanin0(NodeIndex(x));
+    AigLiteral x1 = fanin1(NodeIndex(x));
+    if (!IsComplemented(x)) {
+      // (x0 & x1) & x0 == x0 & x1; (x0 & x1) & !x0 == 0.
+      if (y == x0 || y == x1) {
+        return x;
+      }
+      if (y == Not(x0) || y == Not(x1)) {
+        return kFalse;
+      }
+    } else {
+      // !(x0 & x1) & !x0 == !x0; !(x0 & x1) & x0 == x0 & !x1.
+      if (y == Not(x0) || y == Not(x1)) {
+        return y;
+      }
+      if (y == x0) {
+        return And(y, Not(x1));
+      }
+      if (y == x1) {
+        return And(y, Not(x0));
+      }
+    }
+  }
+
+  // (a0 & a1) & (b0 & b1) == 0 if any a_i == !b_j.
+  if (!IsComplemented(a) && !IsComplemented(b) && IsAnd(NodeIndex(a)) &&
+      IsAnd(NodeIndex(b))) {
+    for (AigLiteral a_fanin : {fanin0(NodeIndex(a)), fanin1(NodeIndex(a))}) {
+      for (AigLiteral b_fanin : {fanin0(NodeIndex(b)), fanin1(NodeIndex(b))}) {
+        if (a_fanin == Not(b_fanin)) {
+          return kFalse;
+        }
+      }
+    }
+  }
+
+  auto [it, inserted] = strash_.insert({{a, b}, 0});
+  if (inserted) {
+    it->second = NodeLiteral(nodes_.size());
+    nodes_.push_back({a, b});
+  }
+  return it->second;
+}
+
+AigLiteral Aig::Xor(AigLiteral a, AigLiteral b) {
+  // Built as !(a & b) & !(!a & !b), so that XORs of the same operands (in
+  // either polarity) share their nodes.
+  return And(Not(And(a, b)), Not(And(Not(a), Not(b))));
+}
+
+AigLiteral Aig::Mux(AigLiteral selector, AigLiteral on_true,
+                    AigLiteral on_false) {
+  if (on_true == on_false) {
+    return on_true;
+  }
+  return Or(And(selector, on_true), And(Not(selector), on_false));
+}
+
+std::vector<uint64_t> Aig::Simulate(
+    absl::Span<const uint64_t> input_values) const {
+  XLS_CHECK_EQ(input_values.size(), inputs_.size());
+  std::vector<uint64_t> values(nodes_.size(), 0);
+  for (int64_t i = 0; i < inputs_.size(); ++i) {
+    values[NodeIndex(inputs_[i])] = input_values[i];
+  }
+  // Nodes are created after their fanins, so index order is topological.
+  for (int64_t i = 1; i < nodes_.size(); ++i) {
+    if (IsAnd(i)) {
+      values[i] = LiteralValue(values, nodes_[i].fanin0) &
+                  LiteralValue(values, nodes_[i].fanin1);
+    }
+  }
+  return values;
+}
+
+absl::InlinedVector<bool, 64> Aig::Evaluate(
+    absl::Span<const bool> input_values,
+    absl::Span<const AigLiteral> literals) const {
+  std::vector<uint64_t> input_words;
+  for (bool value : input_values) {
+    input_words.push_back(value ? 1 : 0);
+  }
+  std::vector<uint64_t> node_values = Simulate(input_words);
+  absl::InlinedVector<bool, 64> result;
+  for (AigLiteral literal : literals) {
+    result.push_back((LiteralValue(node_values, literal) & 1) != 0);
+  }
+  return result;
+}
+
+}  // namespace solvers
+}  // namespace xls
@@ -0,0 +1,115 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SOLVERS_AIG_H_
+#define XLS_SOLVERS_AIG_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/types/span.h"
+
+namespace xls {
+namespace solvers {
+
+// A reference to a node of an Aig, possibly complemented: the node's index
+// times two, plus one if complemented.
+using AigLiteral = uint32_t;
+
+// An And-Inverter Graph: a boolean circuit of two-input AND nodes over primary
+// inputs, with inversion expressed on the edges (i.e., in the literals). Node 0
+// is the constant false, so literal 0 is false and literal 1 is true.
+//
+// AND nodes are structurally hashed - requesting the AND of the same two
+// literals again returns the existing node - and simplified as they are
+// created: constants are propagated and, looking through one level of AND
+// fanins, redundant and contradictory conjunctions are folded (e.g.,
+// (a & b) & a is a & b, and (a & b) & !a is false). Equivalent logic built
+// from the same primitives therefore often reduces to the very same literal.
+class Aig {
+ public:
+  static constexpr AigLiteral kFalse = 0;
+  static constexpr AigLiteral kTrue = 1;
+
+  static AigLiteral Not(AigLiteral a) { return a ^ 1; }
+  static bool IsComplemented(AigLiteral a) { return (a & 1) != 0; }
+  static int64_t NodeIndex(AigLiteral a) { return a >> 1; }
+  static AigLiteral NodeLiteral(int64_t index) { return index << 1; }
+
+  Aig();
+
+  // Adds a new primary input and returns its (uncomplemented) literal.
+  AigLiteral AddInput();
+
+  AigLiteral And(AigLiteral a, AigLiteral b);
+  AigLiteral Or(AigLiteral a, AigLiteral b) { return Not(And(Not(a), Not(b))); }
+  AigLiteral Xor(AigLiteral a, AigLiteral b);
+  // Returns "selector ? on_true : on_false".
+  AigLiteral Mux(AigLiteral selector, AigLiteral on_true, AigLiteral on_false);
+
+  // The number of nodes, including the constant node and inputs.
+  int64_t node_count() const { return nodes_.size(); }
+  int64_t input_count() const { return inputs_.size(); }
+  int64_t and_count() const { return node_count() - input_count() - 1; }
+
+  // The literals of the primary inputs, in order of creation.
+  absl::Span<const AigLiteral> inputs() const { return inputs_; }
+
+  bool IsAnd(int64_t index) const { return nodes_[index].fanin0 != kNoFanin; }
+  // The fanins of an AND node, the lesser literal first.
+  AigLiteral fanin0(int64_t index) const { return nodes_[index].fanin0; }
+  AigLiteral fanin1(int64_t index) const { return nodes_[index].fanin1; }
+
+  // Evaluates the graph on 64 input vectors at once: bit i of each word of
+  // "input_values" (one per primary input) is the input's value in vector i.
+  // Returns a word per node, to be queried with LiteralValue().
+  std::vector<uint64_t> Simulate(absl::Span<const uint64_t> input_values) const;
+  static uint64_t LiteralValue(absl::Span<const uint64_t> node_values,
+                               AigLiteral a) {
+    uint64_t value = node_values[NodeIndex(a)];
+    return IsComplemented(a) ? ~value : value;
+  }
+
+  // Returns the values of "literals" for the given values of the primary
+  // inputs.
+  absl::InlinedVector<bool, 64> Evaluate(
+      absl::Span<const bool> input_values,
+      absl::Span<const AigLiteral> literals) const;
+
+ private:
+  // Fanin value marking the constant and input nodes.
+  static constexpr AigLiteral kNoFanin = ~AigLiteral{0};
+
+  struct Node {
+    AigLiteral fanin0;
+    AigLiteral fanin1;
+  };
+
+  // Returns the AND of "a" and "b" (a < b), which are neither constant nor
+  // each other's (possible) complements, using the rewrite rules over their
+  // fanins when those apply.
+  AigLiteral RewriteAnd(AigLiteral a, AigLiteral b);
+
+  std::vector<Node> nodes_;
+  std::vector<AigLiteral> inputs_;
+  absl::flat_hash_map<std::pair<AigLiteral, AigLiteral>, AigLiteral> strash_;
+};
+
+}  // namespace solvers
+}  // namespace xls
+
+#endif  // XLS_SOLVERS_AIG_H_
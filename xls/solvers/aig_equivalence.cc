@@ -0,0 +1,130 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/aig_equivalence.h"
+
+#include <random>
+#include <vector>
+
+#include "xls/common/logging/logging.h"
+#include "xls/solvers/sat_solver.h"
+
+namespace xls {
+namespace solvers {
+namespace {
+
+// Batches of 64 random input vectors simulated before resorting to SAT.
+constexpr int64_t kSimulationRounds = 16;
+
+}  // namespace
+
+AigEquivalenceResult CheckAigEquivalence(Aig* aig,
+                                         absl::Span<const AigLiteral> lhs,
+                                         absl::Span<const AigLiteral> rhs,
+                                         absl::Time deadline,
+                                         const std::atomic<bool>* interrupt) {
+  XLS_CHECK_EQ(lhs.size(), rhs.size());
+  AigEquivalenceResult result{AigEquivalence::kEquivalent};
+
+  // The miter: true wherever any pair differs.
+  AigLiteral miter = Aig::kFalse;
+  for (int64_t i = 0; i < lhs.size(); ++i) {
+    miter = aig->Or(miter, aig->Xor(lhs[i], rhs[i]));
+  }
+  if (miter == Aig::kFalse) {
+    return result;
+  }
+
+  std::mt19937_64 engine(0);
+  std::vector<uint64_t> input_words(aig->input_count());
+  for (int64_t round = 0; round < kSimulationRounds; ++round) {
+    for (uint64_t& word : input_words) {
+      word = engine();
+    }
+    uint64_t differs = Aig::LiteralValue(aig->Simulate(input_words), miter);
+    if (differs != 0) {
+      int64_t lane = 0;
+      while (((differs >> lane) & 1) == 0) {
+        ++lane;
+      }
+      result.outcome = AigEquivalence::kNotEquivalent;
+      for (uint64_t word : input_words) {
+        result.counterexample.push_back(((word >> lane) & 1) != 0);
+      }
+      return result;
+    }
+  }
+
+  // Encode the miter's cone - nodes are numbered after their fanins, so a
+  // reverse sweep from the miter finds it - one variable per node.
+  std::vector<bool> in_cone(aig->node_count(), false);
+  in_cone[Aig::NodeIndex(miter)] = true;
+  for (int64_t i = Aig::NodeIndex(miter); i > 0; --i) {
+    if (in_cone[i] && aig->IsAnd(i)) {
+      in_cone[Aig::NodeIndex(aig->fanin0(i))] = true;
+      in_cone[Aig::NodeIndex(aig->fanin1(i))] = true;
+    }
+  }
+  SatSolver solver;
+  std::vector<int64_t> variables(aig->node_count(), -1);
+  auto to_sat = [&](AigLiteral literal) {
+    SatLiteral positive =
+        SatSolver::PositiveLiteral(variables[Aig::NodeIndex(literal)]);
+    return Aig::IsComplemented(literal) ? SatSolver::Negate(positive)
+                                        : positive;
+  };
+  for (int64_t i = 0; i < aig->node_count(); ++i) {
+    if (!in_cone[i]) {
+      continue;
+    }
+    variables[i] = solver.AddVariable();
+    if (i == 0) {
+      // Node 0 is the constant; its positive literal is kFalse.
+      solver.AddClause({SatSolver::Negate(to_sat(Aig::kFalse))});
+    } else if (aig->IsAnd(i)) {
+      // node == fanin0 & fanin1.
+      SatLiteral node = to_sat(Aig::NodeLiteral(i));
+      SatLiteral a = to_sat(aig->fanin0(i));
+      SatLiteral b = to_sat(aig->fanin1(i));
+      solver.AddClause({SatSolver::Negate(node), a});
+      solver.AddClause({SatSolver::Negate(node), b});
+      solver.AddClause({node, SatSolver::Negate(a), SatSolver::Negate(b)});
+    }
+  }
+  solver.AddClause({to_sat(miter)});
+
+  SatSolver::Result sat_result = solver.Solve({}, deadline, interrupt);
+  result.sat_variable_count = solver.variable_count();
+  result.sat_conflict_count = solver.conflict_count();
+  switch (sat_result) {
+    case SatSolver::Result::kUnsatisfiable:
+      break;
+    case SatSolver::Result::kUnknown:
+      result.outcome = AigEquivalence::kUnknown;
+      break;
+    case SatSolver::Result::kSatisfiable:
+      // Inputs outside the cone don't matter.
+      result.outcome = AigEquivalence::kNotEquivalent;
+      for (AigLiteral input : aig->inputs()) {
+        int64_t variable = variables[Aig::NodeIndex(input)];
+        result.counterexample.push_back(variable >= 0 &&
+                                        solver.ModelValue(variable));
+      }
+      break;
+  }
+  return result;
+}
+
+}  // namespace solvers
+}  // namespace xls
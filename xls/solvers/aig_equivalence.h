@@ -0,0 +1,65 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SOLVERS_AIG_EQUIVALENCE_H_
+#define XLS_SOLVERS_AIG_EQUIVALENCE_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xls/solvers/aig.h"
+
+namespace xls {
+namespace solvers {
+
+enum class AigEquivalence {
+  kEquivalent,
+  kNotEquivalent,
+  // The deadline passed (or the check was interrupted) before an answer was
+  // found.
+  kUnknown,
+};
+
+struct AigEquivalenceResult {
+  AigEquivalence outcome;
+
+  // For kNotEquivalent, values of the graph's primary inputs (in order) for
+  // which the compared literals differ.
+  absl::InlinedVector<bool, 64> counterexample;
+
+  // The size of the SAT problem solved (if any) and the conflicts it took.
+  int64_t sat_variable_count = 0;
+  int64_t sat_conflict_count = 0;
+};
+
+// Determines whether "lhs[i]" and "rhs[i]" are equal for every i under all
+// values of the graph's inputs, giving up at "deadline". Pairs which
+// structural hashing reduced to the same literal need no further work; a
+// difference in the rest is looked for by random simulation and, failing
+// that, decided by the SatSolver on the (Tseitin) encoding of just the logic
+// they depend on. Adds the comparison logic to "aig". Setting "interrupt" (if
+// given) from another thread abandons the check.
+AigEquivalenceResult CheckAigEquivalence(
+    Aig* aig, absl::Span<const AigLiteral> lhs,
+    absl::Span<const AigLiteral> rhs,
+    absl::Time deadline = absl::InfiniteFuture(),
+    const std::atomic<bool>* interrupt = nullptr);
+
+}  // namespace solvers
+}  // namespace xls
+
+#endif  // XLS_SOLVERS_AIG_EQUIVALENCE_H_
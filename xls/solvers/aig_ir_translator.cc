@@ -0,0 +1,284 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/aig_ir_translator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/abstract_evaluator.h"
+#include "xls/ir/abstract_node_evaluator.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/nodes.h"
+
+namespace xls {
+namespace solvers {
+
+// Evaluator building the logic of IR operations out of AIG nodes.
+class AigEvaluator : public AbstractEvaluator<AigLiteral, AigEvaluator> {
+ public:
+  explicit AigEvaluator(Aig* aig) : aig_(aig) {}
+
+  AigLiteral One() const { return Aig::kTrue; }
+  AigLiteral Zero() const { return Aig::kFalse; }
+  AigLiteral Not(const AigLiteral& input) const { return Aig::Not(input); }
+  AigLiteral And(const AigLiteral& a, const AigLiteral& b) const {
+    return aig_->And(a, b);
+  }
+  AigLiteral Or(const AigLiteral& a, const AigLiteral& b) const {
+    return aig_->Or(a, b);
+  }
+
+ private:
+  Aig* aig_;
+};
+
+AigIrTranslator::AigIrTranslator(
+    Aig* aig, absl::flat_hash_map<const Node*, Vector> bindings)
+    : aig_(aig),
+      evaluator_(std::make_unique<AigEvaluator>(aig)),
+      translations_(std::move(bindings)) {}
+
+AigIrTranslator::~AigIrTranslator() = default;
+
+absl::StatusOr<AigIrTranslator::Vector> AigIrTranslator::Translate(
+    Node* node) {
+  // A post-order walk over the untranslated nodes "node" depends on, with an
+  // explicit stack as the IR may be very deep.
+  std::vector<std::pair<Node*, int64_t>> stack = {{node, 0}};
+  while (!stack.empty()) {
+    auto& [current, next_operand] = stack.back();
+    if (translations_.contains(current)) {
+      stack.pop_back();
+      continue;
+    }
+    if (next_operand < current->operand_count()) {
+      Node* operand = current->operand(next_operand++);
+      if (!translations_.contains(operand)) {
+        stack.push_back({operand, 0});
+      }
+      continue;
+    }
+    Node* ready = current;
+    stack.pop_back();
+    XLS_RETURN_IF_ERROR(TranslateNode(ready));
+  }
+  return translations_.at(node);
+}
+
+absl::Status AigIrTranslator::TranslateNode(Node* node) {
+  std::vector<Vector> operands;
+  for (Node* operand : node->operands()) {
+    operands.push_back(translations_.at(operand));
+  }
+  XLS_ASSIGN_OR_RETURN(
+      Vector result,
+      AbstractEvaluate(node, operands, evaluator_.get(),
+                       [this](Node* node) { return HandleSpecialOps(node); }));
+  XLS_RETURN_IF_ERROR(special_op_status_);
+  translations_[node] = std::move(result);
+  return absl::OkStatus();
+}
+
+AigIrTranslator::Vector AigIrTranslator::HandleSpecialOps(Node* node) {
+  switch (node->op()) {
+    case Op::kAfterAll:
+    case Op::kAssert:
+    case Op::kCover:
+      // Tokens have no bits; assertions aren't checked.
+      return Vector();
+    case Op::kArray:
+    case Op::kArrayConcat:
+    case Op::kTuple: {
+      Vector result;
+      for (const Node* operand : node->operands()) {
+        const Vector& bits = translations_.at(operand);
+        result.insert(result.end(), bits.begin(), bits.end());
+      }
+      return result;
+    }
+    case Op::kArrayIndex: {
+      ArrayIndex* array_index = node->As<ArrayIndex>();
+      return IndexArray(array_index->array()->GetType(),
+                        translations_.at(array_index->array()),
+                        array_index->indices());
+    }
+    case Op::kArrayUpdate: {
+      ArrayUpdate* array_update = node->As<ArrayUpdate>();
+      return UpdateArray(array_update->GetType(),
+                         translations_.at(array_update->array_to_update()),
+                         array_update->indices(),
+                         translations_.at(array_update->update_value()));
+    }
+    case Op::kDynamicBitSlice: {
+      DynamicBitSlice* slice = node->As<DynamicBitSlice>();
+      const Vector& input = translations_.at(slice->operand(0));
+      // Bits past the end of the input are zero.
+      Vector extended = evaluator_->ZeroExtend(
+          input, std::max<int64_t>(input.size(), slice->width()));
+      return evaluator_->BitSlice(
+          evaluator_->ShiftRightLogical(extended,
+                                        translations_.at(slice->operand(1))),
+          0, slice->width());
+    }
+    case Op::kGate: {
+      // A set condition gates the data to zero.
+      Gate* gate = node->As<Gate>();
+      AigLiteral pass = Aig::Not(translations_.at(gate->condition())[0]);
+      Vector result;
+      for (AigLiteral bit : translations_.at(gate->data())) {
+        result.push_back(aig_->And(pass, bit));
+      }
+      return result;
+    }
+    case Op::kLiteral:
+      return FlattenValue(node->As<Literal>()->value());
+    case Op::kParam: {
+      Vector result;
+      for (int64_t i = 0; i < node->GetType()->GetFlatBitCount(); ++i) {
+        result.push_back(aig_->AddInput());
+      }
+      return result;
+    }
+    case Op::kTupleIndex: {
+      TupleIndex* tuple_index = node->As<TupleIndex>();
+      TupleType* tuple_type = node->operand(0)->GetType()->AsTupleOrDie();
+      int64_t start = 0;
+      for (int64_t i = 0; i < tuple_index->index(); ++i) {
+        start += tuple_type->element_type(i)->GetFlatBitCount();
+      }
+      return evaluator_->BitSlice(translations_.at(node->operand(0)), start,
+                                  node->GetType()->GetFlatBitCount());
+    }
+    default:
+      special_op_status_ = absl::UnimplementedError(absl::StrFormat(
+          "Unsupported op for AIG translation: %s", node->ToString()));
+      return Vector(node->GetType()->GetFlatBitCount(), Aig::kFalse);
+  }
+}
+
+AigIrTranslator::Vector AigIrTranslator::IndexArray(
+    const Type* type, absl::Span<const AigLiteral> array,
+    absl::Span<Node* const> indices) {
+  if (indices.empty()) {
+    return Vector(array.begin(), array.end());
+  }
+  const ArrayType* array_type = type->AsArrayOrDie();
+  const Type* element_type = array_type->element_type();
+  int64_t element_size = element_type->GetFlatBitCount();
+  const Vector& index = translations_.at(indices[0]);
+
+  Vector selector;
+  std::vector<Vector> cases;
+  for (int64_t i = 0; i < array_type->size(); ++i) {
+    selector.push_back(IndexEquals(index, i));
+    cases.push_back(IndexArray(element_type,
+                               array.subspan(i * element_size, element_size),
+                               indices.subspan(1)));
+  }
+  // Out-of-bounds indices select the last element.
+  AigLiteral any_earlier = Aig::kFalse;
+  for (int64_t i = 0; i + 1 < selector.size(); ++i) {
+    any_earlier = aig_->Or(any_earlier, selector[i]);
+  }
+  selector.back() = Aig::Not(any_earlier);
+  return evaluator_->OneHotSelect(selector, cases,
+                                  /*selector_can_be_zero=*/false);
+}
+
+AigIrTranslator::Vector AigIrTranslator::UpdateArray(
+    const Type* type, absl::Span<const AigLiteral> array,
+    absl::Span<Node* const> indices, const Vector& value) {
+  if (indices.empty()) {
+    return value;
+  }
+  const ArrayType* array_type = type->AsArrayOrDie();
+  const Type* element_type = array_type->element_type();
+  int64_t element_size = element_type->GetFlatBitCount();
+  const Vector& index = translations_.at(indices[0]);
+
+  // Out-of-bounds updates leave the array unchanged.
+  Vector result;
+  for (int64_t i = 0; i < array_type->size(); ++i) {
+    absl::Span<const AigLiteral> element =
+        array.subspan(i * element_size, element_size);
+    Vector updated =
+        UpdateArray(element_type, element, indices.subspan(1), value);
+    AigLiteral selected = IndexEquals(index, i);
+    for (int64_t bit = 0; bit < element_size; ++bit) {
+      result.push_back(aig_->Mux(selected, updated[bit], element[bit]));
+    }
+  }
+  return result;
+}
+
+AigIrTranslator::Vector AigIrTranslator::FlattenValue(const Value& value) {
+  if (value.IsBits()) {
+    return evaluator_->BitsToVector(value.bits());
+  }
+  Vector result;
+  for (const Value& element : value.elements()) {
+    Vector bits = FlattenValue(element);
+    result.insert(result.end(), bits.begin(), bits.end());
+  }
+  return result;
+}
+
+AigLiteral AigIrTranslator::IndexEquals(const Vector& index, int64_t value) {
+  if (index.size() < Bits::MinBitCountUnsigned(value)) {
+    return Aig::kFalse;
+  }
+  return evaluator_->Equals(index,
+                            evaluator_->BitsToVector(UBits(value, index.size())));
+}
+
+Value AigIrTranslator::UnflattenValue(const Type* type,
+                                      absl::Span<const bool> bits) {
+  switch (type->kind()) {
+    case TypeKind::kBits:
+      return Value(Bits(bits));
+    case TypeKind::kArray: {
+      const ArrayType* array_type = type->AsArrayOrDie();
+      int64_t element_size = array_type->element_type()->GetFlatBitCount();
+      std::vector<Value> elements;
+      for (int64_t i = 0; i < array_type->size(); ++i) {
+        elements.push_back(
+            UnflattenValue(array_type->element_type(),
+                           bits.subspan(i * element_size, element_size)));
+      }
+      return Value::ArrayOrDie(elements);
+    }
+    case TypeKind::kTuple: {
+      const TupleType* tuple_type = type->AsTupleOrDie();
+      std::vector<Value> elements;
+      int64_t offset = 0;
+      for (const Type* element_type : tuple_type->element_types()) {
+        int64_t element_size = element_type->GetFlatBitCount();
+        elements.push_back(
+            UnflattenValue(element_type, bits.subspan(offset, element_size)));
+        offset += element_size;
+      }
+      return Value::Tuple(elements);
+    }
+    case TypeKind::kToken:
+      return Value::Token();
+  }
+  XLS_LOG(FATAL) << "Unsupported type kind: " << type->kind();
+}
+
+}  // namespace solvers
+}  // namespace xls
@@ -0,0 +1,90 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SOLVERS_AIG_IR_TRANSLATOR_H_
+#define XLS_SOLVERS_AIG_IR_TRANSLATOR_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/ir/node.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/solvers/aig.h"
+
+namespace xls {
+namespace solvers {
+
+class AigEvaluator;
+
+// Translates XLS IR nodes into bit-level logic in an Aig, much as the
+// Booleanifier translates them into single-bit IR operations. Values are held
+// flattened: the elements of tuples and arrays in order, and each bits value
+// least significant bit first.
+//
+// Translation is on demand: translating a node translates the nodes it depends
+// on (once), so only the logic actually compared ends up in the graph.
+// Invokes, maps and loops aren't supported; they must be inlined or unrolled
+// first.
+class AigIrTranslator {
+ public:
+  // The flattened bits of a value, as in AbstractEvaluator.
+  using Vector = std::vector<AigLiteral>;
+
+  // "bindings" gives the (flattened) bits to use for nodes in place of their
+  // translations, e.g., the parameters of another function being compared, or
+  // the inputs of a pipeline stage. Parameters without bindings become new
+  // inputs of "aig".
+  explicit AigIrTranslator(
+      Aig* aig, absl::flat_hash_map<const Node*, Vector> bindings = {});
+  ~AigIrTranslator();
+
+  // Returns the bits of "node", translating it if need be.
+  absl::StatusOr<Vector> Translate(Node* node);
+
+  // Rebuilds a value of "type" from its flattened bits.
+  static Value UnflattenValue(const Type* type, absl::Span<const bool> bits);
+
+ private:
+  // Translates "node", whose operands have been translated.
+  absl::Status TranslateNode(Node* node);
+
+  // Handles the ops AbstractEvaluate() leaves to its default handler.
+  Vector HandleSpecialOps(Node* node);
+  Vector IndexArray(const Type* type, absl::Span<const AigLiteral> array,
+                    absl::Span<Node* const> indices);
+  Vector UpdateArray(const Type* type, absl::Span<const AigLiteral> array,
+                     absl::Span<Node* const> indices, const Vector& value);
+  Vector FlattenValue(const Value& value);
+
+  // Returns whether the unsigned "index" equals "value", which may be too
+  // large for its width.
+  AigLiteral IndexEquals(const Vector& index, int64_t value);
+
+  Aig* aig_;
+  std::unique_ptr<AigEvaluator> evaluator_;
+  absl::flat_hash_map<const Node*, Vector> translations_;
+
+  // The error raised by HandleSpecialOps(), which can't return a status.
+  absl::Status special_op_status_;
+};
+
+}  // namespace solvers
+}  // namespace xls
+
+#endif  // XLS_SOLVERS_AIG_IR_TRANSLATOR_H_
@@ -0,0 +1,207 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/aig_ir_translator.h"
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/function_interpreter.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/solvers/aig.h"
+#include "xls/solvers/aig_equivalence.h"
+
+namespace xls {
+namespace solvers {
+namespace {
+
+using status_testing::StatusIs;
+
+class AigIrTranslatorTest : public IrTestBase {};
+
+// Appends the bits of "value" in the translator's flattened order.
+void FlattenValue(const Value& value, std::vector<bool>* bits) {
+  if (value.IsBits()) {
+    for (int64_t i = 0; i < value.bits().bit_count(); ++i) {
+      bits->push_back(value.bits().Get(i));
+    }
+    return;
+  }
+  for (const Value& element : value.elements()) {
+    FlattenValue(element, bits);
+  }
+}
+
+// Binds each parameter of "f" to new inputs of "aig", in parameter order.
+absl::flat_hash_map<const Node*, AigIrTranslator::Vector> BindParams(
+    Function* f, Aig* aig) {
+  absl::flat_hash_map<const Node*, AigIrTranslator::Vector> bindings;
+  for (Param* param : f->params()) {
+    AigIrTranslator::Vector& bits = bindings[param];
+    for (int64_t i = 0; i < param->GetType()->GetFlatBitCount(); ++i) {
+      bits.push_back(aig->AddInput());
+    }
+  }
+  return bindings;
+}
+
+// Checks that the translation of "f" computes what the interpreter does for
+// each of "args".
+void ExpectMatchesInterpreter(Function* f,
+                              absl::Span<const std::vector<Value>> args) {
+  Aig aig;
+  AigIrTranslator translator(&aig, BindParams(f, &aig));
+  XLS_ASSERT_OK_AND_ASSIGN(AigIrTranslator::Vector result,
+                           translator.Translate(f->return_value()));
+  for (const std::vector<Value>& arg_set : args) {
+    std::vector<bool> input_values;
+    for (const Value& arg : arg_set) {
+      FlattenValue(arg, &input_values);
+    }
+    absl::InlinedVector<bool, 64> input_bits(input_values.begin(),
+                                             input_values.end());
+    absl::InlinedVector<bool, 64> output_bits =
+        aig.Evaluate(input_bits, result);
+    XLS_ASSERT_OK_AND_ASSIGN(Value expected, InterpretFunction(f, arg_set));
+    EXPECT_EQ(AigIrTranslator::UnflattenValue(f->return_value()->GetType(),
+                                              output_bits),
+              expected);
+  }
+}
+
+TEST_F(AigIrTranslatorTest, Arithmetic) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8], y: bits[8]) -> (bits[8], bits[8], bits[1], bits[8]) {
+  add.1: bits[8] = add(x, y)
+  umul.2: bits[8] = umul(x, y)
+  slt.3: bits[1] = slt(x, y)
+  shrl.4: bits[8] = shrl(x, y)
+  ret tuple.5: (bits[8], bits[8], bits[1], bits[8]) = tuple(add.1, umul.2, slt.3, shrl.4)
+}
+)",
+                                                       p.get()));
+  ExpectMatchesInterpreter(f, {{Value(UBits(0, 8)), Value(UBits(0, 8))},
+                               {Value(UBits(200, 8)), Value(UBits(100, 8))},
+                               {Value(UBits(3, 8)), Value(UBits(255, 8))},
+                               {Value(UBits(129, 8)), Value(UBits(2, 8))}});
+}
+
+TEST_F(AigIrTranslatorTest, ArraysAndTuples) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(a: bits[4][3], i: bits[2], t: (bits[4], bits[3])) -> (bits[4], bits[4][3], bits[2]) {
+  array_index.1: bits[4] = array_index(a, indices=[i])
+  tuple_index.2: bits[4] = tuple_index(t, index=0)
+  tuple_index.3: bits[3] = tuple_index(t, index=1)
+  array_update.4: bits[4][3] = array_update(a, tuple_index.2, indices=[i])
+  dynamic_bit_slice.5: bits[2] = dynamic_bit_slice(tuple_index.2, tuple_index.3, width=2)
+  ret tuple.6: (bits[4], bits[4][3], bits[2]) = tuple(array_index.1, array_update.4, dynamic_bit_slice.5)
+}
+)",
+                                                       p.get()));
+  Value array = Value::UBitsArray({1, 2, 3}, 4).value();
+  std::vector<std::vector<Value>> args;
+  for (int64_t i = 0; i < 4; ++i) {
+    for (int64_t offset = 0; offset < 8; offset += 3) {
+      args.push_back({array, Value(UBits(i, 2)),
+                      Value::Tuple({Value(UBits(0b1011, 4)),
+                                    Value(UBits(offset, 3))})});
+    }
+  }
+  ExpectMatchesInterpreter(f, args);
+}
+
+TEST_F(AigIrTranslatorTest, ProvesEquivalence) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[16], y: bits[16]) -> bits[16] {
+  literal.1: bits[16] = literal(value=2)
+  umul.2: bits[16] = umul(x, literal.1)
+  ret sub.3: bits[16] = sub(umul.2, y)
+}
+)",
+                                                       p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * g, ParseFunction(R"(
+fn g(x: bits[16], y: bits[16]) -> bits[16] {
+  add.1: bits[16] = add(x, x)
+  neg.2: bits[16] = neg(y)
+  ret add.3: bits[16] = add(add.1, neg.2)
+}
+)",
+                                                       p.get()));
+  Aig aig;
+  absl::flat_hash_map<const Node*, AigIrTranslator::Vector> f_bindings =
+      BindParams(f, &aig);
+  absl::flat_hash_map<const Node*, AigIrTranslator::Vector> g_bindings;
+  for (int64_t i = 0; i < f->params().size(); ++i) {
+    g_bindings[g->param(i)] = f_bindings.at(f->param(i));
+  }
+  AigIrTranslator f_translator(&aig, f_bindings);
+  AigIrTranslator g_translator(&aig, g_bindings);
+  XLS_ASSERT_OK_AND_ASSIGN(AigIrTranslator::Vector lhs,
+                           f_translator.Translate(f->return_value()));
+  XLS_ASSERT_OK_AND_ASSIGN(AigIrTranslator::Vector rhs,
+                           g_translator.Translate(g->return_value()));
+  EXPECT_EQ(CheckAigEquivalence(&aig, lhs, rhs).outcome,
+            AigEquivalence::kEquivalent);
+}
+
+TEST_F(AigIrTranslatorTest, FindsCounterexample) {
+  auto p = CreatePackage();
+  // Differs from x only when x is 0xffff.
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[16]) -> bits[16] {
+  literal.1: bits[16] = literal(value=0xffff)
+  literal.2: bits[16] = literal(value=0)
+  eq.3: bits[1] = eq(x, literal.1)
+  ret sel.4: bits[16] = sel(eq.3, cases=[x, literal.2])
+}
+)",
+                                                       p.get()));
+  Aig aig;
+  AigIrTranslator translator(&aig);
+  XLS_ASSERT_OK_AND_ASSIGN(AigIrTranslator::Vector lhs,
+                           translator.Translate(f->return_value()));
+  XLS_ASSERT_OK_AND_ASSIGN(AigIrTranslator::Vector rhs,
+                           translator.Translate(f->param(0)));
+  AigEquivalenceResult result = CheckAigEquivalence(&aig, lhs, rhs);
+  ASSERT_EQ(result.outcome, AigEquivalence::kNotEquivalent);
+  EXPECT_EQ(AigIrTranslator::UnflattenValue(f->param(0)->GetType(),
+                                            result.counterexample),
+            Value(UBits(0xffff, 16)));
+}
+
+TEST_F(AigIrTranslatorTest, UnsupportedOp) {
+  auto p = CreatePackage();
+  FunctionBuilder sub_builder("sub", p.get());
+  sub_builder.Param("x", p->GetBitsType(8));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * sub, sub_builder.Build());
+  FunctionBuilder b("f", p.get());
+  b.Invoke({b.Param("x", p->GetBitsType(8))}, sub);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+
+  Aig aig;
+  AigIrTranslator translator(&aig);
+  EXPECT_THAT(translator.Translate(f->return_value()),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+}  // namespace
+}  // namespace solvers
+}  // namespace xls
@@ -0,0 +1,80 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/aig.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace xls {
+namespace solvers {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(AigTest, ConstantsFold) {
+  Aig aig;
+  AigLiteral a = aig.AddInput();
+  EXPECT_EQ(aig.And(a, Aig::kFalse), Aig::kFalse);
+  EXPECT_EQ(aig.And(Aig::kTrue, a), a);
+  EXPECT_EQ(aig.And(a, a), a);
+  EXPECT_EQ(aig.And(a, Aig::Not(a)), Aig::kFalse);
+  EXPECT_EQ(aig.Or(a, Aig::Not(a)), Aig::kTrue);
+  EXPECT_EQ(aig.Xor(a, a), Aig::kFalse);
+  EXPECT_EQ(aig.Mux(a, Aig::kTrue, Aig::kFalse), a);
+  EXPECT_EQ(aig.and_count(), 0);
+}
+
+TEST(AigTest, StructurallyHashed) {
+  Aig aig;
+  AigLiteral a = aig.AddInput();
+  AigLiteral b = aig.AddInput();
+  AigLiteral ab = aig.And(a, b);
+  EXPECT_EQ(aig.And(b, a), ab);
+  EXPECT_EQ(aig.Xor(a, b), aig.Xor(b, a));
+  EXPECT_EQ(aig.Xor(Aig::Not(a), Aig::Not(b)), aig.Xor(a, b));
+  EXPECT_EQ(aig.and_count(), 3);
+}
+
+TEST(AigTest, RewritesThroughOneLevel) {
+  Aig aig;
+  AigLiteral a = aig.AddInput();
+  AigLiteral b = aig.AddInput();
+  AigLiteral c = aig.AddInput();
+  AigLiteral ab = aig.And(a, b);
+  EXPECT_EQ(aig.And(ab, a), ab);
+  EXPECT_EQ(aig.And(ab, Aig::Not(b)), Aig::kFalse);
+  EXPECT_EQ(aig.And(Aig::Not(ab), Aig::Not(a)), Aig::Not(a));
+  EXPECT_EQ(aig.And(Aig::Not(ab), a), aig.And(a, Aig::Not(b)));
+  EXPECT_EQ(aig.And(ab, aig.And(Aig::Not(a), c)), Aig::kFalse);
+}
+
+TEST(AigTest, Simulate) {
+  Aig aig;
+  AigLiteral a = aig.AddInput();
+  AigLiteral b = aig.AddInput();
+  AigLiteral x = aig.Xor(a, b);
+  AigLiteral m = aig.Mux(a, b, Aig::Not(b));
+  std::vector<uint64_t> values = aig.Simulate({0b0011, 0b0101});
+  EXPECT_EQ(Aig::LiteralValue(values, x) & 0xf, 0b0110);
+  EXPECT_EQ(Aig::LiteralValue(values, m) & 0xf, 0b1001);
+  EXPECT_EQ(Aig::LiteralValue(values, Aig::kTrue) & 0xf, 0b1111);
+
+  EXPECT_THAT(aig.Evaluate({true, false}, {x, m, Aig::kFalse}),
+              ElementsAre(true, false, false));
+}
+
+}  // namespace
+}  // namespace solvers
+}  // namespace xls
@@ -0,0 +1,445 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/sat_solver.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/time/clock.h"
+
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+namespace solvers {
+namespace {
+
+constexpr double kVariableDecay = 0.95;
+constexpr double kClauseDecay = 0.999;
+constexpr double kRescaleLimit = 1e100;
+constexpr int64_t kRestartBase = 100;
+// The deadline and interrupt are only checked every this many conflicts.
+constexpr int64_t kDeadlineCheckInterval = 256;
+
+// Returns element "i" (zero-based) of the Luby sequence 1, 1, 2, 1, 1, 2, 4,
+// 1, 1, 2, 1, 1, 2, 4, 8, ...
+int64_t Luby(int64_t i) {
+  int64_t size = 1;
+  int64_t power = 0;
+  while (size < i + 1) {
+    ++power;
+    size = 2 * size + 1;
+  }
+  while (size - 1 != i) {
+    size = (size - 1) / 2;
+    --power;
+    i = i % size;
+  }
+  return int64_t{1} << power;
+}
+
+}  // namespace
+
+int64_t SatSolver::AddVariable() {
+  int64_t variable = values_.size();
+  values_.push_back(kUndef);
+  levels_.push_back(0);
+  reasons_.push_back(kNoReason);
+  polarities_.push_back(true);
+  activities_.push_back(0.0);
+  seen_.push_back(false);
+  heap_positions_.push_back(-1);
+  watches_.emplace_back();
+  watches_.emplace_back();
+  HeapInsert(variable);
+  return variable;
+}
+
+void SatSolver::AddClause(absl::Span<const SatLiteral> literals) {
+  XLS_CHECK_EQ(DecisionLevel(), 0);
+  if (!ok_) {
+    return;
+  }
+  std::vector<SatLiteral> clause(literals.begin(), literals.end());
+  std::sort(clause.begin(), clause.end());
+  clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+  int64_t kept = 0;
+  for (int64_t i = 0; i < clause.size(); ++i) {
+    XLS_DCHECK_LT(Variable(clause[i]), variable_count());
+    int8_t value = LiteralValue(clause[i]);
+    // Sorting puts a literal next to its negation.
+    if (value == kTrue ||
+        (i + 1 < clause.size() && clause[i + 1] == Negate(clause[i]))) {
+      return;
+    }
+    if (value == kUndef) {
+      clause[kept++] = clause[i];
+    }
+  }
+  clause.resize(kept);
+
+  if (clause.empty()) {
+    ok_ = false;
+  } else if (clause.size() == 1) {
+    Enqueue(clause[0], kNoReason);
+    ok_ = Propagate() == kNoReason;
+  } else {
+    AttachClause(std::move(clause), /*learned=*/false);
+  }
+}
+
+int32_t SatSolver::AttachClause(std::vector<SatLiteral> literals,
+                                bool learned) {
+  int32_t index = clauses_.size();
+  watches_[literals[0]].push_back(index);
+  watches_[literals[1]].push_back(index);
+  clauses_.push_back(Clause{std::move(literals), learned, /*deleted=*/false,
+                            /*activity=*/0.0});
+  if (learned) {
+    ++learned_count_;
+  }
+  return index;
+}
+
+void SatSolver::Enqueue(SatLiteral literal, int32_t reason) {
+  int64_t variable = Variable(literal);
+  XLS_DCHECK_EQ(values_[variable], kUndef);
+  values_[variable] = IsNegated(literal) ? kFalse : kTrue;
+  levels_[variable] = DecisionLevel();
+  reasons_[variable] = reason;
+  trail_.push_back(literal);
+}
+
+int32_t SatSolver::Propagate() {
+  int32_t conflict = kNoReason;
+  while (conflict == kNoReason && propagation_head_ < trail_.size()) {
+    SatLiteral false_literal = Negate(trail_[propagation_head_++]);
+    std::vector<int32_t>& watchers = watches_[false_literal];
+    int64_t kept = 0;
+    int64_t i = 0;
+    while (i < watchers.size()) {
+      int32_t index = watchers[i++];
+      Clause& clause = clauses_[index];
+      if (clause.deleted) {
+        continue;
+      }
+      std::vector<SatLiteral>& literals = clause.literals;
+      // Keep the false watched literal second.
+      if (literals[0] == false_literal) {
+        std::swap(literals[0], literals[1]);
+      }
+      if (LiteralValue(literals[0]) == kTrue) {
+        watchers[kept++] = index;
+        continue;
+      }
+      bool moved = false;
+      for (int64_t k = 2; k < literals.size(); ++k) {
+        if (LiteralValue(literals[k]) != kFalse) {
+          std::swap(literals[1], literals[k]);
+          watches_[literals[1]].push_back(index);
+          moved = true;
+          break;
+        }
+      }
+      if (moved) {
+        continue;
+      }
+      watchers[kept++] = index;
+      if (LiteralValue(literals[0]) == kFalse) {
+        conflict = index;
+        while (i < watchers.size()) {
+          watchers[kept++] = watchers[i++];
+        }
+      } else {
+        Enqueue(literals[0], index);
+      }
+    }
+    watchers.resize(kept);
+  }
+  return conflict;
+}
+
+std::vector<SatLiteral> SatSolver::Analyze(int32_t conflict,
+                                           int64_t* backtrack_level) {
+  std::vector<SatLiteral> learned = {kNoLiteral};
+  int64_t pending = 0;
+  SatLiteral implied = kNoLiteral;
+  int64_t trail_index = trail_.size() - 1;
+  int32_t index = conflict;
+  do {
+    Clause& clause = clauses_[index];
+    if (clause.learned) {
+      BumpClause(clause);
+    }
+    // A reason clause's first literal is the one it implied.
+    for (int64_t k = implied == kNoLiteral ? 0 : 1; k < clause.literals.size();
+         ++k) {
+      SatLiteral literal = clause.literals[k];
+      int64_t variable = Variable(literal);
+      if (seen_[variable] || levels_[variable] == 0) {
+        continue;
+      }
+      BumpVariable(variable);
+      seen_[variable] = true;
+      if (levels_[variable] == DecisionLevel()) {
+        ++pending;
+      } else {
+        learned.push_back(literal);
+      }
+    }
+    while (!seen_[Variable(trail_[trail_index])]) {
+      --trail_index;
+    }
+    implied = trail_[trail_index--];
+    index = reasons_[Variable(implied)];
+    seen_[Variable(implied)] = false;
+    --pending;
+  } while (pending > 0);
+  learned[0] = Negate(implied);
+
+  *backtrack_level = 0;
+  for (int64_t i = 1; i < learned.size(); ++i) {
+    seen_[Variable(learned[i])] = false;
+    if (levels_[Variable(learned[i])] > *backtrack_level) {
+      *backtrack_level = levels_[Variable(learned[i])];
+      // Watch the literal to be unassigned last.
+      std::swap(learned[1], learned[i]);
+    }
+  }
+  return learned;
+}
+
+void SatSolver::Backtrack(int64_t level) {
+  if (DecisionLevel() <= level) {
+    return;
+  }
+  for (int64_t i = trail_.size() - 1; i >= trail_limits_[level]; --i) {
+    int64_t variable = Variable(trail_[i]);
+    polarities_[variable] = IsNegated(trail_[i]);
+    values_[variable] = kUndef;
+    reasons_[variable] = kNoReason;
+    if (heap_positions_[variable] < 0) {
+      HeapInsert(variable);
+    }
+  }
+  trail_.resize(trail_limits_[level]);
+  trail_limits_.resize(level);
+  propagation_head_ = trail_.size();
+}
+
+void SatSolver::ReduceLearnedClauses() {
+  std::vector<int32_t> candidates;
+  for (int32_t i = 0; i < clauses_.size(); ++i) {
+    const Clause& clause = clauses_[i];
+    if (!clause.learned || clause.deleted || clause.literals.size() <= 2) {
+      continue;
+    }
+    SatLiteral first = clause.literals[0];
+    bool locked = LiteralValue(first) == kTrue &&
+                  reasons_[Variable(first)] == i;
+    if (!locked) {
+      candidates.push_back(i);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), [&](int32_t a, int32_t b) {
+    return clauses_[a].activity < clauses_[b].activity;
+  });
+  // Watch lists drop deleted clauses lazily, in Propagate().
+  for (int64_t i = 0; i < candidates.size() / 2; ++i) {
+    Clause& clause = clauses_[candidates[i]];
+    clause.deleted = true;
+    clause.literals.clear();
+    clause.literals.shrink_to_fit();
+    --learned_count_;
+  }
+}
+
+int64_t SatSolver::PickBranchVariable() {
+  while (!heap_.empty()) {
+    int64_t variable = HeapRemoveMax();
+    if (values_[variable] == kUndef) {
+      return variable;
+    }
+  }
+  return -1;
+}
+
+void SatSolver::BumpVariable(int64_t variable) {
+  activities_[variable] += variable_increment_;
+  if (activities_[variable] > kRescaleLimit) {
+    for (double& activity : activities_) {
+      activity /= kRescaleLimit;
+    }
+    variable_increment_ /= kRescaleLimit;
+  }
+  if (heap_positions_[variable] >= 0) {
+    HeapSiftUp(heap_positions_[variable]);
+  }
+}
+
+void SatSolver::BumpClause(Clause& clause) {
+  clause.activity += clause_increment_;
+  if (clause.activity > kRescaleLimit) {
+    for (Clause& c : clauses_) {
+      c.activity /= kRescaleLimit;
+    }
+    clause_increment_ /= kRescaleLimit;
+  }
+}
+
+void SatSolver::HeapInsert(int64_t variable) {
+  heap_positions_[variable] = heap_.size();
+  heap_.push_back(variable);
+  HeapSiftUp(heap_.size() - 1);
+}
+
+int64_t SatSolver::HeapRemoveMax() {
+  int64_t top = heap_[0];
+  heap_positions_[top] = -1;
+  int64_t last = heap_.back();
+  heap_.pop_back();
+  if (!heap_.empty()) {
+    heap_[0] = last;
+    heap_positions_[last] = 0;
+    HeapSiftDown(0);
+  }
+  return top;
+}
+
+void SatSolver::HeapSiftUp(int64_t position) {
+  int64_t variable = heap_[position];
+  while (position > 0) {
+    int64_t parent = (position - 1) / 2;
+    if (activities_[heap_[parent]] >= activities_[variable]) {
+      break;
+    }
+    heap_[position] = heap_[parent];
+    heap_positions_[heap_[position]] = position;
+    position = parent;
+  }
+  heap_[position] = variable;
+  heap_positions_[variable] = position;
+}
+
+void SatSolver::HeapSiftDown(int64_t position) {
+  int64_t variable = heap_[position];
+  while (true) {
+    int64_t child = 2 * position + 1;
+    if (child >= heap_.size()) {
+      break;
+    }
+    if (child + 1 < heap_.size() &&
+        activities_[heap_[child + 1]] > activities_[heap_[child]]) {
+      ++child;
+    }
+    if (activities_[heap_[child]] <= activities_[variable]) {
+      break;
+    }
+    heap_[position] = heap_[child];
+    heap_positions_[heap_[position]] = position;
+    position = child;
+  }
+  heap_[position] = variable;
+  heap_positions_[variable] = position;
+}
+
+SatSolver::Result SatSolver::Solve(absl::Span<const SatLiteral> assumptions,
+                                   absl::Time deadline,
+                                   const std::atomic<bool>* interrupt) {
+  model_.clear();
+  if (!ok_) {
+    return Result::kUnsatisfiable;
+  }
+  if (max_learned_ == 0) {
+    max_learned_ = std::max<double>(clauses_.size() / 3.0, 1000.0);
+  }
+
+  int64_t restart_count = 0;
+  int64_t conflicts_until_restart = kRestartBase * Luby(restart_count);
+  while (true) {
+    int32_t conflict = Propagate();
+    if (conflict != kNoReason) {
+      ++conflict_count_;
+      if (DecisionLevel() == 0) {
+        ok_ = false;
+        return Result::kUnsatisfiable;
+      }
+      int64_t backtrack_level;
+      std::vector<SatLiteral> learned = Analyze(conflict, &backtrack_level);
+      Backtrack(backtrack_level);
+      if (learned.size() == 1) {
+        Enqueue(learned[0], kNoReason);
+      } else {
+        SatLiteral asserted = learned[0];
+        Enqueue(asserted, AttachClause(std::move(learned), /*learned=*/true));
+      }
+      variable_increment_ /= kVariableDecay;
+      clause_increment_ /= kClauseDecay;
+
+      if (conflict_count_ % kDeadlineCheckInterval == 0 &&
+          ((interrupt != nullptr && interrupt->load()) ||
+           absl::Now() >= deadline)) {
+        Backtrack(0);
+        return Result::kUnknown;
+      }
+      if (--conflicts_until_restart <= 0) {
+        Backtrack(0);
+        conflicts_until_restart = kRestartBase * Luby(++restart_count);
+      }
+      continue;
+    }
+
+    if (learned_count_ - static_cast<int64_t>(trail_.size()) >= max_learned_) {
+      ReduceLearnedClauses();
+      max_learned_ *= 1.1;
+    }
+
+    // Assumptions are decided first, one per decision level.
+    SatLiteral next = kNoLiteral;
+    while (DecisionLevel() < assumptions.size()) {
+      SatLiteral assumption = assumptions[DecisionLevel()];
+      int8_t value = LiteralValue(assumption);
+      if (value == kFalse) {
+        Backtrack(0);
+        return Result::kUnsatisfiable;
+      }
+      if (value == kUndef) {
+        next = assumption;
+        break;
+      }
+      // Already true; open an empty level to keep levels and assumptions in
+      // step.
+      trail_limits_.push_back(trail_.size());
+    }
+    if (next == kNoLiteral) {
+      int64_t variable = PickBranchVariable();
+      if (variable < 0) {
+        model_.resize(variable_count());
+        for (int64_t v = 0; v < variable_count(); ++v) {
+          model_[v] = values_[v] == kTrue;
+        }
+        Backtrack(0);
+        return Result::kSatisfiable;
+      }
+      ++decision_count_;
+      next = polarities_[variable] ? Negate(PositiveLiteral(variable))
+                                   : PositiveLiteral(variable);
+    }
+    trail_limits_.push_back(trail_.size());
+    Enqueue(next, kNoReason);
+  }
+}
+
+}  // namespace solvers
+}  // namespace xls
@@ -0,0 +1,168 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SOLVERS_SAT_SOLVER_H_
+#define XLS_SOLVERS_SAT_SOLVER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace xls {
+namespace solvers {
+
+// A literal of a SatSolver: a variable index times two, plus one if negated.
+using SatLiteral = int32_t;
+
+// A conflict-driven clause-learning (CDCL) SAT solver over clauses in
+// conjunctive normal form, in the style of MiniSat: two-watched-literal
+// propagation, first-UIP conflict analysis, VSIDS decisions with phase saving,
+// Luby restarts and periodic reduction of the learned clause database.
+//
+// Solve() may be called repeatedly, with clauses added in between; learned
+// clauses are kept, so related queries - e.g., the same formula under
+// different assumptions - get faster.
+class SatSolver {
+ public:
+  enum class Result {
+    kSatisfiable,
+    kUnsatisfiable,
+    // The deadline passed (or the solver was interrupted) before an answer
+    // was found.
+    kUnknown,
+  };
+
+  static SatLiteral PositiveLiteral(int64_t variable) { return variable * 2; }
+  static SatLiteral Negate(SatLiteral literal) { return literal ^ 1; }
+  static int64_t Variable(SatLiteral literal) { return literal >> 1; }
+  static bool IsNegated(SatLiteral literal) { return (literal & 1) != 0; }
+
+  SatSolver() = default;
+
+  // Adds a variable and returns its index.
+  int64_t AddVariable();
+  int64_t variable_count() const { return values_.size(); }
+
+  // Adds the clause that at least one of "literals" is true. An empty clause
+  // makes the formula unsatisfiable.
+  void AddClause(absl::Span<const SatLiteral> literals);
+
+  // Determines whether the clauses are satisfiable with all of "assumptions"
+  // true, giving up at "deadline" or once "interrupt" (if given) is set, e.g.,
+  // by another thread.
+  Result Solve(absl::Span<const SatLiteral> assumptions = {},
+               absl::Time deadline = absl::InfiniteFuture(),
+               const std::atomic<bool>* interrupt = nullptr);
+
+  // After Solve() returns kSatisfiable, the value of "variable" in the
+  // satisfying assignment found.
+  bool ModelValue(int64_t variable) const { return model_[variable]; }
+
+  int64_t conflict_count() const { return conflict_count_; }
+  int64_t decision_count() const { return decision_count_; }
+
+ private:
+  // Truth values, as held in values_; a literal's value is its variable's
+  // XORed with its negation bit.
+  static constexpr int8_t kFalse = 0;
+  static constexpr int8_t kTrue = 1;
+  static constexpr int8_t kUndef = 2;
+
+  static constexpr SatLiteral kNoLiteral = -1;
+  static constexpr int32_t kNoReason = -1;
+
+  struct Clause {
+    std::vector<SatLiteral> literals;
+    bool learned;
+    bool deleted;
+    double activity;
+  };
+
+  int8_t LiteralValue(SatLiteral literal) const {
+    int8_t value = values_[Variable(literal)];
+    return value == kUndef ? kUndef : value ^ (literal & 1);
+  }
+  int64_t DecisionLevel() const { return trail_limits_.size(); }
+
+  // Assigns "literal" true, as implied by the clause "reason" (or as a
+  // decision or top-level fact).
+  void Enqueue(SatLiteral literal, int32_t reason);
+
+  // Propagates all enqueued assignments. Returns the index of a clause all of
+  // whose literals are false, or kNoReason if there is none.
+  int32_t Propagate();
+
+  // Derives a (first-UIP) clause from the conflict clause "conflict" and
+  // returns it with the literal to assert first; "backtrack_level" receives
+  // the decision level at which the clause becomes unit.
+  std::vector<SatLiteral> Analyze(int32_t conflict, int64_t* backtrack_level);
+
+  // Undoes all assignments above decision level "level".
+  void Backtrack(int64_t level);
+
+  // Adds a clause of two or more literals, watching the first two, and
+  // returns its index.
+  int32_t AttachClause(std::vector<SatLiteral> literals, bool learned);
+
+  // Deletes the less active half of the learned clauses which aren't the
+  // reason for a current assignment.
+  void ReduceLearnedClauses();
+
+  // Returns the unassigned variable with the highest activity, or -1.
+  int64_t PickBranchVariable();
+
+  void BumpVariable(int64_t variable);
+  void BumpClause(Clause& clause);
+
+  // Binary max-heap of variables by activity.
+  void HeapInsert(int64_t variable);
+  int64_t HeapRemoveMax();
+  void HeapSiftUp(int64_t position);
+  void HeapSiftDown(int64_t position);
+
+  bool ok_ = true;
+  std::vector<Clause> clauses_;
+  int64_t learned_count_ = 0;
+  double max_learned_ = 0;
+  // For each literal, the clauses watching it, i.e., to be visited when it
+  // becomes false.
+  std::vector<std::vector<int32_t>> watches_;
+
+  std::vector<int8_t> values_;
+  std::vector<int64_t> levels_;
+  std::vector<int32_t> reasons_;
+  std::vector<bool> polarities_;
+  std::vector<SatLiteral> trail_;
+  std::vector<int64_t> trail_limits_;
+  int64_t propagation_head_ = 0;
+
+  std::vector<double> activities_;
+  double variable_increment_ = 1.0;
+  double clause_increment_ = 1.0;
+  std::vector<int64_t> heap_;
+  std::vector<int64_t> heap_positions_;
+
+  std::vector<bool> seen_;
+  std::vector<bool> model_;
+  int64_t conflict_count_ = 0;
+  int64_t decision_count_ = 0;
+};
+
+}  // namespace solvers
+}  // namespace xls
+
+#endif  // XLS_SOLVERS_SAT_SOLVER_H_
@@ -0,0 +1,175 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/sat_solver.h"
+
+#include <atomic>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace xls {
+namespace solvers {
+namespace {
+
+using Result = SatSolver::Result;
+
+SatLiteral Pos(int64_t variable) {
+  return SatSolver::PositiveLiteral(variable);
+}
+SatLiteral Neg(int64_t variable) {
+  return SatSolver::Negate(SatSolver::PositiveLiteral(variable));
+}
+
+bool Satisfies(const SatSolver& solver,
+               const std::vector<std::vector<SatLiteral>>& clauses) {
+  for (const std::vector<SatLiteral>& clause : clauses) {
+    bool satisfied = false;
+    for (SatLiteral literal : clause) {
+      if (solver.ModelValue(SatSolver::Variable(literal)) !=
+          SatSolver::IsNegated(literal)) {
+        satisfied = true;
+      }
+    }
+    if (!satisfied) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Adds the (unsatisfiable, if there are more pigeons than holes) constraints
+// that every pigeon is in a hole and no two pigeons share one.
+void AddPigeonholeClauses(int64_t pigeons, int64_t holes, SatSolver* solver) {
+  std::vector<std::vector<int64_t>> in_hole(pigeons);
+  for (int64_t p = 0; p < pigeons; ++p) {
+    std::vector<SatLiteral> somewhere;
+    for (int64_t h = 0; h < holes; ++h) {
+      in_hole[p].push_back(solver->AddVariable());
+      somewhere.push_back(Pos(in_hole[p][h]));
+    }
+    solver->AddClause(somewhere);
+  }
+  for (int64_t h = 0; h < holes; ++h) {
+    for (int64_t p = 0; p < pigeons; ++p) {
+      for (int64_t q = p + 1; q < pigeons; ++q) {
+        solver->AddClause({Neg(in_hole[p][h]), Neg(in_hole[q][h])});
+      }
+    }
+  }
+}
+
+TEST(SatSolverTest, TrivialProblems) {
+  SatSolver solver;
+  EXPECT_EQ(solver.Solve(), Result::kSatisfiable);
+  int64_t x = solver.AddVariable();
+  int64_t y = solver.AddVariable();
+  solver.AddClause({Pos(x), Pos(y)});
+  solver.AddClause({Neg(x)});
+  ASSERT_EQ(solver.Solve(), Result::kSatisfiable);
+  EXPECT_FALSE(solver.ModelValue(x));
+  EXPECT_TRUE(solver.ModelValue(y));
+  solver.AddClause({Neg(y)});
+  EXPECT_EQ(solver.Solve(), Result::kUnsatisfiable);
+}
+
+TEST(SatSolverTest, Assumptions) {
+  SatSolver solver;
+  int64_t x = solver.AddVariable();
+  int64_t y = solver.AddVariable();
+  int64_t z = solver.AddVariable();
+  // x -> y, y -> z.
+  solver.AddClause({Neg(x), Pos(y)});
+  solver.AddClause({Neg(y), Pos(z)});
+  EXPECT_EQ(solver.Solve({Pos(x), Neg(z)}), Result::kUnsatisfiable);
+  ASSERT_EQ(solver.Solve({Pos(x)}), Result::kSatisfiable);
+  EXPECT_TRUE(solver.ModelValue(z));
+  // Failing under assumptions doesn't make the problem unsatisfiable.
+  ASSERT_EQ(solver.Solve({Neg(z)}), Result::kSatisfiable);
+  EXPECT_FALSE(solver.ModelValue(x));
+}
+
+TEST(SatSolverTest, PigeonholeIsUnsatisfiable) {
+  SatSolver solver;
+  AddPigeonholeClauses(/*pigeons=*/7, /*holes=*/6, &solver);
+  EXPECT_EQ(solver.Solve(), Result::kUnsatisfiable);
+  EXPECT_GT(solver.conflict_count(), 0);
+}
+
+TEST(SatSolverTest, RandomProblemsMatchExhaustiveSearch) {
+  constexpr int64_t kVariables = 10;
+  std::minstd_rand engine(0);
+  for (int64_t trial = 0; trial < 200; ++trial) {
+    SatSolver solver;
+    for (int64_t i = 0; i < kVariables; ++i) {
+      solver.AddVariable();
+    }
+    std::vector<std::vector<SatLiteral>> clauses(30 + trial % 20);
+    for (std::vector<SatLiteral>& clause : clauses) {
+      for (int64_t i = 0; i < 3; ++i) {
+        SatLiteral literal = Pos(engine() % kVariables);
+        clause.push_back(engine() % 2 ? SatSolver::Negate(literal) : literal);
+      }
+      solver.AddClause(clause);
+    }
+
+    bool satisfiable = false;
+    for (int64_t assignment = 0; assignment < (1 << kVariables); ++assignment) {
+      bool all = true;
+      for (const std::vector<SatLiteral>& clause : clauses) {
+        bool any = false;
+        for (SatLiteral literal : clause) {
+          bool value = (assignment >> SatSolver::Variable(literal)) & 1;
+          any |= value != SatSolver::IsNegated(literal);
+        }
+        all &= any;
+      }
+      if (all) {
+        satisfiable = true;
+        break;
+      }
+    }
+
+    Result result = solver.Solve();
+    EXPECT_EQ(result, satisfiable ? Result::kSatisfiable
+                                  : Result::kUnsatisfiable);
+    if (result == Result::kSatisfiable) {
+      EXPECT_TRUE(Satisfies(solver, clauses));
+    }
+  }
+}
+
+TEST(SatSolverTest, GivesUpAtDeadline) {
+  // Pigeonhole problems are exponentially hard for clause learning.
+  SatSolver solver;
+  AddPigeonholeClauses(/*pigeons=*/13, /*holes=*/12, &solver);
+  EXPECT_EQ(solver.Solve({}, absl::Now() + absl::Milliseconds(100)),
+            Result::kUnknown);
+}
+
+TEST(SatSolverTest, StopsWhenInterrupted) {
+  SatSolver solver;
+  AddPigeonholeClauses(/*pigeons=*/13, /*holes=*/12, &solver);
+  std::atomic<bool> interrupt(true);
+  EXPECT_EQ(solver.Solve({}, absl::InfiniteFuture(), &interrupt),
+            Result::kUnknown);
+}
+
+}  // namespace
+}  // namespace solvers
+}  // namespace xls
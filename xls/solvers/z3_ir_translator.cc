@@ -15,6 +15,7 @@
 #include "xls/solvers/z3_ir_translator.h"
 
 #include "absl/debugging/leak_check.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
@@ -1259,11 +1260,30 @@ absl::StatusOr<Z3_ast> PredicateToObjective(Predicate p, Z3_ast a,
   return objective;
 }
 
-absl::StatusOr<bool> TryProve(Function* f, Node* subject, Predicate p,
-                              absl::Duration timeout) {
-  XLS_ASSIGN_OR_RETURN(auto translator, IrTranslator::CreateAndTranslate(f));
-  translator->SetTimeout(timeout);
-  Z3_ast value = translator->GetTranslation(subject);
+absl::StatusOr<std::unique_ptr<IncrementalProver>> IncrementalProver::Create(
+    Function* f) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrTranslator> translator,
+                       IrTranslator::CreateAndTranslate(f));
+  Z3_solver solver = CreateSolver(translator->ctx(), 1);
+  return absl::WrapUnique(
+      new IncrementalProver(std::move(translator), solver));
+}
+
+IncrementalProver::~IncrementalProver() {
+  Z3_solver_dec_ref(translator_->ctx(), solver_);
+}
+
+absl::StatusOr<bool> IncrementalProver::TryProve(Node* subject, Predicate p,
+                                                 absl::Duration timeout) {
+  XLS_RET_CHECK(subject->function_base() == translator_->xls_function());
+  query_count_++;
+  QueryKey key(subject, p.kind(),
+               p.kind() == PredicateKind::kEqualToNode ? p.node() : nullptr);
+  auto it = results_.find(key);
+  if (it != results_.end()) {
+    memoized_count_++;
+    return it->second;
+  }
 
   // All token types are equal.
   if (subject->GetType()->IsToken() &&
@@ -1271,30 +1291,43 @@ absl::StatusOr<bool> TryProve(Function* f, Node* subject, Predicate p,
       p.node()->GetType()->IsToken()) {
     return true;
   }
-  if (translator->GetValueKind(value) != Z3_BV_SORT) {
+  Z3_ast value = translator_->GetTranslation(subject);
+  if (translator_->GetValueKind(value) != Z3_BV_SORT) {
     return absl::InvalidArgumentError(
         "Cannot prove properties of non-bits-typed node: " +
         subject->ToString());
   }
   XLS_ASSIGN_OR_RETURN(Z3_ast objective,
-                       PredicateToObjective(p, value, translator.get()));
-  Z3_context ctx = translator->ctx();
+                       PredicateToObjective(p, value, translator_.get()));
+  Z3_context ctx = translator_->ctx();
   XLS_VLOG(2) << "objective:\n" << Z3_ast_to_string(ctx, objective);
-  Z3_solver solver = solvers::z3::CreateSolver(ctx, 1);
-  Z3_solver_assert(ctx, solver, objective);
-  Z3_lbool satisfiable = Z3_solver_check(ctx, solver);
-  XLS_VLOG(2) << solvers::z3::SolverResultToString(ctx, solver, satisfiable)
-              << std::endl;
-  Z3_solver_dec_ref(ctx, solver);
 
-  if (Z3_solver_check(ctx, solver) == Z3_L_FALSE) {
-    // We posit the inverse of the predicate we want to check -- when that is
-    // unsatisfiable, the predicate has been proven (there was no way found that
-    // we could not satisfy its inverse).
-    return true;
+  // The objective only holds under its own literal, which is retired once the
+  // query is answered.
+  Z3_ast literal =
+      Z3_mk_fresh_const(ctx, "query", Z3_mk_bool_sort(ctx));
+  Z3_solver_assert(ctx, solver_, Z3_mk_implies(ctx, literal, objective));
+  SetSolverTimeout(ctx, solver_, timeout);
+  Z3_lbool satisfiable = Z3_solver_check_assumptions(ctx, solver_, 1, &literal);
+  XLS_VLOG(2) << solvers::z3::SolverResultToString(ctx, solver_, satisfiable)
+              << std::endl;
+  Z3_solver_assert(ctx, solver_, Z3_mk_not(ctx, literal));
+
+  // We posit the inverse of the predicate we want to check -- when that is
+  // unsatisfiable, the predicate has been proven (there was no way found that
+  // we could not satisfy its inverse).
+  bool proven = satisfiable == Z3_L_FALSE;
+  if (satisfiable != Z3_L_UNDEF) {
+    results_[key] = proven;
   }
+  return proven;
+}
 
-  return false;
+absl::StatusOr<bool> TryProve(Function* f, Node* subject, Predicate p,
+                              absl::Duration timeout) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IncrementalProver> prover,
+                       IncrementalProver::Create(f));
+  return prover->TryProve(subject, p, timeout);
 }
 
 }  // namespace z3
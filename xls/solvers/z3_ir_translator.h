@@ -18,6 +18,10 @@
 #ifndef XLS_TOOLS_Z3_IR_TRANSLATOR_H_
 #define XLS_TOOLS_Z3_IR_TRANSLATOR_H_
 
+#include <memory>
+#include <tuple>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
 #include "xls/common/logging/logging.h"
@@ -284,8 +288,49 @@ class Predicate {
   absl::optional<Node*> node_;
 };
 
+// Answers a series of TryProve() queries about the nodes of a single function.
+// The function is translated once, into a context and solver kept for the
+// lifetime of the prover. Each query's objective is asserted under a fresh
+// assumption literal rather than in a push/pop scope, so later queries reuse
+// both the translation and the lemmas learned by earlier ones. Definitive
+// answers are memoized; timed-out queries are retried when asked again.
+class IncrementalProver {
+ public:
+  static absl::StatusOr<std::unique_ptr<IncrementalProver>> Create(
+      Function* f);
+  ~IncrementalProver();
+
+  // As the free function TryProve(), for a node of this prover's function.
+  absl::StatusOr<bool> TryProve(Node* subject, Predicate p,
+                                absl::Duration timeout);
+
+  // The number of queries made, and how many of those were answered from
+  // memoized results.
+  int64_t query_count() const { return query_count_; }
+  int64_t memoized_count() const { return memoized_count_; }
+
+  IrTranslator* translator() { return translator_.get(); }
+
+ private:
+  IncrementalProver(std::unique_ptr<IrTranslator> translator,
+                    Z3_solver solver)
+      : translator_(std::move(translator)), solver_(solver) {}
+
+  // Identifies a query: the subject, predicate kind and, for kEqualToNode, the
+  // node compared against.
+  using QueryKey = std::tuple<Node*, PredicateKind, Node*>;
+
+  std::unique_ptr<IrTranslator> translator_;
+  Z3_solver solver_;
+  absl::flat_hash_map<QueryKey, bool> results_;
+  int64_t query_count_ = 0;
+  int64_t memoized_count_ = 0;
+};
+
 // Attempts to prove node "subject" in function "f" satisfies the given
 // predicate (over all possible inputs) within the duration "timeout".
+// Translates "f" from scratch; use IncrementalProver to make several queries
+// of the same function.
 absl::StatusOr<bool> TryProve(Function* f, Node* subject, Predicate p,
                               absl::Duration timeout);
 
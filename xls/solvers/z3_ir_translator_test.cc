@@ -109,6 +109,46 @@ fn f(x: bits[32], y: bits[32]) -> bits[32] {
   EXPECT_TRUE(proven);
 }
 
+// Queries on the same prover must not affect each other's answers: a failed
+// query's objective is retired before the next.
+TEST_F(Z3IrTranslatorTest, IncrementalProverAnswersSeveralQueries) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  auto x = b.Param("x", p->GetBitsType(32));
+  auto y = b.Param("y", p->GetBitsType(32));
+  auto sum = b.Add(x, y);
+  auto x_minus_x = b.Subtract(x, x);
+  auto sum_minus_y = b.Subtract(sum, y);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<solvers::z3::IncrementalProver> prover,
+      solvers::z3::IncrementalProver::Create(f));
+
+  EXPECT_THAT(prover->TryProve(sum.node(), Predicate::EqualToZero(),
+                               absl::InfiniteDuration()),
+              IsOkAndHolds(false));
+  EXPECT_THAT(prover->TryProve(x_minus_x.node(), Predicate::EqualToZero(),
+                               absl::InfiniteDuration()),
+              IsOkAndHolds(true));
+  EXPECT_THAT(prover->TryProve(sum_minus_y.node(), Predicate::EqualTo(x.node()),
+                               absl::InfiniteDuration()),
+              IsOkAndHolds(true));
+  EXPECT_THAT(prover->TryProve(sum.node(), Predicate::EqualTo(x.node()),
+                               absl::InfiniteDuration()),
+              IsOkAndHolds(false));
+  EXPECT_EQ(prover->memoized_count(), 0);
+
+  // Repeated queries are answered from memoized results.
+  EXPECT_THAT(prover->TryProve(x_minus_x.node(), Predicate::EqualToZero(),
+                               absl::InfiniteDuration()),
+              IsOkAndHolds(true));
+  EXPECT_THAT(prover->TryProve(sum.node(), Predicate::EqualToZero(),
+                               absl::InfiniteDuration()),
+              IsOkAndHolds(false));
+  EXPECT_EQ(prover->query_count(), 6);
+  EXPECT_EQ(prover->memoized_count(), 2);
+}
+
 TEST_F(Z3IrTranslatorTest, TupleIndexMinusSelf) {
   const std::string program = R"(
 fn f(p: (bits[1], bits[32])) -> bits[32] {
@@ -14,18 +14,35 @@
 
 #include "xls/solvers/z3_lec.h"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <random>
 #include <thread>  // NOLINT(build/c++11)
 
 #include "absl/base/internal/sysinfo.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "xls/codegen/vast.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
+#include "xls/interpreter/ir_interpreter.h"
+#include "xls/interpreter/random_value.h"
 #include "xls/ir/bits_ops.h"
+#include "xls/ir/node_iterator.h"
 #include "xls/ir/node_util.h"
+#include "xls/netlist/compiled_interpreter.h"
+#include "xls/netlist/function_parser.h"
+#include "xls/solvers/aig_equivalence.h"
+#include "xls/solvers/aig_ir_translator.h"
 #include "xls/solvers/z3_utils.h"
 #include "../z3/src/api/z3_api.h"
 
@@ -33,6 +50,8 @@ namespace xls {
 namespace solvers {
 namespace z3 {
 
+using netlist::function::Ast;
+using netlist::rtl::Cell;
 using netlist::rtl::Module;
 using netlist::rtl::Netlist;
 using netlist::rtl::NetRef;
@@ -53,12 +72,143 @@ std::vector<const Node*> SetToIdSortedVector(
   return nodes;
 }
 
+// Calls "fn" on each index in [0, count), spread across up to "thread_count"
+// threads (including the calling one).
+void ParallelFor(int64_t count, int64_t thread_count,
+                 const std::function<void(int64_t)>& fn) {
+  std::atomic<int64_t> next(0);
+  auto worker = [&]() {
+    for (int64_t i = next++; i < count; i = next++) {
+      fn(i);
+    }
+  };
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int64_t i = 1; i < std::min(thread_count, count); ++i) {
+    threads.push_back(std::make_unique<Thread>(worker));
+  }
+  worker();
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+}
+
+// Appends the bits of "value" to "bits", in the order of
+// IrTranslator::FlattenValue(..., /*little_endian=*/true).
+void FlattenValueBits(const Value& value, std::vector<bool>* bits) {
+  if (value.IsBits()) {
+    // That order has the most significant bit of each bits value first.
+    for (int64_t i = value.bits().bit_count() - 1; i >= 0; --i) {
+      bits->push_back(value.bits().Get(i));
+    }
+  } else if (value.IsTuple() || value.IsArray()) {
+    for (const Value& element : value.elements()) {
+      FlattenValueBits(element, bits);
+    }
+  }
+}
+
+// Returns true if the simulated values of a bit (one word per batch of input
+// vectors) are the same for every input vector.
+bool IsConstant(absl::Span<const uint64_t> values) {
+  return std::all_of(values.begin(), values.end(),
+                     [](uint64_t word) { return word == 0; }) ||
+         std::all_of(values.begin(), values.end(),
+                     [](uint64_t word) { return word == ~uint64_t{0}; });
+}
+
+// Reverses the bits of each bits-typed element of a flattened value of
+// "type", converting between the order of AigIrTranslator (least significant
+// bit first) and that of IrTranslator::FlattenValue(..., little_endian=true).
+void ReverseBitsElements(const Type* type, absl::Span<AigLiteral> bits) {
+  switch (type->kind()) {
+    case TypeKind::kBits:
+      std::reverse(bits.begin(), bits.end());
+      return;
+    case TypeKind::kArray: {
+      const ArrayType* array_type = type->AsArrayOrDie();
+      int64_t element_size = array_type->element_type()->GetFlatBitCount();
+      for (int64_t i = 0; i < array_type->size(); ++i) {
+        ReverseBitsElements(array_type->element_type(),
+                            bits.subspan(i * element_size, element_size));
+      }
+      return;
+    }
+    case TypeKind::kTuple: {
+      int64_t offset = 0;
+      for (const Type* element_type : type->AsTupleOrDie()->element_types()) {
+        int64_t element_size = element_type->GetFlatBitCount();
+        ReverseBitsElements(element_type, bits.subspan(offset, element_size));
+        offset += element_size;
+      }
+      return;
+    }
+    case TypeKind::kToken:
+      return;
+  }
+}
+
+// Builds the logic of a cell library function of "cell" in "aig", given the
+// translations of the cell's input nets.
+absl::StatusOr<AigLiteral> FunctionToAig(
+    Aig* aig, const Cell& cell, const Ast& ast,
+    const absl::flat_hash_map<NetRef, AigLiteral>& nets) {
+  switch (ast.kind()) {
+    case Ast::Kind::kIdentifier:
+      for (const Cell::Pin& input : cell.inputs()) {
+        if (input.name == ast.name()) {
+          return nets.at(input.netref);
+        }
+      }
+      return absl::NotFoundError(absl::StrFormat(
+          "Identifier \"%s\", was not found in cell %s's inputs.", ast.name(),
+          cell.name()));
+    case Ast::Kind::kLiteralOne:
+      return Aig::kTrue;
+    case Ast::Kind::kLiteralZero:
+      return Aig::kFalse;
+    case Ast::Kind::kNot: {
+      XLS_ASSIGN_OR_RETURN(AigLiteral operand,
+                           FunctionToAig(aig, cell, ast.children()[0], nets));
+      return Aig::Not(operand);
+    }
+    case Ast::Kind::kAnd:
+    case Ast::Kind::kOr:
+    case Ast::Kind::kXor: {
+      XLS_ASSIGN_OR_RETURN(AigLiteral lhs,
+                           FunctionToAig(aig, cell, ast.children()[0], nets));
+      XLS_ASSIGN_OR_RETURN(AigLiteral rhs,
+                           FunctionToAig(aig, cell, ast.children()[1], nets));
+      if (ast.kind() == Ast::Kind::kAnd) {
+        return aig->And(lhs, rhs);
+      }
+      return ast.kind() == Ast::Kind::kOr ? aig->Or(lhs, rhs)
+                                          : aig->Xor(lhs, rhs);
+    }
+  }
+  return absl::InvalidArgumentError(
+      absl::StrFormat("Unknown AST kind: %d", static_cast<int>(ast.kind())));
+}
+
 }  // namespace
 
+std::string LecOutcomeToString(LecOutcome outcome) {
+  switch (outcome) {
+    case LecOutcome::kProven:
+      return "proven";
+    case LecOutcome::kFailed:
+      return "failed";
+    case LecOutcome::kTimedOut:
+      return "timed out";
+  }
+  return absl::StrFormat("<invalid LecOutcome(%d)>",
+                         static_cast<int>(outcome));
+}
+
 absl::StatusOr<std::unique_ptr<Lec>> Lec::Create(const LecParams& params) {
-  auto lec = absl::WrapUnique<Lec>(
-      new Lec(params.ir_package, params.ir_function, params.netlist,
-              params.netlist_module_name, absl::nullopt, 0));
+  auto lec = absl::WrapUnique<Lec>(new Lec(
+      params.ir_package, params.ir_function, params.netlist,
+      params.netlist_module_name, absl::nullopt, 0,
+      /*solver_threads=*/std::thread::hardware_concurrency()));
   XLS_RETURN_IF_ERROR(lec->Init());
   return lec;
 }
@@ -67,22 +217,25 @@ absl::StatusOr<std::unique_ptr<Lec>> Lec::Create(const LecParams& params) {
 // the more-explicit invocation style here.
 absl::StatusOr<std::unique_ptr<Lec>> Lec::CreateForStage(
     const LecParams& params, const PipelineSchedule& schedule, int stage) {
-  auto lec = absl::WrapUnique<Lec>(
-      new Lec(params.ir_package, params.ir_function, params.netlist,
-              params.netlist_module_name, schedule, stage));
+  auto lec = absl::WrapUnique<Lec>(new Lec(
+      params.ir_package, params.ir_function, params.netlist,
+      params.netlist_module_name, schedule, stage,
+      /*solver_threads=*/std::thread::hardware_concurrency()));
   XLS_RETURN_IF_ERROR(lec->Init());
   return lec;
 }
 
 Lec::Lec(Package* ir_package, Function* ir_function, Netlist* netlist,
          const std::string& netlist_module_name,
-         absl::optional<PipelineSchedule> schedule, int stage)
+         absl::optional<PipelineSchedule> schedule, int stage,
+         int solver_threads)
     : ir_package_(ir_package),
       ir_function_(ir_function),
       netlist_(netlist),
       netlist_module_name_(netlist_module_name),
       schedule_(schedule),
-      stage_(stage) {}
+      stage_(stage),
+      solver_threads_(solver_threads) {}
 
 Lec::~Lec() {
   if (model_) {
@@ -111,7 +264,6 @@ absl::Status Lec::Init() {
   // Helpful for reading result output.
   Z3_ast x = Z3_mk_const(ctx(), Z3_mk_string_symbol(ctx(), "X"),
                          Z3_mk_bv_sort(ctx(), 1));
-  std::vector<Z3_ast> eq_nodes;
   for (const Node* node : ir_output_nodes_) {
     // Extract the individual bits out of each IR output node, and match those
     // up the corresponding netlist bits. The netlist outputs do not contain
@@ -135,15 +287,17 @@ absl::Status Lec::Init() {
       } else {
         ir_outputs_.push_back(ir_bits[i]);
         netlist_outputs_.push_back(netlist_bits[i]);
-        eq_nodes.push_back(Z3_mk_eq(ctx(), ir_bits[i], netlist_bits[i]));
+        eq_nodes_.push_back(Z3_mk_eq(ctx(), ir_bits[i], netlist_bits[i]));
+        // The flattened value is MSB-first; name bits from the LSB, as the
+        // netlist does.
+        eq_bits_.push_back({node, ir_bits.size() - 1 - i});
       }
     }
   }
 
-  Z3_ast eval_node = Z3_mk_and(ctx(), eq_nodes.size(), eq_nodes.data());
-  eval_node = Z3_mk_not(ctx(), eval_node);
-  solver_ = CreateSolver(ctx(), std::thread::hardware_concurrency());
-  Z3_solver_assert(ctx(), solver_.value(), eval_node);
+  // The miter itself is asserted by Run() or, a group of output bits at a
+  // time, by CheckOutputBits().
+  solver_ = CreateSolver(ctx(), solver_threads_);
 
   return absl::OkStatus();
 }
@@ -263,11 +417,16 @@ absl::Status Lec::AddConstraints(Function* constraints) {
   Z3_ast eq_node = Z3_mk_eq(ctx(), constraint_translator->GetReturnNode(),
                             Z3_mk_int(ctx(), 1, Z3_mk_bv_sort(ctx(), 1)));
   Z3_solver_assert(ctx(), solver_.value(), eq_node);
+  constrained_ = true;
   return absl::OkStatus();
 }
 
 bool Lec::Run() {
   XLS_LOG(INFO) << "Beginning execution";
+  Z3_ast eval_node = Z3_mk_and(ctx(), eq_nodes_.size(), eq_nodes_.data());
+  eval_node = Z3_mk_not(ctx(), eval_node);
+  SetSolverTimeout(ctx(), solver_.value(), absl::InfiniteDuration());
+  Z3_solver_assert(ctx(), solver_.value(), eval_node);
   satisfiable_ = Z3_solver_check(ctx(), solver_.value()) == Z3_L_TRUE;
   if (satisfiable_) {
     model_ = Z3_solver_get_model(ctx(), solver_.value());
@@ -276,6 +435,554 @@ bool Lec::Run() {
   return !satisfiable_;
 }
 
+absl::StatusOr<LecOutcome> Lec::CheckOutputBits(int64_t first_bit,
+                                                 int64_t bit_count,
+                                                 absl::Duration timeout,
+                                                 std::string* detail) {
+  XLS_RET_CHECK(first_bit >= 0 && bit_count >= 0 &&
+                first_bit + bit_count <= output_bit_count())
+      << "Invalid output bit range: " << first_bit << " + " << bit_count;
+  if (bit_count == 0) {
+    return LecOutcome::kProven;
+  }
+
+  Z3_solver solver = solver_.value();
+  SetSolverTimeout(ctx(), solver, timeout);
+  Z3_solver_push(ctx(), solver);
+  Z3_ast eval_node =
+      Z3_mk_and(ctx(), bit_count, eq_nodes_.data() + first_bit);
+  Z3_solver_assert(ctx(), solver, Z3_mk_not(ctx(), eval_node));
+  Z3_lbool result = Z3_solver_check(ctx(), solver);
+  LecOutcome outcome;
+  switch (result) {
+    case Z3_L_FALSE:
+      outcome = LecOutcome::kProven;
+      break;
+    case Z3_L_TRUE: {
+      outcome = LecOutcome::kFailed;
+      *detail = SolverResultToString(ctx(), solver, result, /*hexify=*/true);
+      Z3_model model = Z3_solver_get_model(ctx(), solver);
+      Z3_model_inc_ref(ctx(), model);
+      std::vector<std::string> mismatches;
+      for (int64_t i = first_bit; i < first_bit + bit_count; ++i) {
+        Z3_ast eq_eval;
+        Z3_model_eval(ctx(), model, eq_nodes_[i], /*model_completion=*/true,
+                      &eq_eval);
+        if (Z3_get_bool_value(ctx(), eq_eval) == Z3_L_FALSE) {
+          mismatches.push_back(OutputBitsToString(i, 1));
+        }
+      }
+      Z3_model_dec_ref(ctx(), model);
+      absl::StrAppend(detail, "\nMismatched output bits: ",
+                      absl::StrJoin(mismatches, ", "));
+      break;
+    }
+    default:
+      outcome = LecOutcome::kTimedOut;
+      *detail = Z3_solver_get_reason_unknown(ctx(), solver);
+      break;
+  }
+  Z3_solver_pop(ctx(), solver, 1);
+  return outcome;
+}
+
+absl::StatusOr<bool> Lec::RunWithSweeping(const SweepOptions& options) {
+  sweep_stats_ = SweepStats();
+  XLS_ASSIGN_OR_RETURN(std::vector<SweepCandidate> candidates,
+                       FindSweepCandidates(options));
+
+  // Cut-points (and proven nets of IR nodes not cut) are applied to later
+  // proofs by substituting their replacements into the compared terms: a
+  // cut-point's IR value and nets are replaced by a free variable, and any
+  // other proven net by its IR bit.
+  std::vector<Z3_ast> from;
+  std::vector<Z3_ast> to;
+  absl::flat_hash_set<Z3_ast> replaced;
+  auto substitute = [&](Z3_ast ast) {
+    if (from.empty()) {
+      return ast;
+    }
+    return Z3_substitute(ctx(), ast, from.size(), from.data(), to.data());
+  };
+  // The proven equivalences between the original terms.
+  std::vector<Z3_ast> lemmas;
+
+  Z3_solver solver = solver_.value();
+  SetSolverTimeout(ctx(), solver, options.candidate_timeout);
+  for (const SweepCandidate& candidate : candidates) {
+    Z3_ast ir_value = ir_translator_->GetTranslation(candidate.node);
+    int64_t bit_count = candidate.bit_nets.size();
+    // Every candidate net of a bit is checked, not just the first: netlists
+    // often hold several copies of a value (e.g., buffered or passed through
+    // to later rows of an array), and a cut-point only cuts the logic reading
+    // the nets it replaces.
+    std::vector<std::vector<Z3_ast>> proven_nets(bit_count);
+    for (int64_t bit = 0; bit < bit_count; ++bit) {
+      Z3_ast ir_bit = Z3_mk_extract(ctx(), bit, bit, ir_value);
+      for (NetRef net : candidate.bit_nets[bit]) {
+        // Nets outside the logic being checked have no translation. Nets
+        // already replaced are still checked (against their replacement), so
+        // that a node whose bits were cut before can be cut again.
+        absl::StatusOr<Z3_ast> net_value =
+            netlist_translator_->GetTranslation(net);
+        if (!net_value.ok()) {
+          continue;
+        }
+        sweep_stats_.candidate_count++;
+        Z3_solver_push(ctx(), solver);
+        Z3_ast eq = Z3_mk_eq(ctx(), substitute(ir_bit),
+                             substitute(net_value.value()));
+        Z3_solver_assert(ctx(), solver, Z3_mk_not(ctx(), eq));
+        Z3_lbool result = Z3_solver_check(ctx(), solver);
+        Z3_solver_pop(ctx(), solver, 1);
+        if (result == Z3_L_FALSE) {
+          sweep_stats_.proven_count++;
+          proven_nets[bit].push_back(net_value.value());
+          lemmas.push_back(Z3_mk_eq(ctx(), ir_bit, net_value.value()));
+          continue;
+        }
+        if (result == Z3_L_TRUE) {
+          sweep_stats_.disproven_count++;
+        } else {
+          sweep_stats_.timed_out_count++;
+        }
+      }
+    }
+
+    bool all_proven = std::all_of(
+        proven_nets.begin(), proven_nets.end(),
+        [](const std::vector<Z3_ast>& nets) { return !nets.empty(); });
+    if (all_proven && !replaced.contains(ir_value)) {
+      // Bits proven equal to nets replaced by earlier cut-points keep those
+      // replacements, so that the cut-points stay related; the others become
+      // free variables.
+      std::vector<Z3_ast> cut_bits(bit_count);
+      for (int64_t bit = 0; bit < bit_count; ++bit) {
+        for (Z3_ast net_value : proven_nets[bit]) {
+          if (replaced.contains(net_value)) {
+            cut_bits[bit] = substitute(net_value);
+            break;
+          }
+        }
+        if (cut_bits[bit] == nullptr) {
+          cut_bits[bit] =
+              Z3_mk_fresh_const(ctx(), candidate.node->GetName().c_str(),
+                                Z3_mk_bv_sort(ctx(), 1));
+        }
+      }
+      Z3_ast cut = cut_bits[bit_count - 1];
+      for (int64_t bit = bit_count - 2; bit >= 0; --bit) {
+        cut = Z3_mk_concat(ctx(), cut, cut_bits[bit]);
+      }
+      from.push_back(ir_value);
+      to.push_back(cut);
+      replaced.insert(ir_value);
+      for (int64_t bit = 0; bit < bit_count; ++bit) {
+        for (Z3_ast net_value : proven_nets[bit]) {
+          if (replaced.insert(net_value).second) {
+            from.push_back(net_value);
+            to.push_back(cut_bits[bit]);
+          }
+        }
+      }
+      sweep_stats_.cut_point_count++;
+      continue;
+    }
+    for (int64_t bit = 0; bit < bit_count; ++bit) {
+      for (Z3_ast net_value : proven_nets[bit]) {
+        if (!replaced.contains(net_value)) {
+          Z3_ast ir_bit =
+              substitute(Z3_mk_extract(ctx(), bit, bit, ir_value));
+          from.push_back(net_value);
+          to.push_back(ir_bit);
+          replaced.insert(net_value);
+        }
+      }
+    }
+  }
+  XLS_VLOG(1) << absl::StreamFormat(
+      "Sweeping: %d candidates, %d proven, %d disproven, %d timed out; %d "
+      "cut-points",
+      sweep_stats_.candidate_count, sweep_stats_.proven_count,
+      sweep_stats_.disproven_count, sweep_stats_.timed_out_count,
+      sweep_stats_.cut_point_count);
+
+  if (!from.empty()) {
+    SetSolverTimeout(ctx(), solver, absl::InfiniteDuration());
+    Z3_ast eval_node = Z3_mk_and(ctx(), eq_nodes_.size(), eq_nodes_.data());
+    Z3_solver_push(ctx(), solver);
+    Z3_solver_assert(ctx(), solver, Z3_mk_not(ctx(), substitute(eval_node)));
+    Z3_lbool result = Z3_solver_check(ctx(), solver);
+    Z3_solver_pop(ctx(), solver, 1);
+    if (result == Z3_L_FALSE) {
+      satisfiable_ = false;
+      return true;
+    }
+  }
+
+  // The cut miter is satisfiable, but that may be due to the cut-points
+  // alone; only the full miter gives a real answer (and counterexample).
+  sweep_stats_.used_full_miter = true;
+  for (Z3_ast lemma : lemmas) {
+    Z3_solver_assert(ctx(), solver, lemma);
+  }
+  return Run();
+}
+
+absl::StatusOr<LecOutcome> Lec::RunWithSat(absl::Duration timeout,
+                                           std::string* detail) {
+  if (constrained_) {
+    return absl::UnimplementedError(
+        "Constraints aren't supported by the SAT engine.");
+  }
+  absl::Time deadline = absl::Now() + timeout;
+  Aig aig;
+
+  // The IR inputs become the graph's inputs, shared by the IR and netlist.
+  std::vector<const Node*> input_nodes;
+  for (const auto& pair : input_mapping_) {
+    input_nodes.push_back(pair.first);
+  }
+  std::sort(input_nodes.begin(), input_nodes.end(),
+            [](const Node* a, const Node* b) { return a->id() < b->id(); });
+  absl::flat_hash_map<const Node*, AigIrTranslator::Vector> bindings;
+  absl::flat_hash_map<NetRef, AigLiteral> net_values;
+  for (const Node* node : input_nodes) {
+    AigIrTranslator::Vector bits;
+    for (int64_t i = 0; i < node->GetType()->GetFlatBitCount(); ++i) {
+      bits.push_back(aig.AddInput());
+    }
+    AigIrTranslator::Vector netlist_order = bits;
+    ReverseBitsElements(node->GetType(), absl::MakeSpan(netlist_order));
+    std::vector<std::vector<NetRef>> nets = GetNetlistInputNets(node);
+    for (int64_t i = 0; i < nets.size(); ++i) {
+      for (NetRef net : nets[i]) {
+        net_values[net] = netlist_order[i];
+      }
+    }
+    bindings[node] = std::move(bits);
+  }
+  AigIrTranslator ir_translator(&aig, bindings);
+  XLS_RETURN_IF_ERROR(TranslateNetlistToAig(&aig, &net_values));
+
+  // Pair up the compared output bits as Init() does.
+  std::vector<AigLiteral> ir_bits;
+  std::vector<AigLiteral> netlist_bits;
+  for (const Node* node : ir_output_nodes_) {
+    // Translation doesn't modify the node.
+    XLS_ASSIGN_OR_RETURN(AigIrTranslator::Vector bits,
+                         ir_translator.Translate(const_cast<Node*>(node)));
+    ReverseBitsElements(node->GetType(), absl::MakeSpan(bits));
+    XLS_ASSIGN_OR_RETURN(std::vector<NetRef> netrefs, GetIrNetrefs(node));
+    netrefs.erase(std::remove_if(netrefs.begin(), netrefs.end(),
+                                 [](NetRef net) {
+                                   return net != nullptr &&
+                                          net->name() == "output_valid";
+                                 }),
+                  netrefs.end());
+    XLS_RET_CHECK_EQ(bits.size(), netrefs.size());
+    for (int64_t i = 0; i < bits.size(); ++i) {
+      if (netrefs[i] == nullptr) {
+        continue;
+      }
+      auto it = net_values.find(netrefs[i]);
+      XLS_RET_CHECK(it != net_values.end()) << netrefs[i]->name();
+      ir_bits.push_back(bits[i]);
+      netlist_bits.push_back(it->second);
+    }
+  }
+  XLS_RET_CHECK_EQ(ir_bits.size(), output_bit_count());
+
+  AigEquivalenceResult result =
+      CheckAigEquivalence(&aig, ir_bits, netlist_bits, deadline);
+  XLS_VLOG(1) << absl::StreamFormat(
+      "SAT engine: %d AIG nodes; %d SAT variables, %d conflicts",
+      aig.node_count(), result.sat_variable_count, result.sat_conflict_count);
+  switch (result.outcome) {
+    case AigEquivalence::kEquivalent:
+      return LecOutcome::kProven;
+    case AigEquivalence::kUnknown:
+      *detail = "The SAT solver timed out.";
+      return LecOutcome::kTimedOut;
+    case AigEquivalence::kNotEquivalent:
+      break;
+  }
+
+  std::vector<std::string> inputs;
+  for (const Node* node : input_nodes) {
+    Value value = AigIrTranslator::UnflattenValue(
+        node->GetType(), aig.Evaluate(result.counterexample, bindings[node]));
+    inputs.push_back(absl::StrFormat("  %s: %s", node->GetName(),
+                                     value.ToString(FormatPreference::kHex)));
+  }
+  absl::InlinedVector<bool, 64> ir_values =
+      aig.Evaluate(result.counterexample, ir_bits);
+  absl::InlinedVector<bool, 64> netlist_values =
+      aig.Evaluate(result.counterexample, netlist_bits);
+  std::vector<std::string> mismatches;
+  for (int64_t i = 0; i < ir_values.size(); ++i) {
+    if (ir_values[i] != netlist_values[i]) {
+      mismatches.push_back(OutputBitsToString(i, 1));
+    }
+  }
+  *detail = absl::StrCat("Inputs:\n", absl::StrJoin(inputs, "\n"),
+                         "\nMismatched output bits: ",
+                         absl::StrJoin(mismatches, ", "));
+  return LecOutcome::kFailed;
+}
+
+absl::Status Lec::TranslateNetlistToAig(
+    Aig* aig, absl::flat_hash_map<NetRef, AigLiteral>* nets) {
+  for (const char* name : {"clk", "input_valid"}) {
+    absl::StatusOr<NetRef> net = module_->ResolveNet(name);
+    if (net.ok()) {
+      (*nets)[net.value()] = Aig::kTrue;
+    }
+  }
+  XLS_ASSIGN_OR_RETURN(NetRef zero, module_->ResolveNumber(0));
+  XLS_ASSIGN_OR_RETURN(NetRef one, module_->ResolveNumber(1));
+  (*nets)[zero] = Aig::kFalse;
+  (*nets)[one] = Aig::kTrue;
+
+  absl::flat_hash_set<std::string> module_names;
+  for (const std::unique_ptr<Module>& module : netlist_->modules()) {
+    module_names.insert(module->name());
+  }
+  std::deque<NetRef> active_nets;
+  auto translate_cell = [&](const Cell& cell) -> absl::Status {
+    const netlist::CellLibraryEntry* entry = cell.cell_library_entry();
+    if (entry->state_table().has_value() ||
+        module_names.contains(entry->name())) {
+      return absl::UnimplementedError(
+          absl::StrFormat("Cell %s (%s) isn't supported by the SAT engine.",
+                          cell.name(), entry->name()));
+    }
+    for (const Cell::Pin& output : cell.outputs()) {
+      // Bound nets, e.g., stage input registers, keep their bindings.
+      if (nets->contains(output.netref)) {
+        continue;
+      }
+      XLS_ASSIGN_OR_RETURN(Ast ast,
+                           netlist::function::Parser::ParseFunction(
+                               entry->output_pin_to_function().at(output.name)));
+      XLS_ASSIGN_OR_RETURN((*nets)[output.netref],
+                           FunctionToAig(aig, cell, ast, *nets));
+      active_nets.push_back(output.netref);
+    }
+    return absl::OkStatus();
+  };
+
+  // As in NetlistTranslator::Translate(), cells are translated once all their
+  // input nets have been.
+  absl::flat_hash_map<const Cell*, absl::flat_hash_set<NetRef>> cell_inputs;
+  for (const std::unique_ptr<Cell>& cell : module_->cells()) {
+    for (const Cell::Pin& input : cell->inputs()) {
+      if (!nets->contains(input.netref)) {
+        cell_inputs[cell.get()].insert(input.netref);
+      }
+    }
+  }
+  for (const std::unique_ptr<Cell>& cell : module_->cells()) {
+    if (!cell_inputs.contains(cell.get())) {
+      XLS_RETURN_IF_ERROR(translate_cell(*cell));
+    }
+  }
+  while (!active_nets.empty()) {
+    NetRef net = active_nets.front();
+    active_nets.pop_front();
+    for (const Cell* cell : net->connected_cells()) {
+      auto it = cell_inputs.find(cell);
+      if (it == cell_inputs.end() || !it->second.erase(net) ||
+          !it->second.empty()) {
+        continue;
+      }
+      XLS_RETURN_IF_ERROR(translate_cell(*cell));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<Lec::SweepCandidate>> Lec::FindSweepCandidates(
+    const SweepOptions& options) {
+  constexpr int64_t kLaneCount = netlist::CompiledInterpreter::kLaneCount;
+  XLS_RET_CHECK_GT(options.sample_count, 0);
+  int64_t batch_count = (options.sample_count + kLaneCount - 1) / kLaneCount;
+
+  // The netlist is evaluated with registered flops, whose outputs - including
+  // the stage input registers bound to the IR inputs - are set directly.
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<netlist::CompiledInterpreter> interpreter,
+      netlist::CompiledInterpreter::Create(
+          netlist_, module_,
+          netlist::CompiledInterpreter::FlopMode::kRegistered));
+
+  std::vector<const Node*> input_nodes;
+  for (const auto& pair : input_mapping_) {
+    input_nodes.push_back(pair.first);
+  }
+  std::sort(input_nodes.begin(), input_nodes.end(),
+            [](const Node* a, const Node* b) { return a->id() < b->id(); });
+  // For each input node bit, the value buffer indices of its nets.
+  std::vector<std::vector<std::vector<int64_t>>> input_indices;
+  absl::flat_hash_set<NetRef> input_nets;
+  for (const Node* node : input_nodes) {
+    std::vector<std::vector<int64_t>> bit_indices;
+    for (const std::vector<NetRef>& nets : GetNetlistInputNets(node)) {
+      std::vector<int64_t> indices;
+      for (NetRef net : nets) {
+        XLS_ASSIGN_OR_RETURN(int64_t index, interpreter->GetNetIndex(net));
+        indices.push_back(index);
+        input_nets.insert(net);
+      }
+      bit_indices.push_back(std::move(indices));
+    }
+    input_indices.push_back(std::move(bit_indices));
+  }
+
+  std::vector<Node*> nodes;
+  if (CheckingSingleStage(schedule_, stage_)) {
+    absl::Span<Node* const> stage_nodes = schedule_->nodes_in_cycle(stage_);
+    nodes.assign(stage_nodes.begin(), stage_nodes.end());
+  } else {
+    for (Node* node : TopoSort(ir_function_)) {
+      nodes.push_back(node);
+    }
+  }
+  nodes.erase(std::remove_if(nodes.begin(), nodes.end(),
+                             [&](Node* node) {
+                               return input_mapping_.contains(node);
+                             }),
+              nodes.end());
+
+  // The simulated values of each bits-typed IR node bit and netlist net, one
+  // word (of kLaneCount input vectors) per batch. Nodes the interpreter can't
+  // evaluate (or which depend on such nodes) are left out.
+  absl::flat_hash_map<const Node*, std::vector<std::vector<uint64_t>>>
+      ir_values;
+  absl::flat_hash_set<const Node*> unsimulated;
+  std::vector<std::vector<uint64_t>> net_values(batch_count);
+  std::minstd_rand engine(options.seed);
+  for (int64_t batch = 0; batch < batch_count; ++batch) {
+    std::vector<uint64_t>& buffer = net_values[batch];
+    buffer.assign(interpreter->net_count(), 0);
+    for (int64_t lane = 0; lane < kLaneCount; ++lane) {
+      uint64_t lane_bit = uint64_t{1} << lane;
+      absl::flat_hash_map<const Node*, Value> values;
+      for (int64_t i = 0; i < input_nodes.size(); ++i) {
+        Value value = RandomValue(input_nodes[i]->GetType(), &engine);
+        std::vector<bool> bits;
+        FlattenValueBits(value, &bits);
+        for (int64_t bit = 0; bit < bits.size(); ++bit) {
+          if (bits[bit]) {
+            for (int64_t index : input_indices[i][bit]) {
+              buffer[index] |= lane_bit;
+            }
+          }
+        }
+        values[input_nodes[i]] = std::move(value);
+      }
+
+      for (Node* node : nodes) {
+        std::vector<Value> operand_values;
+        for (Node* operand : node->operands()) {
+          auto it = values.find(operand);
+          if (it == values.end()) {
+            break;
+          }
+          operand_values.push_back(it->second);
+        }
+        absl::StatusOr<Value> value =
+            operand_values.size() == node->operand_count()
+                ? InterpretNode(node, operand_values)
+                : absl::UnavailableError("Operand not simulated.");
+        if (!value.ok()) {
+          unsimulated.insert(node);
+          continue;
+        }
+        if (value.value().IsBits()) {
+          std::vector<std::vector<uint64_t>>& node_values = ir_values[node];
+          const Bits& bits = value.value().bits();
+          node_values.resize(bits.bit_count(),
+                             std::vector<uint64_t>(batch_count, 0));
+          for (int64_t bit = 0; bit < bits.bit_count(); ++bit) {
+            if (bits.Get(bit)) {
+              node_values[bit][batch] |= lane_bit;
+            }
+          }
+        }
+        values[node] = std::move(value).value();
+      }
+    }
+    interpreter->Run(absl::MakeSpan(buffer));
+  }
+
+  absl::flat_hash_map<std::vector<uint64_t>, std::vector<NetRef>>
+      nets_by_values;
+  for (const std::unique_ptr<netlist::rtl::NetDef>& net : module_->nets()) {
+    absl::StatusOr<int64_t> index = interpreter->GetNetIndex(net.get());
+    if (!index.ok() || input_nets.contains(net.get())) {
+      continue;
+    }
+    std::vector<uint64_t> values(batch_count);
+    for (int64_t batch = 0; batch < batch_count; ++batch) {
+      values[batch] = net_values[batch][index.value()];
+    }
+    if (!IsConstant(values)) {
+      nets_by_values[values].push_back(net.get());
+    }
+  }
+
+  std::vector<SweepCandidate> candidates;
+  for (Node* node : nodes) {
+    if (unsimulated.contains(node) || !ir_values.contains(node)) {
+      continue;
+    }
+    const std::vector<std::vector<uint64_t>>& node_values = ir_values[node];
+    SweepCandidate candidate{node, {}};
+    candidate.bit_nets.resize(node_values.size());
+    bool matched = false;
+    for (int64_t bit = 0; bit < node_values.size(); ++bit) {
+      if (IsConstant(node_values[bit])) {
+        continue;
+      }
+      auto it = nets_by_values.find(node_values[bit]);
+      if (it != nets_by_values.end()) {
+        candidate.bit_nets[bit] = it->second;
+        matched = true;
+      }
+    }
+    if (matched) {
+      candidates.push_back(std::move(candidate));
+    }
+  }
+  return candidates;
+}
+
+std::string Lec::OutputBitsToString(int64_t first_bit,
+                                    int64_t bit_count) const {
+  // Runs of consecutive bits of the same node (which are compared MSB first)
+  // are described as ranges.
+  std::vector<std::string> ranges;
+  int64_t end = first_bit + bit_count;
+  for (int64_t i = first_bit; i < end; ++i) {
+    const Node* node = eq_bits_[i].first;
+    int64_t high = eq_bits_[i].second;
+    int64_t low = high;
+    while (i + 1 < end && eq_bits_[i + 1].first == node &&
+           eq_bits_[i + 1].second == low - 1) {
+      ++i;
+      --low;
+    }
+    if (low == high) {
+      ranges.push_back(absl::StrFormat("%s[%d]", node->GetName(), low));
+    } else {
+      ranges.push_back(
+          absl::StrFormat("%s[%d:%d]", node->GetName(), high, low));
+    }
+  }
+  return absl::StrJoin(ranges, ", ");
+}
+
 std::string Lec::ResultToString() {
   std::vector<std::string> output;
   output.push_back(SolverResultToString(ctx(), solver_.value(),
@@ -329,41 +1036,53 @@ absl::Status Lec::BindNetlistInputs() {
 absl::flat_hash_map<std::string, Z3_ast> Lec::FlattenNetlistInputs() {
   absl::flat_hash_map<std::string, Z3_ast> netlist_inputs;
   for (const auto& pair : input_mapping_) {
-    // We need to reverse the entire bits vector, per item 1 in the header
-    // description, and we need to pass true as little_endian to FlattenValue
-    // per item 2.
     const Node* node = pair.first;
     Z3_ast translation = pair.second;
     std::vector<Z3_ast> bits = ir_translator_->FlattenValue(
         node->GetType(), translation, /*little_endian=*/true);
-    std::reverse(bits.begin(), bits.end());
+    std::vector<std::vector<NetRef>> nets = GetNetlistInputNets(node);
     for (int i = 0; i < bits.size(); i++) {
-      // We have a flat IR node that's our input; we need to find the matching
-      // cells and use their outputs.
-      std::string name;
-      if (bits.size() == 1) {
-        name = NodeToNetlistName(node, absl::nullopt);
-      } else {
-        name = NodeToNetlistName(node, i);
+      for (NetRef net : nets[i]) {
+        netlist_inputs[net->name()] = bits[i];
       }
+    }
+  }
 
-      // Get the cell...
-      auto status_or_cell = module_->ResolveCell(name);
-      if (!status_or_cell.ok()) {
-        XLS_VLOG(3) << "Could not resolve input cell: " << name << "; skipping";
-        XLS_LOG(INFO) << "Could not resolve input cell: " << name
-                      << "; skipping";
-        continue;
-      }
+  return netlist_inputs;
+}
 
-      // Then plop its output in.
-      for (const auto& output : status_or_cell.value()->outputs()) {
-        netlist_inputs[output.netref->name()] = bits[i];
-      }
+std::vector<std::vector<NetRef>> Lec::GetNetlistInputNets(const Node* node) {
+  // Per item 1 in the header description of FlattenNetlistInputs(), the
+  // netlist numbers the bits in the opposite order to the (little-endian)
+  // flattened IR value. We need to pass true as little_endian to FlattenValue
+  // per item 2.
+  int64_t bit_count = node->GetType()->GetFlatBitCount();
+  std::vector<std::vector<NetRef>> nets(bit_count);
+  for (int64_t i = 0; i < bit_count; i++) {
+    // We have a flat IR node that's our input; we need to find the matching
+    // cells and use their outputs.
+    std::string name;
+    if (bit_count == 1) {
+      name = NodeToNetlistName(node, absl::nullopt);
+    } else {
+      name = NodeToNetlistName(node, bit_count - 1 - i);
+    }
+
+    // Get the cell...
+    auto status_or_cell = module_->ResolveCell(name);
+    if (!status_or_cell.ok()) {
+      XLS_VLOG(3) << "Could not resolve input cell: " << name << "; skipping";
+      XLS_LOG(INFO) << "Could not resolve input cell: " << name << "; skipping";
+      continue;
+    }
+
+    // Then plop its outputs in.
+    for (const auto& output : status_or_cell.value()->outputs()) {
+      nets[i].push_back(output.netref);
     }
   }
 
-  return netlist_inputs;
+  return nets;
 }
 
 absl::StatusOr<std::vector<Z3_ast>> Lec::GetNetlistZ3ForIr(const Node* node) {
@@ -505,6 +1224,112 @@ std::string Lec::NodeToNetlistName(const Node* node,
   return name;
 }
 
+absl::StatusOr<std::vector<LecJobResult>> RunParallelLec(
+    const LecParams& params, const absl::optional<PipelineSchedule>& schedule,
+    const ParallelLecOptions& options) {
+  XLS_RET_CHECK_GT(options.thread_count, 0);
+  XLS_RET_CHECK_GE(options.output_group_size, 0);
+
+  std::vector<int> stages;
+  if (schedule.has_value()) {
+    for (int stage = 0; stage < schedule->length(); ++stage) {
+      stages.push_back(stage);
+    }
+  } else {
+    stages.push_back(-1);
+  }
+
+  // Jobs run concurrently, so each solver gets a single thread.
+  auto create_lec = [&](int stage) -> absl::StatusOr<std::unique_ptr<Lec>> {
+    auto lec = absl::WrapUnique<Lec>(new Lec(
+        params.ir_package, params.ir_function, params.netlist,
+        params.netlist_module_name, schedule, stage, /*solver_threads=*/1));
+    XLS_RETURN_IF_ERROR(lec->Init());
+    return lec;
+  };
+
+  // Each stage must be translated to know how many output bits it has. The
+  // resulting Lecs seed the pools of idle Lecs (each with its own Z3 context)
+  // from which jobs of a stage take one and return it when done; further Lecs
+  // are only created when all of a stage's are busy.
+  std::vector<std::vector<std::unique_ptr<Lec>>> idle_lecs(stages.size());
+  std::vector<absl::Status> stage_statuses(stages.size());
+  ParallelFor(stages.size(), options.thread_count, [&](int64_t i) {
+    absl::StatusOr<std::unique_ptr<Lec>> lec = create_lec(stages[i]);
+    if (lec.ok()) {
+      idle_lecs[i].push_back(std::move(lec).value());
+    } else {
+      stage_statuses[i] = lec.status();
+    }
+  });
+  for (const absl::Status& status : stage_statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+
+  std::vector<LecJobResult> results;
+  std::vector<int64_t> job_stage_indices;
+  for (int64_t i = 0; i < stages.size(); ++i) {
+    const Lec& lec = *idle_lecs[i].front();
+    int64_t bit_count = lec.output_bit_count();
+    int64_t group_size = options.output_group_size == 0
+                             ? std::max<int64_t>(bit_count, 1)
+                             : options.output_group_size;
+    int64_t first_bit = 0;
+    do {
+      LecJobResult result;
+      result.stage = stages[i];
+      result.first_bit = first_bit;
+      result.bit_count = std::min(group_size, bit_count - first_bit);
+      result.outputs = lec.OutputBitsToString(first_bit, result.bit_count);
+      results.push_back(std::move(result));
+      job_stage_indices.push_back(i);
+      first_bit += group_size;
+    } while (first_bit < bit_count);
+  }
+
+  absl::Mutex mutex;
+  std::vector<absl::Status> job_statuses(results.size());
+  ParallelFor(results.size(), options.thread_count, [&](int64_t i) {
+    int64_t stage_index = job_stage_indices[i];
+    std::unique_ptr<Lec> lec;
+    {
+      absl::MutexLock lock(&mutex);
+      if (!idle_lecs[stage_index].empty()) {
+        lec = std::move(idle_lecs[stage_index].back());
+        idle_lecs[stage_index].pop_back();
+      }
+    }
+    if (lec == nullptr) {
+      absl::StatusOr<std::unique_ptr<Lec>> new_lec =
+          create_lec(stages[stage_index]);
+      if (!new_lec.ok()) {
+        job_statuses[i] = new_lec.status();
+        return;
+      }
+      lec = std::move(new_lec).value();
+    }
+
+    LecJobResult& result = results[i];
+    absl::Time start = absl::Now();
+    absl::StatusOr<LecOutcome> outcome = lec->CheckOutputBits(
+        result.first_bit, result.bit_count, options.job_timeout,
+        &result.detail);
+    result.duration = absl::Now() - start;
+    if (outcome.ok()) {
+      result.outcome = outcome.value();
+    } else {
+      job_statuses[i] = outcome.status();
+    }
+
+    absl::MutexLock lock(&mutex);
+    idle_lecs[stage_index].push_back(std::move(lec));
+  });
+  for (const absl::Status& status : job_statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+  return results;
+}
+
 }  // namespace z3
 }  // namespace solvers
 }  // namespace xls
@@ -15,15 +15,21 @@
 #ifndef XLS_SOLVERS_Z3_LEC_H_
 #define XLS_SOLVERS_Z3_LEC_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "xls/ir/package.h"
 #include "xls/netlist/netlist.h"
 #include "xls/scheduling/pipeline_schedule.h"
+#include "xls/solvers/aig.h"
 #include "xls/solvers/z3_ir_translator.h"
 #include "xls/solvers/z3_netlist_translator.h"
 
@@ -48,6 +54,82 @@ struct LecParams {
   std::string netlist_module_name;
 };
 
+// Outcome of an equivalence check (or of one job of a parallel check).
+enum class LecOutcome {
+  // The IR and netlist were proven equivalent.
+  kProven,
+  // A counterexample was found.
+  kFailed,
+  // The solver gave up, e.g., by running out of time.
+  kTimedOut,
+};
+
+std::string LecOutcomeToString(LecOutcome outcome);
+
+// Options for RunParallelLec().
+struct ParallelLecOptions {
+  // The maximum number of output bits checked by each job. If zero, all of a
+  // stage's outputs are checked by a single job.
+  int64_t output_group_size = 0;
+
+  // The number of threads on which to run jobs.
+  int64_t thread_count = 1;
+
+  // The time after which each job gives up.
+  absl::Duration job_timeout = absl::InfiniteDuration();
+};
+
+// The result of one job of RunParallelLec().
+struct LecJobResult {
+  // The pipeline stage checked, or -1 for the whole function.
+  int stage;
+
+  // The range of output bits checked, as indices into the stage's compared
+  // output bits (see Lec::output_bit_count()), along with their names in the
+  // IR, e.g., "add.5[7:0]".
+  int64_t first_bit;
+  int64_t bit_count;
+  std::string outputs;
+
+  LecOutcome outcome;
+  absl::Duration duration;
+
+  // For kFailed outcomes, the counterexample and the mismatched output bits;
+  // for kTimedOut outcomes, the reason the solver gave up.
+  std::string detail;
+};
+
+// Options for Lec::RunWithSweeping().
+struct SweepOptions {
+  // The number of random input vectors simulated to find candidate internal
+  // equivalences. Rounded up to a multiple of 64.
+  int64_t sample_count = 1024;
+
+  // The seed of the random input vectors.
+  int64_t seed = 0;
+
+  // The time after which the proof of each candidate equivalence gives up.
+  absl::Duration candidate_timeout = absl::Seconds(1);
+};
+
+// Statistics of a Lec::RunWithSweeping() run.
+struct SweepStats {
+  // IR node bit/netlist net pairs with matching simulation values, and how
+  // their proofs turned out.
+  int64_t candidate_count = 0;
+  int64_t proven_count = 0;
+  int64_t disproven_count = 0;
+  int64_t timed_out_count = 0;
+
+  // IR nodes, all of whose bits were proven equal to netlist nets, replaced
+  // (along with those nets) by free variables in later proofs.
+  int64_t cut_point_count = 0;
+
+  // True if the final check needed the full, uncut miter, i.e., the cut miter
+  // was satisfiable.
+  bool used_full_miter = false;
+};
+
 // Class for performing logical equivalence checks between a function specified
 // in XLS IR (perhaps converted from DSLX) and a netlist.
 class Lec {
@@ -76,6 +158,50 @@ class Lec {
   // Returns true of the netlist and IR are proved to be equivalent.
   bool Run();
 
+  // As Run(), but first proves internal equivalences between the IR and
+  // netlist and uses them as cut-points (i.e., "SAT sweeping"), which lets the
+  // check scale to large datapaths, such as multipliers, that are intractable
+  // as a single miter. Candidate pairs of IR node bits and netlist nets are
+  // found by simulating both on the same random inputs; they are proven in
+  // topological order in the IR, each under the cut-points proven before it.
+  // If the cut miter can't be proven (which may be spurious, since cut-points
+  // drop the relationships between their inputs), the full miter is checked
+  // with the proven equivalences asserted as lemmas, so the result (and any
+  // counterexample) is the same as Run()'s.
+  absl::StatusOr<bool> RunWithSweeping(const SweepOptions& options);
+
+  // Statistics of the last RunWithSweeping().
+  const SweepStats& sweep_stats() const { return sweep_stats_; }
+
+  // As Run(), but with the built-in SAT solver instead of Z3: the IR and the
+  // netlist are translated into one And-Inverter Graph, where structurally
+  // identical logic merges, and the miter is decided by CheckAigEquivalence(),
+  // giving up after "timeout". On failure (or timeout), "detail" receives the
+  // counterexample as values of the IR inputs (or the reason the check gave
+  // up). Constraints aren't supported, nor are netlist cells with state tables
+  // or which instantiate other modules.
+  absl::StatusOr<LecOutcome> RunWithSat(absl::Duration timeout,
+                                        std::string* detail);
+
+  // The number of output bits compared, i.e., excluding IR output bits not
+  // present in the netlist.
+  int64_t output_bit_count() const { return eq_nodes_.size(); }
+
+  // Checks only the compared output bits [first_bit, first_bit + bit_count),
+  // giving up after "timeout". Checks are incremental: each is made in its own
+  // solver scope, so may be run in turn on the same Lec (before Run()),
+  // reusing the translations and anything learned by earlier checks. On
+  // failure (or timeout), "detail" receives the counterexample and the names
+  // of the mismatched bits (or the reason the solver gave up).
+  absl::StatusOr<LecOutcome> CheckOutputBits(int64_t first_bit,
+                                             int64_t bit_count,
+                                             absl::Duration timeout,
+                                             std::string* detail);
+
+  // Returns a description of the compared output bits [first_bit, first_bit +
+  // bit_count) in terms of the IR nodes they belong to.
+  std::string OutputBitsToString(int64_t first_bit, int64_t bit_count) const;
+
   // Dumps all Z3 values corresponding to IR nodes in the input function.
   void DumpIrTree();
 
@@ -85,9 +211,14 @@ class Lec {
   Z3_context ctx() { return ir_translator_->ctx(); }
 
  private:
+  friend absl::StatusOr<std::vector<LecJobResult>> RunParallelLec(
+      const LecParams& params, const absl::optional<PipelineSchedule>& schedule,
+      const ParallelLecOptions& options);
+
   Lec(Package* ir_package, Function* ir_function,
       netlist::rtl::Netlist* netlist, const std::string& netlist_module_name,
-      absl::optional<PipelineSchedule> schedule, int stage);
+      absl::optional<PipelineSchedule> schedule, int stage,
+      int solver_threads);
   absl::Status Init();
   absl::Status CreateIrTranslator();
   absl::Status CreateNetlistTranslator();
@@ -123,6 +254,30 @@ class Lec {
   absl::StatusOr<std::vector<netlist::rtl::NetRef>> GetIrNetrefs(
       const Node* node);
 
+  // Returns, for each flattened (little-endian) bit of the input node, the
+  // netlist nets to which it is bound (if any).
+  std::vector<std::vector<netlist::rtl::NetRef>> GetNetlistInputNets(
+      const Node* node);
+
+  // An IR node and, for each of its bits (least significant first), the
+  // netlist nets simulated to have the same values.
+  struct SweepCandidate {
+    const Node* node;
+    std::vector<std::vector<netlist::rtl::NetRef>> bit_nets;
+  };
+
+  // Simulates the IR nodes and netlist nets on "options.sample_count" random
+  // inputs and returns the bits-typed IR nodes (in topological order) with
+  // any bits matching nets. Bits with constant values are not matched.
+  absl::StatusOr<std::vector<SweepCandidate>> FindSweepCandidates(
+      const SweepOptions& options);
+
+  // Translates the netlist logic driven by the nets in "nets" (the bound
+  // inputs) into "aig", adding the translation of each net reached to "nets".
+  // Clock and valid inputs are tied high, as by NetlistTranslator.
+  absl::Status TranslateNetlistToAig(
+      Aig* aig, absl::flat_hash_map<netlist::rtl::NetRef, AigLiteral>* nets);
+
   // Returns the name of the netlist wire corresponding to the input node.
   std::string NodeToNetlistName(const Node* node, absl::optional<int> bit_index,
                                 bool is_cell = true);
@@ -152,8 +307,15 @@ class Lec {
   std::vector<Z3_ast> ir_outputs_;
   std::vector<Z3_ast> netlist_outputs_;
 
+  // The equality of each compared output bit of the IR and netlist, and the
+  // IR node and bit index (counting from the LSB of its flattened value) it
+  // was taken from. Each node's bits are compared MSB first.
+  std::vector<Z3_ast> eq_nodes_;
+  std::vector<std::pair<const Node*, int64_t>> eq_bits_;
+
   absl::optional<PipelineSchedule> schedule_;
   int stage_;
+  int solver_threads_;
 
   // Z3 elements are, under the hood, void pointers, but let's respect the
   // interface and use absl::optional to determine live-ness.
@@ -163,8 +325,22 @@ class Lec {
   // value is more understandable.
   bool satisfiable_;
   absl::optional<Z3_model> model_;
+
+  SweepStats sweep_stats_;
+
+  // True if AddConstraints() has been called.
+  bool constrained_ = false;
 };
 
+// Splits the equivalence check of an IR function and netlist into jobs - one
+// per pipeline stage (if "schedule" is given; otherwise the whole function is
+// checked as stage -1) and group of output bits - and runs them concurrently.
+// Each thread checks the groups of a stage incrementally in its own Z3
+// context. Results are returned in stage and output bit order.
+absl::StatusOr<std::vector<LecJobResult>> RunParallelLec(
+    const LecParams& params, const absl::optional<PipelineSchedule>& schedule,
+    const ParallelLecOptions& options);
+
 }  // namespace z3
 }  // namespace solvers
 }  // namespace xls
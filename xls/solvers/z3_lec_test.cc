@@ -17,7 +17,13 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_replace.h"
+#include "absl/time/time.h"
 #include "xls/common/status/matchers.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/netlist/cell_library.h"
 #include "xls/netlist/fake_cell_library.h"
@@ -30,29 +36,122 @@ namespace z3 {
 namespace {
 
 using netlist::rtl::Netlist;
+using ::testing::EndsWith;
+using ::testing::HasSubstr;
+
+// The parsed IR and netlist of a test case, along with the LEC parameters
+// comparing the IR's entry function to the netlist's "main" module.
+struct LecTestCase {
+  std::unique_ptr<Package> package;
+  std::unique_ptr<netlist::CellLibrary> cell_library;
+  std::unique_ptr<Netlist> netlist;
+  LecParams params;
+};
 
-absl::StatusOr<bool> Match(const std::string& ir_text,
-                           const std::string& netlist_text, bool expect_equal) {
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(ir_text));
-  XLS_ASSIGN_OR_RETURN(Function * entry_function, package->EntryFunction());
+absl::StatusOr<std::unique_ptr<LecTestCase>> ParseLecTestCase(
+    const std::string& ir_text, const std::string& netlist_text) {
+  auto test_case = std::make_unique<LecTestCase>();
+  XLS_ASSIGN_OR_RETURN(test_case->package, Parser::ParsePackage(ir_text));
+  XLS_ASSIGN_OR_RETURN(Function * entry_function,
+                       test_case->package->EntryFunction());
 
   XLS_ASSIGN_OR_RETURN(netlist::CellLibrary cell_library,
                        netlist::MakeFakeCellLibrary());
+  test_case->cell_library =
+      std::make_unique<netlist::CellLibrary>(std::move(cell_library));
   netlist::rtl::Scanner scanner(netlist_text);
-  XLS_ASSIGN_OR_RETURN(
-      std::unique_ptr<Netlist> netlist,
-      netlist::rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSIGN_OR_RETURN(test_case->netlist,
+                       netlist::rtl::Parser::ParseNetlist(
+                           test_case->cell_library.get(), &scanner));
+
+  test_case->params.ir_package = test_case->package.get();
+  test_case->params.ir_function = entry_function;
+  test_case->params.netlist = test_case->netlist.get();
+  test_case->params.netlist_module_name = "main";
+  return test_case;
+}
 
-  LecParams params;
-  params.ir_package = package.get();
-  params.ir_function = entry_function;
+absl::StatusOr<bool> Match(const std::string& ir_text,
+                           const std::string& netlist_text, bool expect_equal) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<LecTestCase> test_case,
+                       ParseLecTestCase(ir_text, netlist_text));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Lec> lec,
+                       Lec::Create(test_case->params));
+  return lec->Run();
+}
 
-  params.netlist = netlist.get();
-  params.netlist_module_name = "main";
+// As Match(), but checking the whole function with RunParallelLec().
+absl::StatusOr<std::vector<LecJobResult>> ParallelMatch(
+    const std::string& ir_text, const std::string& netlist_text,
+    const ParallelLecOptions& options) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<LecTestCase> test_case,
+                       ParseLecTestCase(ir_text, netlist_text));
+  return RunParallelLec(test_case->params, /*schedule=*/absl::nullopt,
+                        options);
+}
 
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Lec> lec, Lec::Create(params));
-  return lec->Run();
+// As Match(), but checking with Lec::RunWithSweeping().
+absl::StatusOr<bool> SweepMatch(const std::string& ir_text,
+                                const std::string& netlist_text,
+                                SweepStats* stats) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<LecTestCase> test_case,
+                       ParseLecTestCase(ir_text, netlist_text));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Lec> lec,
+                       Lec::Create(test_case->params));
+  XLS_ASSIGN_OR_RETURN(bool equal, lec->RunWithSweeping(SweepOptions()));
+  *stats = lec->sweep_stats();
+  if (!equal) {
+    XLS_RET_CHECK(absl::StrContains(lec->ResultToString(),
+                                    "satisfiable: true"));
+  }
+  return equal;
+}
+
+// As Match(), but checking with Lec::RunWithSat().
+absl::StatusOr<LecOutcome> SatMatch(const std::string& ir_text,
+                                    const std::string& netlist_text,
+                                    std::string* detail) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<LecTestCase> test_case,
+                       ParseLecTestCase(ir_text, netlist_text));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Lec> lec,
+                       Lec::Create(test_case->params));
+  return lec->RunWithSat(absl::InfiniteDuration(), detail);
+}
+
+constexpr const char kNotIr[] = R"(
+package p
+
+fn main(input: bits[4]) -> bits[4] {
+  ret not.2: bits[4] = not(input)
+}
+)";
+
+// Netlist for kNotIr, with the given cell computing the inverse of bit 1.
+std::string NotNetlist(absl::string_view bit_1_cell) {
+  return absl::StrReplaceAll(R"(
+module main ( clk, input_3_, input_2_, input_1_, input_0_, out_3_, out_2_, out_1_, out_0_);
+  input clk, input_3_, input_2_, input_1_, input_0_;
+  output out_3_, out_2_, out_1_, out_0_;
+  wire p0_input_3_, p0_input_2_, p0_input_1_, p0_input_0_,
+       p0_not_2_comb_3_, p0_not_2_comb_2_, p0_not_2_comb_1_, p0_not_2_comb_0_;
+
+  DFF p0_input_reg_3_ ( .D(input_3_), .CLK(clk), .Q(p0_input_3_) );
+  DFF p0_input_reg_2_ ( .D(input_2_), .CLK(clk), .Q(p0_input_2_) );
+  DFF p0_input_reg_1_ ( .D(input_1_), .CLK(clk), .Q(p0_input_1_) );
+  DFF p0_input_reg_0_ ( .D(input_0_), .CLK(clk), .Q(p0_input_0_) );
+
+  INV p0_not_2_3_ ( .A(p0_input_3_), .ZN(p0_not_2_comb_3_) );
+  INV p0_not_2_2_ ( .A(p0_input_2_), .ZN(p0_not_2_comb_2_) );
+  $BIT_1_CELL
+  INV p0_not_2_0_ ( .A(p0_input_0_), .ZN(p0_not_2_comb_0_) );
+
+  DFF p0_not_2_reg_3_ (.D(p0_not_2_comb_3_), .CLK(clk), .Q(out_3_));
+  DFF p0_not_2_reg_2_ (.D(p0_not_2_comb_2_), .CLK(clk), .Q(out_2_));
+  DFF p0_not_2_reg_1_ (.D(p0_not_2_comb_1_), .CLK(clk), .Q(out_1_));
+  DFF p0_not_2_reg_0_ (.D(p0_not_2_comb_0_), .CLK(clk), .Q(out_0_));
+endmodule
+)",
+                             {{"$BIT_1_CELL", bit_1_cell}});
 }
 
 // This test verifies that we can do a simple LEC.
@@ -135,6 +234,251 @@ endmodule
   ASSERT_FALSE(match);
 }
 
+TEST(Z3LecTest, ParallelPerOutputBit) {
+  ParallelLecOptions options;
+  options.output_group_size = 1;
+  options.thread_count = 3;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<LecJobResult> results,
+      ParallelMatch(kNotIr,
+                    NotNetlist("INV p0_not_2_1_ ( .A(p0_input_1_), "
+                               ".ZN(p0_not_2_comb_1_) );"),
+                    options));
+  ASSERT_EQ(results.size(), 4);
+  for (int i = 0; i < results.size(); i++) {
+    EXPECT_EQ(results[i].stage, -1);
+    EXPECT_EQ(results[i].first_bit, i);
+    EXPECT_EQ(results[i].bit_count, 1);
+    // Bits are compared MSB first.
+    EXPECT_EQ(results[i].outputs, absl::StrFormat("not.2[%d]", 3 - i));
+    EXPECT_EQ(results[i].outcome, LecOutcome::kProven);
+  }
+}
+
+// Only the job holding the mismatched bit should fail.
+TEST(Z3LecTest, ParallelReportsFailingOutputs) {
+  ParallelLecOptions options;
+  options.output_group_size = 2;
+  options.thread_count = 2;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<LecJobResult> results,
+      ParallelMatch(kNotIr,
+                    NotNetlist("OR p0_not_2_1_ ( .A(p0_input_1_), "
+                               ".B(p0_input_1_), .Z(p0_not_2_comb_1_) );"),
+                    options));
+  ASSERT_EQ(results.size(), 2);
+  EXPECT_EQ(results[0].outputs, "not.2[3:2]");
+  EXPECT_EQ(results[0].outcome, LecOutcome::kProven);
+  // Net p0_not_2_1_ is bit 1 of not.2.
+  EXPECT_EQ(results[1].outputs, "not.2[1:0]");
+  EXPECT_EQ(results[1].outcome, LecOutcome::kFailed);
+  EXPECT_THAT(results[1].detail, HasSubstr("satisfiable: true"));
+  EXPECT_THAT(results[1].detail,
+              EndsWith("Mismatched output bits: not.2[1]"));
+
+  // A single job covers all outputs, and so fails.
+  options.output_group_size = 0;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      results,
+      ParallelMatch(kNotIr,
+                    NotNetlist("OR p0_not_2_1_ ( .A(p0_input_1_), "
+                               ".B(p0_input_1_), .Z(p0_not_2_comb_1_) );"),
+                    options));
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_EQ(results[0].bit_count, 4);
+  EXPECT_EQ(results[0].outcome, LecOutcome::kFailed);
+}
+
+// Every bit of not.2 matches two netlist nets (the inverter output and, as
+// simulated, the output register's), so the whole node is cut.
+TEST(Z3LecTest, SweepingCutsProvenNodes) {
+  SweepStats stats;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      bool equal,
+      SweepMatch(kNotIr,
+                 NotNetlist("INV p0_not_2_1_ ( .A(p0_input_1_), "
+                            ".ZN(p0_not_2_comb_1_) );"),
+                 &stats));
+  EXPECT_TRUE(equal);
+  EXPECT_EQ(stats.proven_count, 8);
+  EXPECT_EQ(stats.disproven_count, 0);
+  EXPECT_EQ(stats.cut_point_count, 1);
+  EXPECT_FALSE(stats.used_full_miter);
+}
+
+// A mismatched bit has no candidate net, so the full miter finds the
+// counterexample.
+TEST(Z3LecTest, SweepingFindsMismatches) {
+  SweepStats stats;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      bool equal,
+      SweepMatch(kNotIr,
+                 NotNetlist("OR p0_not_2_1_ ( .A(p0_input_1_), "
+                            ".B(p0_input_1_), .Z(p0_not_2_comb_1_) );"),
+                 &stats));
+  EXPECT_FALSE(equal);
+  EXPECT_EQ(stats.proven_count, 6);
+  EXPECT_EQ(stats.cut_point_count, 0);
+  EXPECT_TRUE(stats.used_full_miter);
+}
+
+TEST(Z3LecTest, SatProvesMatch) {
+  std::string detail;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      LecOutcome outcome,
+      SatMatch(kNotIr,
+               NotNetlist("INV p0_not_2_1_ ( .A(p0_input_1_), "
+                          ".ZN(p0_not_2_comb_1_) );"),
+               &detail));
+  EXPECT_EQ(outcome, LecOutcome::kProven);
+}
+
+// The counterexample names the IR input and the mismatched output bit.
+TEST(Z3LecTest, SatFindsMismatches) {
+  std::string detail;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      LecOutcome outcome,
+      SatMatch(kNotIr,
+               NotNetlist("OR p0_not_2_1_ ( .A(p0_input_1_), "
+                          ".B(p0_input_1_), .Z(p0_not_2_comb_1_) );"),
+               &detail));
+  EXPECT_EQ(outcome, LecOutcome::kFailed);
+  EXPECT_THAT(detail, HasSubstr("Inputs:\n  input: "));
+  EXPECT_THAT(detail, EndsWith("Mismatched output bits: not.2[1]"));
+}
+
+// Returns the IR and netlist of a "width"-bit (truncating) shift-and-add
+// multiplier: the IR adds up the shifted partial products with a chain of adds,
+// and the netlist with rows of ripple-carry adders.
+std::pair<std::string, std::string> ShiftAddMultiplier(int64_t width) {
+  std::string ir = absl::StrFormat(
+      "package p\n\nfn main(x: bits[%d], y: bits[%d]) -> bits[%d] {\n", width,
+      width, width);
+  int64_t id = 1;
+  std::string sum;
+  for (int64_t i = 0; i < width; ++i) {
+    absl::StrAppendFormat(
+        &ir,
+        "  bit_slice.%d: bits[1] = bit_slice(y, start=%d, width=1)\n"
+        "  sign_ext.%d: bits[%d] = sign_ext(bit_slice.%d, new_bit_count=%d)\n"
+        "  and.%d: bits[%d] = and(x, sign_ext.%d)\n",
+        id, i, id + 1, width, id, width, id + 2, width, id + 1);
+    std::string partial_product = absl::StrCat("and.", id + 2);
+    if (i == 0) {
+      sum = partial_product;
+      id += 3;
+      continue;
+    }
+    absl::StrAppendFormat(
+        &ir,
+        "  literal.%d: bits[%d] = literal(value=%d)\n"
+        "  shll.%d: bits[%d] = shll(%s, literal.%d)\n"
+        "  %sadd.%d: bits[%d] = add(%s, shll.%d)\n",
+        id + 3, width, i, id + 4, width, partial_product, id + 3,
+        i == width - 1 ? "ret " : "", id + 5, width, sum, id + 4);
+    sum = absl::StrCat("add.", id + 5);
+    id += 6;
+  }
+  absl::StrAppend(&ir, "}\n");
+
+  // Net s<i>_<j> is bit j of the running sum after row i, c<i>_<j> the carry
+  // into it, and p<i>_<j> the partial product bit added to it.
+  std::vector<std::string> inputs = {"clk"};
+  std::vector<std::string> outputs;
+  std::vector<std::string> wires;
+  std::string cells;
+  int64_t cell_count = 0;
+  auto add_cell = [&](absl::string_view kind, absl::string_view a,
+                      absl::string_view b, const std::string& z) {
+    absl::StrAppendFormat(&cells, "  %s g%d ( .A(%s), .B(%s), .Z(%s) );\n",
+                          kind, cell_count++, a, b, z);
+    wires.push_back(z);
+    return z;
+  };
+  for (absl::string_view input : {"x", "y"}) {
+    for (int64_t j = 0; j < width; ++j) {
+      inputs.push_back(absl::StrFormat("%s_%d_", input, j));
+      wires.push_back(absl::StrFormat("p0_%s_%d_", input, j));
+      absl::StrAppendFormat(
+          &cells,
+          "  DFF p0_%s_reg_%d_ ( .D(%s_%d_), .CLK(clk), .Q(p0_%s_%d_) );\n",
+          input, j, input, j, input, j);
+    }
+  }
+  for (int64_t j = 0; j < width; ++j) {
+    add_cell("AND", absl::StrFormat("p0_x_%d_", j), "p0_y_0_",
+             absl::StrFormat("s0_%d", j));
+  }
+  for (int64_t i = 1; i < width; ++i) {
+    std::string carry;
+    for (int64_t j = 0; j < width; ++j) {
+      std::string previous = absl::StrFormat("s%d_%d", i - 1, j);
+      std::string bit = absl::StrFormat("s%d_%d", i, j);
+      if (j < i) {
+        // Bits below the shifted partial product are passed through.
+        add_cell("AND", previous, previous, bit);
+        continue;
+      }
+      std::string partial_product =
+          add_cell("AND", absl::StrFormat("p0_x_%d_", j - i),
+                   absl::StrFormat("p0_y_%d_", i),
+                   absl::StrFormat("p%d_%d", i, j));
+      std::string half_sum = add_cell("XOR", previous, partial_product,
+                                      absl::StrFormat("h%d_%d", i, j));
+      if (carry.empty()) {
+        add_cell("AND", half_sum, half_sum, bit);
+      } else {
+        add_cell("XOR", half_sum, carry, bit);
+      }
+      if (j == width - 1) {
+        break;
+      }
+      std::string generate = add_cell("AND", previous, partial_product,
+                                      absl::StrFormat("g%d_%d", i, j));
+      std::string next_carry = absl::StrFormat("c%d_%d", i, j + 1);
+      if (carry.empty()) {
+        add_cell("AND", generate, generate, next_carry);
+      } else {
+        std::string propagate = add_cell("AND", half_sum, carry,
+                                         absl::StrFormat("t%d_%d", i, j));
+        add_cell("OR", generate, propagate, next_carry);
+      }
+      carry = next_carry;
+    }
+  }
+  for (int64_t j = 0; j < width; ++j) {
+    outputs.push_back(absl::StrFormat("out_%d_", j));
+    absl::StrAppendFormat(
+        &cells, "  DFF p0_%s_reg_%d_ ( .D(s%d_%d), .CLK(clk), .Q(out_%d_) );\n",
+        absl::StrReplaceAll(sum, {{".", "_"}}), j, width - 1, j, j);
+  }
+  std::string netlist = absl::StrFormat(
+      "module main ( %s, %s );\n  input %s;\n  output %s;\n  wire %s;\n%s"
+      "endmodule\n",
+      absl::StrJoin(inputs, ", "), absl::StrJoin(outputs, ", "),
+      absl::StrJoin(inputs, ", "), absl::StrJoin(outputs, ", "),
+      absl::StrJoin(wires, ", "), cells);
+  return {ir, netlist};
+}
+
+// The plain miter of a shift-and-add multiplier blows up with its width (it
+// takes Run() about a second at 8 bits and half a minute at 10), but sweeping
+// proves each add of the chain in terms of the one before, so scales to widths
+// far beyond that.
+TEST(Z3LecTest, SweepingScalesToMultipliers) {
+  constexpr int64_t kWidth = 16;
+  auto [ir_text, netlist_text] = ShiftAddMultiplier(kWidth);
+  SweepStats stats;
+  XLS_ASSERT_OK_AND_ASSIGN(bool equal,
+                           SweepMatch(ir_text, netlist_text, &stats));
+  EXPECT_TRUE(equal);
+  // The first partial product and every add are cut.
+  EXPECT_EQ(stats.cut_point_count, kWidth);
+  EXPECT_EQ(stats.disproven_count, 0);
+  EXPECT_EQ(stats.timed_out_count, 0);
+  EXPECT_FALSE(stats.used_full_miter);
+}
+
 // This test verifies that we can do a simple multi-stage LEC.
 // There are three defined stages:
 // [inputs] -> p0_AND -> p1_OR -> p2 NOT -> [outputs]
@@ -218,6 +562,18 @@ endmodule
     ASSERT_TRUE(lec->Run());
     XLS_LOG(INFO) << "Pass stage " << i;
   }
+
+  // All stages at once, in parallel.
+  ParallelLecOptions options;
+  options.thread_count = 3;
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<LecJobResult> results,
+                           RunParallelLec(params, schedule, options));
+  ASSERT_EQ(results.size(), schedule.length());
+  for (int i = 0; i < schedule.length(); i++) {
+    EXPECT_EQ(results[i].stage, i);
+    EXPECT_EQ(results[i].outcome, LecOutcome::kProven)
+        << "Stage " << i << ": " << results[i].detail;
+  }
 }
 
 // This test verifies that a non-matching set of inputs "correctly" fails. This
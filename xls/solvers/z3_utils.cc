@@ -13,6 +13,8 @@
 // limitations under the License.
 #include "xls/solvers/z3_utils.h"
 
+#include <limits>
+
 #include "absl/base/internal/sysinfo.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
@@ -21,6 +23,7 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "xls/common/logging/logging.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
@@ -79,6 +82,21 @@ Z3_solver CreateSolver(Z3_context ctx, int num_threads) {
   return solver;
 }
 
+void SetSolverTimeout(Z3_context ctx, Z3_solver solver,
+                      absl::Duration timeout) {
+  // Z3 takes the timeout in milliseconds, with UINT_MAX meaning none.
+  unsigned timeout_ms = std::numeric_limits<unsigned>::max();
+  if (timeout < absl::Milliseconds(timeout_ms)) {
+    timeout_ms = absl::ToInt64Milliseconds(timeout);
+  }
+  Z3_params params = Z3_mk_params(ctx);
+  Z3_params_inc_ref(ctx, params);
+  Z3_params_set_uint(ctx, params, Z3_mk_string_symbol(ctx, "timeout"),
+                     timeout_ms);
+  Z3_solver_set_params(ctx, solver, params);
+  Z3_params_dec_ref(ctx, params);
+}
+
 std::string SolverResultToString(Z3_context ctx, Z3_solver solver,
                                  Z3_lbool satisfiable, bool hexify) {
   std::string result_str;
@@ -19,6 +19,7 @@
 #include <string>
 
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "xls/ir/type.h"
 #include "../z3/src/api/z3.h"
 
@@ -31,6 +32,10 @@ namespace z3 {
 // needed.
 Z3_solver CreateSolver(Z3_context ctx, int num_threads);
 
+// Sets the time after which "solver" gives up on a check.
+void SetSolverTimeout(Z3_context ctx, Z3_solver solver,
+                      absl::Duration timeout);
+
 // Printing / output functions ------------------------------------------------
 // Prints the solver's result, and, if satisfiable, prints a model demonstrating
 // such a case.
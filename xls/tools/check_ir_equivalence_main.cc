@@ -12,27 +12,49 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
 #include <thread>  // NOLINT(build/c++11)
 
 #include "absl/base/internal/sysinfo.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/types/optional.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/interpreter/random_value.h"
+#include "xls/ir/format_preference.h"
+#include "xls/ir/function_builder.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/ir_jit.h"
+#include "xls/passes/bdd_function.h"
 #include "xls/passes/dce_pass.h"
 #include "xls/passes/inlining_pass.h"
 #include "xls/passes/map_inlining_pass.h"
 #include "xls/passes/pass_base.h"
 #include "xls/passes/passes.h"
 #include "xls/passes/unroll_pass.h"
+#include "xls/solvers/aig.h"
+#include "xls/solvers/aig_equivalence.h"
+#include "xls/solvers/aig_ir_translator.h"
 #include "xls/solvers/z3_ir_translator.h"
 #include "xls/solvers/z3_utils.h"
 #include "../z3/src/api/z3.h"
@@ -49,6 +71,17 @@ Example invocation:
 If there are multiple functions in the specified files, then it's _strongly_
 recommended that you specify --function to ensure that the right functions are
 compared. If the tool picks the wrong one, a crash may result.
+
+With --engine=sat, the functions are bit-blasted into a shared and-inverter
+graph and compared with the built-in SAT solver instead of Z3; this is usually
+much faster for datapath-heavy designs that optimization has only lightly
+restructured.
+
+With --engine=portfolio, several strategies race on parallel threads: Z3 with
+different seeds, Z3's bit-blasting QF_BV solver, the SAT engine, a BDD of the
+two functions' miter (which can only prove equivalence) and JIT-compiled random
+simulation (which can only refute it). The first definitive answer is reported
+and the other strategies are cancelled.
 )";
 
 ABSL_FLAG(std::string, function, "",
@@ -56,11 +89,148 @@ ABSL_FLAG(std::string, function, "",
           "and check an entry function for the package.");
 ABSL_FLAG(absl::Duration, timeout, absl::InfiniteDuration(),
           "How long to wait for any proof to complete.");
+ABSL_FLAG(std::string, engine, "z3",
+          "Prover to use: \"z3\" for the Z3 SMT solver, \"sat\" for the "
+          "built-in AIG/SAT engine, or \"portfolio\" to race several "
+          "strategies in parallel.");
+ABSL_FLAG(int64_t, portfolio_z3_seeds, 2,
+          "With --engine=portfolio, the number of differently-seeded Z3 "
+          "solvers to run, besides the QF_BV one.");
 
 namespace xls {
 
 using solvers::z3::IrTranslator;
 
+enum class Verdict {
+  kEquivalent,
+  kNotEquivalent,
+  // The prover gave up, e.g., at the timeout.
+  kUnknown,
+};
+
+// The answer of one prover.
+struct ProverResult {
+  Verdict verdict = Verdict::kUnknown;
+  // The report to print: the solver result and any counterexample.
+  std::string output;
+};
+
+// State shared by the strategies of a portfolio run: the first definitive
+// answer wins and cancels the others.
+class Portfolio {
+ public:
+  Portfolio(int64_t strategy_count, int64_t prover_count)
+      : strategies_running_(strategy_count), provers_running_(prover_count) {}
+
+  // Set once the run is decided; strategies should poll it and give up.
+  const std::atomic<bool>* cancelled() const { return &cancelled_; }
+
+  // Z3 solvers can't poll, so are interrupted via their context instead.
+  // Returns false (without registering "ctx") if the run is already decided.
+  bool RegisterZ3Context(Z3_context ctx) {
+    absl::MutexLock lock(&mutex_);
+    if (cancelled_.load()) {
+      return false;
+    }
+    z3_contexts_.push_back(ctx);
+    return true;
+  }
+  void UnregisterZ3Context(Z3_context ctx) {
+    absl::MutexLock lock(&mutex_);
+    z3_contexts_.erase(
+        std::find(z3_contexts_.begin(), z3_contexts_.end(), ctx));
+  }
+
+  // Records the outcome of the named strategy. "can_prove" says whether it
+  // could ever show equivalence; once every such strategy has finished
+  // undecided, falsifiers are cancelled too, as they can't finish on their
+  // own.
+  void Report(const std::string& name, bool can_prove,
+              absl::StatusOr<ProverResult> result, absl::Duration duration) {
+    absl::MutexLock lock(&mutex_);
+    --strategies_running_;
+    if (!result.ok()) {
+      XLS_LOG(WARNING) << name << " failed: " << result.status();
+      if (error_.ok()) {
+        error_ = result.status();
+      }
+    } else if (result->verdict == Verdict::kUnknown) {
+      XLS_VLOG(1) << name << " finished undecided after "
+                  << absl::FormatDuration(duration);
+    } else if (!winner_.has_value()) {
+      winner_name_ = name;
+      winner_duration_ = duration;
+      winner_ = std::move(result).value();
+      Cancel();
+    }
+    if (can_prove && --provers_running_ == 0) {
+      Cancel();
+    }
+  }
+
+  // Blocks until some strategy has answered definitively, or all have
+  // reported, and returns the winning result, if any, or else the first
+  // error. Strategies still running are left to wind down on their own.
+  absl::StatusOr<ProverResult> Wait() {
+    absl::MutexLock lock(&mutex_);
+    auto decided = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return winner_.has_value() || strategies_running_ == 0;
+    };
+    mutex_.Await(absl::Condition(&decided));
+    // An interrupt which lands before its solver has entered Z3_solver_check()
+    // is lost, so keep interrupting until every registered solver has
+    // returned.
+    auto z3_idle = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return z3_contexts_.empty();
+    };
+    while (!mutex_.AwaitWithTimeout(absl::Condition(&z3_idle),
+                                    absl::Milliseconds(10))) {
+      Cancel();
+    }
+    if (winner_.has_value()) {
+      ProverResult result = *winner_;
+      absl::StrAppendFormat(&result.output, "\nAnswered by %s after %s.",
+                            winner_name_,
+                            absl::FormatDuration(winner_duration_));
+      return result;
+    }
+    XLS_RETURN_IF_ERROR(error_);
+    return ProverResult{Verdict::kUnknown,
+                        "Solver result; satisfiable: undef"};
+  }
+
+ private:
+  void Cancel() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    cancelled_.store(true);
+    for (Z3_context ctx : z3_contexts_) {
+      Z3_interrupt(ctx);
+    }
+  }
+
+  std::atomic<bool> cancelled_{false};
+  absl::Mutex mutex_;
+  int64_t strategies_running_ ABSL_GUARDED_BY(mutex_);
+  int64_t provers_running_ ABSL_GUARDED_BY(mutex_);
+  std::vector<Z3_context> z3_contexts_ ABSL_GUARDED_BY(mutex_);
+  absl::optional<ProverResult> winner_ ABSL_GUARDED_BY(mutex_);
+  std::string winner_name_ ABSL_GUARDED_BY(mutex_);
+  absl::Duration winner_duration_ ABSL_GUARDED_BY(mutex_);
+  absl::Status error_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Formats a counterexample (values of the parameters of "f") after the
+// fashion of SolverResultToString().
+std::string CounterexampleToString(Function* f,
+                                   absl::Span<const Value> args) {
+  std::vector<std::string> lines;
+  for (int64_t i = 0; i < args.size(); ++i) {
+    lines.push_back(absl::StrFormat("%s -> %s", f->param(i)->name(),
+                                    args[i].ToString(FormatPreference::kHex)));
+  }
+  return absl::StrCat("Solver result; satisfiable: true\n\n  Model:\n",
+                      absl::StrJoin(lines, "\n"));
+}
+
 // To compare, simply take the output nodes of each function and compare them.
 absl::StatusOr<Z3_ast> CreateComparisonFunction(
     absl::Span<std::unique_ptr<IrTranslator>> translators,
@@ -76,9 +246,289 @@ absl::StatusOr<Z3_ast> CreateComparisonFunction(
   return Z3_mk_eq(ctx, result1, result2);
 }
 
+// How to configure the Z3 solver.
+struct Z3Options {
+  int threads = 1;
+  // If set, the solver's random seed.
+  absl::optional<int64_t> seed;
+  // If true, uses the solver for QF_BV, which bit-blasts, rather than the
+  // default one.
+  bool bit_blast = false;
+};
+
+absl::StatusOr<ProverResult> CheckWithZ3(
+    const std::vector<Function*>& functions, absl::Duration timeout,
+    const Z3Options& z3_options, Portfolio* portfolio = nullptr) {
+  std::vector<std::unique_ptr<IrTranslator>> translators;
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrTranslator> translator,
+                       IrTranslator::CreateAndTranslate(functions[0]));
+  translators.push_back(std::move(translator));
+
+  // Get the params for the first function, so we can map the second function's
+  // parameters to them.
+  Z3_context ctx = translators[0]->ctx();
+  std::vector<Z3_ast> z3_params;
+  for (const Param* param : functions[0]->params()) {
+    z3_params.push_back(translators[0]->GetTranslation(param));
+  }
+
+  XLS_ASSIGN_OR_RETURN(
+      translator, IrTranslator::CreateAndTranslate(ctx, functions[1],
+                                                   absl::MakeSpan(z3_params)));
+  translators.push_back(std::move(translator));
+
+  XLS_ASSIGN_OR_RETURN(
+      Z3_ast results_equal,
+      CreateComparisonFunction(absl::MakeSpan(translators), functions));
+  translators[0]->SetTimeout(timeout);
+
+  Z3_solver solver;
+  if (z3_options.bit_blast) {
+    solver = Z3_mk_solver_for_logic(ctx, Z3_mk_string_symbol(ctx, "QF_BV"));
+    Z3_solver_inc_ref(ctx, solver);
+  } else {
+    solver = solvers::z3::CreateSolver(ctx, z3_options.threads);
+  }
+  if (z3_options.seed.has_value()) {
+    Z3_params params = Z3_mk_params(ctx);
+    Z3_params_inc_ref(ctx, params);
+    Z3_params_set_uint(ctx, params, Z3_mk_string_symbol(ctx, "random_seed"),
+                       *z3_options.seed);
+    Z3_solver_set_params(ctx, solver, params);
+    Z3_params_dec_ref(ctx, params);
+  }
+
+  // Remember: we try to prove the condition by searching for a model that
+  // produces the opposite result. Thus, we want to find a model where the
+  // results are _not_ equal.
+  Z3_ast objective = Z3_mk_eq(ctx, Z3_mk_false(ctx), results_equal);
+  Z3_solver_assert(ctx, solver, objective);
+
+  Z3_lbool satisfiable = Z3_L_UNDEF;
+  if (portfolio == nullptr || portfolio->RegisterZ3Context(ctx)) {
+    satisfiable = Z3_solver_check(ctx, solver);
+    if (portfolio != nullptr) {
+      portfolio->UnregisterZ3Context(ctx);
+    }
+  }
+  ProverResult result;
+  result.verdict = satisfiable == Z3_L_FALSE  ? Verdict::kEquivalent
+                   : satisfiable == Z3_L_TRUE ? Verdict::kNotEquivalent
+                                              : Verdict::kUnknown;
+  result.output =
+      solvers::z3::SolverResultToString(ctx, solver, satisfiable);
+
+  Z3_solver_dec_ref(ctx, solver);
+
+  return result;
+}
+
+// Bit-blasts both functions into one AIG - the second over the first's
+// parameter bits - and hands the outputs to the SAT-based checker.
+absl::StatusOr<ProverResult> CheckWithSat(
+    const std::vector<Function*>& functions, absl::Duration timeout,
+    const std::atomic<bool>* interrupt = nullptr) {
+  absl::Time deadline = timeout == absl::InfiniteDuration()
+                            ? absl::InfiniteFuture()
+                            : absl::Now() + timeout;
+  XLS_RET_CHECK_EQ(functions[0]->params().size(),
+                   functions[1]->params().size());
+  solvers::Aig aig;
+  solvers::AigIrTranslator translator0(&aig);
+  absl::flat_hash_map<const Node*, solvers::AigIrTranslator::Vector> bindings;
+  for (int64_t i = 0; i < functions[0]->params().size(); ++i) {
+    XLS_ASSIGN_OR_RETURN(bindings[functions[1]->param(i)],
+                         translator0.Translate(functions[0]->param(i)));
+  }
+  solvers::AigIrTranslator translator1(&aig, std::move(bindings));
+  XLS_ASSIGN_OR_RETURN(solvers::AigIrTranslator::Vector result0,
+                       translator0.Translate(functions[0]->return_value()));
+  XLS_ASSIGN_OR_RETURN(solvers::AigIrTranslator::Vector result1,
+                       translator1.Translate(functions[1]->return_value()));
+  XLS_RET_CHECK_EQ(result0.size(), result1.size());
+
+  solvers::AigEquivalenceResult equivalence = solvers::CheckAigEquivalence(
+      &aig, result0, result1, deadline, interrupt);
+  XLS_VLOG(1) << absl::StreamFormat(
+      "AIG: %d nodes; SAT: %d variables, %d conflicts", aig.node_count(),
+      equivalence.sat_variable_count, equivalence.sat_conflict_count);
+
+  // Mirror the Z3 output so existing consumers can parse either.
+  switch (equivalence.outcome) {
+    case solvers::AigEquivalence::kEquivalent:
+      return ProverResult{Verdict::kEquivalent,
+                          "Solver result; satisfiable: false"};
+    case solvers::AigEquivalence::kUnknown:
+      return ProverResult{Verdict::kUnknown,
+                          "Solver result; satisfiable: undef"};
+    case solvers::AigEquivalence::kNotEquivalent:
+      break;
+  }
+  // The parameters were translated first, in order, so they own the graph's
+  // leading inputs.
+  absl::Span<const bool> bits = equivalence.counterexample;
+  std::vector<Value> args;
+  int64_t offset = 0;
+  for (Param* param : functions[0]->params()) {
+    int64_t bit_count = param->GetType()->GetFlatBitCount();
+    args.push_back(solvers::AigIrTranslator::UnflattenValue(
+        param->GetType(), bits.subspan(offset, bit_count)));
+    offset += bit_count;
+  }
+  return ProverResult{Verdict::kNotEquivalent,
+                      CounterexampleToString(functions[0], args)};
+}
+
+// Builds a package holding copies of the functions, as "lhs" and "rhs", and
+// their inlined miter "miter", which returns whether they agree.
+absl::StatusOr<std::unique_ptr<Package>> CreateMiterPackage(
+    const std::vector<Function*>& functions) {
+  auto package = std::make_unique<Package>("miter");
+  XLS_ASSIGN_OR_RETURN(Function * lhs,
+                       functions[0]->Clone("lhs", package.get()));
+  XLS_ASSIGN_OR_RETURN(Function * rhs,
+                       functions[1]->Clone("rhs", package.get()));
+  FunctionBuilder b("miter", package.get());
+  std::vector<BValue> params;
+  for (Param* param : lhs->params()) {
+    params.push_back(b.Param(param->name(), param->GetType()));
+  }
+  b.Eq(b.Invoke(params, lhs), b.Invoke(params, rhs));
+  XLS_RETURN_IF_ERROR(b.Build().status());
+  PassResults results;
+  XLS_RETURN_IF_ERROR(
+      InliningPass().Run(package.get(), PassOptions(), &results).status());
+  return package;
+}
+
+// Builds a BDD of the miter. Operations it can't express (e.g., arithmetic)
+// become free variables, so this can prove equivalence but not refute it.
+absl::StatusOr<ProverResult> CheckWithBdd(Function* miter) {
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<BddFunction> bdd_function,
+      BddFunction::Run(miter, BddFunction::kDefaultPathLimit));
+  if (bdd_function->GetBddNode(miter->return_value(), 0) ==
+      bdd_function->bdd().one()) {
+    return ProverResult{Verdict::kEquivalent,
+                        "Solver result; satisfiable: false"};
+  }
+  return ProverResult();
+}
+
+// Runs the JIT-compiled miter on random arguments until they disagree (or
+// the run is cancelled or times out), so can only refute equivalence.
+absl::StatusOr<ProverResult> FalsifyWithJit(Function* miter,
+                                            absl::Time deadline,
+                                            const std::atomic<bool>* cancelled,
+                                            int64_t seed) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrJit> jit, IrJit::Create(miter));
+  std::minstd_rand engine(seed);
+  while (!cancelled->load() && absl::Now() < deadline) {
+    std::vector<Value> args = RandomFunctionArguments(miter, &engine);
+    XLS_ASSIGN_OR_RETURN(Value agree, jit->Run(args));
+    if (agree.bits().IsZero()) {
+      return ProverResult{Verdict::kNotEquivalent,
+                          CounterexampleToString(miter, args)};
+    }
+  }
+  return ProverResult();
+}
+
+// Races the strategies described in the usage text, each on its own thread
+// and parsing its own copy of the functions, as translation may add types to
+// a package and so isn't thread-safe.
+absl::StatusOr<ProverResult> CheckWithPortfolio(
+    const std::vector<Function*>& functions, absl::Duration timeout,
+    int64_t z3_seeds) {
+  absl::Time deadline = timeout == absl::InfiniteDuration()
+                            ? absl::InfiniteFuture()
+                            : absl::Now() + timeout;
+  auto remaining = [deadline]() {
+    return deadline == absl::InfiniteFuture() ? absl::InfiniteDuration()
+                                              : deadline - absl::Now();
+  };
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> miter_package,
+                       CreateMiterPackage(functions));
+  std::string miter_ir = miter_package->DumpIr();
+
+  using StrategyFn = std::function<absl::StatusOr<ProverResult>(
+      const std::vector<Function*>& functions, Function* miter,
+      Portfolio* portfolio)>;
+  struct Strategy {
+    std::string name;
+    bool can_prove;
+    StrategyFn run;
+  };
+  std::vector<Strategy> strategies;
+  for (int64_t seed = 0; seed < z3_seeds; ++seed) {
+    strategies.push_back(
+        {absl::StrFormat("Z3 (seed %d)", seed), /*can_prove=*/true,
+         [=](const std::vector<Function*>& functions, Function* miter,
+             Portfolio* portfolio) {
+           Z3Options options;
+           options.seed = seed;
+           return CheckWithZ3(functions, remaining(), options, portfolio);
+         }});
+  }
+  strategies.push_back(
+      {"Z3 (QF_BV)", /*can_prove=*/true,
+       [=](const std::vector<Function*>& functions, Function* miter,
+           Portfolio* portfolio) {
+         Z3Options options;
+         options.bit_blast = true;
+         return CheckWithZ3(functions, remaining(), options, portfolio);
+       }});
+  strategies.push_back({"SAT", /*can_prove=*/true,
+                        [=](const std::vector<Function*>& functions,
+                            Function* miter, Portfolio* portfolio) {
+                          return CheckWithSat(functions, remaining(),
+                                              portfolio->cancelled());
+                        }});
+  strategies.push_back({"BDD", /*can_prove=*/true,
+                        [](const std::vector<Function*>& functions,
+                           Function* miter, Portfolio* portfolio) {
+                          return CheckWithBdd(miter);
+                        }});
+  strategies.push_back({"JIT simulation", /*can_prove=*/false,
+                        [=](const std::vector<Function*>& functions,
+                            Function* miter, Portfolio* portfolio) {
+                          return FalsifyWithJit(miter, deadline,
+                                                portfolio->cancelled(),
+                                                /*seed=*/0);
+                        }});
+
+  // The strategies' threads are detached, so that the first answer can be
+  // reported without waiting for the others to wind down; they share
+  // ownership of everything they use.
+  int64_t prover_count = std::count_if(
+      strategies.begin(), strategies.end(),
+      [](const Strategy& strategy) { return strategy.can_prove; });
+  auto portfolio =
+      std::make_shared<Portfolio>(strategies.size(), prover_count);
+  auto shared_miter_ir = std::make_shared<const std::string>(miter_ir);
+  for (const Strategy& strategy : strategies) {
+    std::thread([strategy, portfolio, shared_miter_ir]() {
+      absl::Time start = absl::Now();
+      absl::StatusOr<ProverResult> result =
+          [&]() -> absl::StatusOr<ProverResult> {
+        XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                             Parser::ParsePackage(*shared_miter_ir));
+        XLS_ASSIGN_OR_RETURN(Function * lhs, package->GetFunction("lhs"));
+        XLS_ASSIGN_OR_RETURN(Function * rhs, package->GetFunction("rhs"));
+        XLS_ASSIGN_OR_RETURN(Function * miter, package->GetFunction("miter"));
+        return strategy.run({lhs, rhs}, miter, portfolio.get());
+      }();
+      portfolio->Report(strategy.name, strategy.can_prove, std::move(result),
+                        absl::Now() - start);
+    }).detach();
+  }
+  return portfolio->Wait();
+}
+
 absl::Status RealMain(const std::vector<absl::string_view>& ir_paths,
                       const std::string& entry_function,
-                      absl::Duration timeout) {
+                      absl::Duration timeout, const std::string& engine,
+                      int64_t portfolio_z3_seeds) {
   std::vector<std::unique_ptr<Package>> packages;
   for (const auto ir_path : ir_paths) {
     XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
@@ -122,45 +572,19 @@ absl::Status RealMain(const std::vector<absl::string_view>& ir_paths,
     }
   }
 
-  std::vector<std::unique_ptr<IrTranslator>> translators;
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IrTranslator> translator,
-                       IrTranslator::CreateAndTranslate(functions[0]));
-  translators.push_back(std::move(translator));
-
-  // Get the params for the first function, so we can map the second function's
-  // parameters to them.
-  Z3_context ctx = translators[0]->ctx();
-  std::vector<Z3_ast> z3_params;
-  for (const Param* param : functions[0]->params()) {
-    z3_params.push_back(translators[0]->GetTranslation(param));
+  ProverResult result;
+  if (engine == "sat") {
+    XLS_ASSIGN_OR_RETURN(result, CheckWithSat(functions, timeout));
+  } else if (engine == "portfolio") {
+    XLS_ASSIGN_OR_RETURN(
+        result, CheckWithPortfolio(functions, timeout, portfolio_z3_seeds));
+  } else {
+    Z3Options options;
+    options.threads = std::thread::hardware_concurrency();
+    XLS_ASSIGN_OR_RETURN(result, CheckWithZ3(functions, timeout, options));
   }
-
-  XLS_ASSIGN_OR_RETURN(
-      translator, IrTranslator::CreateAndTranslate(ctx, functions[1],
-                                                   absl::MakeSpan(z3_params)));
-  translators.push_back(std::move(translator));
-
-  XLS_ASSIGN_OR_RETURN(
-      Z3_ast results_equal,
-      CreateComparisonFunction(absl::MakeSpan(translators), functions));
-  translators[0]->SetTimeout(timeout);
-
-  Z3_solver solver =
-      solvers::z3::CreateSolver(ctx, std::thread::hardware_concurrency());
-
-  // Remember: we try to prove the condition by searching for a model that
-  // produces the opposite result. Thus, we want to find a model where the
-  // results are _not_ equal.
-  Z3_ast objective = Z3_mk_eq(ctx, Z3_mk_false(ctx), results_equal);
-  Z3_solver_assert(ctx, solver, objective);
-
   // Finally, print the output to the terminal in gorgeous two-color ASCII.
-  Z3_lbool satisfiable = Z3_solver_check(ctx, solver);
-  std::cout << solvers::z3::SolverResultToString(ctx, solver, satisfiable)
-            << std::endl;
-
-  Z3_solver_dec_ref(ctx, solver);
-
+  std::cout << result.output << std::endl;
   return absl::OkStatus();
 }
 
@@ -170,6 +594,16 @@ int main(int argc, char** argv) {
   std::vector<absl::string_view> positional_args =
       xls::InitXls(kUsage, argc, argv);
   XLS_QCHECK_EQ(positional_args.size(), 2) << "Two IR files must be specified!";
+  std::string engine = absl::GetFlag(FLAGS_engine);
+  XLS_QCHECK(engine == "z3" || engine == "sat" || engine == "portfolio")
+      << "--engine must be \"z3\", \"sat\" or \"portfolio\".";
+  int64_t portfolio_z3_seeds = absl::GetFlag(FLAGS_portfolio_z3_seeds);
+  XLS_QCHECK_GE(portfolio_z3_seeds, 0)
+      << "--portfolio_z3_seeds must be non-negative.";
   XLS_QCHECK_OK(xls::RealMain(positional_args, absl::GetFlag(FLAGS_function),
-                              absl::GetFlag(FLAGS_timeout)));
+                              absl::GetFlag(FLAGS_timeout), engine,
+                              portfolio_z3_seeds));
+  // Portfolio strategies which lost the race may still be running; don't tear
+  // down global state from under them.
+  std::quick_exit(0);
 }
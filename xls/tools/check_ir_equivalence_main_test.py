@@ -0,0 +1,128 @@
+# Lint as: python3
+#
+# Copyright 2021 The XLS Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for xls.tools.check_ir_equivalence_main."""
+
+import subprocess
+
+from xls.common import runfiles
+from xls.common import test_base
+
+CHECK_IR_EQUIVALENCE_MAIN_PATH = runfiles.get_path(
+    'xls/tools/check_ir_equivalence_main')
+
+MUL_IR = """package mul
+
+fn f(x: bits[16], y: bits[16]) -> bits[16] {
+  ret umul.3: bits[16] = umul(x, y, id=3)
+}
+"""
+
+# Multiplication is commutative, but the SAT engine can't show it for 16-bit
+# operands in any reasonable time; Z3 can.
+COMMUTED_MUL_IR = """package commuted_mul
+
+fn f(x: bits[16], y: bits[16]) -> bits[16] {
+  ret umul.3: bits[16] = umul(y, x, id=3)
+}
+"""
+
+MUL_PLUS_ONE_IR = """package mul_plus_one
+
+fn f(x: bits[16], y: bits[16]) -> bits[16] {
+  umul.3: bits[16] = umul(x, y, id=3)
+  literal.4: bits[16] = literal(value=1, id=4)
+  ret add.5: bits[16] = add(umul.3, literal.4, id=5)
+}
+"""
+
+SUB_IR = """package sub
+
+fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  ret sub.3: bits[8] = sub(x, y, id=3)
+}
+"""
+
+# The same subtraction, but with the parameters declared the other way round.
+SUB_SWAPPED_PARAMS_IR = """package sub_swapped_params
+
+fn f(y: bits[8], x: bits[8]) -> bits[8] {
+  ret sub.3: bits[8] = sub(x, y, id=3)
+}
+"""
+
+NEG_SUB_IR = """package neg_sub
+
+fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  sub.3: bits[8] = sub(y, x, id=3)
+  ret neg.4: bits[8] = neg(sub.3, id=4)
+}
+"""
+
+
+class CheckIrEquivalenceMainTest(test_base.TestCase):
+
+  def _check(self, lhs_ir, rhs_ir, *args):
+    lhs_file = self.create_tempfile(content=lhs_ir)
+    rhs_file = self.create_tempfile(content=rhs_ir)
+    return subprocess.check_output(
+        [CHECK_IR_EQUIVALENCE_MAIN_PATH] + list(args) +
+        [lhs_file.full_path, rhs_file.full_path]).decode('utf-8')
+
+  def test_z3(self):
+    self.assertIn('satisfiable: false', self._check(SUB_IR, NEG_SUB_IR))
+    self.assertIn('satisfiable: true',
+                  self._check(SUB_IR, SUB_SWAPPED_PARAMS_IR))
+
+  def test_sat_equivalent(self):
+    output = self._check(SUB_IR, NEG_SUB_IR, '--engine=sat')
+    self.assertIn('satisfiable: false', output)
+
+  def test_sat_not_equivalent(self):
+    output = self._check(MUL_IR, MUL_PLUS_ONE_IR, '--engine=sat')
+    self.assertIn('satisfiable: true', output)
+    self.assertIn('x -> bits[16]:', output)
+    self.assertIn('y -> bits[16]:', output)
+
+  def test_sat_timeout(self):
+    output = self._check(MUL_IR, COMMUTED_MUL_IR, '--engine=sat',
+                         '--timeout=1s')
+    self.assertIn('satisfiable: undef', output)
+
+  def test_portfolio_equivalent(self):
+    output = self._check(SUB_IR, NEG_SUB_IR, '--engine=portfolio')
+    self.assertIn('satisfiable: false', output)
+    self.assertIn('Answered by', output)
+
+  def test_portfolio_not_equivalent(self):
+    output = self._check(MUL_IR, MUL_PLUS_ONE_IR, '--engine=portfolio')
+    self.assertIn('satisfiable: true', output)
+    self.assertIn('Answered by', output)
+
+  def test_portfolio_respects_param_order(self):
+    output = self._check(SUB_IR, SUB_SWAPPED_PARAMS_IR, '--engine=portfolio')
+    self.assertIn('satisfiable: true', output)
+
+  def test_portfolio_cancels_losing_strategies(self):
+    # Only Z3 can answer; the run must not wait out the SAT engine.
+    output = self._check(MUL_IR, COMMUTED_MUL_IR, '--engine=portfolio',
+                         '--timeout=600s')
+    self.assertIn('satisfiable: false', output)
+    self.assertIn('Answered by Z3', output)
+
+
+if __name__ == '__main__':
+  test_base.main()
@@ -19,7 +19,10 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/init_xls.h"
@@ -78,6 +81,34 @@ ABSL_FLAG(int32_t, stage, -1,
           "Pipeline stage to evaluate. Requires --schedule.\n"
           "If \"schedule\" is set, but this is not, then the entire module "
           "will be evaluated.");
+ABSL_FLAG(int32_t, threads, 0,
+          "If nonzero, splits the check into jobs - one per pipeline stage (if "
+          "--schedule_path is set) and group of --output_group_size output "
+          "bits - and runs them on this many threads, reporting which were "
+          "proven, failed or timed out. Cannot be combined with --stage or "
+          "--constraints_file.");
+ABSL_FLAG(int64_t, output_group_size, 0,
+          "With --threads, the maximum number of output bits checked by each "
+          "job. If zero, each stage is checked by a single job.");
+ABSL_FLAG(absl::Duration, job_timeout, absl::InfiniteDuration(),
+          "With --threads, the time after which each job gives up.");
+ABSL_FLAG(bool, sweep, false,
+          "If true, first proves internal equivalences between the IR and "
+          "netlist, found by random simulation, and uses them as cut-points. "
+          "This scales to large arithmetic datapaths, e.g., multipliers. "
+          "Cannot be combined with --threads.");
+ABSL_FLAG(int64_t, sweep_samples, 1024,
+          "With --sweep, the number of random input vectors simulated.");
+ABSL_FLAG(absl::Duration, sweep_candidate_timeout, absl::Seconds(1),
+          "With --sweep, the time after which the proof of each candidate "
+          "internal equivalence gives up.");
+ABSL_FLAG(std::string, engine, "z3",
+          "Prover to use: \"z3\", or \"sat\" to bit-blast both sides into "
+          "an and-inverter graph and use the built-in SAT solver, which is "
+          "often much faster on arithmetic. The SAT engine cannot be combined "
+          "with --threads, --sweep or --constraints_file.");
+ABSL_FLAG(absl::Duration, sat_timeout, absl::InfiniteDuration(),
+          "With --engine=sat, the time after which the check gives up.");
 
 namespace xls {
 namespace {
@@ -97,9 +128,8 @@ absl::StatusOr<netlist::CellLibrary> GetCellLibrary(
     XLS_RET_CHECK(cell_proto.ParseFromString(cell_proto_text));
     return netlist::CellLibrary::FromProto(cell_proto);
   } else {
-    XLS_ASSIGN_OR_RETURN(std::string lib_text, GetFileContents(cell_lib_path));
-    XLS_ASSIGN_OR_RETURN(auto stream,
-                         netlist::cell_lib::CharStream::FromText(lib_text));
+    XLS_ASSIGN_OR_RETURN(
+        auto stream, netlist::cell_lib::CharStream::FromPath(cell_lib_path));
     XLS_ASSIGN_OR_RETURN(netlist::CellLibraryProto proto,
                          netlist::function::ExtractFunctions(&stream));
     return netlist::CellLibrary::FromProto(proto);
@@ -114,6 +144,32 @@ absl::StatusOr<std::unique_ptr<netlist::rtl::Netlist>> GetNetlist(
   return netlist::rtl::Parser::ParseNetlist(cell_library, &scanner);
 }
 
+// Runs the check as independent jobs, printing the outcome of each.
+absl::Status RunAndReportParallelLec(
+    const solvers::z3::LecParams& lec_params,
+    const absl::optional<PipelineSchedule>& schedule,
+    const solvers::z3::ParallelLecOptions& options) {
+  XLS_ASSIGN_OR_RETURN(
+      std::vector<solvers::z3::LecJobResult> results,
+      solvers::z3::RunParallelLec(lec_params, schedule, options));
+  int64_t proven_count = 0;
+  for (const solvers::z3::LecJobResult& result : results) {
+    std::cout << absl::StrFormat(
+        "Stage %d, %s: %s (%s)\n", result.stage, result.outputs,
+        solvers::z3::LecOutcomeToString(result.outcome),
+        absl::FormatDuration(result.duration));
+    if (result.outcome == solvers::z3::LecOutcome::kProven) {
+      proven_count++;
+    } else {
+      std::cout << result.detail << std::endl;
+    }
+  }
+  std::cout << absl::StrFormat("%d of %d jobs proven.", proven_count,
+                               results.size())
+            << std::endl;
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 absl::Status RealMain(absl::string_view ir_path,
@@ -123,7 +179,11 @@ absl::Status RealMain(absl::string_view ir_path,
                       absl::string_view cell_proto_path,
                       absl::string_view netlist_path,
                       absl::string_view constraints_file,
-                      absl::string_view schedule_path, int stage) {
+                      absl::string_view schedule_path, int stage,
+                      const solvers::z3::ParallelLecOptions& parallel_options,
+                      const absl::optional<solvers::z3::SweepOptions>&
+                          sweep_options,
+                      absl::optional<absl::Duration> sat_timeout) {
   solvers::z3::LecParams lec_params;
   XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
   XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
@@ -142,16 +202,23 @@ absl::Status RealMain(absl::string_view ir_path,
   lec_params.netlist = netlist.get();
   lec_params.netlist_module_name = netlist_module_name;
 
-  std::unique_ptr<solvers::z3::Lec> lec;
+  absl::optional<PipelineSchedule> schedule;
   if (!schedule_path.empty()) {
     XLS_ASSIGN_OR_RETURN(
         PipelineScheduleProto proto,
         ParseTextProtoFile<PipelineScheduleProto>(schedule_path));
     XLS_ASSIGN_OR_RETURN(
-        PipelineSchedule schedule,
-        PipelineSchedule::FromProto(lec_params.ir_function, proto));
+        schedule, PipelineSchedule::FromProto(lec_params.ir_function, proto));
+  }
+
+  if (parallel_options.thread_count > 0) {
+    return RunAndReportParallelLec(lec_params, schedule, parallel_options);
+  }
+
+  std::unique_ptr<solvers::z3::Lec> lec;
+  if (schedule.has_value()) {
     XLS_ASSIGN_OR_RETURN(lec, solvers::z3::Lec::CreateForStage(
-                                  std::move(lec_params), schedule, stage));
+                                  std::move(lec_params), *schedule, stage));
   } else {
     XLS_ASSIGN_OR_RETURN(lec, solvers::z3::Lec::Create(std::move(lec_params)));
   }
@@ -171,7 +238,32 @@ absl::Status RealMain(absl::string_view ir_path,
     XLS_RETURN_IF_ERROR(lec->AddConstraints(function));
   }
 
-  bool equal = lec->Run();
+  if (sat_timeout.has_value()) {
+    std::string detail;
+    XLS_ASSIGN_OR_RETURN(solvers::z3::LecOutcome outcome,
+                         lec->RunWithSat(*sat_timeout, &detail));
+    std::cout << solvers::z3::LecOutcomeToString(outcome) << std::endl;
+    if (outcome != solvers::z3::LecOutcome::kProven) {
+      std::cout << detail << std::endl;
+    }
+    return absl::OkStatus();
+  }
+
+  bool equal;
+  if (sweep_options.has_value()) {
+    XLS_ASSIGN_OR_RETURN(equal, lec->RunWithSweeping(*sweep_options));
+    const solvers::z3::SweepStats& stats = lec->sweep_stats();
+    std::cout << absl::StrFormat(
+                     "Sweeping: %d of %d candidates proven (%d disproven, %d "
+                     "timed out); %d cut-points%s.",
+                     stats.proven_count, stats.candidate_count,
+                     stats.disproven_count, stats.timed_out_count,
+                     stats.cut_point_count,
+                     stats.used_full_miter ? "; checked the full miter" : "")
+              << std::endl;
+  } else {
+    equal = lec->Run();
+  }
   std::cout << lec->ResultToString() << std::endl;
   if (!equal) {
     std::cout << std::endl << "IR/netlist value dump:" << std::endl;
@@ -203,10 +295,48 @@ int main(int argc, char* argv[]) {
   XLS_QCHECK(stage == -1 || !schedule_path.empty())
       << "--schedule_path must be specified with --stage.";
 
+  xls::solvers::z3::ParallelLecOptions parallel_options;
+  parallel_options.thread_count = absl::GetFlag(FLAGS_threads);
+  parallel_options.output_group_size = absl::GetFlag(FLAGS_output_group_size);
+  parallel_options.job_timeout = absl::GetFlag(FLAGS_job_timeout);
+  XLS_QCHECK_GE(parallel_options.thread_count, 0)
+      << "--threads must be non-negative.";
+  XLS_QCHECK_GE(parallel_options.output_group_size, 0)
+      << "--output_group_size must be non-negative.";
+  XLS_QCHECK(parallel_options.thread_count == 0 ||
+             (stage == -1 && absl::GetFlag(FLAGS_constraints_file).empty()))
+      << "--threads cannot be combined with --stage or --constraints_file.";
+
+  absl::optional<xls::solvers::z3::SweepOptions> sweep_options;
+  if (absl::GetFlag(FLAGS_sweep)) {
+    XLS_QCHECK_EQ(parallel_options.thread_count, 0)
+        << "--sweep cannot be combined with --threads.";
+    sweep_options.emplace();
+    sweep_options->sample_count = absl::GetFlag(FLAGS_sweep_samples);
+    sweep_options->candidate_timeout =
+        absl::GetFlag(FLAGS_sweep_candidate_timeout);
+    XLS_QCHECK_GT(sweep_options->sample_count, 0)
+        << "--sweep_samples must be positive.";
+  }
+
+  absl::optional<absl::Duration> sat_timeout;
+  std::string engine = absl::GetFlag(FLAGS_engine);
+  XLS_QCHECK(engine == "z3" || engine == "sat")
+      << "--engine must be \"z3\" or \"sat\".";
+  if (engine == "sat") {
+    XLS_QCHECK(parallel_options.thread_count == 0 &&
+               !sweep_options.has_value() &&
+               absl::GetFlag(FLAGS_constraints_file).empty())
+        << "--engine=sat cannot be combined with --threads, --sweep or "
+           "--constraints_file.";
+    sat_timeout = absl::GetFlag(FLAGS_sat_timeout);
+  }
+
   XLS_QCHECK_OK(xls::RealMain(ir_path, absl::GetFlag(FLAGS_entry_function_name),
                               absl::GetFlag(FLAGS_netlist_module_name),
                               cell_lib_path, cell_proto_path, netlist_path,
                               absl::GetFlag(FLAGS_constraints_file),
-                              schedule_path, stage));
+                              schedule_path, stage, parallel_options,
+                              sweep_options, sat_timeout));
   return 0;
 }
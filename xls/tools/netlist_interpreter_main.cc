@@ -21,6 +21,7 @@
 #include "absl/strings/str_split.h"
 #include "xls/codegen/flattening.h"
 #include "xls/common/file/filesystem.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -28,6 +29,7 @@
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/value.h"
 #include "xls/netlist/cell_library.h"
+#include "xls/netlist/compiled_interpreter.h"
 #include "xls/netlist/function_extractor.h"
 #include "xls/netlist/interpreter.h"
 #include "xls/netlist/lib_parser.h"
@@ -66,11 +68,9 @@ absl::StatusOr<netlist::CellLibrary> GetCellLibrary(
     XLS_RET_CHECK(lib_proto.ParseFromString(proto_text));
     return netlist::CellLibrary::FromProto(lib_proto);
   } else {
-    XLS_ASSIGN_OR_RETURN(std::string cell_library_text,
-                         GetFileContents(cell_library_path));
     XLS_ASSIGN_OR_RETURN(
         auto char_stream,
-        netlist::cell_lib::CharStream::FromText(cell_library_text));
+        netlist::cell_lib::CharStream::FromPath(cell_library_path));
     XLS_ASSIGN_OR_RETURN(netlist::CellLibraryProto lib_proto,
                          netlist::function::ExtractFunctions(&char_stream));
     return netlist::CellLibrary::FromProto(lib_proto);
@@ -88,8 +88,8 @@ absl::Status RealMain(const std::string& netlist_path,
       netlist::CellLibrary cell_library,
       GetCellLibrary(cell_library_path, cell_library_proto_path));
 
-  XLS_ASSIGN_OR_RETURN(std::string netlist_text, GetFileContents(netlist_path));
-  netlist::rtl::Scanner scanner(netlist_text);
+  XLS_ASSIGN_OR_RETURN(MappedFile netlist_file, MappedFile::Open(netlist_path));
+  netlist::rtl::Scanner scanner(netlist_file.contents());
   XLS_ASSIGN_OR_RETURN(auto netlist, netlist::rtl::Parser::ParseNetlist(
                                          &cell_library, &scanner));
   XLS_ASSIGN_OR_RETURN(const auto* module, netlist->GetModule(module_name));
@@ -112,9 +112,33 @@ absl::Status RealMain(const std::string& netlist_path,
     input_nets[module_inputs[i]] = input_bits.Get(i);
   }
 
-  netlist::Interpreter interpreter(netlist.get());
-  XLS_ASSIGN_OR_RETURN(auto output_nets, interpreter.InterpretModule(
-                                             module, input_nets, dump_cells));
+  // The compiled interpreter is much faster on large netlists, but can't dump
+  // cells or handle state tables over too many inputs to tabulate; fall back
+  // to the reference interpreter in those cases.
+  absl::StatusOr<std::unique_ptr<netlist::CompiledInterpreter>> compiled =
+      absl::UnimplementedError("Cell dumping requested.");
+  if (dump_cells.empty()) {
+    compiled = netlist::CompiledInterpreter::Create(netlist.get(), module);
+  }
+  absl::flat_hash_map<const netlist::rtl::NetRef, bool> output_nets;
+  if (compiled.ok()) {
+    // Only lane 0 is of interest here.
+    absl::flat_hash_map<const netlist::rtl::NetRef, uint64_t> input_lanes;
+    for (const auto& [net, value] : input_nets) {
+      input_lanes[net] = value ? 1 : 0;
+    }
+    XLS_ASSIGN_OR_RETURN(auto output_lanes,
+                         compiled.value()->InterpretModule(input_lanes));
+    for (const auto& [net, lanes] : output_lanes) {
+      output_nets[net] = lanes & 1;
+    }
+  } else if (absl::IsUnimplemented(compiled.status())) {
+    netlist::Interpreter interpreter(netlist.get());
+    XLS_ASSIGN_OR_RETURN(output_nets, interpreter.InterpretModule(
+                                          module, input_nets, dump_cells));
+  } else {
+    return compiled.status();
+  }
 
   BitsRope rope(output_nets.size());
   for (const netlist::rtl::NetRef ref : module->outputs()) {
@@ -161,7 +185,8 @@ int main(int argc, char* argv[]) {
   std::vector<std::string> inputs = absl::StrSplit(input, ';');
 
   std::string dump_cells_str = absl::GetFlag(FLAGS_dump_cells);
-  std::vector<std::string> dump_cells = absl::StrSplit(dump_cells_str, ',');
+  std::vector<std::string> dump_cells =
+      absl::StrSplit(dump_cells_str, ',', absl::SkipEmpty());
 
   std::string output_type = absl::GetFlag(FLAGS_output_type);
 
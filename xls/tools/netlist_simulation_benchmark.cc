@@ -0,0 +1,183 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the cycle-simulation throughput of CompiledInterpreter on a netlist
+// across a range of thread counts.
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/mapped_file.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/common/thread_pool.h"
+#include "xls/netlist/cell_library.h"
+#include "xls/netlist/compiled_interpreter.h"
+#include "xls/netlist/function_extractor.h"
+#include "xls/netlist/lib_parser.h"
+#include "xls/netlist/netlist.pb.h"
+#include "xls/netlist/netlist_parser.h"
+
+ABSL_FLAG(std::string, cell_library, "", "Cell library of the netlist.");
+ABSL_FLAG(std::string, cell_library_proto, "",
+          "Preprocessed cell library proto of the netlist.");
+ABSL_FLAG(std::string, module_name, "", "Module in the netlist to simulate.");
+ABSL_FLAG(std::string, netlist, "", "Path to the netlist to simulate.");
+ABSL_FLAG(int64_t, cycles, 1000,
+          "Number of clock cycles to simulate for each thread count; each "
+          "cycle evaluates 64 random input vectors.");
+ABSL_FLAG(std::string, thread_counts, "1,2,4,8",
+          "Comma-separated list of thread counts to measure.");
+
+namespace xls {
+namespace {
+
+absl::StatusOr<netlist::CellLibrary> GetCellLibrary(
+    const std::string& cell_library_path,
+    const std::string& cell_library_proto_path) {
+  netlist::CellLibraryProto lib_proto;
+  if (!cell_library_proto_path.empty()) {
+    XLS_ASSIGN_OR_RETURN(std::string proto_text,
+                         GetFileContents(cell_library_proto_path));
+    XLS_RET_CHECK(lib_proto.ParseFromString(proto_text));
+  } else {
+    XLS_ASSIGN_OR_RETURN(
+        auto char_stream,
+        netlist::cell_lib::CharStream::FromPath(cell_library_path));
+    XLS_ASSIGN_OR_RETURN(lib_proto,
+                         netlist::function::ExtractFunctions(&char_stream));
+  }
+  return netlist::CellLibrary::FromProto(lib_proto);
+}
+
+absl::Status RealMain(const std::string& netlist_path,
+                      const std::string& cell_library_path,
+                      const std::string& cell_library_proto_path,
+                      const std::string& module_name, int64_t cycles,
+                      absl::Span<const int64_t> thread_counts) {
+  XLS_ASSIGN_OR_RETURN(
+      netlist::CellLibrary cell_library,
+      GetCellLibrary(cell_library_path, cell_library_proto_path));
+  XLS_ASSIGN_OR_RETURN(MappedFile netlist_file, MappedFile::Open(netlist_path));
+  netlist::rtl::Scanner scanner(netlist_file.contents());
+  XLS_ASSIGN_OR_RETURN(auto netlist, netlist::rtl::Parser::ParseNetlist(
+                                         &cell_library, &scanner));
+  XLS_ASSIGN_OR_RETURN(const netlist::rtl::Module* module,
+                       netlist->GetModule(module_name));
+
+  absl::Time start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(
+      auto interpreter,
+      netlist::CompiledInterpreter::Create(
+          netlist.get(), module,
+          netlist::CompiledInterpreter::FlopMode::kRegistered));
+  std::cout << "Compilation time: " << absl::Now() - start << "\n";
+  std::cout << "Clusters: " << interpreter->cluster_count() << "\n";
+
+  // Every thread count sees the same stimulus, so that their final states can
+  // be checked against each other.
+  std::vector<int64_t> input_indices;
+  for (const netlist::rtl::NetRef input : module->inputs()) {
+    XLS_ASSIGN_OR_RETURN(int64_t index, interpreter->GetNetIndex(input));
+    input_indices.push_back(index);
+  }
+  absl::BitGen bitgen;
+  std::vector<uint64_t> stimulus(cycles * input_indices.size());
+  for (uint64_t& value : stimulus) {
+    value = absl::Uniform<uint64_t>(bitgen);
+  }
+
+  absl::Duration baseline_time;
+  std::vector<uint64_t> baseline_values;
+  for (int64_t thread_count : thread_counts) {
+    ThreadPool thread_pool(thread_count);
+    std::vector<uint64_t> net_values(interpreter->net_count());
+    start = absl::Now();
+    for (int64_t cycle = 0; cycle < cycles; ++cycle) {
+      for (int64_t i = 0; i < input_indices.size(); ++i) {
+        net_values[input_indices[i]] =
+            stimulus[cycle * input_indices.size() + i];
+      }
+      interpreter->Run(absl::MakeSpan(net_values), &thread_pool);
+    }
+    absl::Duration time = absl::Now() - start;
+
+    if (baseline_values.empty()) {
+      baseline_time = time;
+      baseline_values = std::move(net_values);
+    } else {
+      XLS_RET_CHECK(net_values == baseline_values)
+          << "Simulation with " << thread_count
+          << " threads diverged from simulation with " << thread_counts[0]
+          << ".";
+    }
+    std::cout << "Threads: " << thread_count << ", time: " << time
+              << ", vector-cycles/s: "
+              << cycles * netlist::CompiledInterpreter::kLaneCount /
+                     absl::ToDoubleSeconds(time)
+              << ", speedup: " << baseline_time / time << "\n";
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char* argv[]) {
+  xls::InitXls(argv[0], argc, argv);
+
+  std::string cell_library_path = absl::GetFlag(FLAGS_cell_library);
+  std::string cell_library_proto_path = absl::GetFlag(FLAGS_cell_library_proto);
+  XLS_QCHECK(!cell_library_path.empty() ^ !cell_library_proto_path.empty())
+      << "One (and only one) of --cell_library or --cell_library_proto "
+         "must be specified.";
+
+  std::string netlist_path = absl::GetFlag(FLAGS_netlist);
+  XLS_QCHECK(!netlist_path.empty()) << "--netlist must be specified.";
+
+  std::string module_name = absl::GetFlag(FLAGS_module_name);
+  XLS_QCHECK(!module_name.empty()) << "--module_name must be specified.";
+
+  int64_t cycles = absl::GetFlag(FLAGS_cycles);
+  XLS_QCHECK_GT(cycles, 0) << "--cycles must be positive.";
+
+  std::vector<int64_t> thread_counts;
+  for (absl::string_view thread_count_str :
+       absl::StrSplit(absl::GetFlag(FLAGS_thread_counts), ',',
+                      absl::SkipEmpty())) {
+    int64_t thread_count;
+    XLS_QCHECK(absl::SimpleAtoi(thread_count_str, &thread_count) &&
+               thread_count > 0)
+        << "Invalid thread count: " << thread_count_str;
+    thread_counts.push_back(thread_count);
+  }
+  XLS_QCHECK(!thread_counts.empty()) << "--thread_counts must be specified.";
+
+  XLS_QCHECK_OK(xls::RealMain(netlist_path, cell_library_path,
+                              cell_library_proto_path, module_name, cycles,
+                              thread_counts));
+  return 0;
+}
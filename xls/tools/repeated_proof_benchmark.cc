@@ -0,0 +1,151 @@
+// Copyright 2021 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the cost of repeated Z3 queries about the nodes of a function, as
+// made by optimization passes and the solver tool: for each bits-typed node of
+// the entry function, attempts to prove that it is always zero, first with a
+// fresh translation per query (TryProve()) and then with a single
+// IncrementalProver, and checks that both agree.
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/solvers/z3_ir_translator.h"
+
+ABSL_FLAG(int64_t, max_queries, 100,
+          "Maximum number of nodes to query; the first ones in topological "
+          "order are used.");
+ABSL_FLAG(int64_t, repetitions, 2,
+          "Number of times each node is queried, to model workloads which "
+          "revisit the same nodes.");
+ABSL_FLAG(absl::Duration, timeout, absl::Seconds(10),
+          "Timeout for each proof attempt.");
+
+const char kUsage[] = R"(
+Compares one-shot and incremental Z3 proofs over the nodes of an XLS IR entry
+function.
+
+Example invocation:
+
+  repeated_proof_benchmark /tmp/my.ir --max_queries=500
+)";
+
+namespace xls {
+namespace {
+
+using solvers::z3::IncrementalProver;
+using solvers::z3::Predicate;
+
+absl::Status RealMain(absl::string_view ir_path, int64_t max_queries,
+                      int64_t repetitions, absl::Duration timeout) {
+  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(ir_path));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       Parser::ParsePackage(contents, ir_path));
+  XLS_ASSIGN_OR_RETURN(Function * f, package->EntryFunction());
+
+  std::vector<Node*> subjects;
+  for (Node* node : f->nodes()) {
+    if (subjects.size() == max_queries) {
+      break;
+    }
+    if (node->GetType()->IsBits()) {
+      subjects.push_back(node);
+    }
+  }
+
+  absl::Time start = absl::Now();
+  std::vector<bool> one_shot_results;
+  for (int64_t i = 0; i < repetitions; ++i) {
+    for (Node* subject : subjects) {
+      XLS_ASSIGN_OR_RETURN(
+          bool proven, solvers::z3::TryProve(f, subject,
+                                             Predicate::EqualToZero(), timeout));
+      one_shot_results.push_back(proven);
+    }
+  }
+  absl::Duration one_shot_time = absl::Now() - start;
+
+  start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<IncrementalProver> prover,
+                       IncrementalProver::Create(f));
+  absl::Duration translation_time = absl::Now() - start;
+  std::vector<bool> incremental_results;
+  for (int64_t i = 0; i < repetitions; ++i) {
+    for (Node* subject : subjects) {
+      XLS_ASSIGN_OR_RETURN(
+          bool proven,
+          prover->TryProve(subject, Predicate::EqualToZero(), timeout));
+      incremental_results.push_back(proven);
+    }
+  }
+  absl::Duration incremental_time = absl::Now() - start;
+
+  // A timed-out query counts as unproven in both modes, so results may only
+  // differ where one mode timed out.
+  int64_t mismatch_count = 0;
+  for (int64_t i = 0; i < one_shot_results.size(); ++i) {
+    if (one_shot_results[i] != incremental_results[i]) {
+      mismatch_count++;
+    }
+  }
+
+  int64_t proven_count = 0;
+  for (bool proven : incremental_results) {
+    proven_count += proven ? 1 : 0;
+  }
+  std::cout << "Queries: " << incremental_results.size() << " ("
+            << subjects.size() << " nodes x " << repetitions
+            << "), proven: " << proven_count << "\n";
+  std::cout << "One-shot time: " << one_shot_time << "\n";
+  std::cout << "Incremental time: " << incremental_time
+            << " (translation: " << translation_time
+            << ", memoized queries: " << prover->memoized_count() << ")\n";
+  std::cout << "Speedup: " << one_shot_time / incremental_time << "\n";
+  if (mismatch_count > 0) {
+    std::cout << "Differing results (due to timeouts): " << mismatch_count
+              << "\n";
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<absl::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  XLS_QCHECK_EQ(positional_arguments.size(), 1)
+      << "Expected a single IR file argument.";
+
+  int64_t max_queries = absl::GetFlag(FLAGS_max_queries);
+  XLS_QCHECK_GT(max_queries, 0) << "--max_queries must be positive.";
+  int64_t repetitions = absl::GetFlag(FLAGS_repetitions);
+  XLS_QCHECK_GT(repetitions, 0) << "--repetitions must be positive.";
+
+  XLS_QCHECK_OK(xls::RealMain(positional_arguments[0], max_queries,
+                              repetitions, absl::GetFlag(FLAGS_timeout)));
+  return EXIT_SUCCESS;
+}
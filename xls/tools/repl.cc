@@ -33,6 +33,8 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 // TODO(taktoa): 2021-03-10 maybe switch to https://github.com/injinj/linecook
@@ -176,6 +178,10 @@ struct Globals {
   dslx::ImportData import_data;
   std::unique_ptr<dslx::Module> module;
   dslx::TypeInfo* type_info;
+  // Contents of the DSLX file that "module" was successfully loaded from; used
+  // to skip re-parsing and re-typechecking when the file did not change.
+  std::string module_contents;
+  // IR for "module"; nullptr when it needs to be (re)generated.
   std::unique_ptr<Package> ir_package;
   Trie identifier_trie;
   Trie command_trie;
@@ -264,13 +270,19 @@ void PopulateIdentifierTrie() {
 // `GetSingletonGlobals()->module`.
 absl::Status UpdateIr() {
   Globals* globals = GetSingletonGlobals();
+  if (globals->ir_package != nullptr) {
+    // Module has not been reloaded since the IR was generated.
+    return absl::OkStatus();
+  }
+  // The package is only cached once it has been fully optimized, so that a
+  // failed pipeline run is retried by the next command.
   XLS_ASSIGN_OR_RETURN(
-      globals->ir_package,
+      std::unique_ptr<Package> package,
       ConvertModuleToPackage(globals->module.get(), &globals->import_data,
                              dslx::ConvertOptions{},
                              /*traverse_tests=*/true));
-  XLS_RETURN_IF_ERROR(
-      RunStandardPassPipeline(globals->ir_package.get()).status());
+  XLS_RETURN_IF_ERROR(RunStandardPassPipeline(package.get()).status());
+  globals->ir_package = std::move(package);
   return absl::OkStatus();
 }
 
@@ -297,12 +309,21 @@ absl::Status CommandHelp() {
 
 // Function implementing the `:reload` command, which reloads the DSLX file from
 // disk and parses/typechecks it.
+//
+// Note that imported modules stay cached in the import data across reloads, so
+// only the file itself is re-parsed and re-typechecked; if its contents did not
+// change since the last successful load even that is skipped.
 absl::Status CommandReload() {
   Globals* globals = GetSingletonGlobals();
 
   XLS_ASSIGN_OR_RETURN(std::string dslx_contents,
                        GetFileContents(globals->dslx_path));
+  if (globals->module != nullptr && dslx_contents == globals->module_contents) {
+    std::cout << "No changes to " << globals->dslx_path << "\n";
+    return absl::OkStatus();
+  }
 
+  absl::Time start = absl::Now();
   globals->scanner = absl::make_unique<dslx::Scanner>(
       std::string(globals->dslx_path), dslx_contents);
   globals->parser =
@@ -318,12 +339,21 @@ absl::Status CommandReload() {
     return absl::OkStatus();
   }
 
+  absl::Duration parse_time = absl::Now() - start;
+  globals->module_contents.clear();
+  globals->ir_package = nullptr;
+
+  start = absl::Now();
   XLS_ASSIGN_OR_RETURN(globals->type_info, CheckModule(globals->module.get(),
                                                        &globals->import_data));
+  absl::Duration typecheck_time = absl::Now() - start;
+  globals->module_contents = std::move(dslx_contents);
 
   PopulateIdentifierTrie();
 
-  std::cout << "Successfully loaded " << globals->dslx_path << "\n";
+  std::cout << absl::StreamFormat(
+      "Successfully loaded %s (parse: %s, typecheck: %s)\n", globals->dslx_path,
+      absl::FormatDuration(parse_time), absl::FormatDuration(typecheck_time));
 
   return absl::OkStatus();
 }
@@ -16,6 +16,7 @@
 
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_split.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
@@ -25,7 +26,9 @@
 #include "xls/solvers/z3_ir_translator.h"
 
 ABSL_FLAG(std::string, subject, "",
-          "Node that is subject of the proof; default: return value");
+          "Node that is subject of the proof; default: return value. May be a "
+          "comma-separated list of nodes, each of which is the subject of its "
+          "own proof; all proofs share a single translation and solver.");
 ABSL_FLAG(std::string, kind, "eq_zero",
           "Predicate to attempt to prove; choices: eq_zero, ne_zero, eq_node");
 ABSL_FLAG(std::string, other, "",
@@ -46,6 +49,10 @@ Prove that node and.1234 in the entry function is always equal to zero:
 Prove that node and.1234 is equivalent to and.2345:
 
   solver /tmp/my.ir -subject and.1234 -kind eq_node -other and.2345
+
+Prove that each of and.1234 and or.2345 is always equal to zero:
+
+  solver /tmp/my.ir -subject and.1234,or.2345 -kind eq_zero
 )";
 
 namespace xls {
@@ -54,14 +61,13 @@ namespace {
 using solvers::z3::Predicate;
 
 absl::Status RealMain(absl::string_view ir_path,
-                      absl::string_view subject_node_name,
+                      absl::string_view subject_node_names,
                       absl::string_view predicate_kind,
                       absl::string_view other_node_name, int64_t timeout_ms) {
   XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(ir_path));
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
                        Parser::ParsePackage(contents, ir_path));
   XLS_ASSIGN_OR_RETURN(Function * f, package->EntryFunction());
-  XLS_ASSIGN_OR_RETURN(Node * subject, f->GetNode(subject_node_name));
   absl::Duration timeout = absl::Milliseconds(timeout_ms);
 
   absl::optional<Predicate> predicate;
@@ -69,17 +75,25 @@ absl::Status RealMain(absl::string_view ir_path,
     predicate = Predicate::EqualToZero();
   } else if (predicate_kind == "ne_zero") {
     predicate = Predicate::NotEqualToZero();
+  } else if (predicate_kind == "eq_node") {
+    XLS_ASSIGN_OR_RETURN(Node * other, f->GetNode(other_node_name));
+    predicate = Predicate::EqualTo(other);
   } else {
     return absl::InvalidArgumentError(
         absl::StrFormat("Invalid predicate kind: \"%s\"", predicate_kind));
   }
 
-  XLS_ASSIGN_OR_RETURN(
-      bool proved,
-      solvers::z3::TryProve(f, subject, predicate.value(), timeout));
-  std::cout << "Proved " << subject_node_name << " " << predicate->ToString()
-            << " holds for all input?"
-            << ": " << (proved ? "true" : "false") << std::endl;
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<solvers::z3::IncrementalProver> prover,
+                       solvers::z3::IncrementalProver::Create(f));
+  for (absl::string_view subject_node_name :
+       absl::StrSplit(subject_node_names, ',', absl::SkipEmpty())) {
+    XLS_ASSIGN_OR_RETURN(Node * subject, f->GetNode(subject_node_name));
+    XLS_ASSIGN_OR_RETURN(bool proved,
+                         prover->TryProve(subject, predicate.value(), timeout));
+    std::cout << "Proved " << subject_node_name << " " << predicate->ToString()
+              << " holds for all input?"
+              << ": " << (proved ? "true" : "false") << std::endl;
+  }
   return absl::OkStatus();
 }
 